@@ -0,0 +1,108 @@
+#include "acpi_tables.h"
+#include "mm/vmm.h"
+#include "serial.h"
+#include "string.h"
+#include <limine.h>
+
+__attribute__((used, section(".limine_requests")))
+static volatile struct limine_rsdp_request rsdp_request = {
+    .id = LIMINE_RSDP_REQUEST_ID,
+    .revision = 0,
+};
+
+static struct rsdt *g_root = NULL;   // XSDT or RSDT
+static int g_use_xsdt = 0;
+
+void *acpi_map_phys(uint64_t phys, size_t len, int mmio)
+{
+    uint64_t hhdm = vmm_hhdm_offset();
+    uint64_t first = phys & ~0xFFFull;
+    uint64_t last = (phys + (len ? len : 1) - 1) & ~0xFFFull;
+    uint32_t flags = (uint32_t)(VMM_P | VMM_RW | (mmio ? (VMM_PCD | VMM_PWT) : 0));
+
+    for (uint64_t p = first; p <= last; p += 0x1000)
+    {
+        uintptr_t mapped = 0;
+        uint32_t fl = 0;
+        if (vmm_query((uintptr_t)(p + hhdm), &mapped, &fl) == 0)
+            continue;
+        if (vmm_map((uintptr_t)(p + hhdm), (uintptr_t)p, flags) != 0)
+            return NULL;
+    }
+    return (void *)(uintptr_t)(phys + hhdm);
+}
+
+// 헤더를 먼저 매핑해 길이를 읽고, 테이블 전체를 다시 매핑
+static struct sdt *map_sdt(uint64_t phys)
+{
+    struct sdt *h = acpi_map_phys(phys, sizeof(struct sdt), 0);
+    if (!h || h->length < sizeof(struct sdt))
+        return NULL;
+    return acpi_map_phys(phys, h->length, 0);
+}
+
+int acpi_tables_init(void)
+{
+    if (g_root)
+        return 0;
+    if (!rsdp_request.response || !rsdp_request.response->address)
+    {
+        serial_printf("[acpi] no RSDP from the bootloader\n");
+        return -1;
+    }
+
+    // base revision에 따라 물리/HHDM 주소 어느 쪽으로도 올 수 있다
+    uint64_t addr = (uint64_t)(uintptr_t)rsdp_request.response->address;
+    uint64_t hhdm = vmm_hhdm_offset();
+    if (addr >= hhdm)
+        addr -= hhdm;
+
+    struct rsdp *rsdp = acpi_map_phys(addr, sizeof(struct rsdp), 0);
+    if (!rsdp || memcmp(rsdp->signature, "RSD PTR ", 8) != 0 || acpi_checksum(rsdp, 20) != 0)
+    {
+        serial_printf("[acpi] bad RSDP at 0x%llx\n", (unsigned long long)addr);
+        return -1;
+    }
+
+    g_use_xsdt = rsdp->rev >= 2 && rsdp->xsdt_addr;
+    struct sdt *root = map_sdt(g_use_xsdt ? rsdp->xsdt_addr : rsdp->rsdt_addr);
+    if (!root || acpi_checksum(root, root->length) != 0)
+    {
+        serial_printf("[acpi] bad %s\n", g_use_xsdt ? "XSDT" : "RSDT");
+        return -1;
+    }
+    g_root = (struct rsdt *)root;
+    serial_printf("[acpi] %s with %u tables\n", g_use_xsdt ? "XSDT" : "RSDT",
+                  (uint32_t)((root->length - sizeof(struct sdt)) / (g_use_xsdt ? 8 : 4)));
+    return 0;
+}
+
+void *acpi_find_table(const char *signature, int index)
+{
+    if (!g_root && acpi_tables_init() != 0)
+        return NULL;
+
+    size_t n = (g_root->header.length - sizeof(struct sdt)) / (g_use_xsdt ? 8 : 4);
+    int cnt = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint64_t phys;
+        if (g_use_xsdt)
+            memcpy(&phys, g_root->ptrs_start + i * 8, 8);   // 8바이트 정렬 보장 없음
+        else
+        {
+            uint32_t p32;
+            memcpy(&p32, g_root->ptrs_start + i * 4, 4);
+            phys = p32;
+        }
+
+        struct sdt *t = map_sdt(phys);
+        if (!t || memcmp(t->signature, signature, 4) != 0)
+            continue;
+        if (acpi_checksum(t, t->length) != 0)
+            continue;
+        if (cnt++ == index)
+            return t;
+    }
+    return NULL;
+}
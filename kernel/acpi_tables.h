@@ -0,0 +1,16 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "lib/acpi.h"
+
+// Kernel-side ACPI table lookup.
+// - The RSDP comes from the Limine RSDP request; tables are reached through
+//   the HHDM (pages missing from it are mapped on demand).
+// - Table layouts and acpi_checksum() are shared with lib/acpi.h.
+
+int   acpi_tables_init(void);
+// Returns the 'index'-th table whose signature matches (e.g. "HPET"), or NULL.
+void *acpi_find_table(const char *signature, int index);
+// Virtual address for 'len' bytes at 'phys', mapping pages that the HHDM
+// does not cover (uncached when 'mmio' is set). NULL on failure.
+void *acpi_map_phys(uint64_t phys, size_t len, int mmio);
@@ -0,0 +1,190 @@
+#include "apic.h"
+#include "pit.h"
+#include "serial.h"
+#include "mm/vmm.h"
+#include <sys/cpu.h>
+
+#define MSR_APIC_BASE       0x1B
+#define APIC_BASE_ENABLE    (1ull << 11)
+#define APIC_BASE_X2APIC    (1ull << 10)
+#define APIC_ICR_PENDING    (1u << 12)
+#define APIC_ICR_OTHERS     (3u << 18)   // destination shorthand: all excluding self
+#define APIC_TIMER_DIV_16   0x3
+#define MSR_TSC_DEADLINE    0x6E0
+
+static volatile uint32_t *g_apic_mmio = NULL;
+static int g_x2apic = 0;
+static uint32_t g_timer_ticks_per_sec = 0;
+static uint64_t g_tsc_per_sec = 0;
+
+int apic_present(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+    return cpuid(1, 0, &eax, &ebx, &ecx, &edx) && (edx & (1u << 9));
+}
+
+uint32_t apic_read(uint32_t reg)
+{
+    if (g_x2apic)
+        return (uint32_t)rdmsr(0x800 + (reg >> 4));
+    return g_apic_mmio[reg / 4];
+}
+
+void apic_write(uint32_t reg, uint32_t val)
+{
+    if (g_x2apic)
+        wrmsr(0x800 + (reg >> 4), val);
+    else
+        g_apic_mmio[reg / 4] = val;
+}
+
+uint32_t apic_id(void)
+{
+    uint32_t id = apic_read(APIC_REG_ID);
+    return g_x2apic ? id : (id >> 24);
+}
+
+void apic_eoi(void)
+{
+    apic_write(APIC_REG_EOI, 0);
+}
+
+static int apic_map_mmio(uint64_t phys)
+{
+    if (g_apic_mmio)
+        return 0;
+    uintptr_t va = (uintptr_t)(phys + vmm_hhdm_offset());
+    uintptr_t mapped = 0;
+    uint32_t fl = 0;
+    // HHDM에 MMIO가 없으면 UC로 직접 매핑
+    if (vmm_query(va, &mapped, &fl) != 0 &&
+        vmm_map(va, (uintptr_t)phys, (uint32_t)(VMM_P | VMM_RW | VMM_PCD | VMM_PWT)) != 0)
+    {
+        serial_printf("[apic] cannot map LAPIC at 0x%llx\n", (unsigned long long)phys);
+        return -1;
+    }
+    g_apic_mmio = (volatile uint32_t *)va;
+    return 0;
+}
+
+int apic_init(void)
+{
+    if (!apic_present())
+        return -1;
+
+    uint64_t base = rdmsr(MSR_APIC_BASE);
+    g_x2apic = (base & APIC_BASE_X2APIC) != 0;
+    if (!(base & APIC_BASE_ENABLE))
+        wrmsr(MSR_APIC_BASE, base | APIC_BASE_ENABLE);
+
+    if (!g_x2apic && apic_map_mmio(base & 0xFFFFF000ull) != 0)
+        return -1;
+
+    apic_write(APIC_REG_TPR, 0);
+    apic_write(APIC_REG_LVT_TIMER, APIC_LVT_MASKED);
+    apic_write(APIC_REG_LVT_ERROR, APIC_LVT_MASKED);
+    apic_write(APIC_REG_ESR, 0);
+    // SVR: software enable + spurious vector
+    apic_write(APIC_REG_SVR, 0x100u | APIC_VEC_SPURIOUS);
+    apic_eoi();
+    return 0;
+}
+
+static void apic_icr_wait(void)
+{
+    if (g_x2apic)
+        return;
+    for (int i = 0; i < 1000000 && (apic_read(APIC_REG_ICR_LO) & APIC_ICR_PENDING); ++i)
+        __asm__ volatile("pause");
+}
+
+void apic_send_ipi(uint32_t lapic_id, uint8_t vector)
+{
+    if (g_x2apic)
+    {
+        wrmsr(0x830, ((uint64_t)lapic_id << 32) | vector);
+        return;
+    }
+    apic_icr_wait();
+    apic_write(APIC_REG_ICR_HI, lapic_id << 24);
+    apic_write(APIC_REG_ICR_LO, vector);
+}
+
+void apic_send_ipi_others(uint8_t vector)
+{
+    if (g_x2apic)
+    {
+        wrmsr(0x830, APIC_ICR_OTHERS | vector);
+        return;
+    }
+    apic_icr_wait();
+    apic_write(APIC_REG_ICR_LO, APIC_ICR_OTHERS | vector);
+}
+
+/* PIT 100Hz 기준 10 jiffies(100ms) 동안 LAPIC 카운터와 TSC 증가량을 함께 측정 */
+int apic_timer_calibrate(uint64_t *tsc_per_sec)
+{
+    if (!g_timer_ticks_per_sec)
+    {
+        apic_write(APIC_REG_TIMER_DIV, APIC_TIMER_DIV_16);
+        apic_write(APIC_REG_LVT_TIMER, APIC_LVT_MASKED);
+
+        uint64_t start = jiffies;
+        while (jiffies == start)
+            __asm__ volatile("pause");
+        start = jiffies;
+        uint64_t t0 = rdtsc();
+        apic_write(APIC_REG_TIMER_INIT, 0xFFFFFFFFu);
+        while (jiffies - start < 10)
+            __asm__ volatile("pause");
+        uint32_t elapsed = 0xFFFFFFFFu - apic_read(APIC_REG_TIMER_CUR);
+        uint64_t t1 = rdtsc();
+        apic_write(APIC_REG_TIMER_INIT, 0);
+
+        g_timer_ticks_per_sec = elapsed * 10u;
+        g_tsc_per_sec = (t1 - t0) * 10u;
+        serial_printf("[apic] timer %u ticks/s (div 16), tsc %llu Hz\n",
+                      g_timer_ticks_per_sec, (unsigned long long)g_tsc_per_sec);
+    }
+    if (tsc_per_sec)
+        *tsc_per_sec = g_tsc_per_sec;
+    return (g_timer_ticks_per_sec && g_tsc_per_sec) ? 0 : -1;
+}
+
+int apic_tsc_deadline_supported(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+    return cpuid(1, 0, &eax, &ebx, &ecx, &edx) && (ecx & (1u << 24));
+}
+
+void apic_timer_setup(int tsc_deadline)
+{
+    apic_write(APIC_REG_TIMER_DIV, APIC_TIMER_DIV_16);
+    apic_write(APIC_REG_TIMER_INIT, 0);
+    apic_write(APIC_REG_LVT_TIMER, APIC_VEC_TIMER | (tsc_deadline ? APIC_TIMER_TSC_DEADLINE : 0));
+    // LVT 모드 변경이 deadline MSR 쓰기보다 먼저 보이도록 (SDM 10.5.4.1)
+    __asm__ volatile("mfence" ::: "memory");
+}
+
+void apic_timer_oneshot(uint32_t lapic_ticks)
+{
+    apic_write(APIC_REG_TIMER_INIT, lapic_ticks ? lapic_ticks : 1);
+}
+
+void apic_timer_deadline(uint64_t tsc)
+{
+    wrmsr(MSR_TSC_DEADLINE, tsc);
+}
+
+void apic_timer_stop(int tsc_deadline)
+{
+    if (tsc_deadline)
+        wrmsr(MSR_TSC_DEADLINE, 0);
+    else
+        apic_write(APIC_REG_TIMER_INIT, 0);
+}
+
+uint32_t apic_timer_ticks_per_sec(void)
+{
+    return g_timer_ticks_per_sec;
+}
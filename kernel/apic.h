@@ -0,0 +1,54 @@
+#pragma once
+#include <stdint.h>
+
+// Kernel-side local APIC driver (xAPIC MMIO or x2APIC MSRs).
+// sys/lapic.c belongs to the bootloader build and assumes identity-mapped
+// MMIO; this one maps the LAPIC page through the HHDM.
+
+#define APIC_REG_ID         0x020
+#define APIC_REG_VERSION    0x030
+#define APIC_REG_TPR        0x080
+#define APIC_REG_EOI        0x0B0
+#define APIC_REG_SVR        0x0F0
+#define APIC_REG_ESR        0x280
+#define APIC_REG_ICR_LO     0x300
+#define APIC_REG_ICR_HI     0x310
+#define APIC_REG_LVT_TIMER  0x320
+#define APIC_REG_LVT_LINT0  0x350
+#define APIC_REG_LVT_LINT1  0x360
+#define APIC_REG_LVT_ERROR  0x370
+#define APIC_REG_TIMER_INIT 0x380
+#define APIC_REG_TIMER_CUR  0x390
+#define APIC_REG_TIMER_DIV  0x3E0
+
+#define APIC_LVT_MASKED     (1u << 16)
+#define APIC_TIMER_PERIODIC (1u << 17)
+#define APIC_TIMER_TSC_DEADLINE (2u << 17)
+
+// Interrupt vectors owned by the LAPIC (above the PIC range and int 0x80)
+#define APIC_VEC_TIMER      0xF0
+#define APIC_VEC_RESCHED    0xF1
+#define APIC_VEC_TLB        0xF2
+#define APIC_VEC_SPURIOUS   0xFF
+
+// Map + enable the LAPIC on the calling CPU. The BSP call also maps the MMIO page.
+int      apic_init(void);
+int      apic_present(void);
+uint32_t apic_id(void);
+uint32_t apic_read(uint32_t reg);
+void     apic_write(uint32_t reg, uint32_t val);
+void     apic_eoi(void);
+
+void     apic_send_ipi(uint32_t lapic_id, uint8_t vector);
+void     apic_send_ipi_others(uint8_t vector);
+
+// Timer: calibrate once on the BSP against the PIT (interrupts enabled);
+// the TSC rate is measured over the same window. tick.c then drives each
+// CPU's timer in one-shot or TSC-deadline mode.
+int      apic_timer_calibrate(uint64_t *tsc_per_sec);
+int      apic_tsc_deadline_supported(void);
+void     apic_timer_setup(int tsc_deadline);
+void     apic_timer_oneshot(uint32_t lapic_ticks);
+void     apic_timer_deadline(uint64_t tsc);
+void     apic_timer_stop(int tsc_deadline);
+uint32_t apic_timer_ticks_per_sec(void);
@@ -0,0 +1,108 @@
+#include "arena.h"
+#include "serial.h"
+#include "string.h"
+#include "kheap.h"
+
+#define ARENA_ALIGN 16u
+
+static arena_t g_frame_arena;
+
+int arena_init(arena_t *a, const char *name, size_t size)
+{
+    if (!a || size == 0)
+        return -1;
+
+    memset(a, 0, sizeof(*a));
+    a->name = name ? name : "arena";
+    a->base = kmalloc_tag(size + ARENA_ALIGN, KMEM_TAG_ARENA);
+    if (!a->base)
+    {
+        serial_printf("[arena] %s: backing alloc failed (%u bytes)\n",
+                      a->name, (uint32_t)size);
+        return -1;
+    }
+    // don't depend on the heap's block alignment
+    uintptr_t p = ((uintptr_t)a->base + (ARENA_ALIGN - 1)) & ~(uintptr_t)(ARENA_ALIGN - 1);
+    a->base = (uint8_t *)p;
+    a->size = size;
+    return 0;
+}
+
+void *arena_alloc(arena_t *a, size_t sz)
+{
+    if (!a || !a->base || sz == 0)
+        return NULL;
+
+    size_t off = (a->used + (ARENA_ALIGN - 1)) & ~(size_t)(ARENA_ALIGN - 1);
+    if (off > a->size || sz > a->size - off)
+    {
+        a->failures++;
+        return NULL;
+    }
+
+    a->used = off + sz;
+    if (a->used > a->frame_peak)
+        a->frame_peak = a->used;
+    if (a->used > a->high_water)
+        a->high_water = a->used;
+    return a->base + off;
+}
+
+void *arena_calloc(arena_t *a, size_t count, size_t sz)
+{
+    if (sz && count > (size_t)-1 / sz)
+        return NULL;
+    void *p = arena_alloc(a, count * sz);
+    if (p)
+        memset(p, 0, count * sz);
+    return p;
+}
+
+char *arena_strdup(arena_t *a, const char *s)
+{
+    if (!s)
+        return NULL;
+    size_t n = strlen(s) + 1;
+    char *d = arena_alloc(a, n);
+    if (d)
+        memcpy(d, s, n);
+    return d;
+}
+
+arena_mark_t arena_mark(const arena_t *a)
+{
+    return a ? a->used : 0;
+}
+
+void arena_reset_to(arena_t *a, arena_mark_t mark)
+{
+    if (!a || mark > a->used)
+        return;
+    a->used = mark;
+}
+
+void arena_reset(arena_t *a)
+{
+    if (!a)
+        return;
+    a->last_peak = a->frame_peak;
+    a->used = 0;
+    a->frame_peak = 0;
+    a->resets++;
+}
+
+int frame_arena_init(void)
+{
+    return arena_init(&g_frame_arena, "frame", FRAME_ARENA_SIZE);
+}
+
+arena_t *frame_arena(void)
+{
+    return &g_frame_arena;
+}
+
+// fb_flush() 이후 호출: 이번 프레임에서 잡은 임시 메모리를 한 번에 반환
+void frame_arena_end_frame(void)
+{
+    arena_reset(&g_frame_arena);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Linear (bump) arena allocator.
+// - arena_alloc: O(1) pointer bump, 16-byte aligned, never frees individually.
+// - arena_mark / arena_reset_to: scoped release back to a saved position.
+// - arena_reset: drop everything at once.
+//
+// The GUI keeps one per-frame arena (frame_arena()) that is reset after
+// fb_flush(), so render paths can take temporaries (labels, image rows,
+// directory snapshots) without touching the stack or the kmalloc heap.
+
+typedef struct
+{
+    const char *name;
+    uint8_t *base;
+    size_t size;
+    size_t used;
+    size_t high_water;   // max 'used' ever seen
+    size_t frame_peak;   // max 'used' since the last arena_reset
+    size_t last_peak;    // frame_peak captured at the last arena_reset
+    uint32_t resets;
+    uint32_t failures;   // allocations that did not fit
+} arena_t;
+
+typedef size_t arena_mark_t;
+
+// Backing memory is taken from kmalloc once. Returns 0 on success.
+int   arena_init(arena_t *a, const char *name, size_t size);
+void *arena_alloc(arena_t *a, size_t sz);
+void *arena_calloc(arena_t *a, size_t count, size_t sz);
+char *arena_strdup(arena_t *a, const char *s);
+
+arena_mark_t arena_mark(const arena_t *a);
+void  arena_reset_to(arena_t *a, arena_mark_t mark);
+void  arena_reset(arena_t *a);
+
+// Per-frame scratch arena used by the desktop renderer.
+#define FRAME_ARENA_SIZE (256u * 1024u)
+int      frame_arena_init(void);
+arena_t *frame_arena(void);
+void     frame_arena_end_frame(void);
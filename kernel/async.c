@@ -0,0 +1,156 @@
+#include "async.h"
+#include "clock.h"
+#include "serial.h"
+
+// 모두 GUI 스레드에서만 만진다: 잠금이 없다. 워커 쪽은 async_io_run()뿐이고
+// 그것은 t->result만 쓴다 (gui_job 완료 목록이 순서를 맞춘다).
+static async_t  *g_timers;    // ASYNC_WAIT_TIMER, 정렬 안 함 (앱 수만큼)
+static async_t  *g_all;
+static uint32_t  g_started, g_finished, g_steps;
+
+static void step(async_t *t)
+{
+    t->state = ASYNC_RUNNING;
+    t->steps++;
+    g_steps++;
+    t->fn(t);
+    // await 없이 함수가 끝까지 왔다 (ASYNC_END / ASYNC_EXIT)
+    if (t->state == ASYNC_RUNNING)
+    {
+        t->line = 0;
+        t->state = ASYNC_IDLE;
+    }
+    if (t->state == ASYNC_IDLE)
+        g_finished++;
+}
+
+int async_start(async_t *t, async_fn_t fn, void *ctx, const char *name)
+{
+    if (async_busy(t))
+        return -1;
+    if (!t->registered)
+    {
+        t->registered = 1;
+        t->all_next = g_all;
+        g_all = t;
+    }
+    t->fn = fn;
+    t->ctx = ctx;
+    t->name = name;
+    t->line = 0;
+    t->canceled = 0;
+    t->result = 0;
+    g_started++;
+    step(t);
+    return 0;
+}
+
+static void timer_unlink(async_t *t)
+{
+    for (async_t **pp = &g_timers; *pp; pp = &(*pp)->timer_next)
+    {
+        if (*pp == t)
+        {
+            *pp = t->timer_next;
+            t->timer_next = 0;
+            return;
+        }
+    }
+}
+
+void async_cancel(async_t *t)
+{
+    if (!async_busy(t))
+        return;
+    t->canceled = 1;
+    // 자는 중이면 지금 깨워 스스로 끝내게 한다. I/O 중이면 끝난 뒤에 본다.
+    if (t->state == ASYNC_WAIT_TIMER)
+    {
+        timer_unlink(t);
+        step(t);
+    }
+}
+
+/* --------- await_io --------- */
+
+static void async_io_run(gui_job_t *job)
+{
+    async_t *t = container_of(job, async_t, io);
+    job->result = t->io_fn(t);
+}
+
+static void async_io_done(gui_job_t *job)
+{
+    async_t *t = container_of(job, async_t, io);
+    t->result = job->result;
+    step(t);
+}
+
+void async_submit_io(async_t *t, workqueue_t *wq, async_io_fn_t fn)
+{
+    t->state = ASYNC_WAIT_IO;
+    t->ios++;
+    t->io_fn = fn;
+    t->io.run = async_io_run;
+    t->io.done = async_io_done;
+    gui_job_submit(wq, &t->io);
+}
+
+/* --------- timers --------- */
+
+void async_arm_timer(async_t *t, uint32_t ms)
+{
+    t->state = ASYNC_WAIT_TIMER;
+    t->sleeps++;
+    t->wake_ms = ktime_ms() + ms;
+    t->timer_next = g_timers;
+    g_timers = t;
+}
+
+void async_poll(void)
+{
+    // 돌리는 코루틴이 목록을 바꾸므로 하나 돌릴 때마다 처음부터 다시 본다
+    uint64_t now = ktime_ms();
+    for (;;)
+    {
+        async_t *due = 0;
+        for (async_t *t = g_timers; t; t = t->timer_next)
+        {
+            if (t->wake_ms <= now)
+            {
+                due = t;
+                break;
+            }
+        }
+        if (!due)
+            return;
+        timer_unlink(due);
+        step(due);
+    }
+}
+
+uint64_t async_next_timeout_ms(void)
+{
+    if (!g_timers)
+        return ~0ull;
+    uint64_t now = ktime_ms();
+    uint64_t best = ~0ull;
+    for (async_t *t = g_timers; t; t = t->timer_next)
+    {
+        uint64_t d = t->wake_ms > now ? t->wake_ms - now : 0;
+        if (d < best)
+            best = d;
+    }
+    return best;
+}
+
+void async_dump(void)
+{
+    static const char *const states[] = { "idle", "running", "io", "sleep" };
+    serial_printf("[async] %u started, %u finished, %u steps; one shared stack (GUI thread)\n",
+                  g_started, g_finished, g_steps);
+    for (async_t *t = g_all; t; t = t->all_next)
+        serial_printf("[async]   %s: %s, line %u, %u steps, %u io, %u sleeps%s\n",
+                      t->name ? t->name : "?", states[t->state], t->line,
+                      t->steps, t->ios, t->sleeps, t->canceled ? ", canceled" : "");
+}
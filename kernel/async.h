@@ -0,0 +1,90 @@
+#pragma once
+#include <stdint.h>
+#include "gui_event.h"
+#include "workqueue.h"
+
+// Stackless coroutines for the in-kernel apps (file explorer, image viewer,
+// WAV player).
+// - 코루틴은 async_t 하나와 함수 하나다. 함수는 GUI 스레드에서 불리고, await에서
+//   다시 시작할 자리(__LINE__)를 t->line에 적고 돌아온다. 다음 번에는 switch로
+//   그 자리부터 이어서 돈다 (Duff's device). 스레드가 아니라 스택이 따로 없다:
+//   모든 코루틴이 GUI 스레드의 스택 하나를 나눠 쓴다.
+// - 그래서 지역 변수는 await를 넘어 살아남지 않는다. 이어 쓸 값은 ctx(앱 상태)에
+//   둔다. await를 switch 문 안에 두지 않는다 (바깥 switch와 겹친다).
+// - await_io(t, wq, fn): fn을 워크큐의 워커에서 돌리고, 끝나면 gui_jobs_complete()
+//   에서 코루틴을 이어 간다. fn의 반환값은 t->result. fn은 GUI 상태를 만지지 않는다.
+// - await_sleep(t, ms) / async_yield(t): GUI 루프의 대기 시간에 걸려 깨어난다.
+// - async_cancel()은 플래그만 세운다. 코루틴은 await 뒤에 async_canceled()를 보고
+//   스스로 정리하고 끝난다. 자고 있으면 바로 깨운다.
+//
+//   static void load(async_t *t)
+//   {
+//       app_t *a = t->ctx;
+//       ASYNC_BEGIN(t);
+//       await_io(t, fs_wq, read_file);
+//       if (t->result == 0) show(a);
+//       ASYNC_END(t);
+//   }
+
+enum
+{
+    ASYNC_IDLE = 0,     // 시작 전이거나 끝남
+    ASYNC_RUNNING,      // 함수 안 (GUI 스레드)
+    ASYNC_WAIT_IO,
+    ASYNC_WAIT_TIMER,
+};
+
+struct async_task;
+typedef void (*async_fn_t)(struct async_task *t);
+typedef int  (*async_io_fn_t)(struct async_task *t);
+
+typedef struct async_task
+{
+    async_fn_t          fn;
+    void               *ctx;
+    const char         *name;
+    uint32_t            line;       // 다시 시작할 곳, 0 = 처음
+    uint8_t             state;      // ASYNC_*
+    uint8_t             canceled;
+    uint8_t             registered;
+    int                 result;     // 마지막 await_io의 결과
+    uint64_t            wake_ms;    // ASYNC_WAIT_TIMER: ktime_ms()
+    async_io_fn_t       io_fn;
+    gui_job_t           io;
+    struct async_task  *timer_next;
+    struct async_task  *all_next;   // "async" 목록
+    uint32_t            steps, ios, sleeps;
+} async_t;
+
+#define ASYNC_BEGIN(t)  switch ((t)->line) { case 0:
+#define ASYNC_END(t)    } (t)->line = 0; (t)->state = ASYNC_IDLE; return
+
+// 코루틴 함수 안에서만. 돌아오는 return은 GUI 루프로 간다.
+#define ASYNC_SUSPEND_(t) \
+    (t)->line = __LINE__; return; case __LINE__:;
+
+#define await_io(t, wq, fn) \
+    do { async_submit_io((t), (wq), (fn)); ASYNC_SUSPEND_(t) } while (0)
+#define await_sleep(t, ms) \
+    do { async_arm_timer((t), (ms)); ASYNC_SUSPEND_(t) } while (0)
+// 이번 루프는 여기까지, 다음에 GUI가 깨면 이어서
+#define async_yield(t) \
+    do { async_arm_timer((t), 0); ASYNC_SUSPEND_(t) } while (0)
+#define ASYNC_EXIT(t) \
+    do { (t)->line = 0; (t)->state = ASYNC_IDLE; return; } while (0)
+
+// 첫 await까지 바로 돈다. 이미 돌고 있으면 -1.
+int      async_start(async_t *t, async_fn_t fn, void *ctx, const char *name);
+void     async_cancel(async_t *t);
+static inline int async_busy(const async_t *t) { return t->state != ASYNC_IDLE; }
+static inline int async_canceled(const async_t *t) { return t->canceled; }
+
+// await 매크로가 부른다
+void     async_submit_io(async_t *t, workqueue_t *wq, async_io_fn_t fn);
+void     async_arm_timer(async_t *t, uint32_t ms);
+
+// GUI 루프: 때가 된 타이머 코루틴을 돌린다 / 다음 타이머까지 남은 ms (없으면 ~0)
+void     async_poll(void);
+uint64_t async_next_timeout_ms(void);
+
+void     async_dump(void);
@@ -1,29 +1,50 @@
 #include "ata.h"
 #include "io.h"
 #include "serial.h"
+#include "clock.h"
+#include "ktimer.h"
+#include "task/sync.h"
+
+#define ATA_TIMEOUT_MS   1000
+#define ATA_SPIN_POLLS   1000   // 빠른 장치는 여기서 끝난다; 그 뒤로는 1ms씩 잔다
+
+// 한 번에 한 스레드만 primary 채널을 쓴다
+static mutex_t g_ata_lock = MUTEX_INIT;
 
 static inline uint8_t inb_p(uint16_t port) { uint8_t v = inb(port); io_wait(); return v; }
 
 static int ata_wait_bsy(void)
 {
-    for (int i = 0; i < 1000000; ++i)
+    uint64_t deadline = ktime_ms() + ATA_TIMEOUT_MS;
+    for (int i = 0;; ++i)
     {
         if (!(inb(ATA_PRIMARY_IO + ATA_REG_STATUS) & ATA_SR_BSY))
             return 0;
+        if (i >= ATA_SPIN_POLLS)
+        {
+            if (ktime_ms() >= deadline)
+                return -1;
+            msleep(1);
+        }
     }
-    return -1;
 }
 
 static int ata_wait_drq(void)
 {
-    for (int i = 0; i < 1000000; ++i)
+    uint64_t deadline = ktime_ms() + ATA_TIMEOUT_MS;
+    for (int i = 0;; ++i)
     {
         uint8_t st = inb(ATA_PRIMARY_IO + ATA_REG_STATUS);
         if (st & ATA_SR_ERR) return -2;
         if (st & ATA_SR_DF)  return -3;
         if (st & ATA_SR_DRQ) return 0;
+        if (i >= ATA_SPIN_POLLS)
+        {
+            if (ktime_ms() >= deadline)
+                return -1;
+            msleep(1);
+        }
     }
-    return -1;
 }
 
 void ata_init(void)
@@ -33,7 +54,7 @@ void ata_init(void)
     io_wait();
 }
 
-int ata_identify(ata_identify_t* out)
+static int ata_pio_identify(ata_identify_t* out)
 {
     if (!out) return -1;
     out->present = 0;
@@ -75,7 +96,7 @@ int ata_identify(ata_identify_t* out)
     return 0;
 }
 
-int ata_read28(uint32_t lba, uint8_t count, void* buffer)
+static int ata_pio_read28(uint32_t lba, uint8_t count, void* buffer)
 {
     if (count == 0) return 0;
     if (count > 128) count = 128;
@@ -104,7 +125,7 @@ int ata_read28(uint32_t lba, uint8_t count, void* buffer)
     return 0;
 }
 
-int ata_write28(uint32_t lba, uint8_t count, const void* buffer)
+static int ata_pio_write28(uint32_t lba, uint8_t count, const void* buffer)
 {
     if (count == 0) return 0;
     if (count > 128) count = 128;
@@ -131,3 +152,27 @@ int ata_write28(uint32_t lba, uint8_t count, const void* buffer)
     }
     return 0;
 }
+
+int ata_read28(uint32_t lba, uint8_t count, void* buffer)
+{
+    mutex_lock(&g_ata_lock);
+    int r = ata_pio_read28(lba, count, buffer);
+    mutex_unlock(&g_ata_lock);
+    return r;
+}
+
+int ata_write28(uint32_t lba, uint8_t count, const void* buffer)
+{
+    mutex_lock(&g_ata_lock);
+    int r = ata_pio_write28(lba, count, buffer);
+    mutex_unlock(&g_ata_lock);
+    return r;
+}
+
+int ata_identify(ata_identify_t* out)
+{
+    mutex_lock(&g_ata_lock);
+    int r = ata_pio_identify(out);
+    mutex_unlock(&g_ata_lock);
+    return r;
+}
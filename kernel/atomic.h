@@ -0,0 +1,87 @@
+#pragma once
+#include <stdint.h>
+
+// Atomic helpers over the GCC __atomic builtins.
+// - atomic_t / atomic64_t: 카운터와 플래그. 기본은 relaxed, 순서가 필요한
+//   곳은 *_acquire / *_release 변형이나 smp_*mb()를 쓴다.
+// - READ_ONCE/WRITE_ONCE: 컴파일러가 합치거나 나누지 않는 한 번의 접근
+//   (IRQ 핸들러와 나누는 변수).
+// - x86은 TSO라 smp_rmb/smp_wmb는 컴파일러 배리어로 충분하다.
+
+#define CACHELINE_SIZE      64
+#define __cacheline_aligned __attribute__((aligned(CACHELINE_SIZE)))
+
+#define READ_ONCE(x)     (*(const volatile __typeof__(x) *)&(x))
+#define WRITE_ONCE(x, v) (*(volatile __typeof__(x) *)&(x) = (v))
+
+static inline void cpu_relax(void)
+{
+    __asm__ volatile("pause" ::: "memory");
+}
+
+static inline void barrier(void)
+{
+    __asm__ volatile("" ::: "memory");
+}
+
+static inline void smp_mb(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void smp_rmb(void)
+{
+    barrier();
+}
+
+static inline void smp_wmb(void)
+{
+    barrier();
+}
+
+typedef struct { volatile int32_t v; } atomic_t;
+typedef struct { volatile int64_t v; } atomic64_t;
+
+#define ATOMIC_INIT(n) { (n) }
+
+static inline int32_t atomic_read(const atomic_t *a)             { return __atomic_load_n(&a->v, __ATOMIC_RELAXED); }
+static inline int32_t atomic_read_acquire(const atomic_t *a)     { return __atomic_load_n(&a->v, __ATOMIC_ACQUIRE); }
+static inline void    atomic_set(atomic_t *a, int32_t n)         { __atomic_store_n(&a->v, n, __ATOMIC_RELAXED); }
+static inline void    atomic_set_release(atomic_t *a, int32_t n) { __atomic_store_n(&a->v, n, __ATOMIC_RELEASE); }
+static inline int32_t atomic_add(atomic_t *a, int32_t n)         { return __atomic_add_fetch(&a->v, n, __ATOMIC_RELAXED); }
+static inline int32_t atomic_sub(atomic_t *a, int32_t n)         { return __atomic_sub_fetch(&a->v, n, __ATOMIC_RELAXED); }
+static inline int32_t atomic_inc(atomic_t *a)                    { return __atomic_add_fetch(&a->v, 1, __ATOMIC_RELAXED); }
+static inline int32_t atomic_fetch_inc(atomic_t *a)              { return __atomic_fetch_add(&a->v, 1, __ATOMIC_RELAXED); }
+// 참조 카운트용: 0이 되는 순간을 본 쪽만 1을 받는다 (acq_rel)
+static inline int     atomic_dec_and_test(atomic_t *a)           { return __atomic_sub_fetch(&a->v, 1, __ATOMIC_ACQ_REL) == 0; }
+static inline int32_t atomic_xchg(atomic_t *a, int32_t n)        { return __atomic_exchange_n(&a->v, n, __ATOMIC_ACQ_REL); }
+
+// *expected와 같으면 n으로 바꾸고 1. 아니면 *expected에 현재 값을 넣고 0.
+static inline int atomic_cmpxchg(atomic_t *a, int32_t *expected, int32_t n)
+{
+    return __atomic_compare_exchange_n(&a->v, expected, n, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+static inline int64_t atomic64_read(const atomic64_t *a)         { return __atomic_load_n(&a->v, __ATOMIC_RELAXED); }
+static inline void    atomic64_set(atomic64_t *a, int64_t n)     { __atomic_store_n(&a->v, n, __ATOMIC_RELAXED); }
+static inline int64_t atomic64_add(atomic64_t *a, int64_t n)     { return __atomic_add_fetch(&a->v, n, __ATOMIC_RELAXED); }
+static inline int64_t atomic64_inc(atomic64_t *a)                { return __atomic_add_fetch(&a->v, 1, __ATOMIC_RELAXED); }
+static inline int64_t atomic64_xchg(atomic64_t *a, int64_t n)    { return __atomic_exchange_n(&a->v, n, __ATOMIC_ACQ_REL); }
+
+static inline int atomic64_cmpxchg(atomic64_t *a, int64_t *expected, int64_t n)
+{
+    return __atomic_compare_exchange_n(&a->v, expected, n, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+// 단일 비트 플래그 (bitmap[] 위에서)
+static inline int test_and_set_bit(volatile uint64_t *bitmap, uint32_t bit)
+{
+    uint64_t m = 1ull << (bit & 63);
+    return (__atomic_fetch_or(&bitmap[bit >> 6], m, __ATOMIC_ACQ_REL) & m) != 0;
+}
+
+static inline int test_and_clear_bit(volatile uint64_t *bitmap, uint32_t bit)
+{
+    uint64_t m = 1ull << (bit & 63);
+    return (__atomic_fetch_and(&bitmap[bit >> 6], ~m, __ATOMIC_ACQ_REL) & m) != 0;
+}
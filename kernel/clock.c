@@ -0,0 +1,167 @@
+#include "clock.h"
+#include "hpet.h"
+#include "pit.h"
+#include "serial.h"
+#include "spinlock.h"
+#include <sys/cpu.h>
+
+#define NSEC_PER_SEC       1000000000ull
+#define CAL_HPET_DIV       50     // 20 ms window
+#define CAL_PIT_JIFFIES    10     // 100 ms window
+
+static int      g_src = CLOCK_SRC_JIFFIES;
+static uint64_t g_tsc_hz = 0;
+static uint64_t g_base = 0;       // counter value at ktime 0
+static uint64_t g_mult = 0;       // ns = (cycles * g_mult) >> 32
+static uint64_t g_boot_wall_ns = 0;   // time of day at ktime 0
+
+static int tsc_invariant(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+    return cpuid(0x80000007, 0, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8));
+}
+
+static uint64_t hpet_delta(uint64_t from, uint64_t to)
+{
+    return hpet_counter64() ? to - from : (uint32_t)(to - from);
+}
+
+static uint64_t calibrate_tsc_hpet(void)
+{
+    uint64_t window = hpet_hz() / CAL_HPET_DIV;
+    uint64_t h0 = hpet_read();
+    uint64_t t0 = rdtsc();
+    uint64_t d;
+    while ((d = hpet_delta(h0, hpet_read())) < window)
+        __asm__ volatile("pause");
+    uint64_t t1 = rdtsc();
+    return (t1 - t0) * hpet_hz() / d;
+}
+
+static uint64_t calibrate_tsc_pit(void)
+{
+    uint64_t start = jiffies;
+    while (jiffies == start)
+        __asm__ volatile("pause");
+    start = jiffies;
+    uint64_t t0 = rdtsc();
+    while (jiffies - start < CAL_PIT_JIFFIES)
+        __asm__ volatile("pause");
+    uint64_t t1 = rdtsc();
+    return (t1 - t0) * (100u / CAL_PIT_JIFFIES);
+}
+
+uint64_t clock_cycles(void)
+{
+    switch (g_src)
+    {
+    case CLOCK_SRC_TSC:  return rdtsc();
+    case CLOCK_SRC_HPET: return hpet_read();
+    default:             return jiffies;
+    }
+}
+
+uint64_t clock_cycles_to_ns(uint64_t cycles)
+{
+    return (uint64_t)(((unsigned __int128)cycles * g_mult) >> 32);
+}
+
+uint64_t ktime_ns(void)
+{
+    return clock_cycles_to_ns(clock_cycles() - g_base);
+}
+
+uint64_t ktime_us(void)
+{
+    return ktime_ns() / 1000u;
+}
+
+uint64_t ktime_ms(void)
+{
+    return ktime_ns() / 1000000u;
+}
+
+int clock_init(void)
+{
+    int have_hpet = hpet_init() == 0;
+
+    g_tsc_hz = have_hpet ? calibrate_tsc_hpet() : calibrate_tsc_pit();
+
+    if (g_tsc_hz && tsc_invariant())
+        g_src = CLOCK_SRC_TSC;
+    else if (have_hpet && hpet_counter64())
+        g_src = CLOCK_SRC_HPET;   // 32비트 HPET은 금방 돌아가므로 제외
+    else if (g_tsc_hz)
+        g_src = CLOCK_SRC_TSC;    // 불변 TSC가 아니어도 jiffies보단 낫다
+
+    switch (g_src)
+    {
+    case CLOCK_SRC_TSC:
+        g_mult = (NSEC_PER_SEC << 32) / g_tsc_hz;
+        break;
+    case CLOCK_SRC_HPET:
+        // 1 fs = 10^-6 ns
+        g_mult = ((uint64_t)hpet_period_fs() << 32) / 1000000u;
+        break;
+    default:
+        g_mult = 10000000ull << 32;   // 1 jiffy = 10 ms
+        break;
+    }
+
+    rtc_time_t t;
+    uint64_t fl = irq_save();
+    rtc_read_time(&t);
+    g_base = clock_cycles();
+    irq_restore(fl);
+    g_boot_wall_ns = ((uint64_t)t.hh * 3600u + t.mm * 60u + t.ss) * NSEC_PER_SEC;
+
+    serial_printf("[clock] source=%s tsc=%llu Hz%s\n", clock_source_name(),
+                  (unsigned long long)g_tsc_hz, tsc_invariant() ? " (invariant)" : "");
+    return g_src == CLOCK_SRC_JIFFIES ? -1 : 0;
+}
+
+int clock_source(void)
+{
+    return g_src;
+}
+
+const char *clock_source_name(void)
+{
+    static const char *const names[] = { "jiffies", "tsc", "hpet" };
+    return names[g_src];
+}
+
+uint64_t clock_tsc_hz(void)
+{
+    return g_tsc_hz;
+}
+
+void clock_wall_time(rtc_time_t *t)
+{
+    uint64_t s = ((g_boot_wall_ns + ktime_ns()) / NSEC_PER_SEC) % 86400u;
+    t->hh = (uint8_t)(s / 3600u);
+    t->mm = (uint8_t)((s / 60u) % 60u);
+    t->ss = (uint8_t)(s % 60u);
+}
+
+void clock_get_params(uint64_t *cycle_base, uint64_t *mult, uint64_t *boot_wall_ns)
+{
+    *cycle_base = g_base;
+    *mult = g_mult;
+    *boot_wall_ns = g_boot_wall_ns;
+}
+
+void clock_dump(void)
+{
+    rtc_time_t t;
+    char buf[9];
+    clock_wall_time(&t);
+    rtc_format(buf, &t);
+    uint64_t c0 = clock_cycles();
+    uint64_t c1 = clock_cycles();
+    serial_printf("[clock] source=%s uptime=%llu us wall=%s read cost=%llu ns\n",
+                  clock_source_name(), (unsigned long long)ktime_us(), buf,
+                  (unsigned long long)clock_cycles_to_ns(c1 - c0));
+    if (hpet_available())
+        serial_printf("[clock] hpet %llu Hz\n", (unsigned long long)hpet_hz());
+}
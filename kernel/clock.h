@@ -0,0 +1,34 @@
+#pragma once
+#include <stdint.h>
+#include "bios/rtc.h"
+
+// Clocksource layer.
+// - Invariant TSC calibrated against the HPET (or the PIT when there is no
+//   HPET) is the default source. Without an invariant TSC the 64-bit HPET
+//   counter is used directly; jiffies is the last resort.
+// - ktime_ns(): monotonic nanoseconds since clock_init(), callable from any
+//   CPU and from interrupt context.
+// - Wall time = one RTC read at boot + the monotonic delta, so the CMOS is
+//   no longer polled.
+// - clock_cycles()/clock_cycles_to_ns(): raw counter for cheap timestamps.
+
+enum { CLOCK_SRC_JIFFIES = 0, CLOCK_SRC_TSC, CLOCK_SRC_HPET };
+
+// BSP, interrupts enabled, before tick_init().
+int      clock_init(void);
+int      clock_source(void);
+const char *clock_source_name(void);
+
+uint64_t ktime_ns(void);
+uint64_t ktime_us(void);
+uint64_t ktime_ms(void);
+
+uint64_t clock_cycles(void);
+uint64_t clock_cycles_to_ns(uint64_t cycles);
+// Calibrated TSC frequency (0 before clock_init or if uncalibrated).
+uint64_t clock_tsc_hz(void);
+
+void     clock_wall_time(rtc_time_t *t);
+// ktime_ns() = ((clock_cycles() - cycle_base) * mult) >> 32, wall = boot_wall_ns + ktime_ns()
+void     clock_get_params(uint64_t *cycle_base, uint64_t *mult, uint64_t *boot_wall_ns);
+void     clock_dump(void);
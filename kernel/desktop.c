@@ -10,8 +10,10 @@
 #include "mm/vmm.h"
 #include "string.h"
 #include "stdlib.h"
+#include "kheap.h"
+#include "clock.h"
+#include "gui_event.h"
 
-extern void *kmalloc(size_t sz);
 extern void *memcpy_exact(void *dst, const void *src, size_t n);
 extern volatile uint64_t jiffies;
 
@@ -33,9 +35,9 @@ static size_t desktop_bg_cache_bytes = 0;
 static int desktop_bg_dirty = 1;
 
 static uint64_t desktop_frame_ticks = 1;      // max refresh (~100fps at 100Hz PIT)
-static uint64_t last_click_tick = 0;
+static uint64_t last_click_ms = 0;
 static int last_click_index = -1;
-static const int double_click_threshold = 50; // ~500ms at 100Hz
+static const int double_click_threshold = 500; // ms
 
 static const uint32_t THEME_ACCENT = 0xFF4C8DFF;
 static const uint32_t THEME_TEXT = 0xFF2F3645;
@@ -51,16 +53,24 @@ static int wallpaper_loaded = 0;
 
 static void *wp_alloc(size_t sz)
 {
-    void *p = kmalloc(sz);
+    void *p = kmalloc_tag(sz, KMEM_TAG_DESKTOP);
     if (p)
         return p;
     void *phys = ext_mem_alloc(sz);
     if (!phys)
         return NULL;
+    kmem_tag_charge(KMEM_TAG_DESKTOP, sz);
     uintptr_t hhdm = vmm_hhdm_offset();
     return (void *)((uintptr_t)phys + hhdm);
 }
 
+// ext_mem_alloc fallback memory cannot be returned; only heap blocks are freed.
+static void wp_free(void *p)
+{
+    if (p && kheap_owns(p))
+        kfree(p);
+}
+
 static int ensure_desktop_bg_cache(void)
 {
     size_t frame_bytes = (size_t)fb.pitch * (size_t)fb.height;
@@ -70,7 +80,16 @@ static int ensure_desktop_bg_cache(void)
     if (desktop_bg_cache && desktop_bg_cache_bytes == frame_bytes)
         return 1;
 
-    uint8_t *buf = kmalloc(frame_bytes);
+    if (desktop_bg_cache)
+        kfree(desktop_bg_cache);
+    desktop_bg_cache = NULL;
+    desktop_bg_cache_bytes = 0;
+
+    // 메모리 압박 중에는 캐시를 다시 만들지 않고 매 프레임 직접 그린다
+    if (kheap_under_pressure())
+        return 0;
+
+    uint8_t *buf = kmalloc_tag(frame_bytes, KMEM_TAG_DESKTOP);
     if (buf)
     {
         desktop_bg_cache = buf;
@@ -144,12 +163,72 @@ static void desktop_draw_icons(void)
     }
 }
 
+// Shrinker: the background cache is rebuilt from scratch on the next frame.
+static size_t bg_cache_shrink_count(void *user)
+{
+    (void)user;
+    return desktop_bg_cache ? desktop_bg_cache_bytes : 0;
+}
+
+static size_t bg_cache_shrink_scan(size_t want, void *user)
+{
+    (void)want;
+    (void)user;
+    size_t bytes = desktop_bg_cache_bytes;
+    if (!desktop_bg_cache)
+        return 0;
+    kfree(desktop_bg_cache);
+    desktop_bg_cache = NULL;
+    desktop_bg_cache_bytes = 0;
+    desktop_bg_dirty = 1;
+    return bytes;
+}
+
+// Shrinker: halve the decoded wallpaper in place and give the tail back,
+// the same degradation load_bmp_into_bg applies when the first alloc fails.
+#define WALLPAPER_MIN_DIM 160u
+
+static size_t wallpaper_shrink_count(void *user)
+{
+    (void)user;
+    if (!wallpaper || !kheap_owns(wallpaper))
+        return 0;
+    if (wallpaper_w < WALLPAPER_MIN_DIM * 2 || wallpaper_h < WALLPAPER_MIN_DIM * 2)
+        return 0;
+    return (size_t)wallpaper_w * wallpaper_h * sizeof(uint32_t) * 3 / 4;
+}
+
+static size_t wallpaper_shrink_scan(size_t want, void *user)
+{
+    size_t got = 0;
+    while (got < want && wallpaper_shrink_count(user))
+    {
+        uint32_t nw = wallpaper_w / 2, nh = wallpaper_h / 2;
+        // dst index never passes src index, so in-place is safe
+        for (uint32_t y = 0; y < nh; ++y)
+            for (uint32_t x = 0; x < nw; ++x)
+                wallpaper[y * nw + x] = wallpaper[(y * 2) * wallpaper_w + x * 2];
+        size_t old_bytes = (size_t)wallpaper_w * wallpaper_h * sizeof(uint32_t);
+        size_t new_bytes = (size_t)nw * nh * sizeof(uint32_t);
+        kshrink(wallpaper, new_bytes);
+        wallpaper_w = nw;
+        wallpaper_h = nh;
+        got += old_bytes - new_bytes;
+    }
+    if (got)
+        desktop_bg_dirty = 1;
+    return got;
+}
+
 void desktop_init(void)
 {
     g_item_count = 0;
     g_selection = -1;
     desktop_bg_dirty = 1;
     g_layout_valid = 0;
+
+    shrinker_register_gui("desktop-bg", bg_cache_shrink_count, bg_cache_shrink_scan, NULL, 10);
+    shrinker_register_gui("wallpaper", wallpaper_shrink_count, wallpaper_shrink_scan, NULL, 30);
 }
 
 void desktop_config_frame_rate(void)
@@ -230,9 +309,9 @@ int desktop_hit_test(int mx, int my)
 
 int desktop_is_double_click(int idx)
 {
-    uint64_t now = jiffies;
-    int dc = (idx == last_click_index) && ((now - last_click_tick) <= (uint64_t)double_click_threshold);
-    last_click_tick = now;
+    uint64_t now = ktime_ms();
+    int dc = (idx == last_click_index) && ((now - last_click_ms) <= (uint64_t)double_click_threshold);
+    last_click_ms = now;
     last_click_index = idx;
     return dc;
 }
@@ -254,6 +333,7 @@ int desktop_get_selection(void)
 void desktop_mark_dirty(void)
 {
     desktop_bg_dirty = 1;
+    gui_event_post(GUI_EV_DRAW);
 }
 
 int desktop_dirty(void)
@@ -426,6 +506,7 @@ static int load_bmp_into_bg(const uint8_t *file_buf, uint32_t file_size,
         }
     }
 
+    wp_free(wallpaper);
     wallpaper = pix;
     wallpaper_w = target_w;
     wallpaper_h = target_h;
@@ -476,11 +557,14 @@ int desktop_load_wallpaper(fat32_vol_t *vol, disk_read_fn rd, const char *name83
     if (fat32_read_file(vol, rd, name83, file_buf, file_size, &full_read) != 0 || full_read < file_size)
     {
         serial_printf("[WALLPAPER] full read failed (%u/%u)\n", full_read, file_size);
+        wp_free(file_buf);
         return -1;
     }
     serial_printf("[WALLPAPER] file read ok (%u bytes)\n", full_read);
 
-    return load_bmp_into_bg(file_buf, file_size, data_off, w, h, bpp, palette_colors);
+    int ret = load_bmp_into_bg(file_buf, file_size, data_off, w, h, bpp, palette_colors);
+    wp_free(file_buf);
+    return ret;
 }
 
 int desktop_load_wallpaper_path(fat32_vol_t *vol, disk_read_fn rd, const char *path)
@@ -508,9 +592,13 @@ int desktop_load_wallpaper_path(fat32_vol_t *vol, disk_read_fn rd, const char *p
 
     uint32_t full_read = 0;
     if (fat32_read_file_path(vol, rd, path, file_buf, file_size, &full_read) != 0 || full_read < file_size)
+    {
+        wp_free(file_buf);
         return -1;
+    }
 
     int ret = load_bmp_into_bg(file_buf, file_size, data_off, w, h, bpp, palette_colors);
+    wp_free(file_buf);
     return ret;
 }
 
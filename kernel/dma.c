@@ -0,0 +1,204 @@
+#include "dma.h"
+#include "mm/vmm.h"
+#include "serial.h"
+#include "string.h"
+#include "kheap.h"
+#include "spinlock.h"
+
+#define PAGE_SIZE 4096u
+
+void *pmm_alloc_contig(uint32_t pages);
+
+// Address-ordered block list covering the whole pool (free and used).
+typedef struct
+{
+    uint32_t off;
+    uint32_t size;
+    uint8_t used;
+} dma_blk_t;
+
+static dma_blk_t g_blk[DMA_MAX_BLOCKS];
+static int g_nblk = 0;
+static uint8_t *g_pool_va = NULL;
+static uint64_t g_pool_phys = 0;
+static size_t g_pool_size = 0;
+static size_t g_used = 0;
+// 블록 목록과 통계를 지킨다. 드라이버들이 여러 CPU에서 동시에 부른다.
+static spinlock_t g_dma_lock = SPINLOCK_INIT;
+
+static inline uint64_t align_up64(uint64_t v, uint64_t a)
+{
+    return (v + (a - 1)) & ~(a - 1);
+}
+
+static int blk_insert(int at, uint32_t off, uint32_t size, uint8_t used)
+{
+    if (g_nblk >= DMA_MAX_BLOCKS)
+        return -1;
+    for (int i = g_nblk; i > at; --i)
+        g_blk[i] = g_blk[i - 1];
+    g_blk[at].off = off;
+    g_blk[at].size = size;
+    g_blk[at].used = used;
+    g_nblk++;
+    return 0;
+}
+
+static void blk_remove(int at)
+{
+    for (int i = at; i + 1 < g_nblk; ++i)
+        g_blk[i] = g_blk[i + 1];
+    g_nblk--;
+}
+
+int dma_init(void)
+{
+    uint64_t fl = spin_lock_irqsave(&g_dma_lock);
+    if (g_pool_va)
+    {
+        spin_unlock_irqrestore(&g_dma_lock, fl);
+        return 0;
+    }
+
+    uint8_t *va = pmm_alloc_contig(DMA_POOL_SIZE / PAGE_SIZE);
+    if (!va)
+    {
+        spin_unlock_irqrestore(&g_dma_lock, fl);
+        serial_printf("[DMA] pool alloc failed (%u bytes)\n", DMA_POOL_SIZE);
+        return -1;
+    }
+
+    g_pool_phys = (uint64_t)((uintptr_t)va - vmm_hhdm_offset());
+    g_pool_size = DMA_POOL_SIZE;
+    g_nblk = 0;
+    blk_insert(0, 0, DMA_POOL_SIZE, 0);
+    g_used = 0;
+    g_pool_va = va;
+    spin_unlock_irqrestore(&g_dma_lock, fl);
+    spin_register(&g_dma_lock, "dma.pool");
+
+    serial_printf("[DMA] pool phys=0x%llx size=%u KB\n",
+                  (unsigned long long)g_pool_phys, DMA_POOL_SIZE / 1024u);
+    return 0;
+}
+
+void *dma_alloc_coherent(size_t size, size_t align, uint64_t max_phys, uint64_t *bus_out)
+{
+    if (size == 0 || size > DMA_POOL_SIZE)
+        return NULL;
+    if (!g_pool_va && dma_init() != 0)
+        return NULL;
+
+    if (align < DMA_MIN_ALIGN)
+        align = DMA_MIN_ALIGN;
+    if (align & (align - 1))
+        return NULL;
+    uint32_t sz = (uint32_t)align_up64(size, DMA_MIN_ALIGN);
+
+    uint64_t fl = spin_lock_irqsave(&g_dma_lock);
+    for (int i = 0; i < g_nblk; ++i)
+    {
+        dma_blk_t *b = &g_blk[i];
+        if (b->used)
+            continue;
+
+        uint64_t start = align_up64(g_pool_phys + b->off, align);
+        uint32_t pad = (uint32_t)(start - (g_pool_phys + b->off));
+        if ((uint64_t)pad + sz > b->size)
+            continue;
+        if (start + sz - 1 > max_phys)
+            break; // blocks are address-ordered: later ones are higher still
+
+        uint32_t tail = b->size - pad - sz;
+        // Worst case needs two extra slots (leading pad + trailing remainder)
+        if (g_nblk + (pad ? 1 : 0) + (tail ? 1 : 0) > DMA_MAX_BLOCKS)
+            break;
+
+        uint32_t off = b->off + pad;
+        if (pad)
+        {
+            b->size = pad;
+            blk_insert(++i, off, sz, 1);
+        }
+        else
+        {
+            b->size = sz;
+            b->used = 1;
+        }
+        if (tail)
+            blk_insert(i + 1, off + sz, tail, 0);
+
+        g_used += sz;
+        kmem_tag_charge(KMEM_TAG_DMA, sz);
+        spin_unlock_irqrestore(&g_dma_lock, fl);
+        // 블록은 이제 호출자 것이다: 큰 memset은 락 밖에서
+        void *va = g_pool_va + off;
+        memset(va, 0, sz);
+        if (bus_out)
+            *bus_out = g_pool_phys + off;
+        return va;
+    }
+
+    uint32_t used = (uint32_t)g_used;
+    spin_unlock_irqrestore(&g_dma_lock, fl);
+    serial_printf("[DMA] alloc failed size=%u align=%u max=0x%llx (used %u/%u)\n",
+                  (uint32_t)size, (uint32_t)align, (unsigned long long)max_phys,
+                  used, (uint32_t)g_pool_size);
+    return NULL;
+}
+
+void dma_free(void *va)
+{
+    if (!va || !g_pool_va)
+        return;
+    uintptr_t p = (uintptr_t)va;
+    if (p < (uintptr_t)g_pool_va || p >= (uintptr_t)g_pool_va + g_pool_size)
+    {
+        serial_printf("[DMA] free of foreign pointer %p\n", va);
+        return;
+    }
+
+    uint32_t off = (uint32_t)(p - (uintptr_t)g_pool_va);
+    uint64_t fl = spin_lock_irqsave(&g_dma_lock);
+    for (int i = 0; i < g_nblk; ++i)
+    {
+        if (g_blk[i].off != off)
+            continue;
+        if (!g_blk[i].used)
+        {
+            spin_unlock_irqrestore(&g_dma_lock, fl);
+            serial_printf("[DMA] double free %p\n", va);
+            return;
+        }
+        g_blk[i].used = 0;
+        g_used -= g_blk[i].size;
+        kmem_tag_uncharge(KMEM_TAG_DMA, g_blk[i].size);
+
+        // 인접한 빈 블록과 병합
+        if (i + 1 < g_nblk && !g_blk[i + 1].used)
+        {
+            g_blk[i].size += g_blk[i + 1].size;
+            blk_remove(i + 1);
+        }
+        if (i > 0 && !g_blk[i - 1].used)
+        {
+            g_blk[i - 1].size += g_blk[i].size;
+            blk_remove(i);
+        }
+        spin_unlock_irqrestore(&g_dma_lock, fl);
+        return;
+    }
+    spin_unlock_irqrestore(&g_dma_lock, fl);
+
+    serial_printf("[DMA] free of unknown block %p\n", va);
+}
+
+size_t dma_pool_size(void)
+{
+    return g_pool_size;
+}
+
+size_t dma_bytes_used(void)
+{
+    return g_used;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// DMA-coherent buffer allocator shared by bus-master drivers
+// (AC'97, IDE bus-master, AHCI, virtio, ...).
+// - Backed by one physically contiguous pool carved out at first use.
+// - Every buffer is physically contiguous and returned with its bus address.
+// - max_phys limits the last byte's bus address (e.g. DMA_BIT_MASK(32)).
+// - x86 PCI DMA snoops the caches, so WB memory is coherent as-is.
+
+#define DMA_BIT_MASK(n) (((n) >= 64) ? ~0ull : ((1ull << (n)) - 1))
+
+#define DMA_POOL_SIZE  (8u * 1024u * 1024u)
+#define DMA_MIN_ALIGN  64u
+#define DMA_MAX_BLOCKS 64
+
+int   dma_init(void);
+void *dma_alloc_coherent(size_t size, size_t align, uint64_t max_phys, uint64_t *bus_out);
+void  dma_free(void *va);
+
+// Statistics (bytes)
+size_t dma_pool_size(void);
+size_t dma_bytes_used(void);
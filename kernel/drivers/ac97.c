@@ -7,6 +7,8 @@
 #include "string.h"
 #include "io.h"
 #include "sys/cpu.h"
+#include "dma.h"
+#include "ktimer.h"
 
 extern void *kmalloc(size_t sz);
 extern void *ext_mem_alloc(size_t sz);
@@ -58,8 +60,6 @@ static uint8_t g_ready = 0;
 static uint32_t g_pcm_bytes_alloc = 0;
 static uint32_t g_pcm_phys = 0;
 static uint32_t g_bd_phys = 0;
-void *pmm_alloc(void);
-void *pmm_alloc_contig(uint32_t pages);
 
 static void outw_offset(uint16_t base, uint16_t off, uint16_t v) { outw(base + off, v); }
 static uint16_t inw_offset(uint16_t base, uint16_t off) { return inw(base + off); }
@@ -72,31 +72,34 @@ static void ac97_hw_reset(void)
     outl(g_nabm + AC97_GLOB_CNT, 0x00000002);
 
     // 짧은 딜레이 (QEMU에서도 중요)
-    for (volatile int i = 0; i < 100000; ++i)
-        (void)inw_offset(g_nam, AC97_MASTER_VOL);
+    msleep(100);
 
     // 2. NAM reset (mixer reset)
     outw_offset(g_nam, 0x00, 0x0000);
 
-    for (volatile int i = 0; i < 100000; ++i)
-        (void)inw_offset(g_nam, AC97_MASTER_VOL);
+    msleep(100);
 }
 
-static int alloc_phys_block(uint32_t bytes, uint32_t *phys_out, void **va_out)
+// ICH bus master takes 32-bit descriptor/buffer addresses only.
+static int alloc_phys_block(uint32_t bytes, uint32_t align, uint32_t *phys_out, void **va_out)
 {
-    uint32_t pages = (bytes + PAGE_SIZE - 1) / PAGE_SIZE;
-    if (pages == 0) pages = 1;
-
-    uint8_t *first = (uint8_t *)pmm_alloc_contig(pages);
-    if (!first)
+    uint64_t bus = 0;
+    void *va = dma_alloc_coherent(bytes, align, DMA_BIT_MASK(32), &bus);
+    if (!va)
         return -1;
 
-    uintptr_t hhdm = vmm_hhdm_offset();
-    *phys_out = (uint32_t)((uintptr_t)first - hhdm);
-    *va_out = first;
+    *phys_out = (uint32_t)bus;
+    *va_out = va;
     return 0;
 }
 
+static void ac97_stop_dma(void)
+{
+    outb_offset(g_nabm, CR_PCM_OUT, 0);
+    outb_offset(g_nabm, CR_PCM_OUT, CR_RR);
+    while (inb_offset(g_nabm, CR_PCM_OUT) & CR_RR);
+}
+
 
 static void ac97_powerup(void)
 {
@@ -115,6 +118,12 @@ int ac97_is_ready(void)
     return g_ready;
 }
 
+void ac97_stop(void)
+{
+    if (g_ready)
+        ac97_stop_dma();
+}
+
 int ac97_init(void)
 {
     uint8_t bus, slot, func;
@@ -155,7 +164,7 @@ int ac97_init(void)
     outw_offset(g_nam, AC97_PCM_OUT_VOL, 0x0000);
 
     // BD 테이블 할당
-    if (alloc_phys_block(sizeof(ac97_bd_t) * BD_ENTRY_COUNT,
+    if (alloc_phys_block(sizeof(ac97_bd_t) * BD_ENTRY_COUNT, 8,
                           &g_bd_phys, (void **)&g_bd) != 0)
         return -1;
 
@@ -174,12 +183,27 @@ int ac97_init(void)
 }
 
 
+uint32_t ac97_max_frames(uint8_t channels)
+{
+    if (channels != 1 && channels != 2)
+        return 0;
+    return BD_ENTRY_COUNT * (0xFFFEu / channels);
+}
+
 int ac97_play_pcm(const uint16_t *pcm, uint32_t frames,
                   uint32_t rate_hz, uint8_t channels)
 {
     if (!g_ready || !pcm || frames == 0 || (channels != 1 && channels != 2))
         return -1;
 
+    // BD 링이 담을 수 있는 만큼만 버퍼를 잡고 복사한다 (나머지는 어차피 안 나간다)
+    uint32_t max_frames = ac97_max_frames(channels);
+    if (frames > max_frames)
+    {
+        serial_printf("[AC97] clip truncated: %u -> %u frames\n", frames, max_frames);
+        frames = max_frames;
+    }
+
     // Variable Rate Audio enable
     outw_offset(g_nam, 0x2A, 0x0001);
 
@@ -192,7 +216,15 @@ int ac97_play_pcm(const uint16_t *pcm, uint32_t frames,
 
     if (!g_pcm_buf || need > g_pcm_bytes_alloc)
     {
-        if (alloc_phys_block(need, &g_pcm_phys, (void **)&g_pcm_buf) != 0)
+        // 이전 버퍼는 DMA를 멈춘 뒤 풀에 반환하고 더 큰 버퍼로 교체
+        if (g_pcm_buf)
+        {
+            ac97_stop_dma();
+            dma_free(g_pcm_buf);
+            g_pcm_buf = 0;
+            g_pcm_bytes_alloc = 0;
+        }
+        if (alloc_phys_block(need, PAGE_SIZE, &g_pcm_phys, (void **)&g_pcm_buf) != 0)
             return -1;
         g_pcm_bytes_alloc = need;
     }
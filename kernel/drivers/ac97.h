@@ -6,4 +6,8 @@
 
 int ac97_init(void);
 int ac97_play_pcm(const uint16_t *pcm, uint32_t frames, uint32_t rate_hz, uint8_t channels);
+// Longest clip one ac97_play_pcm() call can queue (32 BDs); longer ones are cut.
+uint32_t ac97_max_frames(uint8_t channels);
 int ac97_is_ready(void);
+// Stop PCM OUT DMA (cancel the clip started by ac97_play_pcm).
+void ac97_stop(void);
@@ -6,8 +6,7 @@
 #include "bootinfo.h"
 #include <mm/vmm.h>
 #include <mm/pmm.h> 
-
-extern void *kmalloc(size_t sz);
+#include "kheap.h"
 
 static size_t g_back_pages = 0;
 
@@ -80,7 +79,7 @@ int fb_map(uint64_t phys, uint32_t w, uint32_t h, uint32_t pitch, uint32_t bpp)
     //------------------------------------------------------------------
     // 1) 백버퍼 확보: 먼저 커널 힙(kmalloc), 안 되면 ext_mem_alloc + HHDM
     //------------------------------------------------------------------
-    void *back = kmalloc(sz);
+    void *back = kmalloc_tag(sz, KMEM_TAG_FB);
     if (!back) {
         serial_printf("[fb_map] kmalloc(%u) failed, trying ext_mem_alloc\n",
                       (uint32_t)sz);
@@ -88,6 +87,7 @@ int fb_map(uint64_t phys, uint32_t w, uint32_t h, uint32_t pitch, uint32_t bpp)
         void *back_phys = ext_mem_alloc(sz);
         if (back_phys) {
             back = (void *)((uintptr_t)back_phys + hhdm);
+            kmem_tag_charge(KMEM_TAG_FB, sz);
             serial_printf("[fb_map] ext_mem_alloc back_phys=%p -> back_va=%p\n",
                           back_phys, back);
         }
@@ -1,15 +1,23 @@
 #include "fs_fat32.h"
 #include <string.h>
 #include "serial.h"
+#include "task/sync.h"
 
 #define MAX_SECTOR_SIZE 4096
 
+// 볼륨 락: 공개 함수는 모두 이것을 잡고 *_locked 본체를 부른다. FAT/비트맵과
+// 디렉터리 갱신, 정적 섹터 버퍼가 잠금 없이 만들어져 있어서 GUI 스레드, fs_wq,
+// uring(SQPOLL 포함)이 동시에 부르면 서로 덮어쓴다. ATA 락은 섹터 단위만 지킨다.
+static mutex_t g_fat_lock = MUTEX_INIT;
+
 // forward declarations for helpers used by exFAT helpers
 static const char *skip_drive_prefix(const char *path);
 static int get_component(const char **ppath, char *out, int outsz);
 static int path_has_more(const char *p);
 static int read_file_from_cluster(fat32_vol_t *v, disk_read_fn rd, uint32_t start_clus,
                                   uint32_t file_size, void *out, uint32_t max_bytes, uint32_t *out_bytes);
+static int fat32_read_file_path_locked(fat32_vol_t *vol, disk_read_fn rd, const char *path,
+                                       void *out, uint32_t max_bytes, uint32_t *out_bytes);
 
 typedef struct __attribute__((packed)) {
     uint8_t  jmp[3];
@@ -119,7 +127,7 @@ static int match_name11(const char *ent11, const char *want11)
     return 1;
 }
 
-int fat32_mount(fat32_vol_t* v, disk_read_fn rd, uint32_t part_lba_start)
+static int fat32_mount_locked(fat32_vol_t* v, disk_read_fn rd, uint32_t part_lba_start)
 {
     if (!v || !rd) return -1;
     uint8_t sec[512];
@@ -889,15 +897,16 @@ static int exfat_follow_path(fat32_vol_t *v, disk_read_fn rd, const char *path,
     return 0;
 }
 
-static int exfat_read_file_path(fat32_vol_t* v, disk_read_fn rd, const char* path,
-                                void* out, uint32_t max_bytes, uint32_t* out_bytes)
+static int exfat_lookup_file(fat32_vol_t* v, disk_read_fn rd, const char* path,
+                             uint32_t* out_clus, uint32_t* out_size)
 {
     exfat_entry_info_t info;
     int r = exfat_follow_path(v, rd, path, NULL, &info);
     if (r != 0) return r;
     if (info.is_dir) return -4;
-    uint32_t size32 = (info.size > 0xFFFFFFFFu) ? 0xFFFFFFFFu : (uint32_t)info.size;
-    return read_file_from_cluster(v, rd, info.cluster, size32, out, max_bytes, out_bytes);
+    *out_clus = info.cluster;
+    *out_size = (info.size > 0xFFFFFFFFu) ? 0xFFFFFFFFu : (uint32_t)info.size;
+    return 0;
 }
 
 static int exfat_write_file_path(fat32_vol_t* v, disk_read_fn rd, disk_write_fn wr,
@@ -1065,8 +1074,8 @@ static void make_name83(char out11[11], const char* name83)
     int k=0; while (name83[j] && k<3) { char c=name83[j++]; if(c>='a'&&c<='z') c-=32; out11[8+k]=c; k++; }
 }
 
-int fat32_create_file_root(fat32_vol_t* v, disk_read_fn rd, disk_write_fn wr,
-                           const char* name83, const void* data, uint32_t bytes)
+static int fat32_create_file_root_locked(fat32_vol_t* v, disk_read_fn rd, disk_write_fn wr,
+                                         const char* name83, const void* data, uint32_t bytes)
 {
     if (!v || !rd || !wr || !name83) return -1;
     // allocate one cluster
@@ -1130,8 +1139,8 @@ int fat32_create_file_root(fat32_vol_t* v, disk_read_fn rd, disk_write_fn wr,
     return -6; // no free dir entry (not extending root)
 }
 
-int fat32_write_file_root(fat32_vol_t* v, disk_read_fn rd, disk_write_fn wr,
-                          const char* name83, const void* data, uint32_t bytes)
+static int fat32_write_file_root_locked(fat32_vol_t* v, disk_read_fn rd, disk_write_fn wr,
+                                        const char* name83, const void* data, uint32_t bytes)
 {
     if (!v || !rd || !wr || !name83) return -1;
 
@@ -1172,7 +1181,7 @@ int fat32_write_file_root(fat32_vol_t* v, disk_read_fn rd, disk_write_fn wr,
     }
 
 create_new:
-    return fat32_create_file_root(v, rd, wr, name83, data, bytes);
+    return fat32_create_file_root_locked(v, rd, wr, name83, data, bytes);
 
 have_cluster:
     if (target_cl == 0)
@@ -1218,7 +1227,7 @@ have_cluster:
     return 0;
 }
 
-int fat32_list_root(fat32_vol_t* v, disk_read_fn rd)
+static int fat32_list_root_locked(fat32_vol_t* v, disk_read_fn rd)
 {
     if (!v || !rd) return -1;
     if (v->fs_type == FAT_FS_EXFAT)
@@ -1276,11 +1285,11 @@ static int match_name83(const char* ent11, const char* q)
     return memcmp(ent11, want, 11) == 0;
 }
 
-int fat32_read_file(fat32_vol_t* v, disk_read_fn rd, const char* name83,
-                    void* out, uint32_t max_bytes, uint32_t* out_bytes)
+static int fat32_read_file_locked(fat32_vol_t* v, disk_read_fn rd, const char* name83,
+                                  void* out, uint32_t max_bytes, uint32_t* out_bytes)
 {
     if (v && v->fs_type == FAT_FS_EXFAT)
-        return fat32_read_file_path(v, rd, name83, out, max_bytes, out_bytes);
+        return fat32_read_file_path_locked(v, rd, name83, out, max_bytes, out_bytes);
     if (out_bytes) *out_bytes = 0;
     if (!v || !rd || !name83 || !out) return -1;
     uint32_t cl = v->root_clus;
@@ -1335,8 +1344,8 @@ found_done:
     return 0;
 }
 
-int fat32_list_root_array(fat32_vol_t* v, disk_read_fn rd,
-                          fat32_dirent_t* out, int max_items, int* out_count)
+static int fat32_list_root_array_locked(fat32_vol_t* v, disk_read_fn rd,
+                                        fat32_dirent_t* out, int max_items, int* out_count)
 {
     if (v && v->fs_type == FAT_FS_EXFAT)
         return exfat_list_dir(v, rd, v->root_clus, out, max_items, out_count);
@@ -1590,8 +1599,8 @@ static int ensure_directory(fat32_vol_t *v, disk_read_fn rd, disk_write_fn wr,
     return 0;
 }
 
-int fat32_ensure_dir_path(fat32_vol_t *vol, disk_read_fn rd, disk_write_fn wr,
-                          const char *path)
+static int fat32_ensure_dir_path_locked(fat32_vol_t *vol, disk_read_fn rd, disk_write_fn wr,
+                                        const char *path)
 {
     if (vol && vol->fs_type == FAT_FS_EXFAT)
         return exfat_ensure_dir_path(vol, rd, wr, path);
@@ -1617,15 +1626,12 @@ int fat32_ensure_dir_path(fat32_vol_t *vol, disk_read_fn rd, disk_write_fn wr,
     return 0;
 }
 
-int fat32_read_file_path(fat32_vol_t *vol, disk_read_fn rd, const char *path,
-                         void *out, uint32_t max_bytes, uint32_t *out_bytes)
+// Resolve a file path to its first cluster and size (FAT32 or exFAT).
+static int lookup_file_path(fat32_vol_t *vol, disk_read_fn rd, const char *path,
+                            uint32_t *out_clus, uint32_t *out_size)
 {
-    if (vol && vol->fs_type == FAT_FS_EXFAT)
-        return exfat_read_file_path(vol, rd, path, out, max_bytes, out_bytes);
-    if (out_bytes)
-        *out_bytes = 0;
-    if (!vol || !rd || !path || !out)
-        return -1;
+    if (vol->fs_type == FAT_FS_EXFAT)
+        return exfat_lookup_file(vol, rd, path, out_clus, out_size);
 
     const char *p = skip_drive_prefix(path);
     uint32_t dir_cl = vol->root_clus;
@@ -1652,14 +1658,127 @@ int fat32_read_file_path(fat32_vol_t *vol, disk_read_fn rd, const char *path,
         {
             if (de.attr & ATTR_DIR)
                 return -4;
-            return read_file_from_cluster(vol, rd, cl, de.file_size, out, max_bytes, out_bytes);
+            *out_clus = cl;
+            *out_size = de.file_size;
+            return 0;
         }
     }
     return -5;
 }
 
-int fat32_write_file_path(fat32_vol_t *vol, disk_read_fn rd, disk_write_fn wr,
-                          const char *path, const void *data, uint32_t bytes)
+static int fat32_read_file_path_locked(fat32_vol_t *vol, disk_read_fn rd, const char *path,
+                                       void *out, uint32_t max_bytes, uint32_t *out_bytes)
+{
+    if (out_bytes)
+        *out_bytes = 0;
+    if (!vol || !rd || !path || !out)
+        return -1;
+
+    uint32_t cl, size;
+    int r = lookup_file_path(vol, rd, path, &cl, &size);
+    if (r != 0)
+        return r;
+    return read_file_from_cluster(vol, rd, cl, size, out, max_bytes, out_bytes);
+}
+
+static int fat32_open_path_locked(fat32_vol_t *vol, disk_read_fn rd, const char *path, fat32_file_t *f)
+{
+    if (!vol || !rd || !path || !f)
+        return -1;
+    uint32_t cl, size;
+    int r = lookup_file_path(vol, rd, path, &cl, &size);
+    if (r != 0)
+        return r;
+    f->first_clus = cl;
+    f->size = size;
+    f->cur_idx = 0;
+    f->cur_clus = cl;
+    return 0;
+}
+
+static int fat32_read_at_locked(fat32_vol_t *vol, disk_read_fn rd, fat32_file_t *f, uint32_t off,
+                                void *out, uint32_t len, uint32_t *out_bytes)
+{
+    if (out_bytes)
+        *out_bytes = 0;
+    if (!vol || !rd || !f || !out)
+        return -1;
+    if (off >= f->size || len == 0)
+        return 0;
+    if (len > f->size - off)
+        len = f->size - off;
+
+    uint32_t bps = vol->bytes_per_sec;
+    uint32_t bpc = bps * vol->sec_per_clus;
+    uint32_t idx = off / bpc;
+
+    // 커서가 목표 클러스터 앞에 있으면 거기서부터, 아니면 처음부터 체인을 따라간다
+    if (!f->cur_clus || f->cur_idx > idx)
+    {
+        f->cur_idx = 0;
+        f->cur_clus = f->first_clus;
+    }
+    while (f->cur_idx < idx)
+    {
+        if (is_end_cluster(f->cur_clus) || f->cur_clus < 2)
+            return -2;
+        f->cur_clus = fat_read_fat_entry(vol, rd, f->cur_clus);
+        f->cur_idx++;
+    }
+
+    uint8_t *dst = (uint8_t *)out;
+    uint32_t left = len;
+    uint32_t in_clus = off % bpc;
+    uint8_t sec[MAX_SECTOR_SIZE];
+    while (left > 0)
+    {
+        if (is_end_cluster(f->cur_clus) || f->cur_clus < 2)
+            return -2;
+        uint32_t lba = clus_to_lba(vol, f->cur_clus);
+        uint32_t s = in_clus / bps;
+        uint32_t s_off = in_clus % bps;
+        while (left > 0 && s < vol->sec_per_clus)
+        {
+            if (s_off == 0 && left >= bps)
+            {
+                // 섹터 단위로 맞으면 버퍼를 거치지 않고 한 번에 읽는다
+                uint32_t n = left / bps;
+                if (n > vol->sec_per_clus - s)
+                    n = vol->sec_per_clus - s;
+                if (n > 255)
+                    n = 255;
+                if (rd(lba + s, (uint8_t)n, dst))
+                    return -3;
+                dst += n * bps;
+                left -= n * bps;
+                s += n;
+                continue;
+            }
+            if (rd(lba + s, 1, sec))
+                return -3;
+            uint32_t take = bps - s_off;
+            if (take > left)
+                take = left;
+            memcpy(dst, sec + s_off, take);
+            dst += take;
+            left -= take;
+            s_off = 0;
+            s++;
+        }
+        in_clus = 0;
+        if (left > 0)
+        {
+            f->cur_clus = fat_read_fat_entry(vol, rd, f->cur_clus);
+            f->cur_idx++;
+        }
+    }
+    if (out_bytes)
+        *out_bytes = len;
+    return 0;
+}
+
+static int fat32_write_file_path_locked(fat32_vol_t *vol, disk_read_fn rd, disk_write_fn wr,
+                                        const char *path, const void *data, uint32_t bytes)
 {
     if (vol && vol->fs_type == FAT_FS_EXFAT)
         return exfat_write_file_path(vol, rd, wr, path, data, bytes);
@@ -1741,8 +1860,8 @@ int fat32_write_file_path(fat32_vol_t *vol, disk_read_fn rd, disk_write_fn wr,
     return -10;
 }
 
-int fat32_list_dir_path(fat32_vol_t *vol, disk_read_fn rd, const char *path,
-                        fat32_dirent_t *out, int max_items, int *out_count)
+static int fat32_list_dir_path_locked(fat32_vol_t *vol, disk_read_fn rd, const char *path,
+                                      fat32_dirent_t *out, int max_items, int *out_count)
 {
     if (vol && vol->fs_type == FAT_FS_EXFAT)
         return exfat_list_dir_path(vol, rd, path, out, max_items, out_count);
@@ -1843,3 +1962,110 @@ done_list:
         *out_count = n;
     return 0;
 }
+
+/* --------- locked entry points --------- */
+
+int fat32_mount(fat32_vol_t* v, disk_read_fn rd, uint32_t part_lba_start)
+{
+    mutex_lock(&g_fat_lock);
+    int r = fat32_mount_locked(v, rd, part_lba_start);
+    mutex_unlock(&g_fat_lock);
+    return r;
+}
+
+int fat32_create_file_root(fat32_vol_t* v, disk_read_fn rd, disk_write_fn wr,
+                           const char* name83, const void* data, uint32_t bytes)
+{
+    mutex_lock(&g_fat_lock);
+    int r = fat32_create_file_root_locked(v, rd, wr, name83, data, bytes);
+    mutex_unlock(&g_fat_lock);
+    return r;
+}
+
+int fat32_write_file_root(fat32_vol_t* v, disk_read_fn rd, disk_write_fn wr,
+                          const char* name83, const void* data, uint32_t bytes)
+{
+    mutex_lock(&g_fat_lock);
+    int r = fat32_write_file_root_locked(v, rd, wr, name83, data, bytes);
+    mutex_unlock(&g_fat_lock);
+    return r;
+}
+
+int fat32_list_root(fat32_vol_t* v, disk_read_fn rd)
+{
+    mutex_lock(&g_fat_lock);
+    int r = fat32_list_root_locked(v, rd);
+    mutex_unlock(&g_fat_lock);
+    return r;
+}
+
+int fat32_read_file(fat32_vol_t* v, disk_read_fn rd, const char* name83,
+                    void* out, uint32_t max_bytes, uint32_t* out_bytes)
+{
+    mutex_lock(&g_fat_lock);
+    int r = fat32_read_file_locked(v, rd, name83, out, max_bytes, out_bytes);
+    mutex_unlock(&g_fat_lock);
+    return r;
+}
+
+int fat32_list_root_array(fat32_vol_t* v, disk_read_fn rd,
+                          fat32_dirent_t* out, int max_items, int* out_count)
+{
+    mutex_lock(&g_fat_lock);
+    int r = fat32_list_root_array_locked(v, rd, out, max_items, out_count);
+    mutex_unlock(&g_fat_lock);
+    return r;
+}
+
+int fat32_ensure_dir_path(fat32_vol_t *vol, disk_read_fn rd, disk_write_fn wr,
+                          const char *path)
+{
+    mutex_lock(&g_fat_lock);
+    int r = fat32_ensure_dir_path_locked(vol, rd, wr, path);
+    mutex_unlock(&g_fat_lock);
+    return r;
+}
+
+int fat32_read_file_path(fat32_vol_t *vol, disk_read_fn rd, const char *path,
+                         void *out, uint32_t max_bytes, uint32_t *out_bytes)
+{
+    mutex_lock(&g_fat_lock);
+    int r = fat32_read_file_path_locked(vol, rd, path, out, max_bytes, out_bytes);
+    mutex_unlock(&g_fat_lock);
+    return r;
+}
+
+int fat32_open_path(fat32_vol_t *vol, disk_read_fn rd, const char *path, fat32_file_t *f)
+{
+    mutex_lock(&g_fat_lock);
+    int r = fat32_open_path_locked(vol, rd, path, f);
+    mutex_unlock(&g_fat_lock);
+    return r;
+}
+
+int fat32_read_at(fat32_vol_t *vol, disk_read_fn rd, fat32_file_t *f, uint32_t off,
+                  void *out, uint32_t len, uint32_t *out_bytes)
+{
+    mutex_lock(&g_fat_lock);
+    int r = fat32_read_at_locked(vol, rd, f, off, out, len, out_bytes);
+    mutex_unlock(&g_fat_lock);
+    return r;
+}
+
+int fat32_write_file_path(fat32_vol_t *vol, disk_read_fn rd, disk_write_fn wr,
+                          const char *path, const void *data, uint32_t bytes)
+{
+    mutex_lock(&g_fat_lock);
+    int r = fat32_write_file_path_locked(vol, rd, wr, path, data, bytes);
+    mutex_unlock(&g_fat_lock);
+    return r;
+}
+
+int fat32_list_dir_path(fat32_vol_t *vol, disk_read_fn rd, const char *path,
+                        fat32_dirent_t *out, int max_items, int *out_count)
+{
+    mutex_lock(&g_fat_lock);
+    int r = fat32_list_dir_path_locked(vol, rd, path, out, max_items, out_count);
+    mutex_unlock(&g_fat_lock);
+    return r;
+}
@@ -56,6 +56,19 @@ int fat32_list_root_array(fat32_vol_t* vol, disk_read_fn rd,
 // Basic path-aware helpers (8.3 components, '/' separated, uppercase-insensitive).
 int fat32_read_file_path(fat32_vol_t* vol, disk_read_fn rd, const char* path,
                          void* out, uint32_t max_bytes, uint32_t* out_bytes);
+// Random-access reads (exec demand paging). The handle remembers the last
+// cluster visited so forward reads do not rewalk the chain from the start.
+typedef struct {
+    uint32_t first_clus;
+    uint32_t size;
+    uint32_t cur_idx;     // index of cur_clus in the chain
+    uint32_t cur_clus;
+} fat32_file_t;
+
+int fat32_open_path(fat32_vol_t* vol, disk_read_fn rd, const char* path, fat32_file_t* f);
+// Reads up to len bytes at off; *out_bytes is short at end of file.
+int fat32_read_at(fat32_vol_t* vol, disk_read_fn rd, fat32_file_t* f, uint32_t off,
+                  void* out, uint32_t len, uint32_t* out_bytes);
 int fat32_write_file_path(fat32_vol_t* vol, disk_read_fn rd, disk_write_fn wr,
                           const char* path, const void* data, uint32_t bytes);
 int fat32_list_dir_path(fat32_vol_t* vol, disk_read_fn rd, const char* path,
@@ -21,26 +21,18 @@ static uint64_t make_data_desc(void) {
     return 0x00AF92000000FFFFULL;
 }
 
-/* TSS 디스크립터 (16바이트) */
-struct tss_descriptor {
-    uint16_t limit_low;
-    uint16_t base_low;
-    uint8_t  base_mid1;
-    uint8_t  type;       // 0x89: 64-bit available TSS
-    uint8_t  limit_high  : 4;
-    uint8_t  flags       : 4;
-    uint8_t  base_mid2;
-    uint32_t base_high;
-    uint32_t reserved;
-} __attribute__((packed));
-
-/* GDT 전체 – 0:null, 1:code, 2:data, 3:TSS(16B) */
-static struct {
-    uint64_t        null;
-    uint64_t        code;
-    uint64_t        data;
-    struct tss_descriptor tss_desc;
-} __attribute__((packed)) gdt;
+static uint64_t make_user_code64_desc(void) {
+    /* DPL=3 64비트 코드 */
+    return 0x00AFFA000000FFFFULL;
+}
+
+static uint64_t make_user_data_desc(void) {
+    /* DPL=3 데이터 */
+    return 0x00AFF2000000FFFFULL;
+}
+
+/* BSP용 GDT */
+static gdt_table_t gdt;
 
 /* 전역 TSS 객체 */
 struct tss64 g_tss;
@@ -68,32 +60,39 @@ static void set_tss_descriptor(struct tss_descriptor *d, struct tss64 *tss) {
     d->reserved    = 0;
 }
 
-void gdt_init(uint64_t kernel_stack_top) {
+void gdt_init_cpu(gdt_table_t *g, struct gdtr *gdtr,
+                  struct tss64 *tss, uint64_t kernel_stack_top) {
     /* GDT 엔트리 설정 */
-    gdt.null = 0;
-    gdt.code = make_code64_desc();
-    gdt.data = make_data_desc();
+    g->null  = 0;
+    g->code  = make_code64_desc();
+    g->data  = make_data_desc();
+    g->udata = make_user_data_desc();
+    g->ucode = make_user_code64_desc();
 
     /* TSS 초기화 */
-    for (unsigned i = 0; i < sizeof(g_tss); i++)
-        ((uint8_t *)&g_tss)[i] = 0;
+    for (unsigned i = 0; i < sizeof(*tss); i++)
+        ((uint8_t *)tss)[i] = 0;
 
-    g_tss.rsp0 = kernel_stack_top;
-    g_tss.iopb_offset = sizeof(struct tss64);
+    tss->rsp0 = kernel_stack_top;
+    tss->iopb_offset = sizeof(struct tss64);
 
-    set_tss_descriptor(&gdt.tss_desc, &g_tss);
+    set_tss_descriptor(&g->tss_desc, tss);
 
     /* GDTR 설정 */
-    gdt_reg.limit = sizeof(gdt) - 1;
-    gdt_reg.base  = (uint64_t)&gdt;
+    gdtr->limit = sizeof(*g) - 1;
+    gdtr->base  = (uint64_t)g;
 
     /* GDT 로드 + 세그먼트 재설정 */
-    gdt_flush(&gdt_reg);
+    gdt_flush(gdtr);
 
     /* TSS 로드 */
     tss_flush(GDT_SEL_TSS);
 }
 
+void gdt_init(uint64_t kernel_stack_top) {
+    gdt_init_cpu(&gdt, &gdt_reg, &g_tss, kernel_stack_top);
+}
+
 /* Double Fault용 IST 스택 설정 (IST1 사용) */
 void tss_set_df_ist(uint64_t ist_stack_top) {
     g_tss.ist1 = ist_stack_top;
@@ -7,11 +7,16 @@
 #define GDT_IDX_NULL         0
 #define GDT_IDX_KERNEL_CODE  1
 #define GDT_IDX_KERNEL_DATA  2
-#define GDT_IDX_TSS          3   // TSS descriptor (16 bytes: index 3 and 4 사용)
+/* SYSRET은 STAR[63:48]+8 을 SS, +16 을 CS로 쓰므로 유저 data가 code 앞에 온다 */
+#define GDT_IDX_USER_DATA    3
+#define GDT_IDX_USER_CODE    4
+#define GDT_IDX_TSS          5   // TSS descriptor (16 bytes: index 5 and 6 사용)
 
-/* 셀렉터 = 인덱스 << 3 */
+/* 셀렉터 = 인덱스 << 3 (유저 셀렉터는 RPL=3) */
 #define GDT_SEL_KERNEL_CODE  (GDT_IDX_KERNEL_CODE << 3)
 #define GDT_SEL_KERNEL_DATA  (GDT_IDX_KERNEL_DATA << 3)
+#define GDT_SEL_USER_DATA    ((GDT_IDX_USER_DATA << 3) | 3)   // 0x1B
+#define GDT_SEL_USER_CODE    ((GDT_IDX_USER_CODE << 3) | 3)   // 0x23
 #define GDT_SEL_TSS          (GDT_IDX_TSS         << 3)
 
 /* 기존 df_tss.c 와의 호환용 이름 */
@@ -45,9 +50,36 @@ struct tss64 {
     uint16_t iopb_offset;
 } __attribute__((packed));
 
-/* 전역 TSS 객체 (gdt.c 에서 정의) */
+/* TSS 디스크립터 (16바이트) */
+struct tss_descriptor {
+    uint16_t limit_low;
+    uint16_t base_low;
+    uint8_t  base_mid1;
+    uint8_t  type;       // 0x89: 64-bit available TSS
+    uint8_t  limit_high  : 4;
+    uint8_t  flags       : 4;
+    uint8_t  base_mid2;
+    uint32_t base_high;
+    uint32_t reserved;
+} __attribute__((packed));
+
+/* GDT 전체 – 0:null, 1:kcode, 2:kdata, 3:udata, 4:ucode, 5:TSS(16B).
+   SMP에서는 CPU마다 하나씩 갖는다 (TSS가 busy 상태가 되므로 공유 불가). */
+typedef struct {
+    uint64_t        null;
+    uint64_t        code;
+    uint64_t        data;
+    uint64_t        udata;
+    uint64_t        ucode;
+    struct tss_descriptor tss_desc;
+} __attribute__((packed)) gdt_table_t;
+
+/* 전역 TSS 객체 (gdt.c 에서 정의, BSP용) */
 extern struct tss64 g_tss;
 
 /* 초기화 함수들 */
 void gdt_init(uint64_t kernel_stack_top);
+/* 주어진 GDT/TSS를 채우고 현재 CPU에 로드 (lgdt + ltr) */
+void gdt_init_cpu(gdt_table_t *gdt, struct gdtr *gdtr,
+                  struct tss64 *tss, uint64_t kernel_stack_top);
 void tss_set_df_ist(uint64_t ist_stack_top);
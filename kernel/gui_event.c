@@ -0,0 +1,115 @@
+#include "gui_event.h"
+#include "clock.h"
+#include "serial.h"
+#include "spinlock.h"
+#include "task/sync.h"
+
+static volatile uint32_t g_pending;
+static wait_queue_t      g_gui_wq = WAIT_QUEUE_INIT;
+static uint32_t          g_wakes[GUI_EV_COUNT];
+static uint32_t          g_waits;
+static uint32_t          g_no_sleep;    // 부를 때 이미 이유가 있었다
+static uint64_t          g_sleep_ns;
+
+static spinlock_t    g_job_lock = SPINLOCK_INIT;
+static gui_job_t    *g_done_head, *g_done_tail;   // GUI가 done()을 부를 것
+static volatile int  g_jobs_busy;
+static uint32_t      g_jobs_run;
+
+void gui_event_post(uint32_t bits)
+{
+    // 이미 이유가 쌓여 있으면 누군가 깨웠거나 GUI가 아직 꺼내지 않았다
+    if (!__atomic_fetch_or(&g_pending, bits, __ATOMIC_ACQ_REL))
+        wq_wake_one(&g_gui_wq);
+}
+
+static int gui_has_event(void *arg)
+{
+    (void)arg;
+    return __atomic_load_n(&g_pending, __ATOMIC_ACQUIRE) != 0;
+}
+
+uint32_t gui_event_wait(uint64_t timeout_ms)
+{
+    g_waits++;
+    if (gui_has_event(NULL))
+        g_no_sleep++;
+    else if (timeout_ms)
+    {
+        uint64_t t0 = ktime_ns();
+        wq_wait_cond(&g_gui_wq, gui_has_event, NULL, timeout_ms);
+        g_sleep_ns += ktime_ns() - t0;
+    }
+    uint32_t bits = __atomic_exchange_n(&g_pending, 0u, __ATOMIC_ACQ_REL);
+    if (!bits)
+        bits = GUI_EV_TIMER;
+    for (uint32_t i = 0; i < GUI_EV_COUNT; ++i)
+        if (bits & (1u << i))
+            g_wakes[i]++;
+    return bits;
+}
+
+/* --------- background jobs --------- */
+
+static void gui_job_work(work_t *w)
+{
+    gui_job_t *j = container_of(w, gui_job_t, work);
+    j->run(j);
+
+    j->next = NULL;
+    uint64_t fl = spin_lock_irqsave(&g_job_lock);
+    g_jobs_run++;
+    if (g_done_tail)
+        g_done_tail->next = j;
+    else
+        g_done_head = j;
+    g_done_tail = j;
+    spin_unlock_irqrestore(&g_job_lock, fl);
+    gui_event_post(GUI_EV_IO);
+}
+
+void gui_jobs_init(void)
+{
+    spin_register(&g_job_lock, "gui.jobs");
+}
+
+void gui_job_submit(workqueue_t *wq, gui_job_t *job)
+{
+    job->next = NULL;
+    job->result = 0;
+    init_work(&job->work, gui_job_work);
+    __atomic_add_fetch(&g_jobs_busy, 1, __ATOMIC_RELAXED);
+    queue_work(wq, &job->work);
+}
+
+void gui_jobs_complete(void)
+{
+    uint64_t fl = spin_lock_irqsave(&g_job_lock);
+    gui_job_t *j = g_done_head;
+    g_done_head = g_done_tail = NULL;
+    spin_unlock_irqrestore(&g_job_lock, fl);
+    while (j)
+    {
+        gui_job_t *next = j->next;   // done()이 job을 해제할 수 있다
+        if (j->done)
+            j->done(j);
+        __atomic_sub_fetch(&g_jobs_busy, 1, __ATOMIC_RELAXED);
+        j = next;
+    }
+}
+
+int gui_jobs_busy(void)
+{
+    return __atomic_load_n(&g_jobs_busy, __ATOMIC_RELAXED);
+}
+
+void gui_event_dump(void)
+{
+    static const char *const names[GUI_EV_COUNT] = { "input", "timer", "draw", "io", "serial", "reclaim" };
+    serial_printf("[gui] %u waits, %u without sleeping, asleep %llu ms in total\n",
+                  g_waits, g_no_sleep, (unsigned long long)(g_sleep_ns / 1000000u));
+    for (uint32_t i = 0; i < GUI_EV_COUNT; ++i)
+        serial_printf("[gui]   woken by %s: %u\n", names[i], g_wakes[i]);
+    serial_printf("[gui] jobs: %u run, %d in flight (queue latency: \"wq\")\n",
+                  g_jobs_run, gui_jobs_busy());
+}
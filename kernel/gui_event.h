@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+#include "workqueue.h"
+
+// Wake-up object for the GUI thread.
+// - 데스크톱은 전용 커널 스레드("gui")에서 돈다. 할 일이 없으면 gui_event_wait()
+//   에서 자고, 입력 IRQ, 직렬 콘솔 IRQ, 화면 갱신 요청(desktop_mark_dirty,
+//   유저 창 damage, uring 그리기), 백그라운드 작업 완료가 깨운다.
+// - 이유는 비트로 모인다. 한 번 깨면 그동안 쌓인 이유를 한꺼번에 받는다.
+// - gui_event_post()는 IRQ 핸들러를 포함해 어디서나 부를 수 있다.
+//
+// Background jobs: 디스크 쓰기나 디렉터리 읽기처럼 느린 일은 gui_job_submit()으로
+// 워크큐(workqueue.h)에 넘긴다. run()은 워커에서, done()은 다음에 깨어난 GUI
+// 스레드에서 (gui_jobs_complete) 돈다. GUI 상태는 done()에서만 바꾼다.
+
+#define GUI_EV_INPUT   0x01u   // 입력 큐에 이벤트
+#define GUI_EV_TIMER   0x02u   // 대기 시간이 끝남 (시계, 샘플러)
+#define GUI_EV_DRAW    0x04u   // 다시 그려야 함
+#define GUI_EV_IO      0x08u   // 백그라운드 작업 완료
+#define GUI_EV_SERIAL  0x10u   // 직렬 콘솔 수신
+#define GUI_EV_RECLAIM 0x20u   // 다른 스레드가 메모리가 모자라 GUI 캐시를 줄여 달라고 함
+#define GUI_EV_COUNT   6
+
+void     gui_event_post(uint32_t bits);
+// 쌓인 이유를 꺼내고 비운다. 이유 없이 timeout_ms가 지나면 GUI_EV_TIMER.
+// 이미 쌓여 있으면 자지 않는다.
+uint32_t gui_event_wait(uint64_t timeout_ms);
+
+typedef struct gui_job
+{
+    void (*run)(struct gui_job *job);    // 워커 스레드
+    void (*done)(struct gui_job *job);   // GUI 스레드 (NULL이면 없음)
+    struct gui_job *next;
+    work_t          work;
+    int             result;
+} gui_job_t;
+
+void     gui_jobs_init(void);
+// wq가 NULL이면 system_wq. 파일시스템을 만지는 작업은 fs_wq로.
+void     gui_job_submit(workqueue_t *wq, gui_job_t *job);
+// GUI 스레드에서: 끝난 작업의 done()을 끝난 순서대로
+void     gui_jobs_complete(void);
+int      gui_jobs_busy(void);    // 대기 중이거나 도는 작업 수
+
+void     gui_event_dump(void);
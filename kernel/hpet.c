@@ -0,0 +1,103 @@
+#include "hpet.h"
+#include "acpi_tables.h"
+#include "serial.h"
+
+#define HPET_REG_CAP     0x000   // [63:32] period (fs), bit 13: 64-bit counter
+#define HPET_REG_CONFIG  0x010   // bit 0: ENABLE_CNF, bit 1: LEG_RT_CNF
+#define HPET_REG_COUNTER 0x0F0
+#define HPET_CAP_64BIT   (1ull << 13)
+#define HPET_CFG_ENABLE  1ull
+
+struct acpi_gas
+{
+    uint8_t  space_id;   // 0: system memory
+    uint8_t  bit_width;
+    uint8_t  bit_offset;
+    uint8_t  access_size;
+    uint64_t address;
+} __attribute__((packed));
+
+struct acpi_hpet
+{
+    struct sdt header;
+    uint32_t event_timer_block_id;
+    struct acpi_gas base;
+    uint8_t  hpet_number;
+    uint16_t min_tick;
+    uint8_t  page_prot;
+} __attribute__((packed));
+
+static volatile uint64_t *g_hpet = NULL;
+static uint32_t g_period_fs = 0;
+static int g_counter64 = 0;
+
+static inline uint64_t hpet_reg(uint32_t off)
+{
+    return g_hpet[off / 8];
+}
+
+int hpet_init(void)
+{
+    if (g_hpet)
+        return 0;
+
+    struct acpi_hpet *t = acpi_find_table("HPET", 0);
+    if (!t || t->base.space_id != 0 || !t->base.address)
+    {
+        serial_printf("[hpet] not present\n");
+        return -1;
+    }
+
+    volatile uint64_t *regs = acpi_map_phys(t->base.address, 0x400, 1);
+    if (!regs)
+        return -1;
+    g_hpet = regs;
+
+    uint64_t cap = hpet_reg(HPET_REG_CAP);
+    g_period_fs = (uint32_t)(cap >> 32);
+    // 스펙상 주기는 100ns(10^8 fs) 이하
+    if (g_period_fs == 0 || g_period_fs > 100000000u)
+    {
+        serial_printf("[hpet] bad period %u fs\n", g_period_fs);
+        g_hpet = NULL;
+        return -1;
+    }
+    g_counter64 = (cap & HPET_CAP_64BIT) != 0;
+
+    // 카운터만 켠다 (legacy replacement는 건드리지 않음)
+    g_hpet[HPET_REG_CONFIG / 8] = hpet_reg(HPET_REG_CONFIG) | HPET_CFG_ENABLE;
+
+    serial_printf("[hpet] at 0x%llx, %llu Hz, %s counter\n",
+                  (unsigned long long)t->base.address, (unsigned long long)hpet_hz(),
+                  g_counter64 ? "64-bit" : "32-bit");
+    return 0;
+}
+
+int hpet_available(void)
+{
+    return g_hpet != NULL;
+}
+
+uint64_t hpet_read(void)
+{
+    if (!g_hpet)
+        return 0;
+    if (g_counter64)
+        return hpet_reg(HPET_REG_COUNTER);
+    return (uint32_t)hpet_reg(HPET_REG_COUNTER);
+}
+
+int hpet_counter64(void)
+{
+    return g_counter64;
+}
+
+uint64_t hpet_hz(void)
+{
+    return g_period_fs ? 1000000000000000ull / g_period_fs : 0;
+}
+
+uint32_t hpet_period_fs(void)
+{
+    return g_period_fs;
+}
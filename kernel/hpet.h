@@ -0,0 +1,15 @@
+#pragma once
+#include <stdint.h>
+
+// HPET main counter, used as a calibration reference for the TSC and as the
+// clocksource when the TSC is not invariant. Comparators are not used.
+
+int      hpet_init(void);
+int      hpet_available(void);
+uint64_t hpet_read(void);
+// 32-bit counters wrap in minutes and are only used for calibration.
+int      hpet_counter64(void);
+// Counter frequency in Hz.
+uint64_t hpet_hz(void);
+// Counter period in femtoseconds.
+uint32_t hpet_period_fs(void);
@@ -2,6 +2,7 @@
 #include "serial.h"
 #include "isr.h"
 #include "gdt.h"            // 나중에 TSS/IST 쓸 때를 위해 남겨둠
+#include "apic.h"
 #include <stddef.h>
 #include <string.h>
 
@@ -47,6 +48,10 @@ extern void irq_stub10(void);  extern void irq_stub11(void);
 extern void irq_stub12(void);  extern void irq_stub13(void);
 extern void irq_stub14(void);  extern void irq_stub15(void);
 
+// Local APIC vectors (see apic.h)
+extern void apic_stub240(void); extern void apic_stub241(void);
+extern void apic_stub242(void); extern void apic_stub255(void);
+
 // If you have a syscall stub (e.g. int 0x80), declare it here.
 // extern void isr_stub128(void);
 
@@ -134,12 +139,18 @@ void idt_init64(void)
     idt_set_gate(46, (uint64_t)irq_stub14, cs, IDT_FLAG_INTGATE, 0);
     idt_set_gate(47, (uint64_t)irq_stub15, cs, IDT_FLAG_INTGATE, 0);
 
-    // 5) Optionally: system call vector (e.g. 0x80) if you have one.
+    // 5) Local APIC timer / IPIs / spurious (SMP)
+    idt_set_gate(APIC_VEC_TIMER,    (uint64_t)apic_stub240, cs, IDT_FLAG_INTGATE, 0);
+    idt_set_gate(APIC_VEC_RESCHED,  (uint64_t)apic_stub241, cs, IDT_FLAG_INTGATE, 0);
+    idt_set_gate(APIC_VEC_TLB,      (uint64_t)apic_stub242, cs, IDT_FLAG_INTGATE, 0);
+    idt_set_gate(APIC_VEC_SPURIOUS, (uint64_t)apic_stub255, cs, IDT_FLAG_INTGATE, 0);
+
+    // 6) Optionally: system call vector (e.g. 0x80) if you have one.
     // idt_set_gate(0x80, (uint64_t)isr_stub128, KERNEL_CS,
     //              IDT_FLAG_TRAPGATE | 0x60, 0);
     // (0x60 sets DPL=3 so user mode can call it.)
 
-    // 6) Load IDT
+    // 7) Load IDT
     idt_load();
 
     serial_printf("[IDT] base=%016lx limit=%04x (64-bit IDT)\n",
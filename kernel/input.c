@@ -0,0 +1,275 @@
+#include "input.h"
+#include "ring.h"
+#include "clock.h"
+#include "serial.h"
+#include "gui_event.h"
+
+#define INPUT_QUEUE_CAP 256
+#define LAT_BUCKETS     20      // 2^i us, 마지막 칸은 그 이상 모두
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t min_ns;
+    uint64_t max_ns;
+    uint32_t hist[LAT_BUCKETS];
+} lat_stat_t;
+
+static uint8_t     g_q_buf[MPSC_RING_BYTES(INPUT_QUEUE_CAP, sizeof(input_event_t))];
+static mpsc_ring_t g_q;
+static volatile int g_ready;
+
+// IRQ 쪽: 키보드 핸들러만 쓰는 modifier, 마우스 핸들러만 쓰는 버튼
+enum { HELD_LSHIFT = 1, HELD_RSHIFT = 2, HELD_LCTRL = 4, HELD_RCTRL = 8,
+       HELD_LALT = 16, HELD_RALT = 32, HELD_GUI = 64 };
+static uint8_t g_held;
+static uint8_t g_caps;
+static uint8_t g_irq_buttons;
+static volatile uint32_t g_pushed[INPUT_EV_WHEEL + 1];
+
+// GUI 쪽
+static int      g_scr_w, g_scr_h;
+static int      g_cur_x, g_cur_y;
+static uint8_t  g_buttons;
+static int      g_wheel;
+static uint32_t g_coalesced;     // 다른 이동과 합쳐진 REL 이벤트
+static uint64_t g_pend_move_ns;  // 아직 화면에 안 나간 이동 중 가장 이른 IRQ 시각
+static uint64_t g_pend_key_ns;
+static lat_stat_t g_lat_move, g_lat_key;
+
+void input_init(uint32_t screen_w, uint32_t screen_h)
+{
+    g_scr_w = (int)screen_w;
+    g_scr_h = (int)screen_h;
+    g_cur_x = g_scr_w / 2;
+    g_cur_y = g_scr_h / 2;
+    if (!g_ready && mpsc_init(&g_q, g_q_buf, INPUT_QUEUE_CAP, sizeof(input_event_t)) == 0)
+        g_ready = 1;
+}
+
+static void push(input_event_t *ev)
+{
+    if (!g_ready)
+        return;
+    if (mpsc_push(&g_q, ev) == 0)
+    {
+        __atomic_add_fetch(&g_pushed[ev->type], 1, __ATOMIC_RELAXED);
+        gui_event_post(GUI_EV_INPUT);
+    }
+}
+
+static uint8_t held_bit(uint8_t code, int ext)
+{
+    switch (code)
+    {
+    case 0x2A: return HELD_LSHIFT;
+    case 0x36: return HELD_RSHIFT;
+    case 0x1D: return ext ? HELD_RCTRL : HELD_LCTRL;
+    case 0x38: return ext ? HELD_RALT : HELD_LALT;
+    case 0x5B:
+    case 0x5C: return ext ? HELD_GUI : 0;
+    default:   return 0;
+    }
+}
+
+static uint8_t cur_mods(void)
+{
+    uint8_t m = 0;
+    if (g_held & (HELD_LSHIFT | HELD_RSHIFT)) m |= INPUT_MOD_SHIFT;
+    if (g_held & (HELD_LCTRL | HELD_RCTRL))   m |= INPUT_MOD_CTRL;
+    if (g_held & (HELD_LALT | HELD_RALT))     m |= INPUT_MOD_ALT;
+    if (g_held & HELD_GUI)                    m |= INPUT_MOD_GUI;
+    if (g_caps)                               m |= INPUT_MOD_CAPS;
+    return m;
+}
+
+void input_push_key(uint8_t scancode, int ext)
+{
+    uint8_t code = scancode & 0x7F;
+    int down = !(scancode & 0x80);
+    // E0 2A / E0 36: PrtSc 등이 앞뒤로 보내는 가짜 Shift
+    if (ext && (code == 0x2A || code == 0x36))
+        return;
+
+    uint8_t bit = held_bit(code, ext);
+    if (down)
+        g_held |= bit;
+    else
+        g_held &= (uint8_t)~bit;
+    if (down && code == 0x3A)
+        g_caps ^= 1;
+
+    input_event_t ev = { 0 };
+    ev.time_ns = ktime_ns();
+    ev.type = INPUT_EV_KEY;
+    ev.code = code;
+    ev.value = (uint8_t)down;
+    ev.mods = (uint8_t)(cur_mods() | (ext ? INPUT_MOD_EXT : 0));
+    push(&ev);
+}
+
+void input_push_mouse(int dx, int dy, int dz, uint8_t buttons)
+{
+    input_event_t ev = { 0 };
+    ev.time_ns = ktime_ns();
+
+    // 패킷 안에서는 이동이 버튼 변화보다 먼저
+    if (dx || dy)
+    {
+        ev.type = INPUT_EV_REL;
+        ev.dx = (int16_t)dx;
+        ev.dy = (int16_t)dy;
+        push(&ev);
+        ev.dx = ev.dy = 0;
+    }
+    uint8_t changed = (uint8_t)((buttons ^ g_irq_buttons) & 0x07);
+    for (uint8_t b = INPUT_BTN_LEFT; b <= INPUT_BTN_MIDDLE; b <<= 1)
+    {
+        if (!(changed & b))
+            continue;
+        ev.type = INPUT_EV_BTN;
+        ev.code = b;
+        ev.value = (buttons & b) ? 1 : 0;
+        push(&ev);
+    }
+    g_irq_buttons = buttons & 0x07;
+    if (dz)
+    {
+        ev.type = INPUT_EV_WHEEL;
+        ev.code = ev.value = 0;
+        ev.dy = (int16_t)dz;
+        push(&ev);
+    }
+}
+
+int input_poll(input_event_t *ev)
+{
+    input_event_t e;
+    int moves = 0;
+    while (mpsc_pop(&g_q, &e))
+    {
+        switch (e.type)
+        {
+        case INPUT_EV_REL:
+            g_cur_x += e.dx;
+            g_cur_y += e.dy;
+            if (g_cur_x < 0) g_cur_x = 0;
+            if (g_cur_y < 0) g_cur_y = 0;
+            if (g_cur_x >= g_scr_w) g_cur_x = g_scr_w - 1;
+            if (g_cur_y >= g_scr_h) g_cur_y = g_scr_h - 1;
+            if (!g_pend_move_ns)
+                g_pend_move_ns = e.time_ns;
+            if (moves++)
+                g_coalesced++;
+            continue;
+        case INPUT_EV_WHEEL:
+            g_wheel += e.dy;
+            continue;
+        case INPUT_EV_BTN:
+            if (e.value)
+                g_buttons |= e.code;
+            else
+                g_buttons &= (uint8_t)~e.code;
+            break;
+        case INPUT_EV_KEY:
+            break;
+        default:
+            continue;
+        }
+        if (!g_pend_key_ns)
+            g_pend_key_ns = e.time_ns;
+        if (ev)
+            *ev = e;
+        return 1;
+    }
+    return 0;
+}
+
+int input_pending(void)
+{
+    return mpsc_count(&g_q) != 0;
+}
+
+void input_cursor(int *x, int *y)
+{
+    if (x) *x = g_cur_x;
+    if (y) *y = g_cur_y;
+}
+
+uint8_t input_buttons(void)
+{
+    return g_buttons;
+}
+
+int input_wheel_take(void)
+{
+    int w = g_wheel;
+    g_wheel = 0;
+    return w;
+}
+
+static void lat_add(lat_stat_t *s, uint64_t ns)
+{
+    uint64_t us = ns / 1000u;
+    uint32_t b = 0;
+    while (b < LAT_BUCKETS - 1 && us >= (2ull << b))
+        b++;
+    s->hist[b]++;
+    if (!s->count || ns < s->min_ns)
+        s->min_ns = ns;
+    if (ns > s->max_ns)
+        s->max_ns = ns;
+    s->sum_ns += ns;
+    s->count++;
+}
+
+void input_frame_presented(void)
+{
+    if (!g_pend_move_ns && !g_pend_key_ns)
+        return;
+    uint64_t now = ktime_ns();
+    if (g_pend_move_ns)
+        lat_add(&g_lat_move, now - g_pend_move_ns);
+    if (g_pend_key_ns)
+        lat_add(&g_lat_key, now - g_pend_key_ns);
+    g_pend_move_ns = g_pend_key_ns = 0;
+}
+
+// 히스토그램 칸의 위 경계 (us)
+static uint64_t lat_pct_us(const lat_stat_t *s, uint32_t pct)
+{
+    uint64_t want = (s->count * pct + 99) / 100, seen = 0;
+    for (uint32_t b = 0; b < LAT_BUCKETS; ++b)
+    {
+        seen += s->hist[b];
+        if (seen >= want)
+            return 2ull << b;
+    }
+    return 2ull << (LAT_BUCKETS - 1);
+}
+
+static void lat_dump(const char *what, const lat_stat_t *s)
+{
+    if (!s->count)
+    {
+        serial_printf("[input] %s -> photon: no samples\n", what);
+        return;
+    }
+    serial_printf("[input] %s -> photon: %llu frames, avg %llu us, min %llu us, p50 <%llu us, p99 <%llu us, max %llu us\n",
+                  what, (unsigned long long)s->count,
+                  (unsigned long long)(s->sum_ns / s->count / 1000u),
+                  (unsigned long long)(s->min_ns / 1000u),
+                  (unsigned long long)lat_pct_us(s, 50), (unsigned long long)lat_pct_us(s, 99),
+                  (unsigned long long)(s->max_ns / 1000u));
+}
+
+void input_dump(void)
+{
+    serial_printf("[input] queued: %u key, %u move, %u button, %u wheel; %u dropped, %u waiting\n",
+                  g_pushed[INPUT_EV_KEY], g_pushed[INPUT_EV_REL], g_pushed[INPUT_EV_BTN],
+                  g_pushed[INPUT_EV_WHEEL], g_q.dropped, mpsc_count(&g_q));
+    serial_printf("[input] cursor (%d,%d) buttons 0x%x, %u moves coalesced\n",
+                  g_cur_x, g_cur_y, g_buttons, g_coalesced);
+    lat_dump("move", &g_lat_move);
+    lat_dump("key/button", &g_lat_key);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+
+// Timestamped input event queue.
+// - 키보드/마우스 IRQ 핸들러는 해석한 이벤트를 IRQ 시각(ktime_ns)과 함께
+//   lock-free MPSC 링(ring.h)에 넣기만 한다. 화면 좌표나 GUI 상태는 만지지 않는다.
+// - GUI 루프는 input_poll()로 큐를 비운다: 상대 이동과 휠은 모두 합쳐 커서에
+//   반영하고(coalescing), 키/버튼 같은 이산 이벤트는 하나씩 순서대로 넘긴다.
+//   프레임보다 짧은 클릭도 눌림과 뗌이 각각 보인다.
+// - input-to-photon: 꺼낸 이벤트의 IRQ 시각부터 그 결과가 fb_flush로 화면에
+//   나갈 때까지를 input_frame_presented()가 잰다 (커서 이동 / 키·버튼 따로).
+
+enum {
+    INPUT_EV_KEY = 1,   // code = 스캔코드 (set 1, 7비트), value = 1 눌림 / 0 뗌
+    INPUT_EV_REL,       // dx, dy = 상대 이동 (화면 아래쪽이 +y)
+    INPUT_EV_BTN,       // code = 버튼 비트 (INPUT_BTN_*), value = 1 눌림 / 0 뗌
+    INPUT_EV_WHEEL,     // dy = 휠 (아래로 +)
+};
+
+#define INPUT_BTN_LEFT   0x01
+#define INPUT_BTN_RIGHT  0x02
+#define INPUT_BTN_MIDDLE 0x04
+
+// 이벤트 시점의 modifier 상태 (KEY 이벤트에 붙는다)
+#define INPUT_MOD_SHIFT  0x01
+#define INPUT_MOD_CTRL   0x02
+#define INPUT_MOD_ALT    0x04
+#define INPUT_MOD_GUI    0x08
+#define INPUT_MOD_CAPS   0x10
+#define INPUT_MOD_EXT    0x80   // E0 확장 키 (오른쪽 Ctrl/Alt, 방향키 블록 등)
+
+typedef struct {
+    uint64_t time_ns;   // IRQ에서 찍은 ktime_ns
+    uint8_t  type;      // INPUT_EV_*
+    uint8_t  code;
+    uint8_t  value;
+    uint8_t  mods;
+    int16_t  dx, dy;
+} input_event_t;   // 16 bytes
+
+// 키보드/마우스 초기화 전에: 큐와 커서 범위
+void input_init(uint32_t screen_w, uint32_t screen_h);
+
+// IRQ 쪽 (keyboard.c, mouse.c)
+void input_push_key(uint8_t scancode, int ext);   // set 1 바이트 (E0 접두는 ext로)
+void input_push_mouse(int dx, int dy, int dz, uint8_t buttons);
+
+// GUI 쪽. 이동/휠은 모두 반영하고, 키나 버튼 이벤트를 하나 만나면 그걸 *ev에
+// 담아 1을 돌려준다. 큐에 이산 이벤트가 없으면 0.
+int      input_poll(input_event_t *ev);
+int      input_pending(void);            // 큐에 남은 이벤트가 있으면 1
+void     input_cursor(int *x, int *y);   // 지금까지 꺼낸 이동을 반영한 커서
+uint8_t  input_buttons(void);            // 지금까지 꺼낸 버튼 상태
+int      input_wheel_take(void);         // 쌓인 휠 값을 꺼내고 0으로
+// 프레임을 화면에 낸 직후 (fb_flush 다음)
+void     input_frame_presented(void);
+void     input_dump(void);
@@ -0,0 +1,233 @@
+#include "ioapic.h"
+#include "acpi_tables.h"
+#include "serial.h"
+#include "spinlock.h"
+
+#define IOAPIC_REGSEL   0x00
+#define IOAPIC_WINDOW   0x10
+#define IOAPIC_REG_ID   0x00
+#define IOAPIC_REG_VER  0x01
+#define IOAPIC_REG_RED  0x10   // + 2 * pin (low dword), + 1 (high dword)
+
+#define RED_MASKED      (1u << 16)
+#define RED_LEVEL       (1u << 15)
+#define RED_ACTIVE_LOW  (1u << 13)
+
+#define MADT_TYPE_IOAPIC 1
+#define MADT_TYPE_ISO    2
+
+// MPS INTI flags (polarity bits 0-1, trigger bits 2-3)
+#define MPS_POL_MASK     0x3
+#define MPS_POL_LOW      0x3
+#define MPS_TRIG_MASK    0xC
+#define MPS_TRIG_LEVEL   0xC
+
+// MADT type 2: ISA IRQ 'source' arrives on 'gsi'
+struct madt_iso
+{
+    uint8_t  type;
+    uint8_t  length;
+    uint8_t  bus;
+    uint8_t  source;
+    uint32_t gsi;
+    uint16_t flags;
+} __attribute__((packed));
+
+typedef struct
+{
+    volatile uint32_t *mmio;
+    uint8_t  id;
+    uint32_t gsi_base;
+    uint32_t pins;
+} ioapic_t;
+
+typedef struct
+{
+    uint32_t gsi;
+    uint16_t flags;
+    uint8_t  present;
+} isa_override_t;
+
+static ioapic_t g_ioapics[IOAPIC_MAX];
+static int g_nioapics = 0;
+static isa_override_t g_iso[16];
+static spinlock_t g_ioapic_lock = SPINLOCK_INIT;
+
+static uint32_t ioapic_rd(ioapic_t *io, uint32_t reg)
+{
+    io->mmio[IOAPIC_REGSEL / 4] = reg;
+    return io->mmio[IOAPIC_WINDOW / 4];
+}
+
+static void ioapic_wr(ioapic_t *io, uint32_t reg, uint32_t val)
+{
+    io->mmio[IOAPIC_REGSEL / 4] = reg;
+    io->mmio[IOAPIC_WINDOW / 4] = val;
+}
+
+static ioapic_t *ioapic_for(uint32_t gsi, uint32_t *pin)
+{
+    for (int i = 0; i < g_nioapics; ++i)
+    {
+        ioapic_t *io = &g_ioapics[i];
+        if (gsi >= io->gsi_base && gsi < io->gsi_base + io->pins)
+        {
+            *pin = gsi - io->gsi_base;
+            return io;
+        }
+    }
+    return NULL;
+}
+
+int ioapic_init(void)
+{
+    if (g_nioapics)
+        return 0;
+    spin_register(&g_ioapic_lock, "ioapic");
+
+    struct madt *madt = acpi_find_table("APIC", 0);
+    if (!madt)
+    {
+        serial_printf("[ioapic] no MADT\n");
+        return -1;
+    }
+
+    uint8_t *p = (uint8_t *)madt->madt_entries_begin;
+    uint8_t *end = (uint8_t *)madt + madt->header.length;
+    for (; p + 2 <= end && p[1] >= 2; p += p[1])
+    {
+        if (p[0] == MADT_TYPE_IOAPIC && g_nioapics < IOAPIC_MAX)
+        {
+            struct madt_io_apic *e = (struct madt_io_apic *)p;
+            volatile uint32_t *mmio = acpi_map_phys(e->address, 0x20, 1);
+            if (!mmio)
+                continue;
+            ioapic_t *io = &g_ioapics[g_nioapics++];
+            io->mmio = mmio;
+            io->id = e->apic_id;
+            io->gsi_base = e->gsib;
+            io->pins = ((ioapic_rd(io, IOAPIC_REG_VER) >> 16) & 0xFF) + 1;
+        }
+        else if (p[0] == MADT_TYPE_ISO)
+        {
+            struct madt_iso *e = (struct madt_iso *)p;
+            if (e->bus == 0 && e->source < 16)
+            {
+                g_iso[e->source].gsi = e->gsi;
+                g_iso[e->source].flags = e->flags;
+                g_iso[e->source].present = 1;
+            }
+        }
+    }
+
+    if (!g_nioapics)
+    {
+        serial_printf("[ioapic] MADT lists no IOAPIC\n");
+        return -1;
+    }
+
+    // 펌웨어가 남긴 설정은 믿지 않는다: 전부 막고 시작
+    for (int i = 0; i < g_nioapics; ++i)
+    {
+        ioapic_t *io = &g_ioapics[i];
+        for (uint32_t pin = 0; pin < io->pins; ++pin)
+        {
+            ioapic_wr(io, IOAPIC_REG_RED + 2 * pin, RED_MASKED);
+            ioapic_wr(io, IOAPIC_REG_RED + 2 * pin + 1, 0);
+        }
+        serial_printf("[ioapic] id %u GSI %u-%u\n", io->id, io->gsi_base,
+                      io->gsi_base + io->pins - 1);
+    }
+    return 0;
+}
+
+int ioapic_count(void)
+{
+    return g_nioapics;
+}
+
+uint32_t ioapic_isa_to_gsi(uint8_t isa_irq, int *level, int *active_low)
+{
+    uint32_t gsi = isa_irq;
+    int lvl = 0, low = 0;
+    if (isa_irq < 16 && g_iso[isa_irq].present)
+    {
+        uint16_t f = g_iso[isa_irq].flags;
+        gsi = g_iso[isa_irq].gsi;
+        // 0 = 버스 기본값 (ISA: edge, active-high)
+        lvl = (f & MPS_TRIG_MASK) == MPS_TRIG_LEVEL;
+        low = (f & MPS_POL_MASK) == MPS_POL_LOW;
+    }
+    if (level)
+        *level = lvl;
+    if (active_low)
+        *active_low = low;
+    return gsi;
+}
+
+int ioapic_route(uint32_t gsi, uint8_t vector, int level, int active_low,
+                 uint32_t dest_lapic)
+{
+    uint32_t pin;
+    ioapic_t *io = ioapic_for(gsi, &pin);
+    if (!io)
+        return -1;
+    uint32_t lo = vector | RED_MASKED;
+    if (level)
+        lo |= RED_LEVEL;
+    if (active_low)
+        lo |= RED_ACTIVE_LOW;
+
+    uint64_t fl = spin_lock_irqsave(&g_ioapic_lock);
+    ioapic_wr(io, IOAPIC_REG_RED + 2 * pin + 1, dest_lapic << 24);
+    ioapic_wr(io, IOAPIC_REG_RED + 2 * pin, lo);
+    spin_unlock_irqrestore(&g_ioapic_lock, fl);
+    return 0;
+}
+
+int ioapic_set_masked(uint32_t gsi, int masked)
+{
+    uint32_t pin;
+    ioapic_t *io = ioapic_for(gsi, &pin);
+    if (!io)
+        return -1;
+    uint64_t fl = spin_lock_irqsave(&g_ioapic_lock);
+    uint32_t lo = ioapic_rd(io, IOAPIC_REG_RED + 2 * pin);
+    lo = masked ? (lo | RED_MASKED) : (lo & ~RED_MASKED);
+    ioapic_wr(io, IOAPIC_REG_RED + 2 * pin, lo);
+    spin_unlock_irqrestore(&g_ioapic_lock, fl);
+    return 0;
+}
+
+int ioapic_set_dest(uint32_t gsi, uint32_t dest_lapic)
+{
+    uint32_t pin;
+    ioapic_t *io = ioapic_for(gsi, &pin);
+    if (!io)
+        return -1;
+    uint64_t fl = spin_lock_irqsave(&g_ioapic_lock);
+    ioapic_wr(io, IOAPIC_REG_RED + 2 * pin + 1, dest_lapic << 24);
+    spin_unlock_irqrestore(&g_ioapic_lock, fl);
+    return 0;
+}
+
+void ioapic_dump(void)
+{
+    for (int i = 0; i < g_nioapics; ++i)
+    {
+        ioapic_t *io = &g_ioapics[i];
+        for (uint32_t pin = 0; pin < io->pins; ++pin)
+        {
+            uint64_t fl = spin_lock_irqsave(&g_ioapic_lock);
+            uint32_t lo = ioapic_rd(io, IOAPIC_REG_RED + 2 * pin);
+            uint32_t hi = ioapic_rd(io, IOAPIC_REG_RED + 2 * pin + 1);
+            spin_unlock_irqrestore(&g_ioapic_lock, fl);
+            if (lo & RED_MASKED)
+                continue;
+            serial_printf("[ioapic] GSI %u -> vec 0x%x lapic %u %s %s\n",
+                          io->gsi_base + pin, lo & 0xFF, hi >> 24,
+                          (lo & RED_LEVEL) ? "level" : "edge",
+                          (lo & RED_ACTIVE_LOW) ? "low" : "high");
+        }
+    }
+}
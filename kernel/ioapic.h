@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+
+// I/O APIC driver.
+// - IOAPICs and ISA interrupt source overrides come from the ACPI MADT.
+// - Pins are addressed by GSI (global system interrupt); each IOAPIC covers
+//   [gsi_base, gsi_base + pins).
+// - Every pin starts masked; irq.c decides what gets routed where.
+
+#define IOAPIC_MAX 8
+
+int      ioapic_init(void);
+int      ioapic_count(void);
+// ISA IRQ → GSI with the polarity/trigger the firmware asked for
+// (identity, edge, active-high unless an override says otherwise).
+uint32_t ioapic_isa_to_gsi(uint8_t isa_irq, int *level, int *active_low);
+// Program a redirection entry (fixed delivery, physical destination).
+// The pin is left masked; use ioapic_set_masked() to open it. 0 / -1.
+int      ioapic_route(uint32_t gsi, uint8_t vector, int level, int active_low,
+                      uint32_t dest_lapic);
+int      ioapic_set_masked(uint32_t gsi, int masked);
+int      ioapic_set_dest(uint32_t gsi, uint32_t dest_lapic);
+void     ioapic_dump(void);
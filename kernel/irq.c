@@ -0,0 +1,149 @@
+#include "irq.h"
+#include "ioapic.h"
+#include "apic.h"
+#include "pic.h"
+#include "percpu.h"
+#include "serial.h"
+
+typedef struct
+{
+    uint8_t  enabled;
+    uint8_t  pci;        // level-triggered PCI line
+    uint32_t cpu;        // target CPU (IOAPIC mode)
+    uint32_t count;
+} irq_line_t;
+
+static irq_line_t g_irq[IRQ_LINES];
+static irq_mode_t g_mode = IRQ_MODE_PIC;
+static uint32_t g_bsp_lapic = 0;   // mp_init이 cpu_t를 채우기 전에도 쓸 수 있게
+
+static uint32_t irq_dest(uint32_t cpu)
+{
+    cpu_t *c = cpu_get(cpu);
+    return (cpu && c) ? c->lapic_id : g_bsp_lapic;
+}
+
+static void irq_route_line(uint8_t irq)
+{
+    irq_line_t *l = &g_irq[irq];
+    int level, low;
+    uint32_t gsi = ioapic_isa_to_gsi(irq, &level, &low);
+    // PCI 라인은 오버라이드가 없으면 level / active-low
+    if (l->pci && gsi == irq && !level)
+    {
+        level = 1;
+        low = 1;
+    }
+    ioapic_route(gsi, (uint8_t)(IRQ_VECTOR_BASE + irq), level, low, irq_dest(l->cpu));
+    ioapic_set_masked(gsi, !l->enabled);
+}
+
+int irq_init_apic(void)
+{
+    if (g_mode == IRQ_MODE_IOAPIC)
+        return 0;
+    if (apic_init() != 0 || ioapic_init() != 0)
+    {
+        serial_printf("[irq] no IOAPIC, staying on the 8259 PIC\n");
+        return -1;
+    }
+
+    g_bsp_lapic = apic_id();
+    uint64_t fl = irq_save();
+    // PIC의 모든 라인을 막은 뒤 켜져 있던 라인을 IOAPIC으로 옮긴다
+    for (uint8_t irq = 0; irq < IRQ_LINES; ++irq)
+        pic_set_mask(irq);
+    for (uint8_t irq = 0; irq < IRQ_LINES; ++irq)
+    {
+        // 캐스케이드 라인은 PIC 전용
+        if (irq == 2)
+            continue;
+        g_irq[irq].cpu = 0;
+        irq_route_line(irq);
+    }
+    g_mode = IRQ_MODE_IOAPIC;
+    irq_restore(fl);
+
+    serial_printf("[irq] legacy IRQs routed through %d IOAPIC(s), PIC masked\n", ioapic_count());
+    return 0;
+}
+
+irq_mode_t irq_mode(void)
+{
+    return g_mode;
+}
+
+static void irq_set_enabled(uint8_t irq, int on)
+{
+    if (irq >= IRQ_LINES)
+        return;
+    g_irq[irq].enabled = (uint8_t)on;
+    if (g_mode == IRQ_MODE_IOAPIC)
+    {
+        if (irq != 2)
+            ioapic_set_masked(ioapic_isa_to_gsi(irq, 0, 0), !on);
+    }
+    else if (on)
+        pic_clear_mask(irq);
+    else
+        pic_set_mask(irq);
+}
+
+void irq_enable(uint8_t irq)
+{
+    irq_set_enabled(irq, 1);
+}
+
+void irq_disable(uint8_t irq)
+{
+    irq_set_enabled(irq, 0);
+}
+
+void irq_enable_pci(uint8_t irq)
+{
+    if (irq >= IRQ_LINES)
+        return;
+    g_irq[irq].pci = 1;
+    if (g_mode == IRQ_MODE_IOAPIC)
+        irq_route_line(irq);
+    // 슬레이브 PIC 라인은 캐스케이드가 열려 있어야 한다
+    if (g_mode == IRQ_MODE_PIC && irq >= 8)
+        irq_enable(2);
+    irq_enable(irq);
+}
+
+void irq_ack(uint32_t vector)
+{
+    uint32_t irq = vector - IRQ_VECTOR_BASE;
+    if (irq >= IRQ_LINES)
+        return;
+    g_irq[irq].count++;
+    if (g_mode == IRQ_MODE_IOAPIC)
+        apic_eoi();
+    else
+        pic_eoi((uint8_t)irq);
+}
+
+int irq_set_affinity(uint8_t irq, uint32_t cpu)
+{
+    cpu_t *c = cpu_get(cpu);
+    if (g_mode != IRQ_MODE_IOAPIC || irq >= IRQ_LINES || irq == 2 || !c || !c->online)
+        return -1;
+    g_irq[irq].cpu = cpu;
+    return ioapic_set_dest(ioapic_isa_to_gsi(irq, 0, 0), irq_dest(cpu));
+}
+
+void irq_dump(void)
+{
+    serial_printf("[irq] mode %s\n", g_mode == IRQ_MODE_IOAPIC ? "IOAPIC" : "8259 PIC");
+    for (uint8_t irq = 0; irq < IRQ_LINES; ++irq)
+    {
+        irq_line_t *l = &g_irq[irq];
+        if (!l->enabled && !l->count)
+            continue;
+        serial_printf("  IRQ%u %s%s cpu%u count %u\n", irq, l->enabled ? "on" : "off",
+                      l->pci ? " pci" : "", l->cpu, l->count);
+    }
+    if (g_mode == IRQ_MODE_IOAPIC)
+        ioapic_dump();
+}
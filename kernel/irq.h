@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+
+// Legacy IRQ lines 0-15 on vectors 0x20 + irq.
+// - Start on the 8259 PIC. irq_init_apic() moves them onto the IOAPIC
+//   (MADT overrides applied, LAPIC EOI) and masks the PIC for good.
+// - Drivers only use irq_enable/irq_disable; the mode is invisible to them.
+// - In IOAPIC mode a line can be steered to any online CPU.
+
+#define IRQ_VECTOR_BASE 0x20
+#define IRQ_LINES       16
+
+typedef enum
+{
+    IRQ_MODE_PIC = 0,
+    IRQ_MODE_IOAPIC
+} irq_mode_t;
+
+// BSP, after the LAPIC is up. Lines enabled so far keep working. 0 / -1 (stays on the PIC).
+int        irq_init_apic(void);
+irq_mode_t irq_mode(void);
+
+void       irq_enable(uint8_t irq);
+void       irq_disable(uint8_t irq);
+// PCI INTx on its legacy interrupt line: level-triggered, active-low unless
+// the MADT says otherwise.
+void       irq_enable_pci(uint8_t irq);
+// isr_common_handler: EOI + statistics for vectors 0x20-0x2F.
+void       irq_ack(uint32_t vector);
+// Deliver 'irq' to logical CPU 'cpu' (IOAPIC mode only). 0 / -1.
+int        irq_set_affinity(uint8_t irq, uint32_t cpu);
+void       irq_dump(void);
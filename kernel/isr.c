@@ -6,7 +6,11 @@
 #include "panic/panic.h"
 #include <stdbool.h>
 #include "io.h"
-#include "panic/panic.h"
+#include "apic.h"
+#include "irq.h"
+#include "task/task.h"
+#include "syscall.h"
+#include "task/exec.h"
 #ifndef COM1
 #define COM1 0x3F8
 #endif
@@ -55,14 +59,36 @@ void isr_common_handler(uint32_t vector, uint32_t error_code, uint64_t *frame) {
         for(;;);
     }
 
+    // int 0x80 호환 시스템콜: 레지스터를 직접 읽고 RAX에 결과를 쓴다
+    if (vector == 0x80) {
+        syscall_int80(INT_FRAME(frame));
+        return;
+    }
+
+    // 유저 주소공간의 demand paging (task/exec.c)
+    if (vector == 14 && uspace_page_fault(error_code, INT_FRAME(frame)) == 0)
+        return;
+
+    // 인터럽트 컨트롤러 EOI는 핸들러보다 먼저: 핸들러가 스케줄러를 불러
+    // 다른 태스크로 전환하면 이 프레임으로 한참 뒤에야 돌아오기 때문.
+    // (인터럽트 게이트라 IF=0이므로 먼저 보내도 중첩되지 않는다)
+    bool is_irq = (vector >= IRQ_VECTOR_BASE && vector < IRQ_VECTOR_BASE + IRQ_LINES);
+    if (is_irq)
+        irq_ack(vector);   // PIC 또는 IOAPIC 모드에 맞는 EOI
+    else if (vector >= APIC_VEC_TIMER && vector < APIC_VEC_SPURIOUS)
+        apic_eoi();
+
     // 사용자 핸들러
     if (vector < MAX_INTERRUPTS && handlers[vector]) {
         handlers[vector]();
+        // 핸들러가 등록된 CPU 예외(#NM 등)는 처리 완료로 보고 복귀
+        if (vector < 32)
+            return;
     }
 
-    // IRQ (PIC)
-    if (vector >= 0x20 && vector <= 0x2F) {
-        pic_eoi(vector - 0x20);
+    // IRQ: 핸들러가 더 급한 태스크를 깨웠으면 여기서 선점
+    if (vector >= 0x20) {
+        sched_irq_exit();
         return;
     }
 
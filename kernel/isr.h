@@ -15,3 +15,14 @@ typedef struct __attribute__((packed)) {
     uint32_t err_code;  // error code (or 0 if none)
     uint32_t eip, cs, eflags, useresp, ss;            // pushed automatically by CPU
 } isr_regs_t;
+
+// 64-bit: isr_common_entry가 PUSH_ALL로 쌓은 레지스터 + vector/error_code + CPU 프레임.
+// isr_common_handler의 frame은 rip을 가리키므로 INT_FRAME(frame)으로 전체를 얻는다.
+typedef struct int_frame {
+    uint64_t rax, rbx, rcx, rdx, rbp, rsi, rdi;
+    uint64_t r8, r9, r10, r11, r12, r13, r14, r15;
+    uint64_t vector, error_code;
+    uint64_t rip, cs, rflags, rsp, ss;
+} int_frame_t;
+
+#define INT_FRAME(frame) ((int_frame_t *)((uint64_t *)(frame) - 17))
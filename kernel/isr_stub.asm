@@ -42,6 +42,12 @@ GLOB_IRQ i
 ; System call (int 0x80)
 global isr_stub80
 
+; Local APIC vectors (timer, IPIs, spurious)
+global apic_stub240
+global apic_stub241
+global apic_stub242
+global apic_stub255
+
 ; ------------------------------
 ; 레지스터 세이브/리스토어
 ; ------------------------------
@@ -92,11 +98,17 @@ global isr_stub80
 ;      ...
 ; =======================================================
 isr_common_entry:
+    ; ring 3에서 들어왔으면 커널 GS(per-CPU)로 교체
+    test qword [rsp + 24], 3
+    jz .from_kernel
+    swapgs
+.from_kernel:
     PUSH_ALL
 
     ; PUSH_ALL 뒤 스택:
-    ;  [rsp           ] = r15
+    ;  [rsp           ] = rax (마지막에 푸시)
     ;  ...
+    ;  [rsp+14*8     ] = r15
     ;  [rsp+15*8     ] = vector
     ;  [rsp+15*8 + 8 ] = error_code
     ;  [rsp+15*8 +16 ] = RIP (CPU frame 시작)
@@ -112,6 +124,11 @@ isr_common_entry:
     ; vector + error_code 제거
     add rsp, 16
 
+    ; ring 3로 돌아가면 유저 GS를 되돌린다 ([rsp+8] = CS)
+    test qword [rsp + 8], 3
+    jz .to_kernel
+    swapgs
+.to_kernel:
     ; CPU가 푸시한 예외 프레임으로 복귀
     iretq
 
@@ -198,3 +215,20 @@ isr_stub80:
     push 0                  ; error_code = 0
     push 0x80               ; vector = 0x80
     jmp isr_common_entry
+
+; =======================================================
+; Local APIC (0xF0 timer, 0xF1 reschedule IPI,
+;             0xF2 TLB shootdown IPI, 0xFF spurious)
+;  - error_code 없음
+; =======================================================
+%macro APIC_STUB 1
+apic_stub%1:
+    push 0                  ; error_code = 0
+    push %1                 ; vector
+    jmp isr_common_entry
+%endmacro
+
+APIC_STUB 240
+APIC_STUB 241
+APIC_STUB 242
+APIC_STUB 255
@@ -6,12 +6,23 @@
 #include "gdt.h"
 #include "tss.h"
 #include "syscall.h"
+#include "uring.h"
+#include "uwin.h"
+#include "vdso.h"
+#include "ring.h"
+#include "input.h"
+#include "gui_event.h"
+#include "workqueue.h"
+#include "async.h"
+#include "isr.h"
+#include "task/exec.h"
 #include "multiboot2.h"
 #include "fb.h"
 #include "psf.h"
 #include "bootinfo.h"
 #include "idt.h"
 #include "pic.h"
+#include "irq.h"
 #include "pit.h"
 #include "serial.h"
 #include "keyboard.h"
@@ -30,7 +41,17 @@
 #include "config.h"
 #include "ui.h"
 #include "drivers/ac97.h"
+#include "dma.h"
 #include "wav.h"
+#include "arena.h"
+#include "kheap.h"
+#include "task/fpu.h"
+#include "task/task.h"
+#include "percpu.h"
+#include "mp.h"
+#include "tick.h"
+#include "clock.h"
+#include "ktimer.h"
 
 // BIOS
 #include "bios/rtc.h"
@@ -93,7 +114,6 @@ static void launch_toggle(int show);
 static void launch_activate(int idx);
 static void boot_anim_render(void);
 static void sound_play_wav_path(const char *path);
-void *kmalloc(size_t sz);
 void *ext_mem_alloc(size_t sz);
 
 // Simple linear resampler for 16-bit interleaved PCM
@@ -110,7 +130,7 @@ static uint16_t *resample_linear_16(const uint16_t *src, uint32_t src_frames, ui
     uint64_t bytes = samples * sizeof(uint16_t);
     serial_printf("[WAV] resample alloc: in_frames=%u out_frames=%llu ch=%u bytes=%llu\n",
                   src_frames, (unsigned long long)oframes, channels, (unsigned long long)bytes);
-    uint16_t *dst = kmalloc((size_t)bytes);
+    uint16_t *dst = kmalloc_tag((size_t)bytes, KMEM_TAG_AUDIO);
     if (!dst)
     {
         serial_printf("[WAV] resample alloc failed (%llu bytes)\n", (unsigned long long)bytes);
@@ -181,8 +201,6 @@ static char key_to_char(uint8_t sc)
 
 extern void limine_fill_bootinfo_from_fb(void);
 
-#define U_ENTRY 0x00800000u
-#define U_STACK_TOP 0x00C00000u
 
 extern uint32_t g_mbinfo_phys;
 extern uint32_t stack_top;
@@ -236,7 +254,7 @@ static void probe_back_tail(void)
 static void gui_draw_clock_fb(void)
 {
     rtc_time_t now;
-    rtc_read_time(&now);
+    clock_wall_time(&now);
     char buf[9];
     rtc_format(buf, &now);
 
@@ -254,32 +272,6 @@ static void gui_draw_clock_fb(void)
     draw_text(x0, y0, buf, 0xFFFFFFFF, 0xFF2A2A2A);
 }
 
-extern uint32_t pmm_alloc_phys(void);
-extern int vmm_map(uintptr_t v, uintptr_t p, uint32_t flags);
-
-static int map_user_minimal(void)
-{
-    uint32_t pa_code = pmm_alloc_phys();
-    uint32_t pa_stack = pmm_alloc_phys();
-    if (!pa_code || !pa_stack)
-    {
-        serial_printf("[user] pmm_alloc_phys failed\n");
-        return -1;
-    }
-    if (vmm_map(U_ENTRY, pa_code, VMM_P | VMM_RW | VMM_US))
-        return -1;
-    if (vmm_map(U_STACK_TOP - 0x1000, pa_stack, VMM_P | VMM_RW | VMM_US))
-        return -1;
-
-    return 0;
-}
-
-static const uint8_t user_stub[] = {0x90, 0xEB, 0xFE};
-
-static void load_user_stub(void)
-{
-    memcpy((void *)U_ENTRY, user_stub, sizeof(user_stub));
-}
 
 #if 0
 static inline void put_cell(size_t x, size_t y, char c, uint8_t color)
@@ -374,123 +366,9 @@ static inline void enable_io_full(void)
     serial_printf("[rflags-after]=%016lx\n", new_rflags);
 }
 
-/*
-static void jump_to_user(void)
-{
-    extern void user_mode_start(void);
-
-    uint32_t user_attack = 0x800000;
-
-    __asm__ volatile(
-        "cli\n"
-        "mov $0x23, %%ax\n"
-        "mov %%ax, %%ds\n"
-        "mov %%ax, %%es\n"
-        "mov %%ax, %%fs\n"
-        "mov %%ax, %%gs\n"
-        "pushl $0x23\n"
-        "pushl %[ustack]\n"
-        "pushfl\n"
-        "pushl $0x1B\n"
-        "pushl %[entry]\n"
-        "iret\n"
-        :
-        : [entry] "r"(user_mode_start), [ustack] "r"(user_attack)
-        : "ax");
-} */
-
-static void jump_to_user_real(uintptr_t entry, uintptr_t user_stack_top)
-{
-    if (!vmm_alloc_page(U_ENTRY, VMM_P | VMM_RW | VMM_US)) {
-        serial_printf("[user] map failed: entry\n");
-        for (;;)
-            __asm__ __volatile__("cli; hlt");
-    }
-    if (!vmm_alloc_page(U_STACK_TOP - 0x1000, VMM_P | VMM_RW | VMM_US)) {
-        serial_printf("[user] map failed: stack\n");
-        for (;;)
-            __asm__ __volatile__("cli; hlt");
-    }
-
-    volatile uint8_t *u = (uint8_t *)U_ENTRY;
-    u[0] = 0x90; /* NOP */
-    u[1] = 0xEB; /* JMP rel8 */
-    u[2] = 0xFE; /* -2 */
-
-    vmm_reload_cr3();
-
-    uintptr_t phys;
-    uint32_t fl;
-    int q = vmm_query(U_ENTRY, &phys, &fl);
-    serial_printf("[user] entry=%08lx stack=%08lx q=%d phys=%08lx fl=%08x\n",
-                  (unsigned long)U_ENTRY,
-                  (unsigned long)U_STACK_TOP,
-                  q,
-                  (unsigned long)phys,
-                  fl);
-
-    if (q != 0 || (fl & (VMM_P | VMM_US)) != (VMM_P | VMM_US)) {
-        serial_printf("[user] bad mapping (P/US missing)\n");
-        for (;;)
-            __asm__ __volatile__("cli; hlt");
-    }
-
-    __asm__ volatile(
-        "cli\n"
-        "mov $0x23, %%ax\n"       /* user data selector (DPL=3) */
-        "mov %%ax, %%ds\n"
-        "mov %%ax, %%es\n"
-        "mov %%ax, %%fs\n"
-        "mov %%ax, %%gs\n"
-        "pushq $0x23\n"           /* SS = user data */
-        "pushq %[ustack]\n"       /* RSP */
-        "pushfq\n"                /* RFLAGS */
-        "pushq $0x1B\n"           /* CS = user code */
-        "pushq %[entry]\n"        /* RIP */
-        "iretq\n"
-        :
-        : [entry]  "r" ((uint64_t)entry),
-          [ustack] "r" ((uint64_t)user_stack_top)
-        : "ax", "memory");
-}
 
 
 #define PAGE_SIZE 4096u
-// Grow kernel heap to 32 MiB so audio resample buffers fit
-#define KHEAP_PAGES 8192u
-
-static inline uintptr_t align_up(uintptr_t v, uintptr_t a)
-{
-    return (v + (a - 1)) & ~(a - 1);
-}
-
-static uint8_t *kheap_begin, *kheap_end, *kheap_brk;
-
-static void kheap_init(void)
-{
-    uintptr_t hb = align_up((uintptr_t)__kernel_high_end, PAGE_SIZE);
-    uintptr_t he = hb + KHEAP_PAGES * PAGE_SIZE;
-
-    // 힙 VA 범위 매핑
-    map_kernel_heap(hb, he);
-
-    kheap_begin = (uint8_t *)hb;
-    kheap_end   = (uint8_t *)he;
-    kheap_brk   = kheap_begin;
-
-    serial_printf("[kheap] heap=%p..%p\n", (void*)hb, (void*)he);
-}
-
-void *kmalloc(size_t sz)
-{
-    if (!sz)
-        return 0;
-    uintptr_t p = align_up((uintptr_t)kheap_brk, 8);
-    if (p + sz > (uintptr_t)kheap_end)
-        return 0;
-    kheap_brk = (uint8_t *)(p + sz);
-    return (void *)p;
-}
 
 // 커널 PMM은 사용하지 않고, Limine의 ext_mem_alloc 기반 HHDM만 사용
 
@@ -585,6 +463,7 @@ typedef struct
     int can_maximize;
     char path[128];
     char name[32];
+    char status[32];
 } wavplay_t;
 static wavplay_t g_wavplay = {0};
 static int topmenu_active_window(void);
@@ -724,6 +603,9 @@ static void desktop_render(void)
     else if (front == g_win_wavplay)
         wavplay_render();
 
+    // User process windows: a layer above the built-in apps
+    uwin_composite();
+
     // Top menu (between branding and clock)
     topmenu_draw();
 
@@ -811,6 +693,10 @@ static void desktop_render(void)
 
     // 9) Present back buffer to front
     fb_flush();
+    input_frame_presented();
+
+    // 10) Per-frame scratch memory is released in bulk
+    frame_arena_end_frame();
 }
 
 static int str_ieq_ext(const char *name, const char *ext)
@@ -853,11 +739,16 @@ static int find_first_wallpaper_name(char *out, size_t out_sz)
     if (!out || out_sz == 0)
         return -1;
 
-    fat32_dirent_t entries[128];
+    // Heap rather than the frame arena: the image viewer calls this from a worker.
+    fat32_dirent_t *entries = kmalloc_tag(128 * sizeof(fat32_dirent_t), KMEM_TAG_FS);
     int n = 0;
-    if (fat32_list_root_array(&g_vol, ata_read28, entries, 128, &n) != 0)
+    if (!entries || fat32_list_root_array(&g_vol, ata_read28, entries, 128, &n) != 0)
+    {
+        kfree(entries);
         return -1;
+    }
 
+    int ret = -1;
     for (int i = 0; i < n; ++i)
     {
         if (entries[i].attr & 0x10) // directory bit
@@ -869,10 +760,12 @@ static int find_first_wallpaper_name(char *out, size_t out_sz)
         for (; j + 1 < (int)out_sz && entries[i].name83[j]; ++j)
             out[j] = entries[i].name83[j];
         out[j] = 0;
-        return 0;
+        ret = 0;
+        break;
     }
 
-    return -1;
+    kfree(entries);
+    return ret;
 }
 
 // --- User accounts / login ---
@@ -1177,6 +1070,7 @@ static void login_render(void)
 
     fb_draw_cursor(mouse_get_x(), mouse_get_y());
     fb_flush();
+    input_frame_presented();
     g_login_dirty = 0;
 }
 
@@ -1206,39 +1100,138 @@ static void ensure_user_dirs_on_disk(const char *uname)
     fat32_ensure_dir_path(&g_vol, ata_read28, ata_write28, user_dir);
 }
 
+// Desktop listing runs on the GUI worker: the user-dir check and the FAT walk
+// hit the disk, the GUI thread only swaps in the finished item list.
+typedef struct
+{
+    gui_job_t      job;
+    char           user[16];
+    char           dir[64];
+    int            count;
+    desktop_item_t items[DESKTOP_MAX_ITEMS];
+} desktop_refresh_job_t;
+
+static int g_refresh_inflight;
+static int g_refresh_again;   // 도는 동안 또 요청됨 → 끝나면 한 번 더
+
+static void desktop_refresh_run(gui_job_t *job)
+{
+    desktop_refresh_job_t *rj = (desktop_refresh_job_t *)job;
+    ensure_user_dirs_on_disk(rj->user);
+    fat32_dirent_t *tmp = kmalloc_tag(128 * sizeof(fat32_dirent_t), KMEM_TAG_DESKTOP);
+    int n = 0;
+    if (!tmp || fat32_list_dir_path(&g_vol, ata_read28, rj->dir, tmp, 128, &n) != 0)
+    {
+        job->result = -1;
+        if (tmp)
+            kfree(tmp);
+        return;
+    }
+    int count = 0;
+    for (int i = 0; i < n && count < DESKTOP_MAX_ITEMS; ++i)
+    {
+        // Skip zero-length files as "deleted" entries (we zero files on delete)
+        if (!(tmp[i].attr & 0x10) && tmp[i].size == 0)
+            continue;
+        desktop_item_t *it = &rj->items[count];
+        int j = 0;
+        for (; j < (int)sizeof(it->name) - 1 && tmp[i].name83[j]; ++j)
+            it->name[j] = tmp[i].name83[j];
+        it->name[j] = 0;
+        it->attr = tmp[i].attr;
+        it->size = tmp[i].size;
+        count++;
+    }
+    rj->count = count;
+    kfree(tmp);
+}
+
+static void desktop_refresh_done(gui_job_t *job)
+{
+    desktop_refresh_job_t *rj = (desktop_refresh_job_t *)job;
+    // 도는 사이 로그인 사용자가 바뀌었으면 버리고 새로 읽는다
+    if (strcmp(rj->dir, g_desktop_dir) == 0)
+    {
+        if (job->result == 0)
+            desktop_set_items(rj->items, rj->count);
+        else
+            desktop_set_items(NULL, 0);
+        desktop_mark_dirty();
+    }
+    else
+        g_refresh_again = 1;
+    kfree(rj);
+    g_refresh_inflight = 0;
+    if (g_refresh_again)
+        desktop_refresh_from_path();
+}
+
 static void desktop_refresh_from_path(void)
 {
     if (!g_vol_mounted)
         return;
-    ensure_user_dirs_on_disk(g_logged_in_user);
-    fat32_dirent_t tmp[128];
-    int n = 0;
-    if (fat32_list_dir_path(&g_vol, ata_read28, g_desktop_dir, tmp, 128, &n) == 0)
+    if (g_refresh_inflight)
     {
-        desktop_item_t items[DESKTOP_MAX_ITEMS];
-        int count = 0;
-        for (int i = 0; i < n && count < DESKTOP_MAX_ITEMS; ++i)
-        {
-            // Skip zero-length files as "deleted" entries (we zero files on delete)
-            if (!(tmp[i].attr & 0x10) && tmp[i].size == 0)
-                continue;
-            int j = 0;
-            for (; j < (int)sizeof(items[count].name) - 1 && tmp[i].name83[j]; ++j)
-                items[count].name[j] = tmp[i].name83[j];
-            items[count].name[j] = 0;
-            items[count].attr = tmp[i].attr;
-            items[count].size = tmp[i].size;
-            count++;
-        }
-        desktop_set_items(items, count);
-        desktop_mark_dirty();
-        desktop_render();
+        g_refresh_again = 1;
+        return;
+    }
+    desktop_refresh_job_t *rj = kmalloc_tag(sizeof(*rj), KMEM_TAG_DESKTOP);
+    if (!rj)
+        return;
+    memset(rj, 0, sizeof(*rj));
+    strncpy(rj->user, g_logged_in_user, sizeof(rj->user) - 1);
+    strncpy(rj->dir, g_desktop_dir, sizeof(rj->dir) - 1);
+    rj->job.run = desktop_refresh_run;
+    rj->job.done = desktop_refresh_done;
+    g_refresh_inflight = 1;
+    g_refresh_again = 0;
+    gui_job_submit(fs_wq, &rj->job);
+}
+
+// Delete = zero the file (no unlink in fs_fat32 yet); the write goes through fs_wq.
+typedef struct
+{
+    gui_job_t   job;
+    char        path[128];
+    const char *tag;
+    int         filewin;   // 파일 창 목록도 다시 읽는다
+} file_zero_job_t;
+
+static void file_zero_run(gui_job_t *job)
+{
+    file_zero_job_t *zj = (file_zero_job_t *)job;
+    job->result = fat32_write_file_path(&g_vol, ata_read28, ata_write28, zj->path, "", 0);
+}
+
+static void file_zero_done(gui_job_t *job)
+{
+    file_zero_job_t *zj = (file_zero_job_t *)job;
+    if (job->result == 0)
+    {
+        serial_printf("[%s] deleted (zeroed) %s\n", zj->tag, zj->path);
+        if (zj->filewin)
+            filewin_refresh_list();
+        desktop_refresh_from_path();
     }
     else
     {
-        desktop_set_items(NULL, 0);
-        desktop_mark_dirty();
+        serial_printf("[%s] delete failed (%d) %s\n", zj->tag, job->result, zj->path);
     }
+    kfree(zj);
+}
+
+static void file_zero_async(const char *path, const char *tag, int filewin)
+{
+    file_zero_job_t *zj = kmalloc_tag(sizeof(*zj), KMEM_TAG_FS);
+    if (!zj)
+        return;
+    memset(zj, 0, sizeof(*zj));
+    strncpy(zj->path, path, sizeof(zj->path) - 1);
+    zj->tag = tag;
+    zj->filewin = filewin;
+    zj->job.run = file_zero_run;
+    zj->job.done = file_zero_done;
+    gui_job_submit(fs_wq, &zj->job);
 }
 
 static void desktop_delete_selection(void)
@@ -1251,41 +1244,64 @@ static void desktop_delete_selection(void)
         return;
     char full[96];
     desktop_path_for_name(full, sizeof(full), it->name);
-    int r = fat32_write_file_path(&g_vol, ata_read28, ata_write28, full, "", 0);
-    if (r == 0)
-    {
-        serial_printf("[DESKTOP] deleted (zeroed) %s\n", full);
-        desktop_refresh_from_path();
-    }
-    else
-    {
-        serial_printf("[DESKTOP] delete failed (%d) %s\n", r, full);
-    }
+    file_zero_async(full, "DESKTOP", 0);
 }
 
-static void sound_play_wav_path(const char *path)
+// WAV playback as a coroutine: the file read queues behind the other FAT
+// traffic on fs_wq, decode/resample/start runs on audio_wq (one at a time,
+// the AC'97 DMA buffer is shared), then the player counts down the clip on
+// GUI timers.
+static struct
 {
-    if (!path || !ac97_is_ready() || !g_vol_mounted)
-        return;
+    async_t   task;
+    char      path[128];
+    char      next_path[128];  // 도는 중에 눌린 Play: 끝나면 이것으로 다시 시작
+    uint8_t  *buf;
+    uint32_t  len;
+    uint32_t  ms_left;    // 재생 길이로 어림한 남은 시간
+    uint32_t  ms_step;
+} g_wavload;
+
+static void wavplay_set_status(const char *st)
+{
+    strncpy(g_wavplay.status, st, sizeof(g_wavplay.status) - 1);
+    g_wavplay.status[sizeof(g_wavplay.status) - 1] = 0;
+    desktop_mark_dirty();
+}
+
+static int wav_read_io(async_t *t)
+{
+    (void)t;
     uint32_t max_sz = 2 * 1024 * 1024;
-    uint8_t *buf = kmalloc(max_sz);
-    if (!buf)
-        return;
+    uint8_t *buf = kmalloc_tag(max_sz, KMEM_TAG_FS);
     uint32_t read = 0;
-    if (fat32_read_file_path(&g_vol, ata_read28, path, buf, max_sz, &read) != 0 || read < 44)
-        return;
+    if (!buf || fat32_read_file_path(&g_vol, ata_read28, g_wavload.path, buf, max_sz, &read) != 0 || read < 44)
+    {
+        kfree(buf);
+        return -1;
+    }
+    kshrink(buf, read);
+    g_wavload.buf = buf;
+    g_wavload.len = read;
+    return 0;
+}
+
+static int wav_start_io(async_t *t)
+{
+    (void)t;
     wav_info_t info;
-    if (wav_parse(buf, read, &info) != 0 || info.bits != 16 || info.channels == 0)
-        return;
+    if (wav_parse(g_wavload.buf, g_wavload.len, &info) != 0 || info.bits != 16 || info.channels == 0)
+        return -1;
     uint32_t frames = info.data_bytes / (info.channels * 2);
     uint32_t rate = info.rate ? info.rate : 48000;
     const uint16_t *pcm = (const uint16_t *)info.data;
+    uint16_t *rbuf = NULL;
 
     // Resample to 48 kHz to avoid host/backend quirks with uncommon rates.
     if (rate != 48000)
     {
         uint32_t rframes = 0;
-        uint16_t *rbuf = resample_linear_16(pcm, frames, (uint8_t)info.channels, rate, 48000, &rframes);
+        rbuf = resample_linear_16(pcm, frames, (uint8_t)info.channels, rate, 48000, &rframes);
         if (rbuf && rframes > 0)
         {
             serial_printf("[WAV] resample %u->48000 Hz: frames %u->%u\n", rate, frames, rframes);
@@ -1299,9 +1315,101 @@ static void sound_play_wav_path(const char *path)
         }
     }
 
+    if (frames > ac97_max_frames((uint8_t)info.channels))
+        frames = ac97_max_frames((uint8_t)info.channels);
     serial_printf("[WAV] play %s: rate=%u ch=%u frames=%u bytes=%u\n",
-                  path, rate, info.channels, frames, info.data_bytes);
-    ac97_play_pcm(pcm, frames, rate, (uint8_t)info.channels);
+                  g_wavload.path, rate, info.channels, frames, info.data_bytes);
+    int r = ac97_play_pcm(pcm, frames, rate, (uint8_t)info.channels);
+    g_wavload.ms_left = (uint32_t)((uint64_t)frames * 1000u / rate);
+
+    // ac97_play_pcm copies into its own DMA buffer; nothing here outlives the call
+    kfree(rbuf);
+    return r;
+}
+
+static void wavplay_task(async_t *t)
+{
+    ASYNC_BEGIN(t);
+    for (;;)
+    {
+        wavplay_set_status("Loading...");
+        await_io(t, fs_wq, wav_read_io);
+        if (t->result != 0 || async_canceled(t))
+        {
+            kfree(g_wavload.buf);
+            g_wavload.buf = NULL;
+            wavplay_set_status(t->result != 0 ? "Read failed" : "Stopped");
+            goto next;
+        }
+
+        wavplay_set_status("Decoding...");
+        await_io(t, audio_wq, wav_start_io);
+        kfree(g_wavload.buf);
+        g_wavload.buf = NULL;
+        if (t->result != 0)
+        {
+            wavplay_set_status("Unsupported format");
+            goto next;
+        }
+        // 디코드 중에 취소됐으면 방금 시작된 DMA를 멈춘다
+        if (async_canceled(t))
+        {
+            ac97_stop();
+            wavplay_set_status("Stopped");
+            goto next;
+        }
+
+        while (g_wavload.ms_left > 0 && !async_canceled(t))
+        {
+            sprintf(g_wavplay.status, "Playing, %u s left", (g_wavload.ms_left + 999u) / 1000u);
+            desktop_mark_dirty();
+            g_wavload.ms_step = g_wavload.ms_left < 1000u ? g_wavload.ms_left : 1000u;
+            await_sleep(t, g_wavload.ms_step);
+            g_wavload.ms_left -= g_wavload.ms_step;
+        }
+        if (async_canceled(t))
+        {
+            // 카운트다운만 끝내면 AC'97은 버퍼 끝까지 계속 튼다
+            ac97_stop();
+            wavplay_set_status("Stopped");
+        }
+        else
+        {
+            wavplay_set_status("Finished");
+        }
+
+    next:
+        // 도는 동안 Play가 다시 눌렸으면 그 파일로 처음부터 다시 한다
+        if (!g_wavload.next_path[0])
+            break;
+        memcpy(g_wavload.path, g_wavload.next_path, sizeof(g_wavload.path));
+        g_wavload.next_path[0] = 0;
+        g_wavload.len = 0;
+        g_wavload.ms_left = 0;
+        t->canceled = 0;
+    }
+    ASYNC_END(t);
+}
+
+static void sound_play_wav_path(const char *path)
+{
+    if (!path || !ac97_is_ready() || !g_vol_mounted)
+        return;
+    // 이미 돌고 있으면 새 경로를 맡기고 취소한다. 코루틴은 지금 단계(읽기/디코드는
+    // 끝난 뒤, 재생 대기는 즉시)에서 멈추고 맡긴 파일로 다시 시작한다.
+    if (async_busy(&g_wavload.task))
+    {
+        strncpy(g_wavload.next_path, path, sizeof(g_wavload.next_path) - 1);
+        g_wavload.next_path[sizeof(g_wavload.next_path) - 1] = 0;
+        async_cancel(&g_wavload.task);
+        return;
+    }
+    strncpy(g_wavload.path, path, sizeof(g_wavload.path) - 1);
+    g_wavload.path[sizeof(g_wavload.path) - 1] = 0;
+    g_wavload.buf = NULL;
+    g_wavload.len = 0;
+    g_wavload.ms_left = 0;
+    async_start(&g_wavload.task, wavplay_task, NULL, "wavplay");
 }
 
 static void desktop_move_selection(int delta)
@@ -1527,20 +1635,24 @@ static void cursor_load_from_disk(void)
     if (planes != 1 || bpp != 32 || comp != 0 || w <= 0 || h_raw == 0)
         return;
 
-    uint8_t *file_buf = kmalloc(file_size);
+    uint8_t *file_buf = kmalloc_tag(file_size, KMEM_TAG_FS);
     if (!file_buf)
         return;
     uint32_t full = 0;
-    if (fat32_read_file_path(&g_vol, ata_read28, path, file_buf, file_size, &full) != 0 || full < file_size)
-        return;
-
-    if (data_off >= file_size)
+    if (fat32_read_file_path(&g_vol, ata_read28, path, file_buf, file_size, &full) != 0 || full < file_size ||
+        data_off >= file_size)
+    {
+        kfree(file_buf);
         return;
+    }
     int top_down = (h_raw < 0);
     uint32_t h = (h_raw < 0) ? (uint32_t)(-h_raw) : (uint32_t)h_raw;
-    uint32_t *img = (uint32_t *)kmalloc((size_t)w * (size_t)h * sizeof(uint32_t));
+    uint32_t *img = (uint32_t *)kmalloc_tag((size_t)w * (size_t)h * sizeof(uint32_t), KMEM_TAG_DESKTOP);
     if (!img)
+    {
+        kfree(file_buf);
         return;
+    }
 
     const uint8_t *src = file_buf + data_off;
     uint32_t row_bytes = (uint32_t)w * 4;
@@ -1559,6 +1671,7 @@ static void cursor_load_from_disk(void)
             img[y * (uint32_t)w + x] = ((uint32_t)a << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
         }
     }
+    kfree(file_buf);
 
     // Downscale to a sane cursor size if needed
     const int CURSOR_MAX_DIM = 32;
@@ -1583,7 +1696,7 @@ static void cursor_load_from_disk(void)
     uint32_t *scaled = img;
     if (target_w != (int)w || target_h != (int)h)
     {
-        scaled = (uint32_t *)kmalloc((size_t)target_w * (size_t)target_h * sizeof(uint32_t));
+        scaled = (uint32_t *)kmalloc_tag((size_t)target_w * (size_t)target_h * sizeof(uint32_t), KMEM_TAG_DESKTOP);
         if (scaled)
         {
             for (int y = 0; y < target_h; ++y)
@@ -1595,6 +1708,7 @@ static void cursor_load_from_disk(void)
                     scaled[y * target_w + x] = img[sy * (int)w + sx];
                 }
             }
+            kfree(img);
         }
         else
         {
@@ -1605,6 +1719,8 @@ static void cursor_load_from_disk(void)
     }
 
     fb_set_cursor_image(scaled, target_w, target_h);
+    if (g_cursor_default_img && g_cursor_default_img != scaled)
+        kfree(g_cursor_default_img);
     g_cursor_default_img = scaled;
     g_cursor_default_w = target_w;
     g_cursor_default_h = target_h;
@@ -1742,22 +1858,31 @@ static void notepad_open(const char *name)
     notepad_open_path(fullpath);
 }
 
-static void notepad_open_path(const char *fullpath)
+// 파일 읽기는 fs_wq에서: 창은 읽기가 끝난 뒤 done()에서 연다. 그 사이 다른
+// 파일을 열면 먼저 읽던 것은 버린다.
+typedef struct
 {
-    if (!fullpath || !fullpath[0])
-        return;
+    gui_job_t job;
+    uint32_t  seq;
+    char      path[96];
+    uint32_t  len;
+    char      data[sizeof(((notepad_t *)0)->buf)];
+} notepad_load_job_t;
+
+static uint32_t g_notepad_load_seq;
 
+static void notepad_show(const char *fullpath, const char *data, uint32_t len)
+{
     memset(&g_notepad, 0, sizeof(g_notepad));
     notepad_set_path_and_name(fullpath);
     g_notepad.wx = 120;
     g_notepad.wy = 80;
     g_notepad.ww = (fb.width > 400) ? fb.width - 240 : 320;
     g_notepad.wh = (fb.height > 200) ? fb.height - 160 : 160;
-    uint32_t nread = 0;
-    int r = fat32_read_file_path(&g_vol, ata_read28, fullpath, g_notepad.buf, sizeof(g_notepad.buf) - 1, &nread);
-    if (r == 0)
+    if (data)
     {
-        g_notepad.len = (int)nread;
+        g_notepad.len = (int)len;
+        memcpy(g_notepad.buf, data, len);
         g_notepad.buf[g_notepad.len] = 0;
     }
     g_notepad.open = 1;
@@ -1771,6 +1896,41 @@ static void notepad_open_path(const char *fullpath)
     desktop_mark_dirty();
 }
 
+static void notepad_load_run(gui_job_t *job)
+{
+    notepad_load_job_t *lj = (notepad_load_job_t *)job;
+    job->result = fat32_read_file_path(&g_vol, ata_read28, lj->path, lj->data,
+                                       sizeof(lj->data) - 1, &lj->len);
+}
+
+static void notepad_load_done(gui_job_t *job)
+{
+    notepad_load_job_t *lj = (notepad_load_job_t *)job;
+    // 읽기 실패면 빈 문서로 연다 (새 파일)
+    if (lj->seq == g_notepad_load_seq)
+        notepad_show(lj->path, job->result == 0 ? lj->data : NULL, lj->len);
+    kfree(lj);
+}
+
+static void notepad_open_path(const char *fullpath)
+{
+    if (!fullpath || !fullpath[0])
+        return;
+
+    notepad_load_job_t *lj = kmalloc_tag(sizeof(*lj), KMEM_TAG_FS);
+    if (!lj)
+    {
+        serial_printf("[TXT] open %s: no memory\n", fullpath);
+        return;
+    }
+    memset(lj, 0, sizeof(*lj));
+    lj->seq = ++g_notepad_load_seq;
+    strncpy(lj->path, fullpath, sizeof(lj->path) - 1);
+    lj->job.run = notepad_load_run;
+    lj->job.done = notepad_load_done;
+    gui_job_submit(fs_wq, &lj->job);
+}
+
 static void notepad_close(void)
 {
     // 창이 마지막으로 그려졌던 영역을 복구
@@ -1785,35 +1945,6 @@ static void notepad_close(void)
     desktop_render();
 }
 
-static void notepad_save_as_auto(void)
-{
-    // Save to NOTE00.TXT .. NOTE99.TXT
-    for (int idx = 0; idx < 100; ++idx)
-    {
-        char nm[12];
-        nm[0] = 'N';
-        nm[1] = 'O';
-        nm[2] = 'T';
-        nm[3] = 'E';
-        nm[4] = (char)('0' + (idx / 10));
-        nm[5] = (char)('0' + (idx % 10));
-        nm[6] = '.';
-        nm[7] = 'T';
-        nm[8] = 'X';
-        nm[9] = 'T';
-        nm[10] = 0;
-        char fullpath[96];
-        desktop_path_for_name(fullpath, sizeof(fullpath), nm);
-        int r = fat32_write_file_path(&g_vol, ata_read28, ata_write28, fullpath, g_notepad.buf, (uint32_t)g_notepad.len);
-        if (r == 0)
-        {
-            serial_printf("[NOTEPAD] saved as %s\n", nm);
-            desktop_refresh_from_path();
-            break;
-        }
-    }
-}
-
 static void sanitize_txt_name(char *out, size_t outsz, const char *in)
 {
     size_t j = 0;
@@ -1896,6 +2027,7 @@ static int ensure_volume_mounted(void)
     if (mnt == 0)
     {
         g_vol_mounted = 1;
+        exec_set_volume(&g_vol, ata_read28, ata_write28);
         serial_printf("[TXT] auto-mounted FAT32 at LBA %u\n", mount_lba);
         ensure_user_dirs_on_disk(g_logged_in_user);
         desktop_refresh_from_path();
@@ -1906,6 +2038,54 @@ static int ensure_volume_mounted(void)
     return 0;
 }
 
+// 저장은 GUI 워커에서: 버퍼를 떠 두고 쓰기가 끝나면 done()에서 이름/경로를 바꾼다.
+typedef struct
+{
+    gui_job_t job;
+    char      name[32];
+    char      fullpath[96];
+    uint32_t  len;
+    char      data[];
+} notepad_save_job_t;
+
+static void notepad_save_run(gui_job_t *job)
+{
+    notepad_save_job_t *sj = (notepad_save_job_t *)job;
+    job->result = fat32_write_file_path(&g_vol, ata_read28, ata_write28, sj->fullpath,
+                                        sj->data, sj->len);
+}
+
+static void notepad_save_done(gui_job_t *job)
+{
+    notepad_save_job_t *sj = (notepad_save_job_t *)job;
+    if (job->result == 0)
+    {
+        strncpy(g_notepad.name, sj->name, sizeof(g_notepad.name) - 1);
+        g_notepad.name[sizeof(g_notepad.name) - 1] = 0;
+        notepad_set_path_and_name(sj->fullpath);
+        serial_printf("[TXT] saved %s\n", sj->name);
+        desktop_refresh_from_path();
+    }
+    else
+    {
+        serial_printf("[TXT] save failed (%d) for %s\n", job->result, sj->name);
+    }
+    kfree(sj);
+}
+
+// 지금 버퍼를 떠 둔 저장 job (빈 문서는 한 바이트: 0바이트 파일은 지운 것으로 본다)
+static notepad_save_job_t *notepad_save_job_new(void)
+{
+    uint32_t bytes = (g_notepad.len > 0) ? (uint32_t)g_notepad.len : 1;
+    notepad_save_job_t *sj = kmalloc_tag(sizeof(*sj) + bytes, KMEM_TAG_FS);
+    if (!sj)
+        return NULL;
+    memset(sj, 0, sizeof(*sj));
+    memcpy(sj->data, (g_notepad.len > 0) ? g_notepad.buf : "\n", bytes);
+    sj->len = bytes;
+    return sj;
+}
+
 static int notepad_save_current(const char *name_override)
 {
     if (!ensure_volume_mounted())
@@ -1921,29 +2101,82 @@ static int notepad_save_current(const char *name_override)
     char dir[96];
     path_dirname(dir, sizeof(dir), g_notepad.path[0] ? g_notepad.path : g_desktop_dir);
 
-    char fullpath[96];
+    notepad_save_job_t *sj = notepad_save_job_new();
+    if (!sj)
+    {
+        serial_printf("[TXT] save failed (no memory) for %s\n", name);
+        return -1;
+    }
+    memcpy(sj->name, name, sizeof(sj->name));
     if (dir[0])
-        path_join(fullpath, sizeof(fullpath), dir, name);
+        path_join(sj->fullpath, sizeof(sj->fullpath), dir, name);
     else
-        desktop_path_for_name(fullpath, sizeof(fullpath), name);
+        desktop_path_for_name(sj->fullpath, sizeof(sj->fullpath), name);
+    sj->job.run = notepad_save_run;
+    sj->job.done = notepad_save_done;
+    gui_job_submit(fs_wq, &sj->job);
+    return 0;
+}
 
-    uint32_t bytes = (g_notepad.len > 0) ? (uint32_t)g_notepad.len : 1;
-    int r = fat32_write_file_path(&g_vol, ata_read28, ata_write28, fullpath,
-                                  (g_notepad.len > 0) ? g_notepad.buf : "\n",
-                                  bytes);
-    if (r == 0)
-    {
-        strncpy(g_notepad.name, name, sizeof(g_notepad.name) - 1);
-        g_notepad.name[sizeof(g_notepad.name) - 1] = 0;
-        notepad_set_path_and_name(fullpath);
-        serial_printf("[TXT] saved %s\n", name);
+// Save to NOTE00.TXT .. NOTE99.TXT: 첫 번째로 써지는 이름을 워커에서 찾는다.
+// fullpath에는 처음에 폴더가 들어 있고, 성공하면 쓴 경로로 바뀐다.
+static void notepad_save_auto_run(gui_job_t *job)
+{
+    notepad_save_job_t *sj = (notepad_save_job_t *)job;
+    job->result = -1;
+    for (int idx = 0; idx < 100; ++idx)
+    {
+        char nm[12];
+        nm[0] = 'N';
+        nm[1] = 'O';
+        nm[2] = 'T';
+        nm[3] = 'E';
+        nm[4] = (char)('0' + (idx / 10));
+        nm[5] = (char)('0' + (idx % 10));
+        nm[6] = '.';
+        nm[7] = 'T';
+        nm[8] = 'X';
+        nm[9] = 'T';
+        nm[10] = 0;
+        char fullpath[96];
+        path_join(fullpath, sizeof(fullpath), sj->fullpath, nm);
+        job->result = fat32_write_file_path(&g_vol, ata_read28, ata_write28, fullpath, sj->data, sj->len);
+        if (job->result == 0)
+        {
+            memcpy(sj->name, nm, sizeof(nm));
+            memcpy(sj->fullpath, fullpath, sizeof(fullpath));
+            break;
+        }
+    }
+}
+
+static void notepad_save_auto_done(gui_job_t *job)
+{
+    notepad_save_job_t *sj = (notepad_save_job_t *)job;
+    if (job->result == 0)
+    {
+        serial_printf("[NOTEPAD] saved as %s\n", sj->name);
         desktop_refresh_from_path();
     }
     else
     {
-        serial_printf("[TXT] save failed (%d) for %s\n", r, name);
+        serial_printf("[NOTEPAD] save as failed (%d)\n", job->result);
     }
-    return r;
+    kfree(sj);
+}
+
+static void notepad_save_as_auto(void)
+{
+    notepad_save_job_t *sj = notepad_save_job_new();
+    if (!sj)
+    {
+        serial_printf("[NOTEPAD] save as failed (no memory)\n");
+        return;
+    }
+    strncpy(sj->fullpath, g_desktop_dir, sizeof(sj->fullpath) - 1);
+    sj->job.run = notepad_save_auto_run;
+    sj->job.done = notepad_save_auto_done;
+    gui_job_submit(fs_wq, &sj->job);
 }
 
 static void notepad_new(void)
@@ -1958,6 +2191,37 @@ static void notepad_new(void)
     desktop_mark_dirty();
 }
 
+// 새 파일 만들기도 fs_wq에서: 다 쓰면 done()에서 목록을 다시 읽고 편집기로 연다
+typedef struct
+{
+    gui_job_t job;
+    char      name[32];
+    char      fullpath[96];
+} txt_create_job_t;
+
+static void txt_create_run(gui_job_t *job)
+{
+    txt_create_job_t *cj = (txt_create_job_t *)job;
+    const char placeholder = '\n'; // ensure non-zero size so it shows in filtered lists
+    job->result = fat32_write_file_path(&g_vol, ata_read28, ata_write28, cj->fullpath, &placeholder, 1);
+}
+
+static void txt_create_done(gui_job_t *job)
+{
+    txt_create_job_t *cj = (txt_create_job_t *)job;
+    if (job->result == 0)
+    {
+        serial_printf("[TXT] created %s\n", cj->name);
+        desktop_refresh_from_path();
+        notepad_open_path(cj->fullpath);
+    }
+    else
+    {
+        serial_printf("[TXT] create failed (%d) for %s\n", job->result, cj->name);
+    }
+    kfree(cj);
+}
+
 static void create_txt_file_from_prompt(void)
 {
     if (!ensure_volume_mounted() || g_vol.sec_per_clus == 0 || g_vol.tot_sec32 == 0 || g_vol.first_data_lba == 0)
@@ -1982,20 +2246,19 @@ static void create_txt_file_from_prompt(void)
     if (name[0] == 0)
         sanitize_txt_name(name, sizeof(name), "NEWFILE.TXT");
 
-    char fullpath[96];
-    desktop_path_for_name(fullpath, sizeof(fullpath), name);
-    const char placeholder = '\n'; // ensure non-zero size so it shows in filtered lists
-    int r = fat32_write_file_path(&g_vol, ata_read28, ata_write28, fullpath, &placeholder, 1);
-    if (r == 0)
+    txt_create_job_t *cj = kmalloc_tag(sizeof(*cj), KMEM_TAG_FS);
+    if (cj)
     {
-        serial_printf("[TXT] created %s\n", name);
-        desktop_refresh_from_path();
-        notepad_open(name);
-        wm_set_front(g_win_notepad);
+        memset(cj, 0, sizeof(*cj));
+        memcpy(cj->name, name, sizeof(cj->name));
+        desktop_path_for_name(cj->fullpath, sizeof(cj->fullpath), name);
+        cj->job.run = txt_create_run;
+        cj->job.done = txt_create_done;
+        gui_job_submit(fs_wq, &cj->job);
     }
     else
     {
-        serial_printf("[TXT] create failed (%d) for %s\n", r, name);
+        serial_printf("[TXT] create failed (no memory) for %s\n", name);
     }
 
     name_prompt_active = 0;
@@ -2159,6 +2422,82 @@ static void filewin_set_path(const char *path)
     desktop_mark_dirty();
 }
 
+// Directory listing as a coroutine (async.h): the FAT walk runs on fs_wq while
+// the window keeps drawing "Loading...". A refresh asked for while one is in
+// flight reads again once the current one is back.
+static struct
+{
+    async_t         task;
+    char            path[96];
+    int             again;
+    int             n;
+    fat32_dirent_t *tmp;
+} g_filewin_load;
+
+static int filewin_list_io(async_t *t)
+{
+    (void)t;
+    return fat32_list_dir_path(&g_vol, ata_read28, g_filewin_load.path, g_filewin_load.tmp,
+                               DESKTOP_MAX_ITEMS, &g_filewin_load.n);
+}
+
+static void filewin_load_task(async_t *t)
+{
+    ASYNC_BEGIN(t);
+    do
+    {
+        g_filewin_load.again = 0;
+        strncpy(g_filewin_load.path, g_filewin.path, sizeof(g_filewin_load.path) - 1);
+        g_filewin_load.path[sizeof(g_filewin_load.path) - 1] = 0;
+        g_filewin_load.n = 0;
+        g_filewin_load.tmp = kmalloc_tag(DESKTOP_MAX_ITEMS * sizeof(fat32_dirent_t), KMEM_TAG_FS);
+        if (!g_filewin_load.tmp)
+        {
+            strcpy(g_file_status, "Out of memory");
+            desktop_mark_dirty();
+            ASYNC_EXIT(t);
+        }
+        strcpy(g_file_status, "Loading...");
+        desktop_mark_dirty();
+
+        await_io(t, fs_wq, filewin_list_io);
+
+        // 도는 사이 경로가 또 바뀌었으면 이 결과는 버린다
+        if (!g_filewin_load.again)
+        {
+            if (t->result != 0)
+            {
+                strcpy(g_file_status, "Path not found");
+            }
+            else
+            {
+                const fat32_dirent_t *tmp = g_filewin_load.tmp;
+                int count = 0;
+                for (int i = 0; i < g_filewin_load.n && count < DESKTOP_MAX_ITEMS; ++i)
+                {
+                    // Skip zero-length files (treated as deleted placeholders)
+                    if (!(tmp[i].attr & 0x10) && tmp[i].size == 0)
+                        continue;
+                    int j = 0;
+                    for (; j < (int)sizeof(g_file_items[count].name) - 1 && tmp[i].name83[j]; ++j)
+                        g_file_items[count].name[j] = tmp[i].name83[j];
+                    g_file_items[count].name[j] = 0;
+                    g_file_items[count].attr = tmp[i].attr;
+                    g_file_items[count].size = tmp[i].size;
+                    count++;
+                }
+                g_file_item_count = count;
+                g_filewin.selection = -1;
+                strcpy(g_file_status, "OK");
+            }
+        }
+        kfree(g_filewin_load.tmp);
+        g_filewin_load.tmp = NULL;
+        desktop_mark_dirty();
+    } while (g_filewin_load.again && !async_canceled(t));
+    ASYNC_END(t);
+}
+
 static void filewin_refresh_list(void)
 {
     g_file_item_count = 0;
@@ -2168,32 +2507,12 @@ static void filewin_refresh_list(void)
         strcpy(g_file_status, "Disk not mounted");
         return;
     }
-
-    fat32_dirent_t tmp[DESKTOP_MAX_ITEMS];
-    int n = 0;
-    if (fat32_list_dir_path(&g_vol, ata_read28, g_filewin.path, tmp, DESKTOP_MAX_ITEMS, &n) != 0)
+    if (async_busy(&g_filewin_load.task))
     {
-        strcpy(g_file_status, "Path not found");
+        g_filewin_load.again = 1;
         return;
     }
-
-    int count = 0;
-    for (int i = 0; i < n && count < DESKTOP_MAX_ITEMS; ++i)
-    {
-        // Skip zero-length files (treated as deleted placeholders)
-        if (!(tmp[i].attr & 0x10) && tmp[i].size == 0)
-            continue;
-        int j = 0;
-        for (; j < (int)sizeof(g_file_items[count].name) - 1 && tmp[i].name83[j]; ++j)
-            g_file_items[count].name[j] = tmp[i].name83[j];
-        g_file_items[count].name[j] = 0;
-        g_file_items[count].attr = tmp[i].attr;
-        g_file_items[count].size = tmp[i].size;
-        count++;
-    }
-    g_file_item_count = count;
-    g_filewin.selection = -1;
-    strcpy(g_file_status, "OK");
+    async_start(&g_filewin_load.task, filewin_load_task, NULL, "filewin.list");
 }
 
 static void filewin_move_selection(int delta)
@@ -2219,17 +2538,7 @@ static void filewin_delete_selection(void)
         return; // skip directories for now
     char full[128];
     path_join(full, sizeof(full), g_filewin.path, it->name);
-    int r = fat32_write_file_path(&g_vol, ata_read28, ata_write28, full, "", 0);
-    if (r == 0)
-    {
-        serial_printf("[FILE] deleted (zeroed) %s\n", full);
-        filewin_refresh_list();
-        desktop_refresh_from_path();
-    }
-    else
-    {
-        serial_printf("[FILE] delete failed (%d) %s\n", r, full);
-    }
+    file_zero_async(full, "FILE", 1);
 }
 
 static void launch_refresh_items(void)
@@ -2772,13 +3081,16 @@ static void taskmgr_render(void)
     int bar_h = 10;
     int y = wy + 6;
 
-    char line[96];
+    char *line = arena_alloc(frame_arena(), 96);
+    if (!line)
+        return;
 
-    // Memory usage
-    extern uint32_t pmm_total_count(void);
-    extern uint32_t pmm_free_count(void);
-    uint32_t total_pages = pmm_total_count();
-    uint32_t free_pages = pmm_free_count();
+    // Memory/CPU/uptime from the shared data page (refreshed once a second)
+    vdso_stats_t st = { 0 };
+    if (vdso_data())
+        vdso_read_stats(vdso_data(), &st);
+    uint32_t total_pages = st.mem_total_pages;
+    uint32_t free_pages = st.mem_free_pages;
     uint32_t used_pages = (total_pages > free_pages) ? (total_pages - free_pages) : 0;
     int bar_x = wx + 6;
     int bar_y = y + psf_height() + 2;
@@ -2813,9 +3125,8 @@ static void taskmgr_render(void)
     }
 
     // Uptime (no width formatting; sprintf is minimal)
-    extern volatile uint64_t jiffies;
-    uint64_t ticks = jiffies;
-    uint32_t sec = (uint32_t)(ticks / 100u);
+    uint32_t sec = vdso_data() ? (uint32_t)(vdso_monotonic_ns(vdso_data()) / 1000000000ull)
+                               : (uint32_t)(jiffies / 100u);
     uint32_t min = sec / 60u;
     uint32_t hr = min / 60u;
     sec %= 60u;
@@ -2826,8 +3137,7 @@ static void taskmgr_render(void)
     y += row_h;
 
     // CPU usage (simple idle-ratio based)
-    extern uint32_t task_cpu_usage_percent(void);
-    uint32_t cpu_pct = task_cpu_usage_percent();
+    uint32_t cpu_pct = st.cpu_usage_pct;
     sprintf(line, "CPU: %u%%", cpu_pct);
     draw_text(wx + 6, y, line, 0xFFFFFFFF, 0xFF000000);
 
@@ -2841,6 +3151,93 @@ static void taskmgr_render(void)
         if (cpu_fill > 0)
             ui_draw_bar_soft(bar_x, bar_y, cpu_fill, bar_h, cpu_color);
     }
+    y = bar_y + bar_h + 6;
+
+    // Per-CPU load (SMP)
+    if (g_cpu_count > 1)
+    {
+        for (uint32_t i = 0; i < g_cpu_count && y + row_h <= wy + wh; ++i)
+        {
+            const cpu_t *c = &g_cpus[i];
+            uint32_t pct = i < VDSO_MAX_CPUS ? st.cpu_load_pct[i] : sched_cpu_load(i);
+            sprintf(line, "CPU%u: %u%%  tasks %u  steals %u", i, pct, c->nr_tasks, c->steals);
+            draw_text(wx + 6, y, line, c->online ? 0xFFFFFFFF : 0xFF808080, 0xFF000000);
+            int cbx = wx + ww / 2 + 40;
+            int cbw = wx + ww - 6 - cbx;
+            if (c->online && cbw > 16)
+            {
+                draw_rect(cbx, y + 3, cbw, bar_h, 0xFF202020);
+                int fill = (int)(cbw * pct / 100u);
+                if (fill > 0)
+                    ui_draw_bar_soft(cbx, y + 3, fill, bar_h, ui_usage_color(pct));
+            }
+            y += row_h;
+        }
+        y += 4;
+    }
+
+    // Per-task scheduling (effective priority, CPU time, run-queue wait)
+    if (y + row_h <= wy + wh)
+    {
+        draw_text(wx + 6, y, "Tasks (prio/nice, run ms, wait ms):", 0xFFCCCCCC, 0xFF000000);
+        y += row_h;
+    }
+    enum { SYSMON_MAX_TASKS = 32 };
+    task_stat_t *ts = arena_calloc(frame_arena(), SYSMON_MAX_TASKS, sizeof(task_stat_t));
+    int nts = ts ? task_snapshot(ts, SYSMON_MAX_TASKS) : 0;
+    for (int i = 0; i < nts && y + row_h <= wy + wh; ++i)
+    {
+        const task_stat_t *st = &ts[i];
+        if (st->dl)
+            sprintf(line, "  %u %s cpu%u  EDF miss %u  %u  %u", st->tid, st->name ? st->name : "?",
+                    st->cpu, st->dl_misses,
+                    (uint32_t)(st->runtime_ns / 1000000u), (uint32_t)(st->wait_ns / 1000000u));
+        else
+            sprintf(line, "  %u %s cpu%u  %d/%d  %u  %u", st->tid, st->name ? st->name : "?",
+                    st->cpu, st->prio, st->nice,
+                    (uint32_t)(st->runtime_ns / 1000000u), (uint32_t)(st->wait_ns / 1000000u));
+        uint32_t fg = st->state == TASK_RUNNING ? 0xFF80FF80 : 0xFFFFFFFF;
+        if (st->dl && st->dl_misses)
+            fg = 0xFFFF8080;
+        draw_text(wx + 6, y, line, fg, 0xFF000000);
+        y += row_h;
+    }
+
+    // Frame scratch arena (last frame peak / all-time high-water)
+    const arena_t *fa = frame_arena();
+    if (y + row_h <= wy + wh)
+    {
+        sprintf(line, "Frame arena: %u / %u KB peak, max %u KB",
+                (uint32_t)(fa->last_peak / 1024u), (uint32_t)(fa->size / 1024u),
+                (uint32_t)(fa->high_water / 1024u));
+        draw_text(wx + 6, y, line, 0xFFFFFFFF, 0xFF000000);
+        y += row_h;
+    }
+    if (fa->failures && y + row_h <= wy + wh)
+    {
+        sprintf(line, "Frame arena overflows: %u", fa->failures);
+        draw_text(wx + 6, y, line, 0xFFFF8080, 0xFF000000);
+        y += row_h;
+    }
+
+    // Per-subsystem heap usage (live / peak / allocation rate)
+    if (y + row_h <= wy + wh)
+    {
+        draw_text(wx + 6, y, "Allocations (live / peak KB, rate):", 0xFFCCCCCC, 0xFF000000);
+        y += row_h;
+    }
+    for (int t = 0; t < KMEM_TAG_COUNT && y + row_h <= wy + wh; ++t)
+    {
+        const kmem_tag_stats_t *st = kmem_tag_stats((kmem_tag_t)t);
+        if (!st || !st->allocs)
+            continue;
+        sprintf(line, "  %s: %u / %u KB, %u B/s, %u blocks",
+                kmem_tag_name((kmem_tag_t)t),
+                (uint32_t)(st->live / 1024u), (uint32_t)(st->peak / 1024u),
+                st->rate, st->allocs - st->frees);
+        draw_text(wx + 6, y, line, st->rate ? 0xFFFFD080 : 0xFFFFFFFF, 0xFF000000);
+        y += row_h;
+    }
 }
 
 static void taskmgr_taskbar_click(wm_entry_t *win, void *user)
@@ -3074,6 +3471,7 @@ typedef struct
     int can_maximize;
     uint32_t *img;
     int img_w, img_h;
+    int img_evicted;   // image dropped by the shrinker; reload from path
     char path[96];
 } imgview_t;
 
@@ -3081,9 +3479,30 @@ static imgview_t g_imgview = {0};
 
 static void imgview_free_image(void)
 {
-    // no free available; keep simple leak avoidance by reusing single buffer
+    kfree(g_imgview.img);
     g_imgview.img = NULL;
     g_imgview.img_w = g_imgview.img_h = 0;
+    g_imgview.img_evicted = 0;
+}
+
+// Shrinker: a minimized viewer can drop its decoded image and reload it later.
+static size_t imgview_shrink_count(void *user)
+{
+    (void)user;
+    if (!g_imgview.img || (g_imgview.open && !g_imgview.minimized))
+        return 0;
+    return (size_t)g_imgview.img_w * (size_t)g_imgview.img_h * sizeof(uint32_t);
+}
+
+static size_t imgview_shrink_scan(size_t want, void *user)
+{
+    (void)want;
+    size_t bytes = imgview_shrink_count(user);
+    if (!bytes)
+        return 0;
+    imgview_free_image();
+    g_imgview.img_evicted = 1;
+    return bytes;
 }
 
 static int imgview_load_bmp(const char *fullpath, uint32_t **out_img, int *ow, int *oh)
@@ -3107,20 +3526,25 @@ static int imgview_load_bmp(const char *fullpath, uint32_t **out_img, int *ow, i
         return -1;
     if (planes != 1 || (bpp != 24 && bpp != 32) || comp != 0 || w <= 0 || h_raw == 0)
         return -1;
-    uint8_t *buf = kmalloc(file_size);
+    uint8_t *buf = kmalloc_tag(file_size, KMEM_TAG_FS);
     if (!buf)
         return -1;
     uint32_t full = 0;
-    if (fat32_read_file_path(&g_vol, ata_read28, fullpath, buf, file_size, &full) != 0 || full < file_size)
-        return -1;
-    if (data_off >= file_size)
+    if (fat32_read_file_path(&g_vol, ata_read28, fullpath, buf, file_size, &full) != 0 || full < file_size ||
+        data_off >= file_size)
+    {
+        kfree(buf);
         return -1;
+    }
     uint32_t h = (h_raw < 0) ? (uint32_t)(-h_raw) : (uint32_t)h_raw;
     int top_down = (h_raw < 0);
     uint32_t row_bytes_raw = ((uint32_t)w * (uint32_t)bpp + 31) / 32 * 4;
-    uint32_t *img = (uint32_t *)kmalloc((size_t)w * (size_t)h * sizeof(uint32_t));
+    uint32_t *img = (uint32_t *)kmalloc_tag((size_t)w * (size_t)h * sizeof(uint32_t), KMEM_TAG_IMAGE);
     if (!img)
+    {
+        kfree(buf);
         return -1;
+    }
     const uint8_t *src = buf + data_off;
     for (uint32_t y = 0; y < h; ++y)
     {
@@ -3135,6 +3559,7 @@ static int imgview_load_bmp(const char *fullpath, uint32_t **out_img, int *ow, i
             img[y * (uint32_t)w + x] = ((uint32_t)a << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
         }
     }
+    kfree(buf);
     *out_img = img;
     *ow = w;
     *oh = (int)h;
@@ -3232,26 +3657,57 @@ static void imgview_toggle_maximize(void)
     desktop_mark_dirty();
 }
 
-static void imgview_open_path(const char *fullpath)
+// BMP read + decode as a coroutine: both run on fs_wq, the viewer window
+// opens when the image is ready.
+static struct
 {
-    if (!fullpath || !fullpath[0])
-        return;
-    if (!ensure_volume_mounted())
-        return;
+    async_t   task;
+    char      path[96];
+    int       fallback;   // 실패하면 벽지 폴더의 첫 BMP
+    uint32_t *img;
+    int       w, h;
+} g_imgview_load;
+
+static int imgview_load_io(async_t *t)
+{
+    (void)t;
+    return imgview_load_bmp(g_imgview_load.path, &g_imgview_load.img, &g_imgview_load.w, &g_imgview_load.h);
+}
+
+static int imgview_fallback_io(async_t *t)
+{
+    (void)t;
+    char wp_name[13] = "WALLPAPR.BMP";
+    if (find_first_wallpaper_name(wp_name, sizeof(wp_name)) != 0)
+        return -1;
+    path_join(g_imgview_load.path, sizeof(g_imgview_load.path), "PARANOS/WALLPAPR", wp_name);
+    return imgview_load_io(t);
+}
 
-    uint32_t *img = NULL;
-    int w = 0, h = 0;
-    if (imgview_load_bmp(fullpath, &img, &w, &h) != 0)
+static void imgview_load_task(async_t *t)
+{
+    ASYNC_BEGIN(t);
+    await_io(t, fs_wq, imgview_load_io);
+    if (t->result != 0 && g_imgview_load.fallback && !async_canceled(t))
+        await_io(t, fs_wq, imgview_fallback_io);
+    if (t->result != 0)
     {
-        serial_printf("[IMG] load failed: %s\n", fullpath);
-        return;
+        serial_printf("[IMG] load failed: %s\n", g_imgview_load.path);
+        ASYNC_EXIT(t);
+    }
+    if (async_canceled(t))
+    {
+        kfree(g_imgview_load.img);
+        g_imgview_load.img = NULL;
+        ASYNC_EXIT(t);
     }
 
     imgview_free_image();
-    g_imgview.img = img;
-    g_imgview.img_w = w;
-    g_imgview.img_h = h;
-    strncpy(g_imgview.path, fullpath, sizeof(g_imgview.path) - 1);
+    g_imgview.img = g_imgview_load.img;
+    g_imgview.img_w = g_imgview_load.w;
+    g_imgview.img_h = g_imgview_load.h;
+    g_imgview_load.img = NULL;
+    strncpy(g_imgview.path, g_imgview_load.path, sizeof(g_imgview.path) - 1);
     g_imgview.path[sizeof(g_imgview.path) - 1] = 0;
 
     g_imgview.open = 1;
@@ -3266,6 +3722,30 @@ static void imgview_open_path(const char *fullpath)
 
     wm_set_front(g_win_imgview);
     desktop_mark_dirty();
+    ASYNC_END(t);
+}
+
+static void imgview_load_async(const char *fullpath, int fallback)
+{
+    if (!fullpath || !fullpath[0])
+        return;
+    if (!ensure_volume_mounted())
+        return;
+    if (async_busy(&g_imgview_load.task))
+    {
+        serial_printf("[IMG] still loading %s\n", g_imgview_load.path);
+        return;
+    }
+    strncpy(g_imgview_load.path, fullpath, sizeof(g_imgview_load.path) - 1);
+    g_imgview_load.path[sizeof(g_imgview_load.path) - 1] = 0;
+    g_imgview_load.fallback = fallback;
+    g_imgview_load.img = NULL;
+    async_start(&g_imgview_load.task, imgview_load_task, NULL, "imgview.load");
+}
+
+static void imgview_open_path(const char *fullpath)
+{
+    imgview_load_async(fullpath, 0);
 }
 
 static void imgview_taskbar_click(wm_entry_t *win, void *user)
@@ -3275,20 +3755,19 @@ static void imgview_taskbar_click(wm_entry_t *win, void *user)
     if (!g_imgview.open)
     {
         // Try system wallpaper first, else first BMP in wallpaper dir
-        imgview_open_path(g_path_wallpaper);
-        if (!g_imgview.open)
-        {
-            char wp_name[13] = "WALLPAPR.BMP";
-            if (find_first_wallpaper_name(wp_name, sizeof(wp_name)) == 0)
-            {
-                char full[96];
-                path_join(full, sizeof(full), "PARANOS/WALLPAPR", wp_name);
-                imgview_open_path(full);
-            }
-        }
+        imgview_load_async(g_path_wallpaper, 1);
     }
     else
+    {
         g_imgview.minimized = !g_imgview.minimized;
+        if (!g_imgview.minimized && g_imgview.img_evicted)
+        {
+            char path[96];
+            strncpy(path, g_imgview.path, sizeof(path) - 1);
+            path[sizeof(path) - 1] = 0;
+            imgview_open_path(path);
+        }
+    }
     desktop_mark_dirty();
     desktop_render();
 }
@@ -3364,6 +3843,11 @@ static void wavplay_render(void)
     int y = btn_y + btn_h + 10;
     draw_text(wx + 12, y, "File:", COLOR_ACCENT, 0x00000000); y += psf_height() + 4;
     draw_text(wx + 12, y, g_wavplay.name[0] ? g_wavplay.name : "(none)", COLOR_TEXT, 0x00000000);
+    if (g_wavplay.status[0])
+    {
+        y += psf_height() + 8;
+        draw_text(wx + 12, y, g_wavplay.status, 0xFFB0B6BF, 0x00000000);
+    }
 }
 
 static void wavplay_taskbar_click(wm_entry_t *win, void *user)
@@ -3682,302 +4166,190 @@ static int taskbar_handle_shortcut_click(int mx, int my, int x, int y, int h)
     return 0;
 }
 
-void kmain(void)
+// --- Serial debug console (COM1, line based) ---
+typedef struct
 {
-    __asm__ __volatile__("cli");
-    //volatile uint16_t *vga = (uint16_t *)0xB8000;
-    //vga[1] = 0x074D;
-    //gdt_install_with_tss((uint32_t)&stack_top);
-    init_fpu_sse();
+    const char *name;
+    const char *help;
+    void (*run)(void);
+} sercon_cmd_t;
 
-    serial_init(COM1);
+static void sercon_help(void);
 
-    enable_io_iopl3();
-    enable_io_full();
+// Rest of the command line after the command name (may be empty).
+static const char *g_sercon_arg = "";
 
-    //kheap_init();
-    
-    
-    serial_printf("\nSTEP >> GDT and heap initialized.");
+static void sercon_exec_prog(void)
+{
+    const char *path = g_sercon_arg;
+    if (!path[0])
+    {
+        serial_printf("[console] usage: exec PATH\n");
+        return;
+    }
+    if (exec(path) < 0)
+        serial_printf("[console] exec %s failed\n", path);
+}
 
-    for (uint32_t i = 0; i < 1024; i++)
-        page_table0[i] = (i * 0x1000) | 0x3;
+static void sercon_locks(void)
+{
+    spin_dump(strlen(g_sercon_arg) == 5 && memcmp(g_sercon_arg, "reset", 5) == 0);
+}
 
-    serial_printf("\nSTEP >> PMM/VMM init Starting...\n");
-    serial_printf(" cr3=%p", (void *)(uintptr_t)read_cr3());
-    vmm_init(); // Grab current CR3/pagetables before we start mapping
-    serial_printf("\nSTEP >> vmm init OK.\n");
-    kheap_init();  
-    // Limine framebuffer 정보를 우선 사용
-    memset(&g_bootinfo, 0, sizeof(g_bootinfo));
-    limine_fill_bootinfo_from_fb();
-    // Multiboot2 경로는 g_mbinfo_phys가 채워져 있을 때만 사용
-    if (g_mbinfo_phys) {
-        bootinfo_parse(g_mbinfo_phys);
-    }
+static const sercon_cmd_t g_sercon_cmds[] = {
+    { "help", "list commands", sercon_help },
+    { "mem",  "heap usage per allocation tag", kmem_dump },
+    { "pcidbench", "address-space switch cost with/without PCID", vmm_pcid_bench },
+    { "fpu", "lazy FPU switching stats", fpu_dump },
+    { "cpus", "per-CPU load, run queues and IPIs", mp_dump },
+    { "tick", "LAPIC tick mode and per-CPU timer activity", tick_dump },
+    { "clock", "clocksource, uptime and wall time", clock_dump },
+    { "timers", "per-CPU timer wheel state", ktimer_dump },
+    { "edf", "deadline tasks, bandwidth and misses", sched_dl_dump },
+    { "tasks", "task list, reaper and stack/task caches", task_dump },
+    { "irqs", "IRQ routing mode, IOAPIC pins and counts", irq_dump },
+    { "sysbench", "null syscall round trip: SYSCALL vs int 0x80", syscall_bench },
+    { "exec", "exec PATH - run an ELF64 program from the FAT volume", sercon_exec_prog },
+    { "uringbench", "submission ring: enter per request vs batched", uring_bench },
+    { "uwindemo", "ring 3 client drawing into a shared window surface", uwin_demo },
+    { "vdso", "shared data page: clock parameters and stats", vdso_dump },
+    { "locks", "locks [reset] - spinlock acquisitions, contention and hold times", sercon_locks },
+    { "input", "input queue counts and input-to-photon latency", input_dump },
+    { "gui", "GUI thread wake-ups by reason and background jobs", gui_event_dump },
+    { "wq", "work queues: depth, enqueue-to-start latency, run time", workqueue_dump },
+    { "async", "in-kernel app coroutines and what each is waiting on", async_dump },
+    { "ringtest", "multi-CPU check of the MPSC ring and ticket spinlock", ring_selftest },
+    { "wqtest", "work queue check: delayed work, cancel and flush", workqueue_selftest },
+};
 
-    // PMM/커널 힙 초기화는 Limine의 HHDM + ext_mem_alloc에 의존하고,
-    // 여기서는 추가적인 저수준 매핑은 수행하지 않는다.
-    serial_printf("\nSTEP >> VMM initialized successfully.\n");
-    psf_init();
+static char g_sercon_line[64];
+static int g_sercon_len = 0;
 
-    serial_printf("\nSTEP >> VMM (no custom PMM) initialized successfully.\n");
-    
-    serial_printf("[dbg] before fb_map check\n");
-    g_fb_ready = 0;
-    if (g_bootinfo.fb_phys && g_bootinfo.fb_w && g_bootinfo.fb_h &&
-        g_bootinfo.fb_pitch && (g_bootinfo.fb_bpp == 24 || g_bootinfo.fb_bpp == 32))
+static void sercon_help(void)
+{
+    for (size_t i = 0; i < sizeof(g_sercon_cmds) / sizeof(g_sercon_cmds[0]); ++i)
+        serial_printf("[console] %s - %s\n", g_sercon_cmds[i].name, g_sercon_cmds[i].help);
+}
+
+static void sercon_exec(const char *cmd)
+{
+    if (!cmd[0])
+        return;
+    const char *arg = cmd;
+    while (*arg && *arg != ' ')
+        arg++;
+    size_t len = (size_t)(arg - cmd);
+    while (*arg == ' ')
+        arg++;
+    for (size_t i = 0; i < sizeof(g_sercon_cmds) / sizeof(g_sercon_cmds[0]); ++i)
     {
-        serial_printf("[dbg] calling fb_map phys=%x w=%u h=%u pitch=%u bpp=%u\n",
-                      (uint32_t)g_bootinfo.fb_phys, g_bootinfo.fb_w, g_bootinfo.fb_h,
-                      g_bootinfo.fb_pitch, g_bootinfo.fb_bpp);
-        if (fb_map(g_bootinfo.fb_phys, g_bootinfo.fb_w, g_bootinfo.fb_h,
-                   g_bootinfo.fb_pitch, g_bootinfo.fb_bpp) == 0)
+        const sercon_cmd_t *c = &g_sercon_cmds[i];
+        if (strlen(c->name) == len && memcmp(cmd, c->name, len) == 0)
         {
-            serial_printf("[fb] w=%d h=%d pitch=%d bpp=%d\n",
-                          fb.width, fb.height, fb.pitch, fb.bpp);
+            g_sercon_arg = arg;
+            c->run();
+            g_sercon_arg = "";
+            return;
+        }
+    }
+    serial_printf("[console] unknown command '%s' (try 'help')\n", cmd);
+}
 
-            serial_printf("[mb2-fb] w=%u h=%u bpp=%u\n",
-                g_bootinfo.fb_w,
-                g_bootinfo.fb_h,
-                g_bootinfo.fb_bpp);
-            // Softer desktop background with vertical gradient
-            uint32_t top_bg = 0xFF20262E;
-            uint32_t bot_bg = 0xFF0E1116;
-            serial_printf("[dbg] before draw_hgrad_rect\n");
-            ui_draw_hgrad_rect(0, 0, fb.width, fb.height, top_bg, bot_bg);
-            serial_printf("[dbg] before draw_text\n");
-        draw_text(20, 20, "Kernel starting...", 0xFFFFFFFF, top_bg);
-        serial_printf("[dbg] before fb_flush\n");
-        fb_flush();
-        serial_printf("[dbg] after fb_flush\n");
-        g_fb_ready = 1;
-        cursor_use_default();
-    }
-        else
+static void serial_console_poll(void)
+{
+    int c;
+    while ((c = serial_try_getc(COM1)) >= 0)
+    {
+        if (c == '\r' || c == '\n')
         {
-            serial_printf("Framebuffer mapping failed.\n");
+            g_sercon_line[g_sercon_len] = 0;
+            g_sercon_len = 0;
+            sercon_exec(g_sercon_line);
         }
+        else if ((c == 0x08 || c == 0x7F) && g_sercon_len > 0)
+            g_sercon_len--;
+        else if (c >= 0x20 && g_sercon_len < (int)sizeof(g_sercon_line) - 1)
+            g_sercon_line[g_sercon_len++] = (char)c;
     }
-    serial_printf("[dbg] after fb_map block fb_ready=%d\n", g_fb_ready);
-
-    serial_printf("[dbg] before idt_install_core\n");
-    idt_install_core();
-    serial_printf("[dbg] after idt_install_core\n");
-
-    // Install C-side ISR handler table before registering any device IRQs.
-    extern void isr_install(void);
-    isr_install();
-    serial_printf("[dbg] after isr_install\n");
-
-    pic_remap();
-    serial_printf("[dbg] after pic_remap\n");
-    pit_init(100);
-    serial_printf("[dbg] after pit_init\n");
-    keyboard_init();
-    serial_printf("[dbg] after keyboard_init\n");
-    probe_back_tail();
-    mouse_init(fb.width, fb.height);
-    serial_printf("[dbg] after mouse_init\n");
-    // Mouse IRQ handler is registered via isr_register_handler inside mouse_init.
-    // Unmask cascade + mouse IRQ (IRQ2 = PIC2 cascade, IRQ12 = PS/2 mouse).
-    pic_clear_mask(2);
-    pic_clear_mask(12);
-    desktop_config_frame_rate();
-
-    serial_write(COM1, "[serial] kernel up: IDT/PIC/PIT/KBD ready\r\n");
-
-    pic_clear_mask(0);
-    pic_clear_mask(1);
-
-    serial_printf("[dbg] before sti\n");
-    __asm__ __volatile__("sti"); // Enable interrupts
-    serial_printf("[dbg] after sti\n");
-
-    //write_center("-- All Drivers Initialized Successfully --", 0x0A, VGA_ROWS - 2);
+}
 
-    extern void tasking_init(void);
-    extern void start_scheduler(void);
-    serial_printf("DEBUG: before tasking_init\n");
-    tasking_init();
-    serial_printf("DEBUG: after tasking_init\n");
-    start_scheduler();
-    serial_printf("DEBUG: after start_scheduler\n");
-    syscall_init();
-    serial_printf("[Kernel] syscall ready.\n");
-    serial_printf("[user] entry=%x stack=%x\n", U_ENTRY, U_STACK_TOP);
-    if (map_user_minimal() == 0)
-    {
-        load_user_stub();
-        serial_printf("[user] minimal user mapping ready.\n");
-    }
-    else
-    {
-        serial_printf("[user] failed to prepare user mapping.\n");
-    }
+// COM1 receive: the console line is read by the GUI thread
+static void sercon_irq(void)
+{
+    gui_event_post(GUI_EV_SERIAL);
+}
 
-    // Init simple window manager (for GUI taskbar)
-    wm_init();
-    desktop_init();
-    ac97_init();
-    // Register Text Editor window for taskbar listing
-    g_win_notepad = wm_register_window("Text Editor", 0xFF5E8C31,
-                                       &g_notepad.open,
-                                       &g_notepad.minimized,
-                                       notepad_taskbar_click,
-                                       NULL);
-    // Register File Explorer window
-    g_win_file = wm_register_window("Explorer", 0xFF2F6FAB,
-                                    &g_filewin.open,
-                                    &g_filewin.minimized,
-                                    filewin_taskbar_click,
-                                    NULL);
-    // Register System Monitor window
-    g_win_taskmgr = wm_register_window("SysMon", 0xFFAA8844,
-                                       &g_taskmgr.open,
-                                       &g_taskmgr.minimized,
-                                       taskmgr_taskbar_click,
-                                       NULL);
-    // Register Display Settings window
-    g_win_display = wm_register_window("Display", 0xFF4488CC,
-                                       &g_display.open,
-                                       &g_display.minimized,
-                                       display_taskbar_click,
-                                       NULL);
-    // Register Terminal window
-    g_win_terminal = wm_register_window("Terminal", 0xFF8844AA,
-                                        &g_terminal.open,
-                                        &g_terminal.minimized,
-                                        terminal_taskbar_click,
-                                        NULL);
-    // Register Image Viewer window
-    g_win_imgview = wm_register_window("ImageView", 0xFF44AA88,
-                                       &g_imgview.open,
-                                       &g_imgview.minimized,
-                                       imgview_taskbar_click,
-                                       NULL);
-    // Register WAV Player window
-    g_win_wavplay = wm_register_window("WAV Player", 0xFF8899DD,
-                                       &g_wavplay.open,
-                                       &g_wavplay.minimized,
-                                       wavplay_taskbar_click,
-                                       NULL);
-    wm_set_front(g_win_taskmgr);
+static uint64_t g_gui_last_frame_ms;   // last desktop frame (ktime_ms)
+static uint64_t g_gui_last_second;     // wall-clock second shown by that frame
 
-    if (!g_fb_ready)
-    {
-        //write_center("-- GUI (FB not available) --", 0x0A, VGA_ROWS - 2);
-    }
-    rtc_time_t t;
-    rtc_read_time(&t);
-    serial_printf("[RTC] %02d:%02d:%02d\n", t.hh, t.mm, t.ss);
-    // jump_to_user_real(U_ENTRY, U_STACK_TOP);
+static uint64_t gui_wall_ns(void)
+{
+    uint64_t base, mult, boot_wall;
+    clock_get_params(&base, &mult, &boot_wall);
+    return boot_wall + ktime_ns();
+}
 
-    // --- Disk / FS probe ---
-    ata_init();
-    ata_identify_t id;
-    int idr = ata_identify(&id);
-    if (idr != 0 || !id.present)
+// How long the GUI thread may sleep when nothing wakes it
+static uint64_t gui_wait_timeout_ms(void)
+{
+    if (input_pending())
+        return 0;
+    uint64_t at = async_next_timeout_ms();   // 코루틴의 await_sleep
+    if (g_boot_anim)
+        return at < 1000 / HZ ? at : 1000 / HZ;
+    // 시계는 초 단위로만 바뀐다: 다음 초 경계에 깨서 다시 그린다 (샘플러도 이때)
+    uint64_t t = (1000000000ull - gui_wall_ns() % 1000000000ull) / 1000000ull + 1;
+    if (g_fb_ready && !g_login_active && desktop_dirty())
     {
-        serial_printf("[ATA] no primary master (idr=%d)\n", idr);
+        // 더러워졌어도 프레임 간격(desktop_frame_ticks)보다 자주 그리지는 않는다
+        uint64_t next = g_gui_last_frame_ms + desktop_frame_ticks_value() * (1000 / HZ);
+        uint64_t now = ktime_ms();
+        uint64_t d = next > now ? next - now : 0;
+        if (d < t)
+            t = d;
     }
-    else
-    {
-        uint8_t sec0[512];
-        if (ata_read28(0, 1, sec0) != 0)
-        {
-            serial_printf("[ATA] read LBA0 failed\n");
-        }
-        else
-        {
-            mbr_t m;
-            int mbr_r = mbr_parse(sec0, &m);
-            uint32_t mount_lba = 0;
-            int found = 0;
-            if (mbr_r == 0 && m.valid)
-            {
-                for (int i = 0; i < 4; ++i)
-                {
-                    if (m.parts[i].type != 0 && m.parts[i].sectors)
-                    {
-                        serial_printf("[MBR] part%d type=0x%02x lba=%u size=%u\n",
-                                      i, m.parts[i].type, m.parts[i].lba_first, m.parts[i].sectors);
-                    }
-                }
-                for (int i = 0; i < 4; ++i)
-                {
-                    if (m.parts[i].type == 0x0B || m.parts[i].type == 0x0C)
-                    {
-                        mount_lba = m.parts[i].lba_first;
-                        found = 1;
-                        break;
-                    }
-                }
-            }
-            else
-            {
-                serial_printf("[MBR] invalid or missing (mbr_r=%d), trying superfloppy at LBA0\n", mbr_r);
-            }
-
-            if (!found)
-                mount_lba = 0; // superfloppy fallback
+    return at < t ? at : t;
+}
 
-            int mnt = fat32_mount(&g_vol, ata_read28, mount_lba);
-            if (mnt == 0)
-            {
-                g_vol_mounted = 1;
-                serial_printf("[FAT32] mounted at LBA %u\n", mount_lba);
-                fat32_ensure_dir_path(&g_vol, ata_read28, ata_write28, g_path_base);
-                ensure_user_dirs_on_disk(g_logged_in_user);
-                desktop_refresh_from_path();
-                if (desktop_load_wallpaper_path(&g_vol, ata_read28, g_path_wallpaper) == 0)
-                {
-                    serial_printf("[WALLPAPER] loaded system wallpaper\n");
-                }
-                else
-                {
-                    serial_printf("[WALLPAPER] system wallpaper missing; trying root fallback\n");
-                    char wp_name[13] = "WALLPAPR.BMP";
-                    if (find_first_wallpaper_name(wp_name, sizeof(wp_name)) == 0 &&
-                        desktop_load_wallpaper(&g_vol, ata_read28, wp_name) == 0)
-                {
-                    serial_printf("[WALLPAPER] loaded fallback %s\n", wp_name);
-                }
-                else
-                {
-                    serial_printf("[WALLPAPER] no wallpaper or failed to load\n");
-                }
-            }
-                cursor_load_from_disk();
-                cursor_use_default();
-            }
-            else
-            {
-                serial_printf("[FAT32] mount failed at LBA %u (err=%d)\n", mount_lba, mnt);
-            }
-        }
-    }
-    ensure_user_store();
-    g_boot_anim_start = jiffies;
+// Desktop event loop: runs in its own kernel thread ("gui") and sleeps in
+// gui_event_wait() until input, a redraw request, a finished background job,
+// the serial console or the next clock second needs it.
+static void gui_main(void *arg)
+{
+    (void)arg;
 
     int last_mouse_x = -1;
     int last_mouse_y = -1;
+    // 배경/이미지 캐시 슈링커는 이 스레드에서만 돈다 (그리는 쪽이 잠그지 않는다)
+    kheap_set_gui_thread();
 
     for (;;)
     {
+        uint32_t why = gui_event_wait(gui_wait_timeout_ms());
+        if (why & GUI_EV_IO)
+            gui_jobs_complete();
+        if (why & GUI_EV_RECLAIM)
+            kheap_reclaim_background();
+        async_poll();
+
         static uint64_t last_rtc_update = 0;
 
         if (jiffies - last_rtc_update >= 100)
         {
+            kmem_tag_sample(jiffies - last_rtc_update);
+            sched_sample_load();
+            vdso_update_stats();
             last_rtc_update = jiffies;
+            kheap_reclaim_background();
             // serial_printf("[clock] tick=%llu\n", jiffies);
-            rtc_time_t now;
-            rtc_read_time(&now);
-            char buf[9];
-            rtc_format(buf, &now);
-            (void)buf;
         }
 
+        serial_console_poll();
+
+        // Input queue: all pending motion is applied, then one key/button event
+        input_event_t iev;
+        int has_ev = input_poll(&iev);
+
         // Boot animation before login
         if (g_boot_anim)
         {
@@ -3986,17 +4358,21 @@ void kmain(void)
             {
                 g_boot_anim = 0;
             }
-            __asm__ volatile("sti; hlt");
             continue;
         }
 
         // Keyboard input dispatch
-        uint8_t sc;
-        int has_sc = kbd_get_scancode(&sc);
+        int has_sc = has_ev && iev.type == INPUT_EV_KEY;
+        uint8_t sc = has_sc ? (uint8_t)(iev.code | (iev.value ? 0 : 0x80)) : 0;
         int release = 0;
         uint8_t scode = sc & 0x7F;
         if (has_sc && (sc & 0x80))
             release = 1;
+        // Focused user window takes the key; modifiers and Alt+Tab still reach the desktop
+        if (has_sc && !g_login_active && !(g_alt_down && scode == 0x0F) &&
+            uwin_key(scode, release, release ? 0 : key_to_char(scode)) &&
+            scode != 0x2A && scode != 0x36 && scode != 0x38 && scode != 0x3A && scode != 0x5B)
+            has_sc = 0;
         if (has_sc && release)
         {
             if (scode == 0x38)
@@ -4062,6 +4438,12 @@ void kmain(void)
             }
         }
 
+        // Mouse wheel moves the file window selection like the arrow keys
+        int wheel = input_wheel_take();
+        if (wheel && !g_login_active && g_filewin.open && !g_filewin.minimized &&
+            wm_get_front() == g_win_file)
+            filewin_move_selection(wheel > 0 ? +1 : -1);
+
         // Mouse click handling (desktop / windows / popup)
         static int prev_btn = 0;
         int btn = mouse_get_buttons();
@@ -4071,7 +4453,6 @@ void kmain(void)
             if (!g_fb_ready)
             {
                 prev_btn = btn;
-                __asm__ volatile("sti; hlt");
                 continue;
             }
 
@@ -4166,12 +4547,15 @@ void kmain(void)
                 }
             }
 
-            __asm__ volatile("sti; hlt");
             continue;
         }
 
         if (name_prompt_active && btn == 0)
             name_prompt_ready_click = 1;
+        // User windows are on top: they see the mouse first
+        if (!ctx_menu_visible && !g_launch_visible &&
+            uwin_mouse(mouse_get_x(), mouse_get_y(), btn, prev_btn))
+            goto after_left_click;
         if ((btn & 1) && !(prev_btn & 1))
         {
             int mx = mouse_get_x(), my = mouse_get_y();
@@ -4563,8 +4947,8 @@ void kmain(void)
                     {
                         static uint64_t file_last_click = 0;
                         static int file_last_idx = -1;
-                        uint64_t now = jiffies;
-                        int double_click = (idx == file_last_idx) && (now - file_last_click <= 50);
+                        uint64_t now = ktime_ms();
+                        int double_click = (idx == file_last_idx) && (now - file_last_click <= 500);
                         file_last_click = now;
                         file_last_idx = idx;
 
@@ -5136,9 +5520,8 @@ void kmain(void)
     after_keys:
         if (g_fb_ready)
         {
-        static uint64_t last_frame_tick = 0;
-        uint64_t frame_ticks = desktop_frame_ticks_value();
-        uint64_t now = jiffies;
+        uint64_t now = ktime_ms();
+        uint64_t second = gui_wall_ns() / 1000000000ull;
 
         int mx = mouse_get_x();
         int my = mouse_get_y();
@@ -5163,16 +5546,327 @@ void kmain(void)
         if (moved)
             desktop_mark_dirty();
 
-        // Redraw on timer or when desktop dirty; cursor/time updated in desktop_render
-        if ((now - last_frame_tick >= frame_ticks) || desktop_dirty())
+        // Redraw when dirty (at most once per frame interval) or when the clock
+        // shows a new second; cursor/time updated in desktop_render
+        uint64_t frame_ms = desktop_frame_ticks_value() * (1000 / HZ);
+        if ((desktop_dirty() && now - g_gui_last_frame_ms >= frame_ms) ||
+            second != g_gui_last_second)
         {
             last_mouse_x = mx;
             last_mouse_y = my;
             desktop_render();
-            last_frame_tick = now;
+            g_gui_last_frame_ms = now;
+            g_gui_last_second = second;
         }
+        // 유저 링의 그리기 요청: 방금 그린 프레임 위에 덮는다
+        uring_gui_drain();
     }
 
-        __asm__ volatile("sti; hlt");
     }
 }
+
+void kmain(void)
+{
+    __asm__ __volatile__("cli");
+    //volatile uint16_t *vga = (uint16_t *)0xB8000;
+    //vga[1] = 0x074D;
+    //gdt_install_with_tss((uint32_t)&stack_top);
+    init_fpu_sse();
+
+    serial_init(COM1);
+
+    enable_io_iopl3();
+    enable_io_full();
+
+    //kheap_init();
+    
+    
+    serial_printf("\nSTEP >> GDT and heap initialized.");
+
+    for (uint32_t i = 0; i < 1024; i++)
+        page_table0[i] = (i * 0x1000) | 0x3;
+
+    serial_printf("\nSTEP >> PMM/VMM init Starting...\n");
+    serial_printf(" cr3=%p", (void *)(uintptr_t)read_cr3());
+    vmm_init(); // Grab current CR3/pagetables before we start mapping
+    vmm_pcid_init(); // global kernel mappings + PCID-tagged CR3 switches
+    serial_printf("\nSTEP >> vmm init OK.\n");
+    kheap_init();  
+    frame_arena_init();
+    // Limine framebuffer 정보를 우선 사용
+    memset(&g_bootinfo, 0, sizeof(g_bootinfo));
+    limine_fill_bootinfo_from_fb();
+    // Multiboot2 경로는 g_mbinfo_phys가 채워져 있을 때만 사용
+    if (g_mbinfo_phys) {
+        bootinfo_parse(g_mbinfo_phys);
+    }
+
+    // PMM/커널 힙 초기화는 Limine의 HHDM + ext_mem_alloc에 의존하고,
+    // 여기서는 추가적인 저수준 매핑은 수행하지 않는다.
+    serial_printf("\nSTEP >> VMM initialized successfully.\n");
+    psf_init();
+
+    serial_printf("\nSTEP >> VMM (no custom PMM) initialized successfully.\n");
+    
+    serial_printf("[dbg] before fb_map check\n");
+    g_fb_ready = 0;
+    if (g_bootinfo.fb_phys && g_bootinfo.fb_w && g_bootinfo.fb_h &&
+        g_bootinfo.fb_pitch && (g_bootinfo.fb_bpp == 24 || g_bootinfo.fb_bpp == 32))
+    {
+        serial_printf("[dbg] calling fb_map phys=%x w=%u h=%u pitch=%u bpp=%u\n",
+                      (uint32_t)g_bootinfo.fb_phys, g_bootinfo.fb_w, g_bootinfo.fb_h,
+                      g_bootinfo.fb_pitch, g_bootinfo.fb_bpp);
+        if (fb_map(g_bootinfo.fb_phys, g_bootinfo.fb_w, g_bootinfo.fb_h,
+                   g_bootinfo.fb_pitch, g_bootinfo.fb_bpp) == 0)
+        {
+            serial_printf("[fb] w=%d h=%d pitch=%d bpp=%d\n",
+                          fb.width, fb.height, fb.pitch, fb.bpp);
+
+            serial_printf("[mb2-fb] w=%u h=%u bpp=%u\n",
+                g_bootinfo.fb_w,
+                g_bootinfo.fb_h,
+                g_bootinfo.fb_bpp);
+            // Softer desktop background with vertical gradient
+            uint32_t top_bg = 0xFF20262E;
+            uint32_t bot_bg = 0xFF0E1116;
+            serial_printf("[dbg] before draw_hgrad_rect\n");
+            ui_draw_hgrad_rect(0, 0, fb.width, fb.height, top_bg, bot_bg);
+            serial_printf("[dbg] before draw_text\n");
+        draw_text(20, 20, "Kernel starting...", 0xFFFFFFFF, top_bg);
+        serial_printf("[dbg] before fb_flush\n");
+        fb_flush();
+        serial_printf("[dbg] after fb_flush\n");
+        g_fb_ready = 1;
+        cursor_use_default();
+    }
+        else
+        {
+            serial_printf("Framebuffer mapping failed.\n");
+        }
+    }
+    serial_printf("[dbg] after fb_map block fb_ready=%d\n", g_fb_ready);
+
+    // 자체 GDT/TSS + GS 기반 per-CPU 데이터 (IDT 게이트가 새 CS를 쓰도록 먼저)
+    percpu_init_bsp();
+
+    serial_printf("[dbg] before idt_install_core\n");
+    idt_install_core();
+    serial_printf("[dbg] after idt_install_core\n");
+
+    // Install C-side ISR handler table before registering any device IRQs.
+    extern void isr_install(void);
+    isr_install();
+    serial_printf("[dbg] after isr_install\n");
+    fpu_init(); // lazy FPU/SSE switching via CR0.TS + #NM
+
+    pic_remap();
+    serial_printf("[dbg] after pic_remap\n");
+    pit_init(100);
+    serial_printf("[dbg] after pit_init\n");
+    input_init(fb.width, fb.height);
+    keyboard_init();
+    serial_printf("[dbg] after keyboard_init\n");
+    probe_back_tail();
+    mouse_init(fb.width, fb.height);
+    serial_printf("[dbg] after mouse_init\n");
+    // Mouse IRQ handler is registered via isr_register_handler inside mouse_init.
+    // Unmask cascade + mouse IRQ (IRQ2 = PIC2 cascade, IRQ12 = PS/2 mouse).
+    irq_enable(2);
+    irq_enable(12);
+    desktop_config_frame_rate();
+
+    serial_write(COM1, "[serial] kernel up: IDT/PIC/PIT/KBD ready\r\n");
+
+    irq_enable(0);
+    irq_enable(1);
+
+    // MADT에 IOAPIC이 있으면 PIC을 막고 켜 둔 라인을 IOAPIC + LAPIC EOI로 옮긴다
+    irq_init_apic();
+
+    serial_printf("[dbg] before sti\n");
+    __asm__ __volatile__("sti"); // Enable interrupts
+    serial_printf("[dbg] after sti\n");
+
+    //write_center("-- All Drivers Initialized Successfully --", 0x0A, VGA_ROWS - 2);
+
+    extern void tasking_init(void);
+    extern void start_scheduler(void);
+    serial_printf("DEBUG: before tasking_init\n");
+    tasking_init();
+    serial_printf("DEBUG: after tasking_init\n");
+    clock_init(); // TSC calibrated against HPET/PIT, ktime_ns(), wall time
+    tick_init(); // PIT → LAPIC one-shot/TSC-deadline, tickless idle
+    vdso_init(); // shared read-only time/stats page for every address space
+    mp_init(); // APs: own GDT/TSS, LAPIC timer, idle task, run queue
+    start_scheduler();
+    serial_printf("DEBUG: after start_scheduler\n");
+    syscall_init();
+    serial_printf("[Kernel] syscall ready.\n");
+
+    // Init simple window manager (for GUI taskbar)
+    wm_init();
+    desktop_init();
+    dma_init();
+    ac97_init();
+    // Register Text Editor window for taskbar listing
+    g_win_notepad = wm_register_window("Text Editor", 0xFF5E8C31,
+                                       &g_notepad.open,
+                                       &g_notepad.minimized,
+                                       notepad_taskbar_click,
+                                       NULL);
+    // Register File Explorer window
+    g_win_file = wm_register_window("Explorer", 0xFF2F6FAB,
+                                    &g_filewin.open,
+                                    &g_filewin.minimized,
+                                    filewin_taskbar_click,
+                                    NULL);
+    // Register System Monitor window
+    g_win_taskmgr = wm_register_window("SysMon", 0xFFAA8844,
+                                       &g_taskmgr.open,
+                                       &g_taskmgr.minimized,
+                                       taskmgr_taskbar_click,
+                                       NULL);
+    // Register Display Settings window
+    g_win_display = wm_register_window("Display", 0xFF4488CC,
+                                       &g_display.open,
+                                       &g_display.minimized,
+                                       display_taskbar_click,
+                                       NULL);
+    // Register Terminal window
+    g_win_terminal = wm_register_window("Terminal", 0xFF8844AA,
+                                        &g_terminal.open,
+                                        &g_terminal.minimized,
+                                        terminal_taskbar_click,
+                                        NULL);
+    // Register Image Viewer window
+    g_win_imgview = wm_register_window("ImageView", 0xFF44AA88,
+                                       &g_imgview.open,
+                                       &g_imgview.minimized,
+                                       imgview_taskbar_click,
+                                       NULL);
+    // Register WAV Player window
+    g_win_wavplay = wm_register_window("WAV Player", 0xFF8899DD,
+                                       &g_wavplay.open,
+                                       &g_wavplay.minimized,
+                                       wavplay_taskbar_click,
+                                       NULL);
+    // User process windows (one WM slot each, enabled on SYS_WIN_CREATE)
+    uwin_init();
+    shrinker_register_gui("imgview", imgview_shrink_count, imgview_shrink_scan, NULL, 20);
+    wm_set_front(g_win_taskmgr);
+
+    if (!g_fb_ready)
+    {
+        //write_center("-- GUI (FB not available) --", 0x0A, VGA_ROWS - 2);
+    }
+    rtc_time_t t;
+    clock_wall_time(&t);
+    serial_printf("[RTC] %02d:%02d:%02d\n", t.hh, t.mm, t.ss);
+
+    // --- Disk / FS probe ---
+    ata_init();
+    ata_identify_t id;
+    int idr = ata_identify(&id);
+    if (idr != 0 || !id.present)
+    {
+        serial_printf("[ATA] no primary master (idr=%d)\n", idr);
+    }
+    else
+    {
+        uint8_t sec0[512];
+        if (ata_read28(0, 1, sec0) != 0)
+        {
+            serial_printf("[ATA] read LBA0 failed\n");
+        }
+        else
+        {
+            mbr_t m;
+            int mbr_r = mbr_parse(sec0, &m);
+            uint32_t mount_lba = 0;
+            int found = 0;
+            if (mbr_r == 0 && m.valid)
+            {
+                for (int i = 0; i < 4; ++i)
+                {
+                    if (m.parts[i].type != 0 && m.parts[i].sectors)
+                    {
+                        serial_printf("[MBR] part%d type=0x%02x lba=%u size=%u\n",
+                                      i, m.parts[i].type, m.parts[i].lba_first, m.parts[i].sectors);
+                    }
+                }
+                for (int i = 0; i < 4; ++i)
+                {
+                    if (m.parts[i].type == 0x0B || m.parts[i].type == 0x0C)
+                    {
+                        mount_lba = m.parts[i].lba_first;
+                        found = 1;
+                        break;
+                    }
+                }
+            }
+            else
+            {
+                serial_printf("[MBR] invalid or missing (mbr_r=%d), trying superfloppy at LBA0\n", mbr_r);
+            }
+
+            if (!found)
+                mount_lba = 0; // superfloppy fallback
+
+            int mnt = fat32_mount(&g_vol, ata_read28, mount_lba);
+            if (mnt == 0)
+            {
+                g_vol_mounted = 1;
+                exec_set_volume(&g_vol, ata_read28, ata_write28);
+                serial_printf("[FAT32] mounted at LBA %u\n", mount_lba);
+                fat32_ensure_dir_path(&g_vol, ata_read28, ata_write28, g_path_base);
+                ensure_user_dirs_on_disk(g_logged_in_user);
+                desktop_refresh_from_path();
+                if (desktop_load_wallpaper_path(&g_vol, ata_read28, g_path_wallpaper) == 0)
+                {
+                    serial_printf("[WALLPAPER] loaded system wallpaper\n");
+                }
+                else
+                {
+                    serial_printf("[WALLPAPER] system wallpaper missing; trying root fallback\n");
+                    char wp_name[13] = "WALLPAPR.BMP";
+                    if (find_first_wallpaper_name(wp_name, sizeof(wp_name)) == 0 &&
+                        desktop_load_wallpaper(&g_vol, ata_read28, wp_name) == 0)
+                {
+                    serial_printf("[WALLPAPER] loaded fallback %s\n", wp_name);
+                }
+                else
+                {
+                    serial_printf("[WALLPAPER] no wallpaper or failed to load\n");
+                }
+            }
+                cursor_load_from_disk();
+                cursor_use_default();
+            }
+            else
+            {
+                serial_printf("[FAT32] mount failed at LBA %u (err=%d)\n", mount_lba, mnt);
+            }
+        }
+    }
+    ensure_user_store();
+    g_boot_anim_start = jiffies;
+
+    // The desktop runs in its own thread on the BSP; slow file and audio work
+    // goes to the worker pool (workqueue.c). The boot context just waits for it.
+    workqueue_init();
+    gui_jobs_init();
+    task_t *gui = kthread_create_pinned(gui_main, NULL, "gui", 0);
+    if (!gui)
+    {
+        serial_printf("[gui] thread create failed; running the desktop on the boot context\n");
+        gui_main(NULL);
+    }
+    task_set_nice(gui, -5);   // 대화형: 워커보다 먼저, 슬라이스도 길게
+    sched_set_input_task(gui);
+    serial_enable_rx_irq(COM1);
+    isr_register_handler(IRQ_VECTOR_BASE + 4, sercon_irq);
+    irq_enable(4);
+    kthread_join(gui);
+    for (;;)
+        sched_wait_irq();
+}
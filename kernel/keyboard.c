@@ -1,28 +1,24 @@
 #include "keyboard.h"
+#include "input.h"
 #include "isr.h"
 #include "io.h"
-#include "pic.h"
+#include "irq.h"
+#include "task/task.h"
 
 #define KBD_DATA 0x60
 
-static volatile uint8_t last_sc = 0;
-static volatile int     has_sc  = 0;
+static int e0_prefix = 0;
 
 static void keyboard_callback(void){
     uint8_t sc = inb(KBD_DATA);
-    last_sc = sc;
-    has_sc  = 1;
+    if (sc == 0xE0) { e0_prefix = 1; return; }
+    // 타임스탬프를 찍어 입력 큐로: 루프가 늦어도 키를 잃지 않는다
+    input_push_key(sc, e0_prefix);
+    e0_prefix = 0;
+    sched_input_event();
 }
 
 void keyboard_init(void){
-    pic_clear_mask(1);      
+    irq_enable(1);
     isr_register_handler(33, keyboard_callback); 
 }
-
-int kbd_get_scancode(uint8_t* out){
-    if (!has_sc) return 0;
-    if (out) *out = last_sc;
-    has_sc = 0;
-    return 1;
-}
-
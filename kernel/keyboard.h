@@ -1,5 +1,4 @@
 #pragma once
 #include <stdint.h>
 void keyboard_init(void);
-/* optional: 폴링 API */
-int kbd_get_scancode(uint8_t* out);
+/* 키 이벤트는 input.h의 큐로 간다 (input_poll) */
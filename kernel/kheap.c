@@ -0,0 +1,495 @@
+#include "kheap.h"
+#include "serial.h"
+#include "string.h"
+#include "spinlock.h"
+#include "tick.h"
+#include "gui_event.h"
+#include "task/task.h"
+
+#define PAGE_SIZE 4096u
+
+#define KBLK_ALIGN      16u
+#define KBLK_MAGIC_USED 0x4B55u   /* 'KU' */
+#define KBLK_MAGIC_FREE 0x4B46u   /* 'KF' */
+
+extern char __kernel_high_end[];
+void map_kernel_heap(uintptr_t start, uintptr_t end);
+
+// 16-byte header in front of every block; 'next' is only valid while free.
+typedef struct kblk
+{
+    uint32_t size;    // payload bytes (multiple of KBLK_ALIGN)
+    uint16_t magic;
+    uint8_t tag;      // kmem_tag_t
+    uint8_t reserved;
+    struct kblk *next;
+} kblk_t;
+
+typedef struct
+{
+    const char *name;
+    shrink_count_fn count;
+    shrink_scan_fn scan;
+    void *user;
+    int cost;
+    int gui_only;
+} shrinker_t;
+
+static uint8_t *kheap_begin, *kheap_end, *kheap_brk;
+static kblk_t *g_free_list = NULL;   // address-ordered
+static size_t g_free_list_bytes = 0; // headers + payloads on the free list
+static size_t g_used_bytes = 0;      // payloads handed out
+
+static kmem_tag_stats_t g_tag_stats[KMEM_TAG_COUNT];
+static const char *const g_tag_names[KMEM_TAG_COUNT] = {
+    "misc", "fb", "desktop", "fs", "audio", "image", "wm", "task", "arena", "dma",
+    "pgtable", "user", "kmap",
+};
+
+// 힙 락 밖(PMM, DMA 풀, IRQ 문맥)에서도 부르므로 통계는 모두 __atomic으로 바꾼다
+static void tag_live_sub(kmem_tag_stats_t *st, size_t bytes)
+{
+    size_t live = __atomic_load_n(&st->live, __ATOMIC_RELAXED);
+    size_t next;
+    do
+        next = (live > bytes) ? live - bytes : 0;
+    while (!__atomic_compare_exchange_n(&st->live, &live, next, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+// 힙 전체를 지키는 락. 슈링커는 kfree를 다시 부르므로 락 밖에서 돌린다.
+static spinlock_t g_heap_lock = SPINLOCK_INIT;
+
+static shrinker_t g_shrinkers[SHRINKER_MAX];
+static int g_shrinker_count = 0;
+static int g_in_reclaim = 0;          // __atomic: 여러 CPU가 동시에 회수에 들어온다
+static task_t *g_gui_thread = NULL;   // gui_only 슈링커를 돌려도 되는 유일한 스레드
+static int g_pressure = 0;
+
+static inline uintptr_t align_up(uintptr_t v, uintptr_t a)
+{
+    return (v + (a - 1)) & ~(a - 1);
+}
+
+static inline uint8_t *blk_payload(kblk_t *b) { return (uint8_t *)b + sizeof(kblk_t); }
+static inline uint8_t *blk_end(kblk_t *b) { return blk_payload(b) + b->size; }
+
+void kheap_init(void)
+{
+    uintptr_t hb = align_up((uintptr_t)__kernel_high_end, PAGE_SIZE);
+    uintptr_t he = hb + KHEAP_PAGES * PAGE_SIZE;
+
+    // 힙 VA 범위 매핑
+    map_kernel_heap(hb, he);
+
+    kheap_begin = (uint8_t *)hb;
+    kheap_end   = (uint8_t *)he;
+    kheap_brk   = kheap_begin;
+    spin_register(&g_heap_lock, "kheap");
+
+    serial_printf("[kheap] heap=%p..%p\n", (void*)hb, (void*)he);
+}
+
+size_t kheap_total_bytes(void)
+{
+    return (size_t)(kheap_end - kheap_begin);
+}
+
+size_t kheap_free_bytes(void)
+{
+    return (size_t)(kheap_end - kheap_brk) + g_free_list_bytes;
+}
+
+size_t kheap_used_bytes(void)
+{
+    return g_used_bytes;
+}
+
+int kheap_owns(const void *p)
+{
+    return (const uint8_t *)p >= kheap_begin + sizeof(kblk_t) &&
+           (const uint8_t *)p < kheap_brk;
+}
+
+static void update_pressure(void)
+{
+    size_t low = kheap_total_bytes() / 100u * KHEAP_WMARK_LOW_PCT;
+    if (kheap_free_bytes() < low)
+        g_pressure = 1;
+}
+
+static void *alloc_from_free_list(uint32_t sz)
+{
+    kblk_t **pp = &g_free_list;
+    for (kblk_t *b = g_free_list; b; pp = &b->next, b = b->next)
+    {
+        if (b->size < sz)
+            continue;
+
+        if (b->size >= sz + sizeof(kblk_t) + KBLK_ALIGN)
+        {
+            // 앞부분을 떼어 주고 나머지는 free list에 그대로 남긴다
+            kblk_t *rest = (kblk_t *)(blk_payload(b) + sz);
+            rest->size = b->size - sz - (uint32_t)sizeof(kblk_t);
+            rest->magic = KBLK_MAGIC_FREE;
+            rest->next = b->next;
+            *pp = rest;
+            b->size = sz;
+        }
+        else
+        {
+            *pp = b->next;
+        }
+
+        g_free_list_bytes -= sizeof(kblk_t) + b->size;
+        b->magic = KBLK_MAGIC_USED;
+        b->next = NULL;
+        return blk_payload(b);
+    }
+    return NULL;
+}
+
+static void *alloc_from_brk(uint32_t sz)
+{
+    uintptr_t p = align_up((uintptr_t)kheap_brk, KBLK_ALIGN);
+    if (p + sizeof(kblk_t) + sz > (uintptr_t)kheap_end)
+        return NULL;
+    kblk_t *b = (kblk_t *)p;
+    b->size = sz;
+    b->magic = KBLK_MAGIC_USED;
+    b->next = NULL;
+    kheap_brk = blk_end(b);
+    return blk_payload(b);
+}
+
+void *kmalloc_tag(size_t sz, kmem_tag_t tag)
+{
+    if (!sz || sz > (size_t)(kheap_end - kheap_begin))
+        return 0;
+    if ((unsigned)tag >= KMEM_TAG_COUNT)
+        tag = KMEM_TAG_MISC;
+    uint32_t asz = (uint32_t)align_up(sz, KBLK_ALIGN);
+
+    uint64_t fl = spin_lock_irqsave(&g_heap_lock);
+    void *p = alloc_from_free_list(asz);
+    if (!p)
+        p = alloc_from_brk(asz);
+
+    // 실패 직전: 캐시를 줄여 보고 다시 시도
+    while (!p && !__atomic_load_n(&g_in_reclaim, __ATOMIC_ACQUIRE))
+    {
+        spin_unlock_irqrestore(&g_heap_lock, fl);
+        size_t got = shrink_caches(asz + sizeof(kblk_t));
+        fl = spin_lock_irqsave(&g_heap_lock);
+        if (got == 0)
+            break;
+        p = alloc_from_free_list(asz);
+        if (!p)
+            p = alloc_from_brk(asz);
+    }
+
+    if (!p)
+    {
+        spin_unlock_irqrestore(&g_heap_lock, fl);
+        serial_printf("[kheap] alloc failed: %u bytes for %s (free %u)\n",
+                      (uint32_t)sz, g_tag_names[tag], (uint32_t)kheap_free_bytes());
+        return 0;
+    }
+
+    ((kblk_t *)((uint8_t *)p - sizeof(kblk_t)))->tag = (uint8_t)tag;
+    g_used_bytes += asz;
+    kmem_tag_charge(tag, asz);
+    update_pressure();
+    spin_unlock_irqrestore(&g_heap_lock, fl);
+    return p;
+}
+
+void *kmalloc(size_t sz)
+{
+    return kmalloc_tag(sz, KMEM_TAG_MISC);
+}
+
+void *kzalloc_tag(size_t sz, kmem_tag_t tag)
+{
+    void *p = kmalloc_tag(sz, tag);
+    if (p)
+        memset(p, 0, sz);
+    return p;
+}
+
+void *kzalloc(size_t sz)
+{
+    return kzalloc_tag(sz, KMEM_TAG_MISC);
+}
+
+static void free_list_insert(kblk_t *b)
+{
+    b->magic = KBLK_MAGIC_FREE;
+    g_free_list_bytes += sizeof(kblk_t) + b->size;
+
+    kblk_t *prev = NULL;
+    kblk_t *cur = g_free_list;
+    while (cur && cur < b)
+    {
+        prev = cur;
+        cur = cur->next;
+    }
+    b->next = cur;
+    if (prev)
+        prev->next = b;
+    else
+        g_free_list = b;
+
+    // 뒤쪽 이웃과 병합
+    if (cur && blk_end(b) == (uint8_t *)cur)
+    {
+        b->size += (uint32_t)sizeof(kblk_t) + cur->size;
+        b->next = cur->next;
+    }
+    // 앞쪽 이웃과 병합
+    if (prev && blk_end(prev) == (uint8_t *)b)
+    {
+        prev->size += (uint32_t)sizeof(kblk_t) + b->size;
+        prev->next = b->next;
+        b = prev;
+    }
+
+    // 마지막 블록이 break에 닿으면 break를 되돌린다
+    if (!b->next && blk_end(b) == kheap_brk)
+    {
+        if (prev && prev->next == b)
+            prev->next = NULL;
+        else if (g_free_list == b)
+            g_free_list = NULL;
+        else
+        {
+            kblk_t *q = g_free_list;
+            while (q && q->next != b)
+                q = q->next;
+            if (q)
+                q->next = NULL;
+        }
+        g_free_list_bytes -= sizeof(kblk_t) + b->size;
+        kheap_brk = (uint8_t *)b;
+    }
+}
+
+static kblk_t *checked_block(void *p, const char *who)
+{
+    if (!p)
+        return NULL;
+    if (!kheap_owns(p) || ((uintptr_t)p & (KBLK_ALIGN - 1)))
+    {
+        serial_printf("[kheap] %s: foreign pointer %p\n", who, p);
+        return NULL;
+    }
+    kblk_t *b = (kblk_t *)((uint8_t *)p - sizeof(kblk_t));
+    if (b->magic != KBLK_MAGIC_USED)
+    {
+        serial_printf("[kheap] %s: bad block %p (magic=0x%x)\n", who, p, b->magic);
+        return NULL;
+    }
+    return b;
+}
+
+void kfree(void *p)
+{
+    kblk_t *b = checked_block(p, "kfree");
+    if (!b)
+        return;
+    uint64_t fl = spin_lock_irqsave(&g_heap_lock);
+    g_used_bytes -= b->size;
+    kmem_tag_uncharge((kmem_tag_t)b->tag, b->size);
+    free_list_insert(b);
+    spin_unlock_irqrestore(&g_heap_lock, fl);
+}
+
+void kshrink(void *p, size_t new_sz)
+{
+    kblk_t *b = checked_block(p, "kshrink");
+    if (!b || new_sz == 0)
+        return;
+    uint32_t asz = (uint32_t)align_up(new_sz, KBLK_ALIGN);
+    if (b->size < asz + sizeof(kblk_t) + KBLK_ALIGN)
+        return;
+
+    uint64_t fl = spin_lock_irqsave(&g_heap_lock);
+    kblk_t *tail = (kblk_t *)(blk_payload(b) + asz);
+    tail->size = b->size - asz - (uint32_t)sizeof(kblk_t);
+    tail->tag = b->tag;
+    tail->reserved = 0;
+    g_used_bytes -= b->size - asz;
+    // still one live block: only the byte count goes down
+    tag_live_sub(&g_tag_stats[b->tag], b->size - asz);
+    b->size = asz;
+    free_list_insert(tail);
+    spin_unlock_irqrestore(&g_heap_lock, fl);
+}
+
+// ---------------------------------------------------------------------------
+// Allocation tags / profiler
+// ---------------------------------------------------------------------------
+
+const char *kmem_tag_name(kmem_tag_t tag)
+{
+    return ((unsigned)tag < KMEM_TAG_COUNT) ? g_tag_names[tag] : "?";
+}
+
+const kmem_tag_stats_t *kmem_tag_stats(kmem_tag_t tag)
+{
+    return ((unsigned)tag < KMEM_TAG_COUNT) ? &g_tag_stats[tag] : NULL;
+}
+
+void kmem_tag_charge(kmem_tag_t tag, size_t bytes)
+{
+    if ((unsigned)tag >= KMEM_TAG_COUNT)
+        tag = KMEM_TAG_MISC;
+    kmem_tag_stats_t *st = &g_tag_stats[tag];
+    size_t live = __atomic_add_fetch(&st->live, bytes, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&st->total, bytes, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&st->allocs, 1, __ATOMIC_RELAXED);
+    size_t peak = __atomic_load_n(&st->peak, __ATOMIC_RELAXED);
+    while (live > peak &&
+           !__atomic_compare_exchange_n(&st->peak, &peak, live, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+void kmem_tag_uncharge(kmem_tag_t tag, size_t bytes)
+{
+    if ((unsigned)tag >= KMEM_TAG_COUNT)
+        tag = KMEM_TAG_MISC;
+    kmem_tag_stats_t *st = &g_tag_stats[tag];
+    tag_live_sub(st, bytes);
+    __atomic_add_fetch(&st->frees, 1, __ATOMIC_RELAXED);
+}
+
+void kmem_tag_sample(uint64_t elapsed_ticks)
+{
+    if (elapsed_ticks == 0)
+        return;
+    for (int i = 0; i < KMEM_TAG_COUNT; ++i)
+    {
+        kmem_tag_stats_t *st = &g_tag_stats[i];
+        uint64_t total = __atomic_load_n(&st->total, __ATOMIC_RELAXED);
+        uint64_t delta = total - st->last_total;
+        st->last_total = total;
+        st->rate = (uint32_t)(delta * HZ / elapsed_ticks);
+    }
+}
+
+void kmem_dump(void)
+{
+    serial_printf("[kmem] heap used=%u free=%u total=%u%s\n",
+                  (uint32_t)g_used_bytes, (uint32_t)kheap_free_bytes(),
+                  (uint32_t)kheap_total_bytes(), g_pressure ? " (pressure)" : "");
+    serial_printf("[kmem] tag       live(KB)  peak(KB)  allocs  frees  live-blocks  rate(B/s)\n");
+    for (int i = 0; i < KMEM_TAG_COUNT; ++i)
+    {
+        const kmem_tag_stats_t *st = &g_tag_stats[i];
+        if (!st->allocs)
+            continue;
+        serial_printf("[kmem] %s  %u  %u  %u  %u  %u  %u\n",
+                      g_tag_names[i], (uint32_t)(st->live / 1024u), (uint32_t)(st->peak / 1024u),
+                      st->allocs, st->frees, st->allocs - st->frees, st->rate);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Shrinkers
+// ---------------------------------------------------------------------------
+
+static int shrinker_add(const char *name, shrink_count_fn count,
+                        shrink_scan_fn scan, void *user, int cost, int gui_only)
+{
+    if (!scan || g_shrinker_count >= SHRINKER_MAX)
+        return -1;
+
+    // cost 오름차순 유지: 재구성 비용이 싼 캐시부터 줄인다
+    int at = g_shrinker_count;
+    while (at > 0 && g_shrinkers[at - 1].cost > cost)
+    {
+        g_shrinkers[at] = g_shrinkers[at - 1];
+        at--;
+    }
+    g_shrinkers[at].name = name ? name : "cache";
+    g_shrinkers[at].count = count;
+    g_shrinkers[at].scan = scan;
+    g_shrinkers[at].user = user;
+    g_shrinkers[at].cost = cost;
+    g_shrinkers[at].gui_only = gui_only;
+    g_shrinker_count++;
+    return 0;
+}
+
+int shrinker_register(const char *name, shrink_count_fn count,
+                      shrink_scan_fn scan, void *user, int cost)
+{
+    return shrinker_add(name, count, scan, user, cost, 0);
+}
+
+int shrinker_register_gui(const char *name, shrink_count_fn count,
+                          shrink_scan_fn scan, void *user, int cost)
+{
+    return shrinker_add(name, count, scan, user, cost, 1);
+}
+
+void kheap_set_gui_thread(void)
+{
+    g_gui_thread = current_task();
+}
+
+size_t shrink_caches(size_t want)
+{
+    if (want == 0 || __atomic_exchange_n(&g_in_reclaim, 1, __ATOMIC_ACQUIRE))
+        return 0;
+
+    // GUI 스레드가 생기기 전에는 그 캐시를 읽는 쪽도 없다
+    int foreign = g_gui_thread && current_task() != g_gui_thread;
+    int deferred = 0;
+    size_t got = 0;
+    for (int i = 0; i < g_shrinker_count && got < want; ++i)
+    {
+        shrinker_t *s = &g_shrinkers[i];
+        if (s->count && s->count(s->user) == 0)
+            continue;
+        if (s->gui_only && foreign)
+        {
+            // GUI가 그리는 중일 수 있다: 여기서 풀지 않고 GUI 스레드에 맡긴다
+            deferred = 1;
+            continue;
+        }
+        size_t freed = s->scan(want - got, s->user);
+        if (freed)
+            serial_printf("[kheap] shrinker %s released %u bytes\n",
+                          s->name, (uint32_t)freed);
+        got += freed;
+    }
+
+    __atomic_store_n(&g_in_reclaim, 0, __ATOMIC_RELEASE);
+    if (deferred)
+    {
+        g_pressure = 1;
+        gui_event_post(GUI_EV_RECLAIM);
+    }
+    return got;
+}
+
+int kheap_under_pressure(void)
+{
+    return g_pressure;
+}
+
+void kheap_reclaim_background(void)
+{
+    if (!g_pressure)
+        return;
+
+    size_t high = kheap_total_bytes() / 100u * KHEAP_WMARK_HIGH_PCT;
+    size_t free_now = kheap_free_bytes();
+    if (free_now < high)
+        shrink_caches(high - free_now);
+
+    size_t low = kheap_total_bytes() / 100u * KHEAP_WMARK_LOW_PCT;
+    g_pressure = (kheap_free_bytes() < low);
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Kernel heap (32 MiB right after the kernel image).
+// - Bump allocation at the break, plus an address-ordered free list that
+//   coalesces neighbours so freed blocks are reused.
+// - Before an allocation fails, registered shrinkers are asked to release
+//   cached memory and the allocation is retried.
+
+// Grow kernel heap to 32 MiB so audio resample buffers fit
+#define KHEAP_PAGES 8192u
+
+// Allocation tags: every block records which subsystem owns it so the
+// profiler can report live/peak bytes and allocation rates per subsystem.
+typedef enum
+{
+    KMEM_TAG_MISC = 0,  // untagged kmalloc()
+    KMEM_TAG_FB,
+    KMEM_TAG_DESKTOP,
+    KMEM_TAG_FS,
+    KMEM_TAG_AUDIO,
+    KMEM_TAG_IMAGE,
+    KMEM_TAG_WM,
+    KMEM_TAG_TASK,
+    KMEM_TAG_ARENA,
+    KMEM_TAG_DMA,       // charged by dma.c, not backed by the heap
+    KMEM_TAG_PGTABLE,   // page-table pages (pmm_alloc_tag)
+    KMEM_TAG_USER,      // user pages, vDSO, uring rings (pmm_alloc_tag)
+    KMEM_TAG_KMAP,      // pages behind vmm_alloc_range/vmm_alloc_page mappings
+    KMEM_TAG_COUNT
+} kmem_tag_t;
+
+typedef struct
+{
+    size_t live;          // bytes currently allocated
+    size_t peak;          // max 'live'
+    uint64_t total;       // cumulative bytes allocated
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t rate;        // bytes/s over the last sample window
+    uint64_t last_total;  // 'total' at the previous sample
+} kmem_tag_stats_t;
+
+void   kheap_init(void);
+void  *kmalloc(size_t sz);
+void  *kzalloc(size_t sz);
+void  *kmalloc_tag(size_t sz, kmem_tag_t tag);
+void  *kzalloc_tag(size_t sz, kmem_tag_t tag);
+void   kfree(void *p);
+// Give back the tail of a block in place (new_sz <= current size).
+void   kshrink(void *p, size_t new_sz);
+int    kheap_owns(const void *p);
+
+size_t kheap_total_bytes(void);
+size_t kheap_free_bytes(void);
+size_t kheap_used_bytes(void);
+
+// Allocation profiler
+const char *kmem_tag_name(kmem_tag_t tag);
+const kmem_tag_stats_t *kmem_tag_stats(kmem_tag_t tag);
+// Account memory that does not come from kmalloc (DMA pool, PMM pages, ...).
+void   kmem_tag_charge(kmem_tag_t tag, size_t bytes);
+void   kmem_tag_uncharge(kmem_tag_t tag, size_t bytes);
+// Recompute per-tag rates; 'elapsed_ticks' is jiffies (HZ) since the last call.
+void   kmem_tag_sample(uint64_t elapsed_ticks);
+// Print the per-tag table to the serial console.
+void   kmem_dump(void);
+
+// --- Memory pressure / cache shrinkers ---
+// count: bytes the cache could release right now.
+// scan : release up to 'want' bytes, return how many were actually freed.
+// cost : how expensive it is to rebuild the cache; cheap caches shrink first.
+typedef size_t (*shrink_count_fn)(void *user);
+typedef size_t (*shrink_scan_fn)(size_t want, void *user);
+
+#define SHRINKER_MAX 16
+
+int    shrinker_register(const char *name, shrink_count_fn count,
+                         shrink_scan_fn scan, void *user, int cost);
+// A cache the GUI thread draws from without a lock (wallpaper, image viewer):
+// its scan only runs on the GUI thread. Reclaim on any other thread skips it,
+// raises memory pressure and wakes the GUI (GUI_EV_RECLAIM) to shrink it there.
+int    shrinker_register_gui(const char *name, shrink_count_fn count,
+                             shrink_scan_fn scan, void *user, int cost);
+// Called once from the GUI thread before it starts drawing.
+void   kheap_set_gui_thread(void);
+size_t shrink_caches(size_t want);
+
+// Watermarks as a percentage of the heap size.
+#define KHEAP_WMARK_LOW_PCT  10
+#define KHEAP_WMARK_HIGH_PCT 20
+
+int    kheap_under_pressure(void);
+// Called from the main loop: shrink caches back up to the high watermark
+// once free memory has dropped below the low watermark.
+void   kheap_reclaim_background(void);
@@ -0,0 +1,337 @@
+#include "ktimer.h"
+#include "clock.h"
+#include "tick.h"
+#include "percpu.h"
+#include "spinlock.h"
+#include "serial.h"
+#include "task/task.h"
+
+#define WHEEL_BITS      6
+#define WHEEL_SIZE      (1u << WHEEL_BITS)
+#define WHEEL_MASK      (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS    6
+#define WHEEL_MAX_DELTA ((1ull << (WHEEL_BITS * WHEEL_LEVELS)) - 1)   // ~795 days
+#define LEVEL_EXPIRED   0xFF
+
+typedef struct
+{
+    spinlock_t lock;
+    uint64_t   now;                 // 다음에 처리할 ms (그 이전은 모두 처리됨)
+    uint64_t   pending[WHEEL_LEVELS];   // 비어 있지 않은 슬롯 비트맵
+    ktimer_t  *slots[WHEEL_LEVELS][WHEEL_SIZE];
+    ktimer_t  *expired;             // 만료되어 콜백을 기다리는 타이머
+    ktimer_t  *volatile running;    // 지금 콜백이 도는 타이머
+    uint32_t   count;               // 휠 안의 타이머 수 (expired 제외)
+    uint32_t   fired;
+    uint32_t   cascaded;
+} wheel_t;
+
+static wheel_t g_wheels[MAX_CPUS];
+
+static inline uint64_t ror64(uint64_t v, unsigned r)
+{
+    r &= 63;
+    return r ? (v >> r) | (v << (64 - r)) : v;
+}
+
+static void list_add(ktimer_t **head, ktimer_t *t)
+{
+    t->next = *head;
+    if (*head)
+        (*head)->pprev = &t->next;
+    *head = t;
+    t->pprev = head;
+}
+
+static void list_del(ktimer_t *t)
+{
+    *t->pprev = t->next;
+    if (t->next)
+        t->next->pprev = t->pprev;
+    t->next = NULL;
+    t->pprev = NULL;
+}
+
+/* 남은 시간이 64^(k+1) ms 미만인 가장 낮은 레벨 k에, 만료 시각의 k번째
+   6비트 자리를 슬롯으로 삼아 넣는다. 그 슬롯이 돌아오면 한 레벨 아래로 내려간다. */
+static void wheel_insert(wheel_t *w, ktimer_t *t)
+{
+    uint64_t exp = t->expires < w->now ? w->now : t->expires;
+    uint64_t delta = exp - w->now;
+    if (delta > WHEEL_MAX_DELTA)
+    {
+        delta = WHEEL_MAX_DELTA;
+        exp = w->now + delta;
+    }
+
+    unsigned lvl = 0;
+    while (lvl + 1 < WHEEL_LEVELS && delta >= (1ull << (WHEEL_BITS * (lvl + 1))))
+        lvl++;
+    unsigned slot = (unsigned)(exp >> (WHEEL_BITS * lvl)) & WHEEL_MASK;
+
+    t->level = (uint8_t)lvl;
+    t->slot = (uint8_t)slot;
+    list_add(&w->slots[lvl][slot], t);
+    w->pending[lvl] |= 1ull << slot;
+}
+
+static void wheel_unlink(wheel_t *w, ktimer_t *t)
+{
+    list_del(t);
+    if (t->level != LEVEL_EXPIRED)
+    {
+        w->count--;
+        if (!w->slots[t->level][t->slot])
+            w->pending[t->level] &= ~(1ull << t->slot);
+    }
+    t->pending = 0;
+}
+
+/* 다음에 휠을 돌려야 하는 시각: 레벨 0은 만료 시각 그대로, 상위 레벨은
+   비어 있지 않은 다음 슬롯이 아래로 내려가는 경계 시각. */
+static uint64_t wheel_next(const wheel_t *w)
+{
+    uint64_t best = KTIMER_NEVER;
+    if (!w->count)
+        return best;
+
+    for (unsigned lvl = 0; lvl < WHEEL_LEVELS; ++lvl)
+    {
+        uint64_t bm = w->pending[lvl];
+        if (!bm)
+            continue;
+        unsigned shift = WHEEL_BITS * lvl;
+        uint64_t pos = w->now >> shift;
+        unsigned cur = (unsigned)pos & WHEEL_MASK;
+        uint64_t d;
+        // 경계 위에 서 있으면 현재 슬롯도 지금 내려가야 한다
+        if ((w->now & ((1ull << shift) - 1)) == 0)
+            d = (uint64_t)__builtin_ctzll(ror64(bm, cur));
+        else
+            d = (uint64_t)__builtin_ctzll(ror64(bm, cur + 1)) + 1;
+        uint64_t at = (pos + d) << shift;
+        if (at < best)
+            best = at;
+    }
+    return best;
+}
+
+static void wheel_cascade(wheel_t *w)
+{
+    for (unsigned lvl = 1; lvl < WHEEL_LEVELS; ++lvl)
+    {
+        unsigned s = (unsigned)(w->now >> (WHEEL_BITS * lvl)) & WHEEL_MASK;
+        ktimer_t *t = w->slots[lvl][s];
+        w->slots[lvl][s] = NULL;
+        w->pending[lvl] &= ~(1ull << s);
+        while (t)
+        {
+            ktimer_t *n = t->next;
+            wheel_insert(w, t);
+            w->cascaded++;
+            t = n;
+        }
+        if (s != 0)
+            break;
+    }
+}
+
+static void wheel_run(wheel_t *w, uint64_t target)
+{
+    spin_lock(&w->lock);
+    for (;;)
+    {
+        uint64_t next = wheel_next(w);
+        if (next > target)
+            break;
+        w->now = next;
+        if ((next & WHEEL_MASK) == 0)
+            wheel_cascade(w);
+
+        unsigned s = (unsigned)next & WHEEL_MASK;
+        while (w->slots[0][s])
+        {
+            ktimer_t *t = w->slots[0][s];
+            list_del(t);
+            t->level = LEVEL_EXPIRED;
+            list_add(&w->expired, t);
+            w->count--;
+        }
+        w->pending[0] &= ~(1ull << s);
+        w->now = next + 1;
+    }
+    if (w->now <= target)
+        w->now = target + 1;   // 사이에 처리할 슬롯이 없다
+
+    // 콜백은 락 밖에서 하나씩 (콜백이 ktimer_add를 다시 부를 수 있다)
+    while (w->expired)
+    {
+        ktimer_t *t = w->expired;
+        list_del(t);
+        t->pending = 0;
+        w->running = t;
+        w->fired++;
+        spin_unlock(&w->lock);
+        t->fn(t->arg);
+        spin_lock(&w->lock);
+        w->running = NULL;
+    }
+    spin_unlock(&w->lock);
+}
+
+void ktimer_init(ktimer_t *t, void (*fn)(void *arg), void *arg)
+{
+    t->next = NULL;
+    t->pprev = NULL;
+    t->expires = 0;
+    t->fn = fn;
+    t->arg = arg;
+    t->cpu = 0;
+    t->level = 0;
+    t->slot = 0;
+    t->pending = 0;
+}
+
+void ktimer_add(ktimer_t *t, uint64_t expires_ms)
+{
+    ktimer_cancel(t);
+
+    uint64_t fl = irq_save();
+    cpu_t *c = this_cpu();
+    wheel_t *w = &g_wheels[c->id];
+    spin_lock(&w->lock);
+
+    // 빈 휠은 현재 시각으로 당겨 둔다 (tickless로 오래 쉰 CPU)
+    if (!w->count && !w->expired)
+    {
+        uint64_t now = ktime_ms();
+        if (now > w->now)
+            w->now = now;
+    }
+
+    uint64_t before = wheel_next(w);
+    t->cpu = c->id;
+    t->expires = expires_ms;
+    t->pending = 1;
+    wheel_insert(w, t);
+    w->count++;
+    int earlier = wheel_next(w) < before;
+
+    spin_unlock(&w->lock);
+    if (earlier)
+        tick_program();
+    irq_restore(fl);
+}
+
+int ktimer_cancel(ktimer_t *t)
+{
+    wheel_t *w = &g_wheels[t->cpu];
+    uint64_t fl = spin_lock_irqsave(&w->lock);
+    int was = t->pending;
+    if (was)
+        wheel_unlink(w, t);
+    spin_unlock_irqrestore(&w->lock, fl);
+
+    // 다른 CPU에서 콜백이 돌고 있으면 끝날 때까지 기다린다
+    if (!was && w != &g_wheels[this_cpu()->id])
+    {
+        while (w->running == t)
+            __asm__ volatile("pause");
+    }
+    return was;
+}
+
+void ktimer_run(void)
+{
+    wheel_run(&g_wheels[this_cpu()->id], ktime_ms());
+}
+
+void ktimer_run_all(void)
+{
+    uint64_t now = ktime_ms();
+    for (uint32_t i = 0; i < g_cpu_count; ++i)
+        if (g_cpus[i].online || i == 0)
+            wheel_run(&g_wheels[i], now);
+}
+
+uint64_t ktimer_next_expiry(void)
+{
+    wheel_t *w = &g_wheels[this_cpu()->id];
+    uint64_t fl = spin_lock_irqsave(&w->lock);
+    uint64_t next = wheel_next(w);
+    spin_unlock_irqrestore(&w->lock, fl);
+    return next;
+}
+
+static void sleep_timeout_fn(void *arg)
+{
+    task_wake((task_t *)arg);
+}
+
+uint64_t schedule_timeout(uint64_t ms)
+{
+    uint64_t expires = ktime_ms() + ms;
+    if (!task_can_block())
+    {
+        // 스케줄러 시작 전 / idle: 기다리기만 한다
+        while (ktime_ms() < expires)
+            __asm__ volatile("pause");
+        return 0;
+    }
+
+    ktimer_t t;
+    task_t *self = current_task();
+    ktimer_init(&t, sleep_timeout_fn, self);
+
+    uint64_t fl = irq_save();
+    task_set_state(TASK_BLOCKED);
+    ktimer_add(&t, expires);
+    task_block();
+    irq_restore(fl);
+
+    ktimer_cancel(&t);
+    uint64_t now = ktime_ms();
+    return now >= expires ? 0 : expires - now;
+}
+
+void msleep(uint32_t ms)
+{
+    uint64_t left = ms;
+    while (left)
+        left = schedule_timeout(left);
+}
+
+void usleep(uint32_t us)
+{
+    if (us >= 1000)
+    {
+        msleep((us + 999) / 1000);
+        return;
+    }
+    uint64_t end = ktime_ns() + (uint64_t)us * 1000u;
+    while (ktime_ns() < end)
+        __asm__ volatile("pause");
+}
+
+void ktimer_dump(void)
+{
+    for (uint32_t i = 0; i < g_cpu_count; ++i)
+    {
+        if (!g_cpus[i].online)
+            continue;
+        wheel_t *w = &g_wheels[i];
+        uint64_t fl = spin_lock_irqsave(&w->lock);
+        uint64_t next = wheel_next(w);
+        uint32_t count = w->count, fired = w->fired, cascaded = w->cascaded;
+        uint64_t now = w->now;
+        spin_unlock_irqrestore(&w->lock, fl);
+
+        if (next == KTIMER_NEVER)
+            serial_printf("[ktimer] cpu%u now=%llu pending=%u fired=%u cascaded=%u next=none\n",
+                          i, (unsigned long long)now, count, fired, cascaded);
+        else
+            serial_printf("[ktimer] cpu%u now=%llu pending=%u fired=%u cascaded=%u next=%llu\n",
+                          i, (unsigned long long)now, count, fired, cascaded,
+                          (unsigned long long)next);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <stdint.h>
+
+// Hierarchical timer wheel (1 ms resolution, ktime_ms() time base).
+// - One wheel per CPU: 6 levels of 64 slots; level k slots span 64^k ms.
+//   Timers cascade down a level when their slot comes round.
+// - Insert and cancel are O(1) (doubly linked slot lists + per-level
+//   pending bitmaps); finding the next expiry is O(levels), so an idle CPU
+//   only wakes up for the next timer no matter how many are queued.
+// - Callbacks run from the timer interrupt of the CPU the timer was added
+//   on, with interrupts disabled. They must not sleep.
+
+#define KTIMER_NEVER (~0ull)
+
+typedef struct ktimer
+{
+    struct ktimer  *next;
+    struct ktimer **pprev;
+    uint64_t        expires;        // ktime_ms()
+    void          (*fn)(void *arg);
+    void           *arg;
+    uint32_t        cpu;            // wheel the timer is queued on
+    uint8_t         level;
+    uint8_t         slot;
+    volatile uint8_t pending;
+} ktimer_t;
+
+void     ktimer_init(ktimer_t *t, void (*fn)(void *arg), void *arg);
+// (Re)arm on this CPU's wheel to fire once ktime_ms() >= expires_ms.
+void     ktimer_add(ktimer_t *t, uint64_t expires_ms);
+// Returns 1 if the timer was pending. If its callback is running on another
+// CPU, waits for it to finish, so the timer can be freed afterwards.
+int      ktimer_cancel(ktimer_t *t);
+
+// Timer interrupt: run every expired timer on this CPU's wheel.
+void     ktimer_run(void);
+// PIT fallback (no LAPIC tick): the BSP drives every CPU's wheel.
+void     ktimer_run_all(void);
+// Earliest time this CPU's wheel needs attention (ms, KTIMER_NEVER if empty).
+uint64_t ktimer_next_expiry(void);
+
+// Block the current task until task_wake() or 'ms' elapse. Returns the ms
+// left when woken early, 0 on timeout.
+uint64_t schedule_timeout(uint64_t ms);
+void     msleep(uint32_t ms);
+// Below 1 ms this spins on ktime_ns(); longer waits sleep.
+void     usleep(uint32_t us);
+
+void     ktimer_dump(void);
@@ -8,6 +8,7 @@
 #include <sys/cpu.h>
 #include <limine.h>
 #include "serial.h"
+#include "../mp.h"
 #include <fb.h>
 #include "../lib/misc.h"
 
@@ -47,6 +48,30 @@ static inline uint64_t read_cr4(void) {
     return v;
 }
 
+static inline void write_cr4(uint64_t v) {
+    __asm__ volatile("mov %0, %%cr4" :: "r"(v) : "memory");
+}
+
+#define CR4_PGE         ((uint64_t)1 << 7)
+#define CR4_PCIDE       ((uint64_t)1 << 17)
+#define CR3_NOFLUSH     ((uint64_t)1 << 63)
+#define CR3_PCID_MASK   ((uint64_t)0xFFF)
+
+/* PCID 상태: 0은 부트/커널 주소공간 전용, 1..VMM_PCID_SLOTS는 라운드로빈 할당 */
+#define VMM_PCID_SLOTS  64
+
+typedef struct {
+    uint64_t cr3;      /* top-level phys (0 = slot free or stale) */
+} pcid_slot_t;
+
+static int g_pge_enabled    = 0;
+static int g_pcid_enabled   = 0;
+static int g_invpcid        = 0;
+static pcid_slot_t g_pcid_slots[VMM_PCID_SLOTS + 1];
+static uint32_t g_pcid_next = 1;
+static uint64_t g_pcid_hits = 0;
+static uint64_t g_pcid_misses = 0;
+
 /* Linker-provided bounds for physical/virtual kernel placement */
 extern char __text_lma[];
 extern char __kernel_high_start[];
@@ -62,7 +87,7 @@ void vmm_alloc_range(uintptr_t va_start, size_t size, uint64_t flags)
 
     for (size_t i = 0; i < pages; i++) {
         uintptr_t va = va_start + i * 0x1000;
-        uintptr_t pa = (uintptr_t)pmm_alloc();   // 새 물리 페이지 할당
+        uintptr_t pa = (uintptr_t)pmm_alloc_tag(KMEM_TAG_KMAP);   // 새 물리 페이지 할당
 
         if (!pa)
             panic(false, "pmm_alloc failed in vmm_alloc_range");
@@ -134,6 +159,9 @@ static void *alloc_table(void) {
     if (!raw) {
         raw = ext_mem_alloc(PT_SIZE);
     }
+    if (!raw)
+        return NULL;
+    kmem_tag_charge(KMEM_TAG_PGTABLE, PT_SIZE);
 
     uint64_t phys = virt_to_phys(raw);
     void *virt = phys_to_virt(phys);
@@ -206,6 +234,8 @@ static pt_entry_t *get_next_level(pagemap_t pagemap, pt_entry_t *current_level,
             return (pt_entry_t *)-1;
         } else {
             ret = alloc_table();
+            if (!ret)
+                return NULL;   // 테이블을 못 받았다: 호출자가 매핑을 포기한다
             current_level[entry] = pte_new(virt_to_phys(ret), PT_TABLE_FLAGS);
         }
     }
@@ -249,6 +279,11 @@ void map_page(pagemap_t pagemap, uint64_t virt_addr, uint64_t phys_addr, uint64_
     pt_entry_t *pml5, *pml4, *pml3, *pml2, *pml1;
 
     flags |= PT_FLAG_VALID; // Always present
+    // Kernel-half mappings are the same in every address space: keep them
+    // in the TLB across CR3 switches.
+    if (g_pge_enabled && virt_addr >= paging_mode_higher_half(PAGING_MODE_X86_64_4LVL)
+        && !(flags & PT_FLAG_USER))
+        flags |= PT_FLAG_GLOBAL;
 
     switch (pagemap.levels) {
         case 5:
@@ -263,9 +298,10 @@ void map_page(pagemap_t pagemap, uint64_t virt_addr, uint64_t phys_addr, uint64_
 
 level5:
     pml4 = get_next_level(pagemap, pml5, virt_addr, pg_size, 4, pml5_entry);
+    if (!pml4 || pml4 == (pt_entry_t *)-1) return;
 level4:
     pml3 = get_next_level(pagemap, pml4, virt_addr, pg_size, 3, pml4_entry);
-    if (pml3 == (pt_entry_t *)-1) return;
+    if (!pml3 || pml3 == (pt_entry_t *)-1) return;
 
     if (pg_size == Size1GiB) {
         if (cpu_has_1gib_pages()) {
@@ -280,7 +316,7 @@ level4:
     }
 
     pml2 = get_next_level(pagemap, pml3, virt_addr, pg_size, 2, pml3_entry);
-    if (pml2 == (pt_entry_t *)-1) return;
+    if (!pml2 || pml2 == (pt_entry_t *)-1) return;
 
     if (pg_size == Size2MiB) {
         pml2[pml2_entry] = (pt_entry_t)(phys_addr | flags | PT_FLAG_LARGE);
@@ -288,7 +324,7 @@ level4:
     }
 
     pml1 = get_next_level(pagemap, pml2, virt_addr, pg_size, 1, pml2_entry);
-    if (pml1 == (pt_entry_t *)-1) return;
+    if (!pml1 || pml1 == (pt_entry_t *)-1) return;
 
     if (flags & ((uint64_t)1 << 12)) {
         flags &= ~((uint64_t)1 << 12);
@@ -438,6 +474,7 @@ int vmm_map(uintptr_t virt, uintptr_t phys, uint32_t flags) {
     if (flags & VMM_RW)  map_flags |= VMM_FLAG_WRITE;
     if (flags & VMM_PWT) map_flags |= VMM_PWT;
     if (flags & VMM_PCD) map_flags |= VMM_PCD;
+    if (flags & VMM_US)  map_flags |= VMM_US;
 
     map_page(current_pagemap(), virt, phys, map_flags, Size4KiB);
     flush_tlb_single((void *)virt);
@@ -457,7 +494,7 @@ int vmm_unmap(uintptr_t virt) {
         return -3;
 
     *pte = 0;
-    flush_tlb_single((void *)virt);
+    vmm_invlpg((void *)virt);
     return 0;
 }
 
@@ -480,11 +517,12 @@ int vmm_query(uintptr_t virt, uintptr_t *phys_out, uint32_t *flags_out) {
 }
 
 void *vmm_alloc_page(uintptr_t virt, uint32_t flags) {
-    void *frame = pmm_alloc();
+    void *frame = pmm_alloc_tag(KMEM_TAG_KMAP);
     if (!frame)
         return NULL;
 
     if (vmm_map(virt, (uintptr_t)frame & ~0xFFFu, flags | (uint32_t)VMM_P) != 0) {
+        kmem_tag_uncharge(KMEM_TAG_KMAP, 0x1000);
         pmm_free(frame, 0x1000);
         return NULL;
     }
@@ -500,8 +538,46 @@ void vmm_reload_cr3(void) {
     write_cr3(read_cr3());
 }
 
-void vmm_invlpg(void *addr) {
+static inline void invpcid(uint64_t type, uint64_t pcid, uint64_t addr) {
+    struct { uint64_t pcid, addr; } desc = { pcid, addr };
+    __asm__ volatile("invpcid %1, %0" :: "r"(type), "m"(desc) : "memory");
+}
+
+/*
+ * 한 페이지 무효화.
+ * - 하위(사용자) 절반은 현재 주소공간에만 존재하므로 invlpg로 충분하다.
+ * - 상위 절반은 모든 PCID에 캐시되어 있을 수 있다. INVPCID가 있으면 살아있는
+ *   PCID마다 개별 주소 무효화를 하고, 없으면 다른 슬롯을 stale로 표시해
+ *   다음 전환 때 전체 flush 되도록 한다.
+ * 다른 CPU에는 vmm_invlpg_range가 범위 전체를 IPI 한 번으로 보낸다.
+ */
+static void invlpg_local(void *addr) {
     flush_tlb_single(addr);
+    if (!g_pcid_enabled)
+        return;
+    if ((uintptr_t)addr < paging_mode_higher_half(PAGING_MODE_X86_64_4LVL))
+        return;
+
+    uint64_t cur = read_cr3() & CR3_PCID_MASK;
+    for (uint32_t p = 0; p <= VMM_PCID_SLOTS; ++p) {
+        if (p == cur || (p != 0 && !g_pcid_slots[p].cr3))
+            continue;
+        if (g_invpcid)
+            invpcid(0, p, (uint64_t)(uintptr_t)addr);
+        else if (p != 0)
+            g_pcid_slots[p].cr3 = 0;
+    }
+}
+
+void vmm_invlpg_range(uintptr_t start, uintptr_t end) {
+    for (uintptr_t va = start & ~(uintptr_t)0xFFF; va < end; va += 0x1000)
+        invlpg_local((void *)va);
+    /* 다른 CPU의 TLB에도 남아 있을 수 있다 */
+    mp_tlb_shootdown_range(start, end);
+}
+
+void vmm_invlpg(void *addr) {
+    vmm_invlpg_range((uintptr_t)addr, (uintptr_t)addr + 0x1000);
 }
 
 void vmm_page_fault_handler(uint32_t errcode, uintptr_t cr2) {
@@ -523,11 +599,320 @@ uintptr_t phys_addr_of(uintptr_t va) {
     return va;
 }
 
-/* Legacy API stub: switch page directory (CR3) */
+/*
+ * 주소공간 전환. PCID가 켜져 있으면 top-level phys마다 PCID 슬롯을 배정하고
+ * 이미 배정된 슬롯이면 no-flush 비트로 CR3를 써서 TLB를 보존한다.
+ * 슬롯을 새로 (재)배정할 때만 해당 PCID가 flush 된다.
+ */
+void vmm_switch_cr3(uint64_t cr3_phys) {
+    cr3_phys &= PT_PADDR_MASK;
+    if (!cr3_phys)
+        return;
+
+    /* PCID 슬롯 표는 BSP 전용: AP는 PCIDE를 켜지 않으므로 일반 CR3 쓰기 */
+    if (!g_pcid_enabled || !(read_cr4() & CR4_PCIDE)) {
+        if ((read_cr3() & PT_PADDR_MASK) != cr3_phys)
+            write_cr3(cr3_phys);
+        return;
+    }
+
+    if (cr3_phys == kernel_pagemap.top_level_phys) {
+        write_cr3(cr3_phys | CR3_NOFLUSH);
+        return;
+    }
+
+    for (uint32_t p = 1; p <= VMM_PCID_SLOTS; ++p) {
+        if (g_pcid_slots[p].cr3 == cr3_phys) {
+            g_pcid_hits++;
+            write_cr3(cr3_phys | p | CR3_NOFLUSH);
+            return;
+        }
+    }
+
+    uint32_t p = g_pcid_next;
+    g_pcid_next = (g_pcid_next % VMM_PCID_SLOTS) + 1;
+    g_pcid_slots[p].cr3 = cr3_phys;
+    g_pcid_misses++;
+    write_cr3(cr3_phys | p);   /* no-flush 없음: 이전 소유자의 항목 제거 */
+}
+
+/* Legacy API: switch page directory (CR3) */
 void vmm_switch_pagedir(uint32_t *new_pgdir_phys) {
     if (!new_pgdir_phys)
         return;
-    write_cr3((uint64_t)(uintptr_t)new_pgdir_phys);
+    vmm_switch_cr3((uint64_t)(uintptr_t)new_pgdir_phys);
+}
+
+/*
+ * 유저 주소공간: 커널 top-level 전체를 복사해 커널 하위 테이블을 공유하고,
+ * VMM_USER_BASE..VMM_USER_LIMIT 의 PML4 슬롯만 주소공간마다 따로 둔다.
+ * 커널이 이 슬롯들을 쓰고 있으면 만들지 않는다.
+ */
+#define USER_PML4_FIRST ((VMM_USER_BASE >> 39) & 0x1ff)
+#define USER_PML4_LAST  (((VMM_USER_LIMIT - 1) >> 39) & 0x1ff)
+
+uint64_t vmm_space_create(void) {
+    if (kernel_pagemap.levels != 4) {
+        serial_printf("[vmm] user address spaces need 4-level paging\n");
+        return 0;
+    }
+    pt_entry_t *kpml4 = kernel_pagemap.top_level;
+    for (size_t i = USER_PML4_FIRST; i <= USER_PML4_LAST; ++i) {
+        if (kpml4[i] & PT_FLAG_VALID) {
+            serial_printf("[vmm] user window overlaps kernel PML4[%zu]\n", i);
+            return 0;
+        }
+    }
+    pt_entry_t *top = alloc_table();
+    if (!top)
+        return 0;
+    memcpy(top, kpml4, PT_SIZE);
+    return virt_to_phys(top);
+}
+
+int vmm_space_map(uint64_t cr3_phys, uintptr_t virt, uintptr_t phys, uint32_t flags) {
+    if ((virt & 0xFFF) || (phys & 0xFFF) || virt < VMM_USER_BASE || virt >= VMM_USER_LIMIT)
+        return -1;
+    pagemap_t pm;
+    pm.levels = 4;
+    pm.top_level = phys_to_virt(cr3_phys & PT_PADDR_MASK);
+    pm.top_level_phys = cr3_phys & PT_PADDR_MASK;
+
+    uint64_t map_flags = PT_FLAG_USER;
+    if (flags & VMM_RW) map_flags |= VMM_FLAG_WRITE;
+    map_page(pm, virt, phys, map_flags, Size4KiB);
+    // map_page는 중간 테이블을 못 받으면 조용히 돌아온다: 들어갔는지 확인한다
+    uintptr_t got;
+    if (vmm_space_query(cr3_phys, virt, &got, NULL) != 0 || got != phys)
+        return -1;
+    if ((read_cr3() & PT_PADDR_MASK) == pm.top_level_phys)
+        flush_tlb_single((void *)virt);
+    return 0;
+}
+
+int vmm_space_query(uint64_t cr3_phys, uintptr_t virt, uintptr_t *phys_out, uint32_t *flags_out) {
+    pt_entry_t *t = phys_to_virt(cr3_phys & PT_PADDR_MASK);
+    for (int shift = 39; shift >= 21; shift -= 9) {
+        pt_entry_t e = t[(virt >> shift) & 0x1ff];
+        if (!PT_IS_TABLE(e))
+            return -1;
+        t = (pt_entry_t *)phys_to_virt(pte_addr(e));
+    }
+    pt_entry_t e = t[(virt >> 12) & 0x1ff];
+    if (!(e & PT_FLAG_VALID))
+        return -1;
+    if (phys_out)  *phys_out = (uintptr_t)pte_addr(e);
+    if (flags_out) *flags_out = entry_to_legacy_flags(e);
+    return 0;
+}
+
+static pt_entry_t *space_pte(uint64_t cr3_phys, uintptr_t virt) {
+    pt_entry_t *t = phys_to_virt(cr3_phys & PT_PADDR_MASK);
+    for (int shift = 39; shift >= 21; shift -= 9) {
+        pt_entry_t e = t[(virt >> shift) & 0x1ff];
+        if (!PT_IS_TABLE(e))
+            return NULL;
+        t = (pt_entry_t *)phys_to_virt(pte_addr(e));
+    }
+    return &t[(virt >> 12) & 0x1ff];
+}
+
+/*
+ * 범위를 지우고 TLB를 비운다. 이 주소공간이 다른 CPU에서 돌고 있을 수 있으므로
+ * 로컬 invlpg 뒤에 범위 전체를 shootdown IPI 한 번으로 보낸다. 지금 CPU에서
+ * 현재 공간이 아니면 PCID 슬롯을 비워 다음 전환 때 전체 flush 되게 한다.
+ */
+int vmm_space_unmap_range(uint64_t cr3_phys, uintptr_t virt, uint32_t pages) {
+    cr3_phys &= PT_PADDR_MASK;
+    int n = 0;
+    for (uint32_t i = 0; i < pages; ++i) {
+        pt_entry_t *pte = space_pte(cr3_phys, virt + (uintptr_t)i * 0x1000);
+        if (pte && (*pte & PT_FLAG_VALID)) {
+            *pte = 0;
+            n++;
+        }
+    }
+    if (!n)
+        return 0;
+
+    uintptr_t end = virt + (uintptr_t)pages * 0x1000;
+    if ((read_cr3() & PT_PADDR_MASK) == cr3_phys) {
+        for (uintptr_t va = virt; va < end; va += 0x1000)
+            flush_tlb_single((void *)va);
+    } else if (g_pcid_enabled) {
+        for (uint32_t p = 1; p <= VMM_PCID_SLOTS; ++p)
+            if (g_pcid_slots[p].cr3 == cr3_phys)
+                g_pcid_slots[p].cr3 = 0;
+    }
+    mp_tlb_shootdown_range(virt, end);
+    return n;
+}
+
+int vmm_space_unmap(uint64_t cr3_phys, uintptr_t virt) {
+    return vmm_space_unmap_range(cr3_phys, virt, 1) == 1 ? 0 : -1;
+}
+
+static void space_free_level(pt_entry_t *table, int level, void (*free_page)(uint64_t phys)) {
+    for (size_t i = 0; i < 512; ++i) {
+        pt_entry_t e = table[i];
+        if (!(e & PT_FLAG_VALID))
+            continue;
+        if (level > 1)
+            space_free_level((pt_entry_t *)phys_to_virt(pte_addr(e)), level - 1, free_page);
+        free_page(pte_addr(e));
+    }
+}
+
+void vmm_space_destroy(uint64_t cr3_phys, void (*free_page)(uint64_t phys)) {
+    cr3_phys &= PT_PADDR_MASK;
+    if (!cr3_phys || cr3_phys == kernel_pagemap.top_level_phys)
+        return;
+    pt_entry_t *top = phys_to_virt(cr3_phys);
+    for (size_t i = USER_PML4_FIRST; i <= USER_PML4_LAST; ++i) {
+        pt_entry_t e = top[i];
+        if (!(e & PT_FLAG_VALID))
+            continue;
+        space_free_level((pt_entry_t *)phys_to_virt(pte_addr(e)), 3, free_page);
+        free_page(pte_addr(e));
+    }
+    /* 같은 물리 페이지가 다음 주소공간의 top-level로 재사용될 때
+       옛 PCID 항목을 no-flush로 물려받지 않도록 슬롯을 비운다 */
+    for (uint32_t p = 1; p <= VMM_PCID_SLOTS; ++p)
+        if (g_pcid_slots[p].cr3 == cr3_phys)
+            g_pcid_slots[p].cr3 = 0;
+    free_page(cr3_phys);
+}
+
+int vmm_pcid_enabled(void) {
+    return g_pcid_enabled;
+}
+
+/* 상위 절반의 모든 leaf 항목에 G 비트를 세운다 (커널 이미지 + HHDM). */
+static void mark_global(pt_entry_t *table, int level, size_t first, size_t last) {
+    for (size_t i = first; i <= last; ++i) {
+        pt_entry_t e = table[i];
+        if (!(e & PT_FLAG_VALID) || (level == 1 && (e & PT_FLAG_USER)))
+            continue;
+        if (level == 1 || PT_IS_LARGE(e)) {
+            table[i] = e | PT_FLAG_GLOBAL;
+            continue;
+        }
+        mark_global((pt_entry_t *)phys_to_virt(pte_addr(e)), level - 1, 0, 511);
+    }
+}
+
+void vmm_pcid_init(void) {
+    uint32_t eax, ebx, ecx, edx;
+    uint64_t cr4 = read_cr4();
+
+    if (cpuid(1, 0, &eax, &ebx, &ecx, &edx) && (edx & (1u << 13))) {
+        if (kernel_pagemap.levels == 5)
+            mark_global(kernel_pagemap.top_level, 5, 256, 511);
+        else
+            mark_global(kernel_pagemap.top_level, 4, 256, 511);
+        /* PGE 토글로 전체 TLB flush 후 G 비트 적용 */
+        write_cr4(cr4 & ~CR4_PGE);
+        write_cr4(cr4 | CR4_PGE);
+        cr4 |= CR4_PGE;
+        g_pge_enabled = 1;
+    }
+
+    bool has_pcid = cpuid(1, 0, &eax, &ebx, &ecx, &edx) && (ecx & (1u << 17));
+    g_invpcid = cpuid(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1u << 10));
+
+    if (has_pcid) {
+        /* PCIDE를 켤 때 CR3[11:0]은 0이어야 한다 */
+        write_cr3(read_cr3() & PT_PADDR_MASK);
+        write_cr4(cr4 | CR4_PCIDE);
+        g_pcid_enabled = 1;
+    } else {
+        g_invpcid = 0;
+    }
+
+    serial_printf("[vmm] PGE=%d PCID=%d INVPCID=%d\n",
+                  g_pge_enabled, g_pcid_enabled, g_invpcid);
+}
+
+/* AP 초기화: 커널 페이지 테이블 로드 + BSP가 세운 G 비트를 쓰도록 PGE 켜기 */
+void vmm_cpu_init_ap(uint64_t kernel_cr3) {
+    if (kernel_cr3)
+        write_cr3(kernel_cr3 & PT_PADDR_MASK);
+    if (g_pge_enabled) {
+        uint64_t cr4 = read_cr4();
+        write_cr4(cr4 & ~CR4_PGE);
+        write_cr4(cr4 | CR4_PGE);
+    }
+}
+
+/*
+ * 컨텍스트 전환 비용 측정: 같은 페이지들을 공유하는 두 주소공간 사이를
+ * 왕복하면서 매번 비전역(하위 절반) 페이지 16장을 만진다.
+ * PCID 없이는 CR3 쓰기마다 TLB가 비워져 다시 page walk가 일어난다.
+ */
+#define PCID_BENCH_VA     0x0000600000000000ull
+#define PCID_BENCH_PAGES  16
+#define PCID_BENCH_ROUNDS 20000
+
+static uint64_t pcid_bench_run(uint64_t cr3_a, uint64_t cr3_b, uint64_t tag_a,
+                               uint64_t tag_b, uint64_t noflush) {
+    uint64_t t0 = rdtsc();
+    for (int r = 0; r < PCID_BENCH_ROUNDS; ++r) {
+        write_cr3(cr3_a | tag_a | noflush);
+        for (int i = 0; i < PCID_BENCH_PAGES; ++i)
+            (void)*(volatile uint8_t *)(uintptr_t)(PCID_BENCH_VA + (uint64_t)i * 0x1000);
+        write_cr3(cr3_b | tag_b | noflush);
+        for (int i = 0; i < PCID_BENCH_PAGES; ++i)
+            (void)*(volatile uint8_t *)(uintptr_t)(PCID_BENCH_VA + (uint64_t)i * 0x1000);
+    }
+    return (rdtsc() - t0) / (2 * PCID_BENCH_ROUNDS);
+}
+
+void vmm_pcid_bench(void) {
+    static pt_entry_t *clone = NULL;
+    static int mapped = 0;
+
+    if (!mapped) {
+        for (int i = 0; i < PCID_BENCH_PAGES; ++i) {
+            uint32_t pa = pmm_alloc_phys();
+            if (!pa || vmm_map(PCID_BENCH_VA + (uint64_t)i * 0x1000, pa, VMM_P | VMM_RW) != 0) {
+                serial_printf("[pcid] bench setup failed\n");
+                return;
+            }
+        }
+        mapped = 1;
+    }
+    if (!clone) {
+        clone = alloc_table();
+        if (!clone)
+            return;
+    }
+    /* 전체 top-level을 복사: 두 주소공간이 같은 하위 테이블을 공유 */
+    memcpy(clone, kernel_pagemap.top_level, PT_SIZE);
+
+    uint64_t cr3_a = kernel_pagemap.top_level_phys;
+    uint64_t cr3_b = virt_to_phys(clone);
+    uint64_t saved = read_cr3();
+
+    __asm__ volatile("cli");
+    uint64_t plain = pcid_bench_run(cr3_a, cr3_b, 0, 0, 0);
+    uint64_t tagged = 0;
+    if (g_pcid_enabled) {
+        /* 벤치 전용 PCID: 슬롯 테이블 밖의 값 사용 후 정리 */
+        uint64_t pa = VMM_PCID_SLOTS + 1, pb = VMM_PCID_SLOTS + 2;
+        write_cr3(cr3_a | pa);
+        write_cr3(cr3_b | pb);
+        tagged = pcid_bench_run(cr3_a, cr3_b, pa, pb, CR3_NOFLUSH);
+        if (g_invpcid) {
+            invpcid(1, pa, 0);
+            invpcid(1, pb, 0);
+        }
+    }
+    write_cr3(saved);
+    __asm__ volatile("sti");
+
+    serial_printf("[pcid] switch+touch %d pages: plain=%llu cycles, pcid=%llu cycles%s\n",
+                  PCID_BENCH_PAGES, (unsigned long long)plain, (unsigned long long)tagged,
+                  g_pcid_enabled ? "" : " (PCID unsupported)");
 }
 
 void vmm_init(void) {
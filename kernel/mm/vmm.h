@@ -212,6 +212,32 @@ void* vmm_alloc_page(uintptr_t virt, uint32_t flags);
 int vmm_map_page(uintptr_t virt, uintptr_t phys, uint32_t flags);
 void vmm_reload_cr3(void);
 void vmm_invlpg(void* addr);
+/* 범위 무효화: 로컬은 페이지마다, 다른 CPU에는 shootdown IPI 한 번 */
+void vmm_invlpg_range(uintptr_t start, uintptr_t end);
+
+/* Address-space switching with PCID-tagged TLB entries (x86_64) */
+void vmm_pcid_init(void);
+int  vmm_pcid_enabled(void);
+void vmm_switch_cr3(uint64_t cr3_phys);
+void vmm_switch_pagedir(uint32_t *new_pgdir_phys);
+void vmm_pcid_bench(void);
+
+/* 유저 주소공간 (task/exec.c). 커널 매핑을 공유하고 유저 창만 따로 갖는다. */
+#define VMM_USER_BASE  0x0000400000000000ull   /* PML4[128] */
+#define VMM_USER_LIMIT 0x0000600000000000ull   /* PML4[192] 미만 */
+uint64_t vmm_space_create(void);               /* top-level phys, 0: 실패 */
+int      vmm_space_map(uint64_t cr3_phys, uintptr_t virt, uintptr_t phys, uint32_t flags);
+/* 현재 CR3와 무관하게 그 주소공간의 4 KiB 매핑을 찾는다. 0 / -1 (없음) */
+int      vmm_space_query(uint64_t cr3_phys, uintptr_t virt, uintptr_t *phys_out, uint32_t *flags_out);
+/* 페이지는 풀지 않고 매핑만 지운다 (커널이 계속 쓰는 공유 페이지를 떼어낼 때) */
+int      vmm_space_unmap(uint64_t cr3_phys, uintptr_t virt);
+/* pages개를 한꺼번에 (다른 CPU에는 shootdown 한 번). 지운 매핑 수를 돌려준다.
+   스핀락을 쥔 채 부르지 않는다 (mp_tlb_shootdown_range) */
+int      vmm_space_unmap_range(uint64_t cr3_phys, uintptr_t virt, uint32_t pages);
+/* 유저 창의 페이지와 테이블, top-level을 free_page로 돌려준다 */
+void     vmm_space_destroy(uint64_t cr3_phys, void (*free_page)(uint64_t phys));
+/* SMP: AP에서 커널 CR3 로드 + PGE */
+void vmm_cpu_init_ap(uint64_t kernel_cr3);
 uint64_t vmm_hhdm_offset(void);
 void vmm_page_fault_handler(uint32_t errcode, uintptr_t cr2);
 
@@ -1,18 +1,20 @@
 #include <stdint.h>
+#include <stddef.h>
 #include "pic.h"
 #include "isr.h"
 #include "serial.h"
 #include "fb.h"
 #include "mouse.h"
+#include "input.h"
+#include "task/task.h"
 
 #define MOUSE_IRQ 12
 #define MOUSE_PORT 0x60
 #define MOUSE_CMD  0x64
 
 static int mouse_cycle = 0;
-static int8_t mouse_bytes[3];
-static int mouse_x = 0, mouse_y = 0;
-static int screen_w = 0, screen_h = 0;
+static uint8_t mouse_bytes[4];
+static int packet_len = 3;   // IntelliMouse(ID 3)면 휠 바이트가 붙어 4
 
 static inline void outb(uint16_t port, uint8_t val)
 { __asm__ __volatile__("outb %0,%1"::"a"(val),"Nd"(port)); }
@@ -43,11 +45,14 @@ static uint8_t mouse_read(void)
     return inb(0x60);
 }
 
+static void mouse_set_rate(uint8_t rate)
+{
+    mouse_write(0xF3); mouse_read();
+    mouse_write(rate); mouse_read();
+}
+
 void mouse_init(uint32_t fb_w, uint32_t fb_h)
 {
-    screen_w = fb_w;
-    screen_h = fb_h;
-
     outb(0x64, 0xA8);      // Enable mouse port
     mouse_wait(0);
     outb(0x64, 0x20);      // Read command byte
@@ -60,12 +65,20 @@ void mouse_init(uint32_t fb_w, uint32_t fb_h)
     outb(0x60, status);
 
     mouse_write(0xF6); mouse_read(); // default settings
+    // IntelliMouse 노크: 샘플레이트 200, 100, 80 다음 ID가 3이면 휠이 있다
+    mouse_set_rate(200);
+    mouse_set_rate(100);
+    mouse_set_rate(80);
+    mouse_write(0xF2); mouse_read();
+    if (mouse_read() == 3)
+        packet_len = 4;
     mouse_write(0xF4); mouse_read(); // enable data reporting
 
-    mouse_x = fb_w / 2;
-    mouse_y = fb_h / 2;
-
-    serial_printf("[mouse] Initialized at (%d,%d)\n", mouse_x, mouse_y);
+    // 커서 위치는 입력 큐를 비우는 GUI 쪽(input.c)이 가진다
+    (void)fb_w;
+    (void)fb_h;
+    serial_printf("[mouse] Initialized, %d-byte packets%s\n", packet_len,
+                  packet_len == 4 ? " (wheel)" : "");
 
     // Register IRQ12 (vector 32+12=44) handler via common ISR dispatcher
     isr_register_handler(32 + 12, mouse_irq_handler);
@@ -80,24 +93,22 @@ void mouse_irq_handler(void)
         return;
 
     mouse_bytes[mouse_cycle++] = data;
-    if (mouse_cycle == 3)
+    if (mouse_cycle == packet_len)
     {
         mouse_cycle = 0;
 
+        uint8_t b0 = mouse_bytes[0];
+        // 9비트 이동값: 부호는 첫 바이트의 bit4(X)/bit5(Y). 넘침(bit6/7)이면 버린다
+        int dx = (b0 & 0x40) ? 0 : (int)mouse_bytes[1] - ((b0 << 4) & 0x100);
+        int dy = (b0 & 0x80) ? 0 : (int)mouse_bytes[2] - ((b0 << 3) & 0x100);
+        int dz = packet_len == 4 ? (int)(int8_t)(mouse_bytes[3] << 4) >> 4 : 0;
         // Keep X as reported, invert Y direction only
-        int dx = (int8_t)mouse_bytes[1];
-        int dy = -(int8_t)mouse_bytes[2];
-        mouse_x += dx;
-        mouse_y += dy;
-
-        if (mouse_x < 0) mouse_x = 0;
-        if (mouse_y < 0) mouse_y = 0;
-        if (mouse_x >= screen_w) mouse_x = screen_w - 1;
-        if (mouse_y >= screen_h) mouse_y = screen_h - 1;
+        input_push_mouse(dx, -dy, dz, b0 & 0x07);
+        sched_input_event();
     }
     // EOI is sent by the common IRQ handler (isr_common_handler)
 }
 
-int mouse_get_x(void) { return mouse_x; }
-int mouse_get_y(void) { return mouse_y; }
-uint8_t mouse_get_buttons(void) { return (uint8_t)(mouse_bytes[0] & 0x07); }
+int mouse_get_x(void) { int x; input_cursor(&x, NULL); return x; }
+int mouse_get_y(void) { int y; input_cursor(NULL, &y); return y; }
+uint8_t mouse_get_buttons(void) { return input_buttons(); }
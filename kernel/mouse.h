@@ -20,6 +20,7 @@ void mouse_irq_handler(void);
 // ───────────────────────────────────────────────
 // 상태 접근
 // ───────────────────────────────────────────────
+// GUI가 input_poll()로 꺼낸 데까지의 커서/버튼 (input.c)
 int mouse_get_x(void);
 int mouse_get_y(void);
 uint8_t mouse_get_buttons(void);  // bit0=left, bit1=right, bit2=middle
@@ -0,0 +1,266 @@
+#include "mp.h"
+#include "percpu.h"
+#include "apic.h"
+#include "tick.h"
+#include "isr.h"
+#include "idt.h"
+#include "serial.h"
+#include "task/task.h"
+#include "task/fpu.h"
+#include "syscall.h"
+#include "mm/vmm.h"
+#include <limine.h>
+
+__attribute__((used, section(".limine_requests")))
+static volatile struct limine_mp_request mp_request = {
+    .id = LIMINE_MP_REQUEST_ID,
+    .revision = 0,
+    .flags = 0,   // xAPIC 모드 유지 (apic.c는 x2APIC도 처리)
+};
+
+static uint64_t g_kernel_cr3 = 0;
+static volatile uint32_t g_aps_ready = 0;
+static int g_mp_ready = 0;
+
+// TLB shootdown: 한 번에 하나씩. 대상 CPU마다 비트를 세우고, 각 CPU는 범위를
+// 비운 뒤 자기 비트를 지운다. 요청한 쪽은 모든 비트가 지워질 때까지 돌아가지 않는다.
+static spinlock_t g_tlb_lock = SPINLOCK_INIT;
+static volatile uintptr_t g_tlb_start = 0;
+static volatile uintptr_t g_tlb_end = 0;
+static volatile uint32_t g_tlb_pending = 0;   // 아직 ack하지 않은 CPU 비트 (1 << id)
+static uint32_t g_tlb_requests = 0;
+static uint32_t g_tlb_pages = 0;
+static uint32_t g_tlb_full = 0;
+static uint32_t g_tlb_timeouts = 0;
+static uint32_t g_tlb_irqoff = 0;
+
+_Static_assert(MAX_CPUS <= 32, "g_tlb_pending is a 32-bit CPU mask");
+
+#define TLB_WAIT_SPINS      10000000u
+// 이보다 긴 범위는 페이지마다 invlpg 하지 않고 전체를 비운다
+#define TLB_RANGE_MAX_PAGES 32u
+#define CR4_PGE             (1ull << 7)
+
+static void tlb_flush_local(uintptr_t start, uintptr_t end)
+{
+    if ((end - start) / 0x1000u > TLB_RANGE_MAX_PAGES)
+    {
+        // 커널 매핑은 G 비트라 CR3 다시 쓰기로는 안 빠진다: PGE를 껐다 켠다
+        uint64_t cr4;
+        __asm__ volatile("mov %%cr4, %0" : "=r"(cr4));
+        if (cr4 & CR4_PGE)
+        {
+            __asm__ volatile("mov %0, %%cr4" ::"r"(cr4 & ~CR4_PGE) : "memory");
+            __asm__ volatile("mov %0, %%cr4" ::"r"(cr4) : "memory");
+        }
+        else
+        {
+            uint64_t cr3;
+            __asm__ volatile("mov %%cr3, %0" : "=r"(cr3));
+            __asm__ volatile("mov %0, %%cr3" ::"r"(cr3) : "memory");
+        }
+        return;
+    }
+    for (uintptr_t va = start; va < end; va += 0x1000)
+        __asm__ volatile("invlpg (%0)" ::"r"(va) : "memory");
+}
+
+static void tlb_service(void)
+{
+    uint32_t bit = 1u << this_cpu()->id;
+    if (!(__atomic_load_n(&g_tlb_pending, __ATOMIC_ACQUIRE) & bit))
+        return;
+    tlb_flush_local(g_tlb_start, g_tlb_end);
+    __atomic_and_fetch(&g_tlb_pending, ~bit, __ATOMIC_RELEASE);
+}
+
+static void ipi_tlb_handler(void)
+{
+    this_cpu()->ipis++;
+    tlb_service();
+}
+
+static void ipi_resched_handler(void)
+{
+    sched_resched();
+}
+
+void mp_tlb_shootdown_range(uintptr_t start, uintptr_t end)
+{
+    start &= ~(uintptr_t)0xFFF;
+    end = (end + 0xFFF) & ~(uintptr_t)0xFFF;
+    if (!g_mp_ready || mp_cpus_online() < 2 || start >= end)
+        return;
+
+    uint64_t fl = irq_save();
+    // 부르는 쪽은 스핀락을 쥐고 있으면 안 된다: 그 락을 기다리며 인터럽트를 끄고
+    // 도는 CPU는 IPI에 답하지 못하고, 우리는 ack를 기다리며 영원히 돈다.
+    // irqsave 락을 쥐었거나 IRQ 문맥이면 IF가 꺼져 있다: 크게 알린다.
+    if (!(fl & (1ull << 9)))
+    {
+        g_tlb_irqoff++;
+        serial_printf("[mp] BUG: TLB shootdown with interrupts off (spinlock held?) from %p\n",
+                      __builtin_return_address(0));
+    }
+    // 락을 기다리는 동안 다른 CPU가 보낸 요청에 응답해야 교착이 없다
+    while (!spin_trylock(&g_tlb_lock))
+    {
+        tlb_service();
+        __asm__ volatile("pause");
+    }
+
+    cpu_t *self = this_cpu();
+    uint32_t targets = 0;
+    for (uint32_t i = 0; i < g_cpu_count; ++i)
+        if (g_cpus[i].online && &g_cpus[i] != self)
+            targets |= 1u << g_cpus[i].id;
+    if (!targets)
+    {
+        spin_unlock(&g_tlb_lock);
+        irq_restore(fl);
+        return;
+    }
+
+    g_tlb_start = start;
+    g_tlb_end = end;
+    g_tlb_requests++;
+    g_tlb_pages += (uint32_t)((end - start) / 0x1000u);
+    if ((end - start) / 0x1000u > TLB_RANGE_MAX_PAGES)
+        g_tlb_full++;
+    __atomic_store_n(&g_tlb_pending, targets, __ATOMIC_RELEASE);
+
+    for (uint32_t i = 0; i < g_cpu_count; ++i)
+        if (targets & (1u << g_cpus[i].id))
+            apic_send_ipi(g_cpus[i].lapic_id, APIC_VEC_TLB);
+
+    // 모두 ack할 때까지 기다린다: 일찍 돌아가면 다음 요청이 범위를 덮어써
+    // 오래된 TLB 항목이 살아남는다. 오래 걸리면 크게 알리고 계속 기다린다.
+    uint32_t spins = 0;
+    uint32_t left;
+    while ((left = __atomic_load_n(&g_tlb_pending, __ATOMIC_ACQUIRE)) != 0)
+    {
+        __asm__ volatile("pause");
+        if (++spins == TLB_WAIT_SPINS)
+        {
+            spins = 0;
+            g_tlb_timeouts++;
+            serial_printf("[mp] TLB shootdown %p-%p stuck: cpu mask 0x%x has not acked\n",
+                          (void *)start, (void *)end, left);
+        }
+    }
+
+    spin_unlock(&g_tlb_lock);
+    irq_restore(fl);
+}
+
+void mp_tlb_shootdown(uintptr_t va)
+{
+    mp_tlb_shootdown_range(va, va + 0x1000);
+}
+
+void mp_send_resched(uint32_t cpu_id)
+{
+    cpu_t *c = cpu_get(cpu_id);
+    if (!g_mp_ready || !c || !c->online || c == this_cpu())
+        return;
+    apic_send_ipi(c->lapic_id, APIC_VEC_RESCHED);
+}
+
+uint32_t mp_cpus_online(void)
+{
+    return percpu_online_count();
+}
+
+static void ap_entry(struct limine_mp_info *info)
+{
+    cpu_t *c = (cpu_t *)(uintptr_t)info->extra_argument;
+
+    // BSP와 같은 커널 주소공간 + G 비트 사용
+    vmm_cpu_init_ap(g_kernel_cr3);
+
+    uint64_t rsp;
+    __asm__ volatile("mov %%rsp, %0" : "=r"(rsp));
+    percpu_init_ap(c, rsp);
+    syscall_init_cpu();
+    idt_load();
+    fpu_init_ap();
+    apic_init();
+
+    sched_init_ap();
+    c->online = 1;
+    __atomic_add_fetch(&g_aps_ready, 1, __ATOMIC_RELEASE);
+
+    tick_cpu_start();
+    sched_idle_loop();
+}
+
+int mp_init(void)
+{
+    struct limine_mp_response *resp = mp_request.response;
+    spin_register(&g_tlb_lock, "tlb.shootdown");
+
+    isr_register_handler(APIC_VEC_TLB, ipi_tlb_handler);
+    isr_register_handler(APIC_VEC_RESCHED, ipi_resched_handler);
+
+    // tick_init()이 이미 LAPIC을 켰다면 다시 초기화하지 않는다 (타이머 LVT 보존)
+    if (tick_mode() == TICK_MODE_PIT && apic_init() != 0)
+    {
+        serial_printf("[mp] no local APIC, running on the BSP only\n");
+        return -1;
+    }
+    g_cpus[0].lapic_id = apic_id();
+    g_mp_ready = 1;
+
+    if (!resp || resp->cpu_count <= 1)
+    {
+        serial_printf("[mp] single CPU\n");
+        return 0;
+    }
+
+    __asm__ volatile("mov %%cr3, %0" : "=r"(g_kernel_cr3));
+    g_kernel_cr3 &= ~0xFFFull;
+
+    uint32_t n = 1;
+    uint32_t expected = 0;
+    for (uint64_t i = 0; i < resp->cpu_count && n < MAX_CPUS; ++i)
+    {
+        struct limine_mp_info *info = resp->cpus[i];
+        if (info->lapic_id == resp->bsp_lapic_id)
+            continue;
+
+        cpu_t *c = &g_cpus[n];
+        c->id = n;
+        c->lapic_id = info->lapic_id;
+        c->online = 0;
+        n++;
+        expected++;
+        g_cpu_count = n;
+
+        info->extra_argument = (uint64_t)(uintptr_t)c;
+        __atomic_store_n(&info->goto_address, ap_entry, __ATOMIC_RELEASE);
+    }
+
+    // AP가 올라올 때까지 최대 1초 대기
+    extern volatile uint64_t jiffies;
+    uint64_t start = jiffies;
+    while (__atomic_load_n(&g_aps_ready, __ATOMIC_ACQUIRE) < expected && jiffies - start < 100)
+        __asm__ volatile("pause");
+
+    serial_printf("[mp] %u/%u CPUs online (bsp lapic %u)\n",
+                  mp_cpus_online(), (uint32_t)resp->cpu_count, resp->bsp_lapic_id);
+    return 0;
+}
+
+void mp_dump(void)
+{
+    for (uint32_t i = 0; i < g_cpu_count; ++i)
+    {
+        cpu_t *c = &g_cpus[i];
+        serial_printf("[mp] cpu%u lapic=%u %s load=%u%% tasks=%u switches=%u steals=%u ipis=%u cur=%s\n",
+                      c->id, c->lapic_id, c->online ? "online" : "offline", c->load_pct,
+                      c->nr_tasks, c->switches, c->steals, c->ipis,
+                      c->current && c->current->name ? c->current->name : "-");
+    }
+    serial_printf("[mp] tlb shootdowns=%u pages=%u full=%u stalls=%u irqoff=%u\n",
+                  g_tlb_requests, g_tlb_pages, g_tlb_full, g_tlb_timeouts, g_tlb_irqoff);
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <stdint.h>
+
+// SMP bring-up and inter-processor interrupts.
+// - mp_init(): starts every AP reported by the Limine MP request. Each AP
+//   gets its own GDT/TSS, GS-based per-CPU data, LAPIC timer (tick.c) and
+//   idle task.
+// - Reschedule IPI: wake an idle CPU when work lands on its run queue.
+// - TLB shootdown IPI: invalidate a page range on every other online CPU and
+//   wait until each of them has acknowledged. Ranges longer than 32 pages
+//   flush the whole TLB instead. The sender spins with interrupts off until
+//   every CPU has acked, so it must not be called with a spinlock held or
+//   from IRQ context (reported on the serial console if it is).
+
+int      mp_init(void);
+uint32_t mp_cpus_online(void);
+void     mp_send_resched(uint32_t cpu_id);
+void     mp_tlb_shootdown(uintptr_t va);
+void     mp_tlb_shootdown_range(uintptr_t start, uintptr_t end);
+void     mp_dump(void);
@@ -0,0 +1,52 @@
+#include "percpu.h"
+#include "serial.h"
+#include <sys/cpu.h>
+#include <string.h>
+
+_Static_assert(offsetof(cpu_t, syscall_rsp) == CPU_OFF_SYSCALL_RSP, "syscall_entry.asm");
+_Static_assert(offsetof(cpu_t, user_rsp) == CPU_OFF_USER_RSP, "syscall_entry.asm");
+
+cpu_t    g_cpus[MAX_CPUS];
+uint32_t g_cpu_count = 1;
+
+static void percpu_load_gs(cpu_t *c)
+{
+    c->self = c;
+    wrmsr(MSR_GS_BASE, (uint64_t)(uintptr_t)c);
+    wrmsr(MSR_KERNEL_GS_BASE, (uint64_t)(uintptr_t)c);
+}
+
+void percpu_init_bsp(void)
+{
+    cpu_t *c = &g_cpus[0];
+    memset(c, 0, sizeof(*c));
+    c->id = 0;
+    c->tss = &g_tss;
+    spin_init(&c->rq_lock);
+    spin_register(&c->rq_lock, "sched.rq");
+
+    // RSP0 is filled in by the scheduler on the first switch
+    gdt_init_cpu(&c->gdt, &c->gdtr, c->tss, 0);
+    percpu_load_gs(c);
+    c->online = 1;
+
+    serial_printf("[percpu] BSP gdt=%p tss=%p gs=%p\n", (void *)&c->gdt, (void *)c->tss, (void *)c);
+}
+
+void percpu_init_ap(cpu_t *c, uint64_t kernel_stack_top)
+{
+    c->tss = &c->tss_ap;
+    spin_init(&c->rq_lock);
+    spin_register(&c->rq_lock, "sched.rq");
+    gdt_init_cpu(&c->gdt, &c->gdtr, c->tss, kernel_stack_top);
+    percpu_load_gs(c);
+}
+
+uint32_t percpu_online_count(void)
+{
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < g_cpu_count; ++i)
+        if (g_cpus[i].online)
+            n++;
+    return n;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "gdt.h"
+#include "spinlock.h"
+
+// Per-CPU data. Each CPU points IA32_GS_BASE at its own cpu_t, so
+// this_cpu() is a single %gs-relative load with no lookup or locking.
+// KERNEL_GS_BASE starts out with the same pointer; the SYSCALL stub and the
+// interrupt stubs swapgs on entry from/exit to ring 3, so in kernel mode
+// GS_BASE is always this CPU and KERNEL_GS_BASE holds the user value.
+
+#define MAX_CPUS 16
+
+#define MSR_GS_BASE        0xC0000101
+#define MSR_KERNEL_GS_BASE 0xC0000102
+
+// %gs offsets used by syscall_entry.asm
+#define CPU_OFF_SYSCALL_RSP 8
+#define CPU_OFF_USER_RSP    16
+
+struct task;
+
+// Run queue priorities: nice -20..19 → 0..39, lower index runs first.
+#define SCHED_PRIOS 40
+
+typedef struct cpu
+{
+    struct cpu   *self;        // %gs:0
+    uint64_t      syscall_rsp; // %gs:8  kernel stack top for SYSCALL (= TSS RSP0)
+    uint64_t      user_rsp;    // %gs:16 user RSP stashed by the SYSCALL stub
+    uint32_t      id;          // logical index (0 = BSP)
+    uint32_t      lapic_id;
+    volatile int  online;
+
+    // Scheduler state
+    struct task  *current;
+    struct task  *idle;
+    struct task  *switch_prev; // task being switched away from (finish_switch)
+    struct task  *fpu_owner;   // task whose FPU state is in this CPU's registers
+    spinlock_t    rq_lock;
+    struct task  *rq_head[SCHED_PRIOS]; // READY FIFO per priority (idle excluded)
+    struct task  *rq_tail[SCHED_PRIOS];
+    uint64_t      rq_bitmap;   // bit p set ⇔ rq_head[p] != NULL
+    uint32_t      nr_tasks;    // runnable tasks owned by this CPU, running one included
+    struct task  *dl_head;     // EDF tasks, earliest absolute deadline first
+    uint64_t      dl_bw;       // admitted EDF bandwidth (runtime/period << 20)
+    uint32_t      dl_misses;   // EDF jobs that finished after their deadline
+    volatile int  need_resched;
+    volatile int  in_hlt;      // waiting in sched_wait_irq(): ticks count as idle
+
+    // Statistics
+    uint64_t      ticks_total;
+    uint64_t      ticks_idle;
+    uint64_t      prev_total;
+    uint64_t      prev_idle;
+    uint32_t      load_pct;    // sampled once per second
+    uint32_t      switches;
+    uint32_t      steals;      // tasks pulled from other CPUs
+    uint32_t      ipis;        // IPIs received
+
+    // Tick (tick.c)
+    uint64_t      acct_jiffies;  // jiffies already charged to busy/idle
+    uint64_t      next_event;    // TSC the LAPIC timer is armed for (TICK_NEVER: off)
+    uint32_t      timer_irqs;
+    uint32_t      nohz_stops;    // times the timer was switched off for idle
+
+    // Descriptor tables (TSS must not be shared between CPUs)
+    gdt_table_t   gdt;
+    struct gdtr   gdtr;
+    struct tss64 *tss;
+    struct tss64  tss_ap;      // storage for APs; the BSP keeps g_tss
+} cpu_t;
+
+extern cpu_t    g_cpus[MAX_CPUS];
+extern uint32_t g_cpu_count;   // CPUs reported by the bootloader (and initialised)
+
+static inline cpu_t *this_cpu(void)
+{
+    cpu_t *c;
+    __asm__ volatile("mov %%gs:0, %0" : "=r"(c));
+    return c;
+}
+
+static inline cpu_t *cpu_get(uint32_t id)
+{
+    return (id < g_cpu_count) ? &g_cpus[id] : NULL;
+}
+
+// BSP: own GDT/TSS + GS base. Must run before anything calls this_cpu().
+void percpu_init_bsp(void);
+// AP: same for g_cpus[id]; called from the AP entry point.
+void percpu_init_ap(cpu_t *c, uint64_t kernel_stack_top);
+uint32_t percpu_online_count(void);
@@ -2,6 +2,8 @@
 #include "io.h"
 #include "isr.h"
 #include "pic.h"
+#include "task/task.h"
+#include "ktimer.h"
 
 #define PIT_CHANNEL0 0x40
 #define PIT_COMMAND  0x43
@@ -11,7 +13,9 @@ volatile uint64_t jiffies = 0;
 
 static void pit_irq(void){
     jiffies++;
-    /* EOI는 isr_handler_c에서 공용 처리 중이므로 여기서는 생략 가능 */
+    /* EOI는 isr_common_handler가 핸들러 호출 전에 보낸다 */
+    ktimer_run_all();        /* LAPIC 틱이 없을 때만 여기로 온다: 모든 CPU의 휠을 돌린다 */
+    schedule_from_timer();   /* BSP 스케줄러 틱 (LAPIC이 없을 때) */
 }
 
 void pit_init(uint32_t hz){
@@ -2,6 +2,7 @@
 #include <mm/pmm.h>  // Limine PMM prototypes (ext_mem_alloc 등)
 #include <mm/vmm.h>  // HHDM offset helpers
 #include "string.h"
+#include "spinlock.h"
 
 // 커널에서 기대하는 전역 pgdir (현재는 사용하지 않음)
 uint32_t *pgdir = NULL;
@@ -23,6 +24,9 @@ static uint32_t fb_total_pages = 0;
 static uint32_t memmap_total_pages = 0;
 static int memmap_total_ready = 0;
 static uint32_t boot_total_pages = 0;
+// fb_cursor를 지킨다: AP가 올라온 뒤에는 여러 CPU가 동시에 페이지를 받는다
+// (유저 #PF, vmm_space_map의 테이블, SQPOLL, uring/uwin 설정).
+static spinlock_t fb_lock = SPINLOCK_INIT;
 
 static inline uintptr_t align_up(uintptr_t v, uintptr_t a) {
     return (v + (a - 1)) & ~(a - 1);
@@ -88,26 +92,44 @@ uint32_t pmm_boot_total_pages(void)
 void pmm_init(void *heap_top) {
     (void)heap_top;
     ensure_fallback_pool();
+    spin_register(&fb_lock, "pmm");
 }
 
-// Fallback pool 기반 4KiB 페이지 할당 (HHDM VA 반환)
-void *pmm_alloc(void) {
+// 풀에서 need 바이트를 떼어 물리 주소를 돌려준다. 모자라면 0.
+static uintptr_t fb_take(uintptr_t need) {
+    uint64_t fl = spin_lock_irqsave(&fb_lock);
     ensure_fallback_pool();
+    uintptr_t phys = 0;
+    if (fb_cursor + need <= fb_limit) {
+        phys = fb_cursor;
+        fb_cursor += need;
+    }
+    spin_unlock_irqrestore(&fb_lock, fl);
+    return phys;
+}
 
-    if (fb_cursor + PAGE_SIZE > fb_limit) {
+// Fallback pool 기반 4KiB 페이지 할당 (HHDM VA 반환)
+void *pmm_alloc(void) {
+    uintptr_t phys = fb_take(PAGE_SIZE);
+    if (!phys) {
         return NULL;
     }
 
-    uintptr_t phys = fb_cursor;
-    fb_cursor += PAGE_SIZE;
-
     // HHDM VA로 변환 후 0으로 초기화
     void *va = (void *)(phys + vmm_hhdm_offset());
     memset(va, 0, PAGE_SIZE);
     return va;
 }
 
+void *pmm_alloc_tag(kmem_tag_t tag) {
+    void *va = pmm_alloc();
+    if (va)
+        kmem_tag_charge(tag, PAGE_SIZE);
+    return va;
+}
+
 // 물리 주소가 필요할 때는 HHDM 오프셋을 제거해서 돌려준다.
+// 커널 힙 매핑이 쓴다: 힙 블록은 kheap.c가 태그별로 세므로 여기서는 세지 않는다.
 uint32_t pmm_alloc_phys(void) {
     void *va = pmm_alloc();
     if (!va) {
@@ -148,17 +170,23 @@ void pmm_release_range(uintptr_t phys_begin, uintptr_t phys_end) {
 // Try to allocate N contiguous physical pages from fallback pool
 void *pmm_alloc_contig(uint32_t pages)
 {
-    ensure_fallback_pool();
     uintptr_t need = (uintptr_t)pages * PAGE_SIZE;
-    if (fb_cursor + need > fb_limit)
+    uintptr_t phys = fb_take(need);
+    if (!phys)
         return NULL;
-    uintptr_t phys = fb_cursor;
-    fb_cursor += need;
     void *va = (void *)(phys + vmm_hhdm_offset());
     memset(va, 0, need);
     return va;
 }
 
+void *pmm_alloc_contig_tag(uint32_t pages, kmem_tag_t tag)
+{
+    void *va = pmm_alloc_contig(pages);
+    if (va)
+        kmem_tag_charge(tag, (size_t)pages * PAGE_SIZE);
+    return va;
+}
+
 // 통계는 아직 의미 있는 값을 추적하지 않으므로 0을 반환한다.
 uint32_t pmm_free_count(void) {
     ensure_fallback_pool();
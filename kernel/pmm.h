@@ -1,6 +1,7 @@
 #pragma once
 #include <stdint.h>
 #include <stddef.h>
+#include "kheap.h"
 
 #define PAGE_SIZE 4096u
 #define BITMAP_MAX_PAGES (1024u * 1024u) /* 4GiB / 4KiB */
@@ -28,6 +29,10 @@ void     pmm_init(void* heap_top);
 /* 물리 페이지 한 장(4KiB) 할당/해제 */
 void*    pmm_alloc(void);
 uint32_t pmm_alloc_phys(void);
+/* 태그를 붙여 할당한다: kmem 프로파일러에 PAGE_SIZE * pages 만큼 잡힌다.
+   태그 없는 pmm_alloc/pmm_alloc_contig는 블록을 따로 세는 풀(커널 힙, DMA 풀) 전용 */
+void*    pmm_alloc_tag(kmem_tag_t tag);
+void*    pmm_alloc_contig_tag(uint32_t pages, kmem_tag_t tag);
 void     pmm_free_page(void* phys_addr);
 
 /* 예약/해제(범위) — 페이지 경계 단위 */
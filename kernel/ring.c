@@ -0,0 +1,224 @@
+#include "ring.h"
+#include "clock.h"
+#include "serial.h"
+#include "spinlock.h"
+#include "task/task.h"
+#include <string.h>
+
+static int pow2(uint32_t n)
+{
+    return n && !(n & (n - 1));
+}
+
+/* --------- SPSC --------- */
+
+int spsc_init(spsc_ring_t *r, void *buf, uint32_t cap, uint32_t esize)
+{
+    if (!buf || !esize || !pow2(cap))
+        return -1;
+    r->buf = buf;
+    r->mask = cap - 1;
+    r->esize = esize;
+    r->head = r->tail = 0;
+    r->dropped = 0;
+    return 0;
+}
+
+int spsc_push(spsc_ring_t *r, const void *elem)
+{
+    uint32_t t = r->tail;   // 생산자만 쓴다
+    if (t - __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) > r->mask)
+    {
+        r->dropped++;
+        return -1;
+    }
+    memcpy(r->buf + (size_t)(t & r->mask) * r->esize, elem, r->esize);
+    __atomic_store_n(&r->tail, t + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int spsc_pop(spsc_ring_t *r, void *out)
+{
+    uint32_t h = r->head;   // 소비자만 쓴다
+    if (h == __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE))
+        return 0;
+    memcpy(out, r->buf + (size_t)(h & r->mask) * r->esize, r->esize);
+    __atomic_store_n(&r->head, h + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+uint32_t spsc_count(const spsc_ring_t *r)
+{
+    return __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+}
+
+/* --------- MPSC --------- */
+
+static inline volatile uint32_t *slot_seq(const mpsc_ring_t *r, uint32_t pos)
+{
+    return (volatile uint32_t *)(r->buf + (size_t)(pos & r->mask) * r->stride);
+}
+
+static inline uint8_t *slot_data(const mpsc_ring_t *r, uint32_t pos)
+{
+    return r->buf + (size_t)(pos & r->mask) * r->stride + 8;
+}
+
+int mpsc_init(mpsc_ring_t *r, void *buf, uint32_t cap, uint32_t esize)
+{
+    if (!buf || !esize || !pow2(cap))
+        return -1;
+    r->buf = buf;
+    r->mask = cap - 1;
+    r->esize = esize;
+    r->stride = (8u + esize + 7u) & ~7u;
+    r->head = r->tail = 0;
+    r->dropped = 0;
+    // 칸 i는 pos == i인 생산자를 기다린다
+    for (uint32_t i = 0; i < cap; ++i)
+        *slot_seq(r, i) = i;
+    return 0;
+}
+
+int mpsc_push(mpsc_ring_t *r, const void *elem)
+{
+    uint32_t pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+    for (;;)
+    {
+        uint32_t seq = __atomic_load_n(slot_seq(r, pos), __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0)
+        {
+            if (__atomic_compare_exchange_n(&r->tail, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+            // 실패하면 pos에 현재 tail이 들어 있다
+        }
+        else if (diff < 0)
+        {
+            // 한 바퀴 전 원소를 소비자가 아직 꺼내지 않았다
+            __atomic_add_fetch(&r->dropped, 1, __ATOMIC_RELAXED);
+            return -1;
+        }
+        else
+            pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+    }
+    memcpy(slot_data(r, pos), elem, r->esize);
+    __atomic_store_n(slot_seq(r, pos), pos + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int mpsc_pop(mpsc_ring_t *r, void *out)
+{
+    uint32_t pos = r->head;
+    if (__atomic_load_n(slot_seq(r, pos), __ATOMIC_ACQUIRE) != pos + 1)
+        return 0;
+    memcpy(out, slot_data(r, pos), r->esize);
+    // 다음 바퀴의 생산자 (pos + cap)에게 칸을 돌려준다
+    __atomic_store_n(slot_seq(r, pos), pos + r->mask + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&r->head, pos + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+uint32_t mpsc_count(const mpsc_ring_t *r)
+{
+    return __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+}
+
+/* --------- self-test (sercon "ringtest") --------- */
+
+#define RT_PRODUCERS 4
+#define RT_ITEMS     20000
+#define RT_CAP       256
+
+typedef struct
+{
+    uint32_t producer;
+    uint32_t seq;
+} rt_item_t;
+
+typedef struct
+{
+    mpsc_ring_t *ring;
+    spinlock_t  *lock;
+    uint64_t    *shared;
+    uint32_t     id;
+    uint32_t     full;
+} rt_producer_t;
+
+static void rt_producer(void *arg)
+{
+    rt_producer_t *p = arg;
+    for (uint32_t i = 0; i < RT_ITEMS; ++i)
+    {
+        rt_item_t it = { p->id, i };
+        while (mpsc_push(p->ring, &it) != 0)
+        {
+            p->full++;
+            yield();
+        }
+        // 락 통계도 같이 확인: 생산자끼리 짧은 임계 구역을 다툰다
+        uint64_t fl = spin_lock_irqsave(p->lock);
+        (*p->shared)++;
+        spin_unlock_irqrestore(p->lock, fl);
+    }
+}
+
+void ring_selftest(void)
+{
+    static uint8_t   storage[MPSC_RING_BYTES(RT_CAP, sizeof(rt_item_t))];
+    static mpsc_ring_t ring;
+    static spinlock_t  lock = SPINLOCK_INIT;
+    static uint64_t    shared;
+    rt_producer_t prod[RT_PRODUCERS];
+    task_t *th[RT_PRODUCERS];
+    uint32_t next[RT_PRODUCERS] = { 0 };
+    uint32_t got = 0, bad = 0, started = 0;
+
+    if (mpsc_init(&ring, storage, RT_CAP, sizeof(rt_item_t)) != 0)
+        return;
+    spin_init(&lock);
+    spin_register(&lock, "ringtest");
+    shared = 0;
+
+    uint64_t t0 = ktime_ns();
+    for (uint32_t i = 0; i < RT_PRODUCERS; ++i)
+    {
+        prod[i] = (rt_producer_t){ &ring, &lock, &shared, i, 0 };
+        th[i] = kthread_create_joinable(rt_producer, &prod[i], "ringtest");
+        if (th[i])
+            started++;
+    }
+
+    while (got < started * RT_ITEMS)
+    {
+        rt_item_t it;
+        if (!mpsc_pop(&ring, &it))
+        {
+            yield();
+            continue;
+        }
+        // 생산자마다 순서가 지켜져야 한다
+        if (it.producer >= RT_PRODUCERS || it.seq != next[it.producer])
+            bad++;
+        else
+            next[it.producer]++;
+        got++;
+    }
+    uint32_t full = 0;
+    for (uint32_t i = 0; i < RT_PRODUCERS; ++i)
+    {
+        if (th[i])
+            kthread_join(th[i]);
+        full += prod[i].full;
+    }
+    uint64_t dt = ktime_ns() - t0;
+
+    serial_printf("[ring] mpsc %u producers x %u items: %s (%u out of order), %u full retries, %llu us\n",
+                  started, RT_ITEMS, bad ? "FAIL" : "ok", bad, full,
+                  (unsigned long long)(dt / 1000));
+    serial_printf("[ring] spinlock counter %llu/%u %s, %llu contended\n",
+                  (unsigned long long)shared, started * RT_ITEMS,
+                  shared == (uint64_t)started * RT_ITEMS ? "ok" : "FAIL",
+                  (unsigned long long)lock.contended);
+}
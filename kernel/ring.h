@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+#include "atomic.h"
+
+// Lock-free bounded rings for IRQ → thread hand-off.
+// - 용량은 2의 거듭제곱, 원소 크기는 init 때 고정. 저장 공간은 부르는 쪽이
+//   준다 (정적 배열이나 kmalloc): IRQ 경로에서 할당하지 않기 위해.
+// - head(소비자)와 tail(생산자)은 서로 다른 캐시 라인에 둔다.
+// - 가득 차면 push는 -1을 돌려주고 dropped를 센다. 덮어쓰지 않는다.
+//
+// spsc_ring_t: 생산자 하나, 소비자 하나 (예: 한 CPU의 IRQ 핸들러 → GUI 스레드).
+//   push/pop 모두 대기 없음.
+// mpsc_ring_t: 생산자 여럿 (여러 CPU의 IRQ, 태스크), 소비자 하나.
+//   칸마다 순번(seq)을 두는 방식: 생산자는 tail을 CAS로 예약하고 값을 쓴 뒤
+//   seq를 올려 발행한다. 같은 CPU에서 생산자가 IRQ로 끼어들어도 서로 기다리지
+//   않는다. 예약만 하고 발행 전인 칸이 있으면 소비자는 그 칸에서 "비었음"을 본다.
+
+typedef struct
+{
+    uint8_t          *buf;
+    uint32_t          mask;
+    uint32_t          esize;
+    volatile uint32_t head __cacheline_aligned;   // 소비자
+    volatile uint32_t tail __cacheline_aligned;   // 생산자
+    volatile uint32_t dropped;
+} spsc_ring_t;
+
+typedef struct
+{
+    uint8_t          *buf;
+    uint32_t          mask;
+    uint32_t          esize;
+    uint32_t          stride;                     // 8바이트 seq + 원소, 8바이트 정렬
+    volatile uint32_t head __cacheline_aligned;   // 소비자
+    volatile uint32_t tail __cacheline_aligned;   // 생산자들
+    volatile uint32_t dropped;
+} mpsc_ring_t;
+
+// 필요한 저장 공간 크기 (바이트)
+#define SPSC_RING_BYTES(cap, esize) ((uint32_t)(cap) * (uint32_t)(esize))
+#define MPSC_RING_BYTES(cap, esize) ((uint32_t)(cap) * ((8u + (uint32_t)(esize) + 7u) & ~7u))
+
+// 0 ok, -1 (cap이 2의 거듭제곱이 아니거나 buf/esize가 없음)
+int      spsc_init(spsc_ring_t *r, void *buf, uint32_t cap, uint32_t esize);
+int      spsc_push(spsc_ring_t *r, const void *elem);   // 0 ok, -1 가득 참
+int      spsc_pop(spsc_ring_t *r, void *out);           // 1 꺼냄, 0 비었음
+uint32_t spsc_count(const spsc_ring_t *r);
+
+int      mpsc_init(mpsc_ring_t *r, void *buf, uint32_t cap, uint32_t esize);
+int      mpsc_push(mpsc_ring_t *r, const void *elem);   // 0 ok, -1 가득 참
+int      mpsc_pop(mpsc_ring_t *r, void *out);           // 1 꺼냄, 0 비었음
+uint32_t mpsc_count(const mpsc_ring_t *r);               // 대략 (예약된 칸 포함)
+
+// 셸 명령: 여러 CPU의 생산자로 mpsc 순서와 spinlock 상호 배제를 확인
+void     ring_selftest(void);
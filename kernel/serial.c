@@ -23,12 +23,23 @@ void serial_init(uint16_t base) {
     outb(base + 4, 0x0B);      // OUT2|OUT1|DTR|RTS (IRQ 라우팅/모뎀 제어)
 }
 
+void serial_enable_rx_irq(uint16_t base) {
+    // 읽을 바이트가 생기면 IRQ (FIFO 문턱 또는 수신 타임아웃). 바이트는 여전히 serial_try_getc로 읽는다
+    outb(base + 1, 0x01);
+}
+
 void serial_putc(uint16_t base, char c) {
     if (c == '\n') serial_putc(base, '\r');
     serial_wait_tx(base);
     outb(base + 0, (uint8_t)c);
 }
 
+int serial_try_getc(uint16_t base) {
+    // LSR(5) bit0=1 → 수신 데이터 있음
+    if ((inb(base + 5) & 0x01) == 0) return -1;
+    return inb(base + 0);
+}
+
 void serial_puts(uint16_t base, const char* s) {
     while (*s) serial_putc(base, *s++);
 }
@@ -6,3 +6,7 @@ int  serial_ready_tx(uint16_t base);
 void serial_putc(uint16_t base, char c);
 void serial_write(uint16_t base, const char* s);
 void serial_printf(const char* fmt, ...);
+// Non-blocking read: returns the next received byte or -1 if none.
+int  serial_try_getc(uint16_t base);
+// Raise the port's IRQ when received data is available (COM1: IRQ 4).
+void serial_enable_rx_irq(uint16_t base);
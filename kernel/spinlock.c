@@ -0,0 +1,67 @@
+#include "spinlock.h"
+#include "clock.h"
+#include "serial.h"
+
+volatile uint64_t g_spin_contended;
+
+static spinlock_t  g_reg_lock = SPINLOCK_INIT;
+static spinlock_t *g_reg_head;
+static uint32_t    g_reg_count;
+
+void spin_register(spinlock_t *l, const char *name)
+{
+    uint64_t fl = spin_lock_irqsave(&g_reg_lock);
+    if (!l->name)
+    {
+        l->reg_next = g_reg_head;
+        g_reg_head = l;
+        g_reg_count++;
+    }
+    l->name = name;
+    spin_unlock_irqrestore(&g_reg_lock, fl);
+}
+
+// TSC 사이클 → ns (TSC 주파수를 모르면 사이클 그대로)
+static uint64_t cyc_ns(uint64_t cyc)
+{
+    uint64_t hz = clock_tsc_hz();
+    if (!hz)
+        return cyc;
+    return (uint64_t)(((unsigned __int128)cyc * 1000000000ull) / hz);
+}
+
+void spin_dump(int reset)
+{
+    serial_printf("[locks] %u registered, %llu contended acquisitions in total%s\n",
+                  g_reg_count, (unsigned long long)g_spin_contended,
+                  clock_tsc_hz() ? "" : " (times in TSC cycles)");
+
+    uint64_t fl = spin_lock_irqsave(&g_reg_lock);
+    for (spinlock_t *l = g_reg_head; l; l = l->reg_next)
+    {
+        // 통계는 쥔 쪽만 쓰므로 여기서는 찢어진 값이 보일 수 있다 (표시용)
+        uint64_t acq = l->acquired, cont = l->contended;
+        uint64_t wait = cont ? cyc_ns(l->wait_cycles / cont) : 0;
+        uint64_t hold = acq ? cyc_ns(l->hold_cycles / acq) : 0;
+        uint32_t pct10 = acq ? (uint32_t)(cont * 1000 / acq) : 0;
+        serial_printf("[locks] %s: %llu acq, %u.%u%% contended, wait %llu ns, hold avg %llu ns max %llu ns\n",
+                      l->name, (unsigned long long)acq, pct10 / 10, pct10 % 10,
+                      (unsigned long long)wait, (unsigned long long)hold,
+                      (unsigned long long)cyc_ns(l->hold_max));
+    }
+    spin_unlock_irqrestore(&g_reg_lock, fl);
+
+    if (!reset)
+        return;
+    // 락을 잡고 지워야 쥔 쪽의 갱신과 섞이지 않는다. 목록은 추가만 되므로
+    // 목록 락 없이 돌아도 된다.
+    for (spinlock_t *l = g_reg_head; l; l = l->reg_next)
+    {
+        uint64_t f = spin_lock_irqsave(l);
+        l->acquired = l->contended = l->wait_cycles = 0;
+        l->hold_cycles = l->hold_max = 0;
+        spin_unlock_irqrestore(l, f);
+    }
+    g_spin_contended = 0;
+    serial_printf("[locks] counters reset\n");
+}
@@ -0,0 +1,158 @@
+#pragma once
+#include <stdint.h>
+
+// Ticket spinlock shared by the SMP scheduler, the heap and the drivers.
+// spin_lock_irqsave() must be used for any lock that an interrupt handler
+// (timer tick, IPI) can also take on the same CPU.
+// - 표 뽑기(next)와 호출(owner): 기다리는 CPU들이 도착 순서대로 잡는다 (FIFO).
+// - 락마다 통계: 잡은 횟수, 경합(바로 못 잡음) 횟수와 기다린 사이클, 잡고 있던
+//   사이클의 합과 최대. 모두 락을 쥔 쪽만 쓰므로 원자 연산이 필요 없다.
+//   spin_register()로 이름을 붙이면 spin_dump()/"locks"에 나온다.
+// - 잡은 태스크와 푸는 태스크가 달라도 된다 (rq_lock은 문맥 전환을 건너간다).
+
+#ifndef SPIN_STATS
+#define SPIN_STATS 1
+#endif
+
+typedef struct spinlock
+{
+    union {
+        volatile uint32_t word;
+        struct {
+            volatile uint16_t owner;   // 지금 호출 중인 표
+            volatile uint16_t next;    // 다음에 나눠 줄 표
+        };
+    };
+    uint32_t          pad;
+    uint64_t          acquired;
+    uint64_t          contended;
+    uint64_t          wait_cycles;
+    uint64_t          hold_cycles;
+    uint64_t          hold_max;
+    uint64_t          hold_start;
+    const char       *name;
+    struct spinlock  *reg_next;        // spin_register 목록
+} spinlock_t;
+
+#define SPINLOCK_INIT { .word = 0 }
+
+// 모든 락의 경합 횟수 합 (spinlock.c)
+extern volatile uint64_t g_spin_contended;
+
+static inline uint64_t spin_cycles(void)
+{
+#if SPIN_STATS
+    uint32_t lo, hi;
+    __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+#else
+    return 0;
+#endif
+}
+
+static inline void spin_init(spinlock_t *l)
+{
+    l->word = 0;
+    l->acquired = l->contended = l->wait_cycles = 0;
+    l->hold_cycles = l->hold_max = 0;
+}
+
+static inline int spin_is_locked(const spinlock_t *l)
+{
+    uint32_t v = __atomic_load_n(&l->word, __ATOMIC_RELAXED);
+    return (v & 0xFFFFu) != (v >> 16);
+}
+
+static inline void spin_acquired(spinlock_t *l)
+{
+#if SPIN_STATS
+    l->acquired++;
+    l->hold_start = spin_cycles();
+#else
+    (void)l;
+#endif
+}
+
+static inline int spin_trylock(spinlock_t *l)
+{
+    uint32_t v = __atomic_load_n(&l->word, __ATOMIC_RELAXED);
+    if ((v & 0xFFFFu) != (v >> 16))
+        return 0;
+    // next만 1 올린다 (16비트 넘침은 32비트 덧셈에서 잘려 나간다)
+    if (!__atomic_compare_exchange_n(&l->word, &v, v + 0x10000u, 0,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return 0;
+    spin_acquired(l);
+    return 1;
+}
+
+static inline void spin_lock(spinlock_t *l)
+{
+    uint16_t t = __atomic_fetch_add(&l->next, 1, __ATOMIC_RELAXED);
+    if (__atomic_load_n(&l->owner, __ATOMIC_ACQUIRE) != t)
+    {
+        uint64_t t0 = spin_cycles();
+        while (__atomic_load_n(&l->owner, __ATOMIC_ACQUIRE) != t)
+            __asm__ volatile("pause");
+#if SPIN_STATS
+        l->contended++;
+        l->wait_cycles += spin_cycles() - t0;
+        __atomic_add_fetch(&g_spin_contended, 1, __ATOMIC_RELAXED);
+#else
+        (void)t0;
+#endif
+    }
+    spin_acquired(l);
+}
+
+static inline void spin_unlock(spinlock_t *l)
+{
+#if SPIN_STATS
+    uint64_t held = spin_cycles() - l->hold_start;
+    l->hold_cycles += held;
+    if (held > l->hold_max)
+        l->hold_max = held;
+#endif
+    __atomic_store_n(&l->owner, (uint16_t)(l->owner + 1), __ATOMIC_RELEASE);
+}
+
+static inline uint64_t irq_save(void)
+{
+    uint64_t flags;
+    __asm__ volatile("pushfq; pop %0; cli" : "=r"(flags)::"memory");
+    return flags;
+}
+
+static inline void irq_restore(uint64_t flags)
+{
+    if (flags & (1ull << 9))
+        __asm__ volatile("sti" ::: "memory");
+}
+
+static inline uint64_t spin_lock_irqsave(spinlock_t *l)
+{
+    uint64_t flags = irq_save();
+    spin_lock(l);
+    return flags;
+}
+
+// 1이면 잡았고 *flags에 저장된 IF가 있다. 0이면 인터럽트 상태는 그대로.
+static inline int spin_trylock_irqsave(spinlock_t *l, uint64_t *flags)
+{
+    *flags = irq_save();
+    if (spin_trylock(l))
+        return 1;
+    irq_restore(*flags);
+    return 0;
+}
+
+static inline void spin_unlock_irqrestore(spinlock_t *l, uint64_t flags)
+{
+    spin_unlock(l);
+    irq_restore(flags);
+}
+
+// 통계 목록에 올린다 (한 번만, 정적 이름 문자열).
+void spin_register(spinlock_t *l, const char *name);
+// 등록된 락의 통계를 시리얼로. reset이면 찍은 뒤 0으로.
+void spin_dump(int reset);
@@ -1,68 +1,271 @@
 #include "syscall.h"
 #include "idt.h"
+#include "isr.h"
+#include "gdt.h"
 #include "serial.h"
+#include "clock.h"
+#include "string.h"
+#include "mm/vmm.h"
+#include "task/task.h"
+#include "task/exec.h"
+#include "uring.h"
+#include "uwin.h"
+#include <sys/cpu.h>
 
-#ifndef COM1
-#define COM1 0x3F8
-#endif
+#define MSR_EFER    0xC0000080
+#define MSR_STAR    0xC0000081
+#define MSR_LSTAR   0xC0000082
+#define MSR_SFMASK  0xC0000084
+#define EFER_SCE    (1ull << 0)
 
+// SYSCALL 진입 시 꺼질 RFLAGS 비트: TF | IF | DF | AC
+#define SYSCALL_RFLAGS_MASK 0x47700ull
 
+extern void syscall_entry(void);
 extern void isr_stub80(void);
-void keyboard_handler(void) {
 
-}
+typedef int64_t (*syscall_fn_t)(uint64_t a0, uint64_t a1, uint64_t a2,
+                                uint64_t a3, uint64_t a4, uint64_t a5);
+
+/* --------- 유저 포인터 검사 --------- */
 
-// kernel/syscall.c
-#include <stdint.h>
+static int user_page_ok(uintptr_t va)
+{
+    uintptr_t phys;
+    uint32_t fl;
+    if (va >= USER_ADDR_TOP)
+        return 0;
+    // 아직 안 건드린 demand-paged 페이지면 여기서 채운다
+    if ((vmm_query(va & ~(uintptr_t)0xFFF, &phys, &fl) != 0 || !(fl & VMM_P)) &&
+        uspace_fault(va, 0) != 0)
+        return 0;
+    if (vmm_query(va & ~(uintptr_t)0xFFF, &phys, &fl) != 0)
+        return 0;
+    return (fl & (VMM_P | VMM_US)) == (VMM_P | VMM_US);
+}
 
-void syscall_handler(uint32_t num, uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
-    (void)b;
-    (void)c;
-    (void)d;
-    switch (num)
-    {
-    case 0:
-        serial_printf("[syscall] write %s\n", (char*)(uintptr_t)a);
-        break;
-    
-    default:
-        break;
+// NUL 종단 유저 문자열을 최대 cap-1 바이트 복사. 길이 또는 SYS_EFAULT.
+static int64_t copy_user_str(char *dst, uintptr_t src, size_t cap)
+{
+    size_t n = 0;
+    uintptr_t page = ~(uintptr_t)0;
+    while (n + 1 < cap) {
+        uintptr_t va = src + n;
+        if ((va & ~(uintptr_t)0xFFF) != page) {
+            if (!user_page_ok(va))
+                return SYS_EFAULT;
+            page = va & ~(uintptr_t)0xFFF;
+        }
+        char ch = *(const volatile char *)va;
+        if (!ch)
+            break;
+        dst[n++] = ch;
     }
+    dst[n] = 0;
+    return (int64_t)n;
+}
+
+/* --------- 핸들러 --------- */
+
+static int64_t sys_debug_write(uint64_t str, uint64_t a1, uint64_t a2,
+                               uint64_t a3, uint64_t a4, uint64_t a5)
+{
+    (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    char buf[256];
+    int64_t n = copy_user_str(buf, (uintptr_t)str, sizeof(buf));
+    if (n < 0)
+        return n;
+    serial_printf("[syscall] write %s\n", buf);
+    return n;
+}
+
+static int64_t sys_debug_hex(uint64_t v, uint64_t a1, uint64_t a2,
+                             uint64_t a3, uint64_t a4, uint64_t a5)
+{
+    (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    serial_printf("[syscall] hex 0x%llx\n", (unsigned long long)v);
+    return 0;
+}
+
+static int64_t sys_null(uint64_t a0, uint64_t a1, uint64_t a2,
+                        uint64_t a3, uint64_t a4, uint64_t a5)
+{
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    return 0;
 }
 
-void isr_syscall(void* frame) {
-    (void)frame;
-    uint32_t num, a, b, c, d;
-    __asm__ volatile (
-        "movl %%eax, %0\n"
-        "movl %%ebx, %1\n"
-        "movl %%ecx, %2\n"
-        "movl %%edx, %3\n"
-        : "=r"(num), "=r"(a), "=r"(b), "=r"(c), "=r"(d)
-    );
+static int64_t sys_gettid(uint64_t a0, uint64_t a1, uint64_t a2,
+                          uint64_t a3, uint64_t a4, uint64_t a5)
+{
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    return current_task()->tid;
+}
 
-    syscall_handler(num, a, b, c, d);
+static int64_t sys_yield(uint64_t a0, uint64_t a1, uint64_t a2,
+                         uint64_t a3, uint64_t a4, uint64_t a5)
+{
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    yield();
+    return 0;
 }
 
+static int64_t sys_clock_ns(uint64_t a0, uint64_t a1, uint64_t a2,
+                            uint64_t a3, uint64_t a4, uint64_t a5)
+{
+    (void)a0; (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    return (int64_t)ktime_ns();
+}
 
+static int64_t sys_exit(uint64_t code, uint64_t a1, uint64_t a2,
+                        uint64_t a3, uint64_t a4, uint64_t a5)
+{
+    (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    task_t *t = current_task();
+    serial_printf("[syscall] '%s' (tid %u) exit %lld\n",
+                  t->name, t->tid, (long long)code);
+    kthread_exit();
+}
 
+static int64_t sys_bench_report(uint64_t a_cycles, uint64_t b_cycles, uint64_t iters,
+                                uint64_t kind, uint64_t a4, uint64_t a5)
+{
+    (void)a4; (void)a5;
+    static const char *const what[][3] = {
+        [BENCH_SYSCALL_VS_INT80]       = { "null round trip", "SYSCALL", "int 0x80" },
+        [BENCH_URING_PERCALL_VS_BATCH] = { "uring NOP", "enter per SQE", "batched" },
+    };
+    if (!iters || kind >= sizeof(what) / sizeof(what[0]))
+        return SYS_EFAULT;
+    uint64_t a = a_cycles / iters, b = b_cycles / iters;
+    serial_printf("[syscall] %s x%llu: %s %llu cycles (%llu ns), %s %llu cycles (%llu ns)\n",
+                  what[kind][0], (unsigned long long)iters,
+                  what[kind][1], (unsigned long long)a, (unsigned long long)clock_cycles_to_ns(a),
+                  what[kind][2], (unsigned long long)b, (unsigned long long)clock_cycles_to_ns(b));
+    return 0;
+}
 
-void syscall_init(void){
-    idt_set_gate(0x80, (uint64_t)isr_syscall, 0x08, 0xEE, 0);
+static int64_t sys_uring_setup(uint64_t flags, uint64_t a1, uint64_t a2,
+                               uint64_t a3, uint64_t a4, uint64_t a5)
+{
+    (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    return uring_setup((uint32_t)flags);
+}
+
+static int64_t sys_uring_enter(uint64_t to_submit, uint64_t min_complete, uint64_t flags,
+                               uint64_t a3, uint64_t a4, uint64_t a5)
+{
+    (void)a3; (void)a4; (void)a5;
+    return uring_enter((uint32_t)to_submit, (uint32_t)min_complete, (uint32_t)flags);
+}
 
-    serial_printf("[syscall] int 0x80 handler installed.\n"); 
+static int64_t sys_win_create(uint64_t w, uint64_t h, uint64_t title,
+                              uint64_t a3, uint64_t a4, uint64_t a5)
+{
+    (void)a3; (void)a4; (void)a5;
+    if (w > 0xFFFFFFFFu || h > 0xFFFFFFFFu)
+        return SYS_EFAULT;
+    return uwin_create((uint32_t)w, (uint32_t)h, title);
 }
 
+static int64_t sys_win_damage(uint64_t xy, uint64_t wh, uint64_t a2,
+                              uint64_t a3, uint64_t a4, uint64_t a5)
+{
+    (void)a2; (void)a3; (void)a4; (void)a5;
+    return uwin_damage(xy, wh);
+}
 
-void syscall_dispatch(uint32_t eax, uint32_t ebx, uint32_t ecx, uint32_t edx){
-    (void)ecx; (void)edx;
-    if (eax == 1){
-        char buf[64];
-        const char H[]="0123456789ABCDEF";
-        buf[0]='[';buf[1]='s';buf[2]='y';buf[3]='s';buf[4]='c';buf[5]='a';buf[6]='l';buf[7]=']';buf[8]=' ';
-        buf[9]='E';buf[10]='B';buf[11]='X';buf[12]='='; 
-        for(int i=0;i<8;i++){ buf[20-1-i]=H[(ebx>>(i*4))&0xF]; }
-        buf[20]='\r'; buf[21]='\n'; buf[22]=0;
-        serial_write(COM1, buf);
+static int64_t sys_win_wait(uint64_t timeout_ms, uint64_t a1, uint64_t a2,
+                            uint64_t a3, uint64_t a4, uint64_t a5)
+{
+    (void)a1; (void)a2; (void)a3; (void)a4; (void)a5;
+    return uwin_wait(timeout_ms);
+}
+
+static const syscall_fn_t g_sys_table[SYS_MAX] = {
+    [SYS_DEBUG_WRITE]  = sys_debug_write,
+    [SYS_DEBUG_HEX]    = sys_debug_hex,
+    [SYS_NULL]         = sys_null,
+    [SYS_GETTID]       = sys_gettid,
+    [SYS_YIELD]        = sys_yield,
+    [SYS_CLOCK_NS]     = sys_clock_ns,
+    [SYS_EXIT]         = sys_exit,
+    [SYS_BENCH_REPORT] = sys_bench_report,
+    [SYS_URING_SETUP]  = sys_uring_setup,
+    [SYS_URING_ENTER]  = sys_uring_enter,
+    [SYS_WIN_CREATE]   = sys_win_create,
+    [SYS_WIN_DAMAGE]   = sys_win_damage,
+    [SYS_WIN_WAIT]     = sys_win_wait,
+};
+
+/* --------- 진입점 --------- */
+
+// syscall_entry.asm 에서 인터럽트를 켠 채로 호출된다.
+int64_t syscall_dispatch(syscall_frame_t *f)
+{
+    int64_t ret = SYS_ENOSYS;
+    if (f->nr < SYS_MAX && g_sys_table[f->nr])
+        ret = g_sys_table[f->nr](f->a0, f->a1, f->a2, f->a3, f->a4, f->a5);
+
+    // SYSRET은 RCX가 non-canonical이면 ring 0에서 #GP를 낸다.
+    // 주소공간 끝에서 syscall 한 태스크는 돌려보내지 않고 끝낸다.
+    if (f->rip >= USER_ADDR_TOP) {
+        serial_printf("[syscall] non-canonical return rip=0x%llx, killing tid %u\n",
+                      (unsigned long long)f->rip, current_task()->tid);
+        kthread_exit();
     }
+    return ret;
+}
+
+// int 0x80 호환 경로: isr_common_handler 에서 인터럽트 게이트(IF=0)로 들어온다.
+void syscall_int80(int_frame_t *r)
+{
+    syscall_frame_t f = {
+        .nr = r->rax,
+        .a0 = r->rdi, .a1 = r->rsi, .a2 = r->rdx,
+        .a3 = r->r10, .a4 = r->r8,  .a5 = r->r9,
+        .rip = r->rip, .rflags = r->rflags, .rsp = r->rsp,
+    };
+    __asm__ volatile("sti");
+    r->rax = (uint64_t)syscall_dispatch(&f);
+    __asm__ volatile("cli");
+}
+
+void syscall_init_cpu(void)
+{
+    wrmsr(MSR_EFER, rdmsr(MSR_EFER) | EFER_SCE);
+    // SYSCALL: CS = STAR[47:32], SS = +8
+    // SYSRET : SS = STAR[63:48] + 8, CS = +16 (RPL 3) → udata, ucode 순서
+    wrmsr(MSR_STAR, ((uint64_t)GDT_SEL_KERNEL_DATA << 48) |
+                    ((uint64_t)GDT_SEL_KERNEL_CODE << 32));
+    wrmsr(MSR_LSTAR, (uint64_t)(uintptr_t)syscall_entry);
+    wrmsr(MSR_SFMASK, SYSCALL_RFLAGS_MASK);
+}
+
+void syscall_init(void)
+{
+    _Static_assert(GDT_SEL_USER_DATA == ((GDT_SEL_KERNEL_DATA + 8) | 3), "SYSRET SS");
+    _Static_assert(GDT_SEL_USER_CODE == ((GDT_SEL_KERNEL_DATA + 16) | 3), "SYSRET CS");
+
+    idt_set_gate(0x80, (uint64_t)(uintptr_t)isr_stub80, GDT_SEL_KERNEL_CODE, 0xEE, 0);
+    syscall_init_cpu();
+
+    serial_printf("[syscall] SYSCALL entry=%p, int 0x80 compat installed\n",
+                  (void *)syscall_entry);
+}
+
+/* --------- 벤치마크 --------- */
+
+extern const uint8_t sysbench_user_start[];
+extern const uint8_t sysbench_user_end[];
+
+// uring_bench와 같이 exec_image로 새 주소공간에 올린다: 코드/스택이 공유 커널
+// 페이지 테이블에 남지 않고, 여러 번 돌려도 서로 스택을 나누지 않는다
+void syscall_bench(void)
+{
+    size_t len = (size_t)(sysbench_user_end - sysbench_user_start);
+    int tid = exec_image("sysbench", sysbench_user_start, len);
+    if (tid < 0)
+        serial_printf("[syscall] bench: start failed\n");
+    else
+        serial_printf("[syscall] bench: ring 3 task tid %d started\n", tid);
 }
@@ -1,5 +1,60 @@
 #pragma once
 #include <stdint.h>
-void syscall_init(void);      
-void syscall_dispatch(uint32_t eax, uint32_t ebx, uint32_t ecx, uint32_t edx);
-void syscall_handler(uint32_t num, uint32_t a, uint32_t b, uint32_t c, uint32_t d);
\ No newline at end of file
+
+// System calls.
+// - SYSCALL/SYSRET (fast path): RAX = number, arguments in RDI, RSI, RDX,
+//   R10, R8, R9, result in RAX. RCX and R11 are clobbered by the CPU.
+// - int 0x80 (compatibility): same registers and the same table, every
+//   register except RAX is preserved.
+// Unknown numbers return SYS_ENOSYS.
+
+enum
+{
+    SYS_DEBUG_WRITE  = 0,  // (const char *str)          serial log
+    SYS_DEBUG_HEX    = 1,  // (uint64_t value)           serial log
+    SYS_NULL         = 2,  // ()                         round-trip benchmark
+    SYS_GETTID       = 3,
+    SYS_YIELD        = 4,
+    SYS_CLOCK_NS     = 5,  // monotonic ns
+    SYS_EXIT         = 6,
+    SYS_BENCH_REPORT = 7,  // (cycles A, cycles B, iterations, BENCH_*)
+    SYS_URING_SETUP  = 8,  // (flags)                    → ring address (uring.h)
+    SYS_URING_ENTER  = 9,  // (to_submit, min_complete, flags) → SQEs consumed
+    SYS_WIN_CREATE   = 10, // (width, height, title)     → surface address (uwin.h)
+    SYS_WIN_DAMAGE   = 11, // (x | y<<32, w | h<<32)
+    SYS_WIN_WAIT     = 12, // (timeout_ms)               → pending input events
+    SYS_MAX
+};
+
+// SYS_BENCH_REPORT kinds: what A and B measured
+enum
+{
+    BENCH_SYSCALL_VS_INT80 = 0,   // null call: SYSCALL vs int 0x80
+    BENCH_URING_PERCALL_VS_BATCH, // NOP: one enter per SQE vs one per batch
+};
+
+#define SYS_ENOSYS (-1)
+#define SYS_EFAULT (-2)
+
+// Highest user address + 1 (canonical lower half).
+#define USER_ADDR_TOP 0x0000800000000000ull
+
+// Built by syscall_entry.asm (and by syscall_int80 from the ISR frame).
+typedef struct
+{
+    uint64_t nr;
+    uint64_t a0, a1, a2, a3, a4, a5;  // rdi, rsi, rdx, r10, r8, r9
+    uint64_t rip;                     // user RCX
+    uint64_t rflags;                  // user R11
+    uint64_t rsp;
+} syscall_frame_t;
+
+struct int_frame;
+
+void    syscall_init(void);       // BSP: int 0x80 gate + SYSCALL MSRs
+void    syscall_init_cpu(void);   // every CPU: EFER.SCE, STAR, LSTAR, SFMASK
+int64_t syscall_dispatch(syscall_frame_t *f);
+void    syscall_int80(struct int_frame *r);
+
+// Run the null-syscall benchmark in a ring 3 task (result on the serial log).
+void    syscall_bench(void);
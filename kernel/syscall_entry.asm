@@ -0,0 +1,115 @@
+; =======================================================
+; 64-bit SYSCALL 엔트리 (syscall.c 의 syscall_init_cpu 가 LSTAR 에 등록)
+;  - CPU 상태: RCX = 유저 RIP, R11 = 유저 RFLAGS, RSP = 유저 스택,
+;              SFMASK 로 IF/TF/DF/AC 가 꺼진 채 ring 0
+;  - swapgs 로 per-CPU(cpu_t)를 잡고 cpu_t.syscall_rsp 커널 스택으로 전환
+;  - syscall_frame_t 를 쌓고 syscall_dispatch(frame) 호출, RAX = 결과
+; =======================================================
+BITS 64
+section .text align=16
+
+extern syscall_dispatch
+global syscall_entry
+
+; percpu.h 의 CPU_OFF_* 와 같아야 한다
+%define CPU_OFF_SYSCALL_RSP 8
+%define CPU_OFF_USER_RSP    16
+
+syscall_entry:
+    swapgs
+    mov [gs:CPU_OFF_USER_RSP], rsp
+    mov rsp, [gs:CPU_OFF_SYSCALL_RSP]
+
+    ; syscall_frame_t (낮은 주소부터 nr, a0..a5, rip, rflags, rsp)
+    push qword [gs:CPU_OFF_USER_RSP]
+    push r11                ; 유저 RFLAGS
+    push rcx                ; 유저 RIP
+    push r9                 ; a5
+    push r8                 ; a4
+    push r10                ; a3 (RCX 대신 R10)
+    push rdx                ; a2
+    push rsi                ; a1
+    push rdi                ; a0
+    push rax                ; 번호
+
+    ; 10 qword = 80 바이트라 스택 16바이트 정렬이 유지된다
+    mov rdi, rsp
+    sti
+    call syscall_dispatch
+    cli
+
+    add rsp, 8              ; 번호 버림 (RAX = 반환값)
+    pop rdi
+    pop rsi
+    pop rdx
+    pop r10
+    pop r8
+    pop r9
+    pop rcx                 ; SYSRET → RIP
+    pop r11                 ; SYSRET → RFLAGS
+    swapgs
+    pop rsp                 ; 유저 스택
+    o64 sysret
+
+; =======================================================
+; 시스템콜 왕복 벤치마크 (ring 3, 위치 독립)
+;  - syscall_bench() 가 exec_image 로 이 바이트들을 새 주소공간에 올려 실행
+;  - SYSCALL 과 int 0x80 으로 SYS_NULL 을 N번씩 부르고
+;    rdtsc 로 잰 총 사이클을 SYS_BENCH_REPORT 로 넘긴 뒤 SYS_EXIT
+; =======================================================
+section .rodata align=16
+
+; syscall.h 의 번호와 같아야 한다
+%define SYS_NULL          2
+%define SYS_EXIT          6
+%define SYS_BENCH_REPORT  7
+%define BENCH_SYSCALL_VS_INT80 0
+%define BENCH_ITERS       100000
+
+global sysbench_user_start
+global sysbench_user_end
+
+%macro RDTSC64 0
+    rdtsc
+    shl rdx, 32
+    or rax, rdx
+%endmacro
+
+sysbench_user_start:
+    ; SYSCALL 경로
+    mov r12, BENCH_ITERS
+    RDTSC64
+    mov r13, rax
+.sc_loop:
+    mov eax, SYS_NULL
+    syscall
+    dec r12
+    jnz .sc_loop
+    RDTSC64
+    sub rax, r13
+    mov r14, rax
+
+    ; int 0x80 호환 경로
+    mov r12, BENCH_ITERS
+    RDTSC64
+    mov r13, rax
+.int_loop:
+    mov eax, SYS_NULL
+    int 0x80
+    dec r12
+    jnz .int_loop
+    RDTSC64
+    sub rax, r13
+
+    mov rdi, r14            ; SYSCALL 총 사이클
+    mov rsi, rax            ; int 0x80 총 사이클
+    mov rdx, BENCH_ITERS
+    mov r10d, BENCH_SYSCALL_VS_INT80
+    mov eax, SYS_BENCH_REPORT
+    syscall
+
+    xor edi, edi
+    mov eax, SYS_EXIT
+    syscall
+    ud2
+sysbench_user_end:
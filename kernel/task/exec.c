@@ -0,0 +1,548 @@
+#include "exec.h"
+#include "task.h"
+#include "isr.h"
+#include "kheap.h"
+#include "pmm.h"
+#include "serial.h"
+#include "spinlock.h"
+#include "uring.h"
+#include "uwin.h"
+#include "vdso.h"
+#include <string.h>
+
+/* ELF64 (커널 쪽 최소 정의: lib/elf.c 는 부트로더 전용) */
+#define EI_NIDENT    16
+#define ELFCLASS64   2
+#define ELFDATA2LSB  1
+#define ET_EXEC      2
+#define ET_DYN       3
+#define EM_X86_64    62
+#define PT_LOAD      1
+#define PT_DYNAMIC   2
+#define PT_INTERP    3
+#define PF_X         1
+#define PF_W         2
+#define PF_R         4
+
+#define EXEC_MAX_PHDRS 16
+
+typedef struct
+{
+    uint8_t  ident[EI_NIDENT];
+    uint16_t type;
+    uint16_t machine;
+    uint32_t version;
+    uint64_t entry;
+    uint64_t phoff;
+    uint64_t shoff;
+    uint32_t flags;
+    uint16_t ehsize;
+    uint16_t phentsize;
+    uint16_t phnum;
+    uint16_t shentsize;
+    uint16_t shnum;
+    uint16_t shstrndx;
+} elf64_ehdr_t;
+
+typedef struct
+{
+    uint32_t type;
+    uint32_t flags;
+    uint64_t offset;
+    uint64_t vaddr;
+    uint64_t paddr;
+    uint64_t filesz;
+    uint64_t memsz;
+    uint64_t align;
+} elf64_phdr_t;
+
+/* #PF 에러 코드 */
+#define PF_ERR_PRESENT (1u << 0)
+#define PF_ERR_WRITE   (1u << 1)
+
+#define PAGE_MASK_4K (~(uint64_t)0xFFF)
+
+static fat32_vol_t *g_exec_vol;
+static disk_read_fn g_exec_rd;
+static disk_write_fn g_exec_wr;
+
+/* --------- 유저 페이지 풀 ---------
+ * PMM은 해제를 지원하지 않으므로 끝난 프로세스의 페이지와 페이지 테이블을
+ * 여기 모아 두었다가 다음 fault-in에서 다시 쓴다. 다음 포인터는 페이지 안에. */
+static spinlock_t g_upage_lock = SPINLOCK_INIT;
+static uint64_t   g_upage_free;
+static uint32_t   g_upage_nfree;
+
+static inline void *upage_va(uint64_t phys)
+{
+    return (void *)(uintptr_t)(phys + vmm_hhdm_offset());
+}
+
+static uint64_t upage_alloc(void)
+{
+    uint64_t fl = spin_lock_irqsave(&g_upage_lock);
+    uint64_t pa = g_upage_free;
+    if (pa)
+    {
+        g_upage_free = *(uint64_t *)upage_va(pa);
+        g_upage_nfree--;
+    }
+    spin_unlock_irqrestore(&g_upage_lock, fl);
+    if (pa)
+        return pa;
+
+    // 풀로 돌아온 페이지는 PMM에 돌려주지 않으므로 처음 받을 때만 센다
+    void *va = pmm_alloc_tag(KMEM_TAG_USER);
+    return va ? (uint64_t)(uintptr_t)va - vmm_hhdm_offset() : 0;
+}
+
+static void upage_free(uint64_t phys)
+{
+    uint64_t fl = spin_lock_irqsave(&g_upage_lock);
+    *(uint64_t *)upage_va(phys) = g_upage_free;
+    g_upage_free = phys;
+    g_upage_nfree++;
+    spin_unlock_irqrestore(&g_upage_lock, fl);
+}
+
+void exec_set_volume(fat32_vol_t *vol, disk_read_fn rd, disk_write_fn wr)
+{
+    g_exec_vol = vol;
+    g_exec_rd = rd;
+    g_exec_wr = wr;
+}
+
+fat32_vol_t *exec_volume(disk_read_fn *rd, disk_write_fn *wr)
+{
+    if (rd)
+        *rd = g_exec_rd;
+    if (wr)
+        *wr = g_exec_wr;
+    return g_exec_vol;
+}
+
+static int read_exact(uspace_t *us, uint64_t off, void *buf, uint32_t len)
+{
+    uint32_t n = 0;
+    if (off + len > us->file.size)
+        return -1;
+    if (fat32_read_at(g_exec_vol, g_exec_rd, &us->file, (uint32_t)off, buf, len, &n) != 0 || n != len)
+        return -1;
+    return 0;
+}
+
+/* --------- exec --------- */
+
+static int elf_check_header(const elf64_ehdr_t *eh)
+{
+    if (eh->ident[0] != 0x7F || eh->ident[1] != 'E' || eh->ident[2] != 'L' || eh->ident[3] != 'F')
+        return -1;
+    if (eh->ident[4] != ELFCLASS64 || eh->ident[5] != ELFDATA2LSB)
+        return -1;
+    if (eh->machine != EM_X86_64 || (eh->type != ET_EXEC && eh->type != ET_DYN))
+        return -1;
+    if (eh->phentsize != sizeof(elf64_phdr_t) || eh->phnum == 0 || eh->phnum > EXEC_MAX_PHDRS)
+        return -1;
+    return 0;
+}
+
+static int add_seg(uspace_t *us, uint64_t vaddr, uint64_t memsz, uint64_t off,
+                   uint64_t filesz, uint32_t prot)
+{
+    if (us->nsegs >= (int)(sizeof(us->segs) / sizeof(us->segs[0])))
+        return -1;
+    useg_t *s = &us->segs[us->nsegs++];
+    s->start = vaddr & PAGE_MASK_4K;
+    s->end = (vaddr + memsz + 0xFFF) & PAGE_MASK_4K;
+    s->vaddr = vaddr;
+    s->file_off = off;
+    s->file_sz = filesz;
+    s->prot = prot;
+    return 0;
+}
+
+static int exec_load_layout(uspace_t *us)
+{
+    elf64_ehdr_t eh;
+    elf64_phdr_t ph[EXEC_MAX_PHDRS];
+
+    if (read_exact(us, 0, &eh, sizeof(eh)) != 0 || elf_check_header(&eh) != 0)
+    {
+        serial_printf("[exec] %s: not an x86_64 ELF64 executable\n", us->path);
+        return -1;
+    }
+    if (read_exact(us, eh.phoff, ph, (uint32_t)(eh.phnum * sizeof(elf64_phdr_t))) != 0)
+        return -1;
+
+    // ET_DYN은 가장 낮은 PT_LOAD가 VMM_USER_BASE에 오도록 민다
+    uint64_t bias = 0;
+    if (eh.type == ET_DYN)
+    {
+        uint64_t lo = ~0ull;
+        for (int i = 0; i < eh.phnum; ++i)
+            if (ph[i].type == PT_LOAD && ph[i].vaddr < lo)
+                lo = ph[i].vaddr;
+        bias = VMM_USER_BASE - (lo & PAGE_MASK_4K);
+    }
+
+    uint64_t seg_limit = USER_VDSO_VA - 0x1000;   // vDSO/창/링/스택 아래 가드 페이지
+    for (int i = 0; i < eh.phnum; ++i)
+    {
+        const elf64_phdr_t *p = &ph[i];
+        if (p->type == PT_INTERP || (p->type == PT_DYNAMIC && eh.type == ET_DYN))
+        {
+            serial_printf("[exec] %s: dynamic linking/relocation not supported\n", us->path);
+            return -1;
+        }
+        if (p->type != PT_LOAD || p->memsz == 0)
+            continue;
+
+        uint64_t va = p->vaddr + bias;
+        if (p->filesz > p->memsz || p->offset + p->filesz > us->file.size ||
+            va < VMM_USER_BASE || va + p->memsz > seg_limit || va + p->memsz < va)
+        {
+            serial_printf("[exec] %s: bad PT_LOAD va=0x%llx memsz=0x%llx\n", us->path,
+                          (unsigned long long)va, (unsigned long long)p->memsz);
+            return -1;
+        }
+        if (add_seg(us, va, p->memsz, p->offset, p->filesz, p->flags & (PF_R | PF_W | PF_X)) != 0)
+        {
+            serial_printf("[exec] %s: too many segments\n", us->path);
+            return -1;
+        }
+        us->image_bytes += us->segs[us->nsegs - 1].end - us->segs[us->nsegs - 1].start;
+    }
+    if (us->nsegs == 0)
+        return -1;
+
+    us->entry = eh.entry + bias;
+    int entry_ok = 0;
+    for (int i = 0; i < us->nsegs; ++i)
+        if (us->entry >= us->segs[i].vaddr && us->entry < us->segs[i].end &&
+            (us->segs[i].prot & PF_X))
+            entry_ok = 1;
+    if (!entry_ok)
+    {
+        serial_printf("[exec] %s: entry 0x%llx outside executable segments\n", us->path,
+                      (unsigned long long)us->entry);
+        return -1;
+    }
+
+    // 스택도 0으로 채워지는 세그먼트: 닿은 페이지만 생긴다
+    return add_seg(us, USER_STACK_TOP - USER_STACK_SIZE, USER_STACK_SIZE, 0, 0,
+                   PF_R | PF_W);
+}
+
+static void uspace_free(uspace_t *us)
+{
+    // 폴링 스레드가 아직 이 주소공간을 만지고 있을 수 있다: 먼저 세운다
+    if (us->ring)
+        uring_destroy(us->ring);
+    if (us->win)
+        uwin_destroy(us->win);
+    if (us->cr3)
+    {
+        vdso_unmap(us->cr3);
+        vmm_space_destroy(us->cr3, upage_free);
+    }
+    kfree(us);
+}
+
+static const char *path_basename(const char *path)
+{
+    const char *name = path;
+    for (const char *p = path; *p; ++p)
+        if (*p == '/')
+            name = p + 1;
+    return name;
+}
+
+int exec(const char *path)
+{
+    if (!g_exec_vol || !g_exec_rd || !path)
+        return -1;
+
+    uspace_t *us = kzalloc_tag(sizeof(*us), KMEM_TAG_TASK);
+    if (!us)
+        return -1;
+    mutex_init(&us->lock);
+    size_t n = strlen(path);
+    if (n >= sizeof(us->path))
+        n = sizeof(us->path) - 1;
+    memcpy(us->path, path, n);
+    us->path[n] = 0;
+
+    if (fat32_open_path(g_exec_vol, g_exec_rd, path, &us->file) != 0)
+    {
+        serial_printf("[exec] %s: not found\n", path);
+        kfree(us);
+        return -1;
+    }
+    if (exec_load_layout(us) != 0)
+    {
+        kfree(us);
+        return -1;
+    }
+    us->cr3 = vmm_space_create();
+    if (!us->cr3)
+    {
+        kfree(us);
+        return -1;
+    }
+    vdso_map(us->cr3);
+
+    // _start 진입 시 [rsp] = argc(0), argv/envp/auxv 끝 표시(0): 0으로 채워진 페이지 그대로
+    task_t *t = proc_create_user(us->entry, USER_STACK_TOP - 64, us->cr3, us, path_basename(us->path));
+    if (!t)
+    {
+        uspace_free(us);
+        return -1;
+    }
+    serial_printf("[exec] %s: tid %u entry=0x%llx, %d segments, %llu KiB image (nothing loaded yet)\n",
+                  us->path, t->tid, (unsigned long long)us->entry, us->nsegs - 1,
+                  (unsigned long long)(us->image_bytes / 1024));
+    return (int)t->tid;
+}
+
+int exec_image(const char *name, const void *code, size_t len)
+{
+    if (!len || len > USER_VDSO_VA - 0x1000 - VMM_USER_BASE)
+        return -1;
+    uspace_t *us = kzalloc_tag(sizeof(*us), KMEM_TAG_TASK);
+    if (!us)
+        return -1;
+    mutex_init(&us->lock);
+    size_t n = strlen(name);
+    if (n >= sizeof(us->path))
+        n = sizeof(us->path) - 1;
+    memcpy(us->path, name, n);
+    us->path[n] = 0;
+    us->entry = VMM_USER_BASE;
+
+    // 코드는 파일이 없으니 미리 채워 매핑한다 (file_sz = 0이라 fault 경로는 안 읽는다)
+    if (add_seg(us, VMM_USER_BASE, len, 0, 0, PF_R | PF_X) != 0 ||
+        add_seg(us, USER_STACK_TOP - USER_STACK_SIZE, USER_STACK_SIZE, 0, 0, PF_R | PF_W) != 0)
+    {
+        kfree(us);
+        return -1;
+    }
+    us->image_bytes = us->segs[0].end - us->segs[0].start;
+    us->cr3 = vmm_space_create();
+    if (!us->cr3)
+    {
+        kfree(us);
+        return -1;
+    }
+    vdso_map(us->cr3);
+    for (size_t off = 0; off < len; off += 0x1000)
+    {
+        uint64_t pa = upage_alloc();
+        if (!pa || vmm_space_map(us->cr3, VMM_USER_BASE + off, pa, VMM_P | VMM_US) != 0)
+        {
+            if (pa)
+                upage_free(pa);
+            uspace_free(us);
+            return -1;
+        }
+        size_t chunk = len - off < 0x1000 ? len - off : 0x1000;
+        memset(upage_va(pa), 0, 0x1000);
+        memcpy(upage_va(pa), (const uint8_t *)code + off, chunk);
+    }
+
+    task_t *t = proc_create_user(us->entry, USER_STACK_TOP - 64, us->cr3, us, path_basename(us->path));
+    if (!t)
+    {
+        uspace_free(us);
+        return -1;
+    }
+    return (int)t->tid;
+}
+
+/* --------- demand paging --------- */
+
+int uspace_fault(uintptr_t addr, uint32_t err)
+{
+    return uspace_fault_in(current_task()->uspace, addr, err);
+}
+
+int uspace_fault_in(uspace_t *us, uintptr_t addr, uint32_t err)
+{
+    if (!us || addr < VMM_USER_BASE || addr >= VMM_USER_LIMIT || (err & PF_ERR_PRESENT))
+        return -1;
+
+    uint64_t va = addr & PAGE_MASK_4K;
+    int rc = -1;
+    mutex_lock(&us->lock);
+
+    uintptr_t phys;
+    uint32_t fl;
+    if (vmm_space_query(us->cr3, va, &phys, &fl) == 0 && (fl & VMM_P))
+    {
+        rc = 0;   // 락을 기다리는 동안 이미 채워졌다
+        goto out;
+    }
+
+    uint32_t prot = 0;
+    for (int i = 0; i < us->nsegs; ++i)
+        if (va < us->segs[i].end && va + 0x1000 > us->segs[i].start)
+            prot |= us->segs[i].prot;
+    if (!prot || ((err & PF_ERR_WRITE) && !(prot & PF_W)))
+        goto out;
+
+    uint64_t pa = upage_alloc();
+    if (!pa)
+        goto out;
+    uint8_t *dst = upage_va(pa);
+    memset(dst, 0, 0x1000);
+
+    // 세그먼트 경계가 한 페이지를 나눠 쓸 수 있으므로 겹치는 모든 파일 구간을 채운다
+    int from_file = 0;
+    for (int i = 0; i < us->nsegs; ++i)
+    {
+        const useg_t *s = &us->segs[i];
+        uint64_t lo = s->vaddr > va ? s->vaddr : va;
+        uint64_t hi = s->vaddr + s->file_sz;
+        if (hi > va + 0x1000)
+            hi = va + 0x1000;
+        if (lo >= hi)
+            continue;
+        if (read_exact(us, s->file_off + (lo - s->vaddr), dst + (lo - va), (uint32_t)(hi - lo)) != 0)
+        {
+            serial_printf("[exec] %s: read failed at va=0x%llx\n", us->path, (unsigned long long)va);
+            upage_free(pa);
+            goto out;
+        }
+        from_file = 1;
+    }
+
+    uint32_t map = VMM_P | VMM_US;
+    if (prot & PF_W)
+        map |= VMM_RW;
+    if (vmm_space_map(us->cr3, va, pa, map) != 0)
+    {
+        upage_free(pa);
+        goto out;
+    }
+    us->faults++;
+    if (from_file)
+        us->file_pages++;
+    else
+        us->zero_pages++;
+    rc = 0;
+out:
+    mutex_unlock(&us->lock);
+    return rc;
+}
+
+/* --------- 유저 메모리 복사 (HHDM 경유) --------- */
+
+// 유저 페이지 va의 커널 쪽 주소. 없으면 채운다.
+static uint8_t *uspace_page(uspace_t *us, uint64_t va, int write)
+{
+    uintptr_t phys;
+    uint32_t fl;
+    if (!us || va < VMM_USER_BASE || va >= VMM_USER_LIMIT)
+        return NULL;
+    if (vmm_space_query(us->cr3, va & PAGE_MASK_4K, &phys, &fl) != 0 || !(fl & VMM_P))
+    {
+        if (uspace_fault_in(us, va, write ? PF_ERR_WRITE : 0) != 0 ||
+            vmm_space_query(us->cr3, va & PAGE_MASK_4K, &phys, &fl) != 0)
+            return NULL;
+    }
+    if (!(fl & VMM_US) || (write && !(fl & VMM_RW)))
+        return NULL;
+    return (uint8_t *)upage_va(phys) + (va & 0xFFF);
+}
+
+int uspace_copy_in(uspace_t *us, void *dst, uint64_t src, size_t len)
+{
+    uint8_t *d = dst;
+    while (len)
+    {
+        uint8_t *s = uspace_page(us, src, 0);
+        if (!s)
+            return -1;
+        size_t chunk = 0x1000 - (src & 0xFFF);
+        if (chunk > len)
+            chunk = len;
+        memcpy(d, s, chunk);
+        d += chunk;
+        src += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
+
+int uspace_copy_out(uspace_t *us, uint64_t dst, const void *src, size_t len)
+{
+    const uint8_t *s = src;
+    while (len)
+    {
+        uint8_t *d = uspace_page(us, dst, 1);
+        if (!d)
+            return -1;
+        size_t chunk = 0x1000 - (dst & 0xFFF);
+        if (chunk > len)
+            chunk = len;
+        memcpy(d, s, chunk);
+        s += chunk;
+        dst += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
+
+int uspace_copy_str(uspace_t *us, char *dst, uint64_t src, size_t cap)
+{
+    size_t n = 0;
+    const char *p = NULL;
+    while (n + 1 < cap)
+    {
+        uint64_t va = src + n;
+        if (!p || (va & 0xFFF) == 0)
+        {
+            p = (const char *)uspace_page(us, va, 0);
+            if (!p)
+                return -1;
+        }
+        char ch = *p++;
+        if (!ch)
+            break;
+        dst[n++] = ch;
+    }
+    dst[n] = 0;
+    return (int)n;
+}
+
+int uspace_page_fault(uint32_t err, struct int_frame *r)
+{
+    uint64_t cr2;
+    __asm__ volatile("mov %%cr2, %0" : "=r"(cr2));
+
+    // 디스크를 읽느라 잠들 수 있다: 끊긴 문맥이 IF=1이었으면 인터럽트를 켠다
+    int irq_on = (r->rflags & 0x200) != 0;
+    if (irq_on)
+        __asm__ volatile("sti");
+    int rc = irq_on ? uspace_fault((uintptr_t)cr2, err) : -1;
+    __asm__ volatile("cli");
+    if (rc == 0)
+        return 0;
+
+    if (r->cs & 3)
+    {
+        task_t *t = current_task();
+        serial_printf("[exec] '%s' (tid %u) segfault at 0x%llx rip=0x%llx err=%x\n",
+                      t->name, t->tid, (unsigned long long)cr2,
+                      (unsigned long long)r->rip, err);
+        kthread_exit();
+    }
+    return -1;
+}
+
+void uspace_destroy(uspace_t *us)
+{
+    serial_printf("[exec] %s done: %u faults (%u file, %u zero) = %u KiB touched of %llu KiB image\n",
+                  us->path, us->faults, us->file_pages, us->zero_pages, us->faults * 4u,
+                  (unsigned long long)(us->image_bytes / 1024));
+    uspace_free(us);
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "fs_fat32.h"
+#include "sync.h"
+#include "mm/vmm.h"
+
+struct int_frame;
+
+// ELF64 user programs from the FAT volume.
+// - exec() 는 헤더와 프로그램 헤더만 읽고 새 주소공간을 만든다.
+//   PT_LOAD 세그먼트는 매핑하지 않고 범위만 기록해 둔다.
+// - 처음 건드린 페이지에서 #PF가 나면 그 페이지만 파일에서 읽어 채우고
+//   (p_filesz 너머의 BSS와 스택은 0으로) 매핑한다.
+// - 유저 창은 VMM_USER_BASE..VMM_USER_LIMIT. ET_EXEC는 그 안에 링크돼 있어야
+//   하고, 동적 재배치가 없는 ET_DYN은 VMM_USER_BASE에 올린다.
+
+#define USPACE_MAX_SEGS   8
+#define USER_STACK_TOP    VMM_USER_LIMIT
+#define USER_STACK_SIZE   (256u * 1024u)
+// 스택 가드 페이지 아래: 커널과 공유하는 submission/completion 링 (uring.c)
+#define USER_RING_SIZE    (64u * 1024u)
+#define USER_RING_VA      (USER_STACK_TOP - USER_STACK_SIZE - 0x1000 - USER_RING_SIZE)
+// 그 아래: 컴포지터와 공유하는 창 서피스 (uwin.c)
+#define USER_WIN_SIZE     (4u * 1024u * 1024u)
+#define USER_WIN_VA       (USER_RING_VA - 0x1000 - USER_WIN_SIZE)
+// 그 아래: 모든 프로세스가 같이 보는 읽기 전용 커널 데이터 페이지 (vdso.c)
+#define USER_VDSO_VA      (USER_WIN_VA - 0x2000)
+
+typedef struct useg
+{
+    uint64_t start, end;   // 페이지 정렬된 [start, end)
+    uint64_t vaddr;        // p_vaddr (+ ET_DYN 바이어스)
+    uint64_t file_off;     // p_offset
+    uint64_t file_sz;      // vaddr부터 파일에서 채우는 바이트 수, 나머지는 0
+    uint32_t prot;         // ELF PF_R/PF_W/PF_X
+} useg_t;
+
+typedef struct uspace
+{
+    uint64_t     cr3;
+    fat32_file_t file;
+    useg_t       segs[USPACE_MAX_SEGS + 1];   // + 스택
+    int          nsegs;
+    uint64_t     entry;
+    uint64_t     image_bytes;   // PT_LOAD 메모리 크기 합 (페이지 단위)
+    mutex_t      lock;          // fault-in 직렬화 (파일 커서 포함)
+    struct uring *ring;         // SYS_URING_SETUP 전에는 NULL
+    struct uwin  *win;          // SYS_WIN_CREATE 전에는 NULL
+    uint32_t     faults;
+    uint32_t     file_pages;
+    uint32_t     zero_pages;
+    char         path[64];
+} uspace_t;
+
+// exec()이 읽을 FAT 볼륨 (마운트 직후 kernel.c가 등록).
+void exec_set_volume(fat32_vol_t *vol, disk_read_fn rd, disk_write_fn wr);
+// 등록된 볼륨 (없으면 NULL). rd/wr는 NULL이어도 된다.
+fat32_vol_t *exec_volume(disk_read_fn *rd, disk_write_fn *wr);
+// 새 주소공간에서 path를 실행한다. tid 또는 음수.
+int  exec(const char *path);
+// 파일 없이 위치 독립 코드 code[0..len)을 VMM_USER_BASE에 올려 실행한다
+// (커널에 내장된 ring 3 벤치마크용). tid 또는 음수.
+int  exec_image(const char *name, const void *code, size_t len);
+
+// 현재 태스크의 유저 주소 addr 페이지를 채운다. 0: 매핑됨, -1: 잘못된 접근.
+int  uspace_fault(uintptr_t addr, uint32_t err);
+// us의 addr 페이지를 채운다. 현재 CR3와 상관없이 동작한다 (폴링 스레드 등).
+int  uspace_fault_in(uspace_t *us, uintptr_t addr, uint32_t err);
+// us의 유저 메모리를 HHDM으로 읽고 쓴다. 안 닿은 페이지는 채우고,
+// 쓰기는 쓰기 가능한 페이지만. 0 또는 -1.
+int  uspace_copy_in(uspace_t *us, void *dst, uint64_t src, size_t len);
+int  uspace_copy_out(uspace_t *us, uint64_t dst, const void *src, size_t len);
+// NUL 종단 문자열을 최대 cap-1 바이트. 길이 또는 -1.
+int  uspace_copy_str(uspace_t *us, char *dst, uint64_t src, size_t cap);
+// isr_common_handler의 #PF 경로. 0이면 처리 완료, -1이면 커널 패닉으로.
+// 유저 모드의 잘못된 접근은 태스크를 끝내고 돌아오지 않는다.
+int  uspace_page_fault(uint32_t err, struct int_frame *r);
+// 태스크 회수 시 (task_free): 페이지/테이블을 풀고 통계를 남긴다.
+void uspace_destroy(uspace_t *us);
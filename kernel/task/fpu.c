@@ -0,0 +1,241 @@
+#include "fpu.h"
+#include "task.h"
+#include "isr.h"
+#include "kheap.h"
+#include "serial.h"
+#include "percpu.h"
+#include <sys/cpu.h>
+#include <string.h>
+
+#define CR0_TS        (1ull << 3)
+#define CR4_OSXSAVE   (1ull << 18)
+
+#define XCR0_X87      (1ull << 0)
+#define XCR0_SSE      (1ull << 1)
+#define XCR0_AVX      (1ull << 2)
+
+#define FXSAVE_SIZE   512u
+#define NM_VECTOR     7
+
+static fpu_stats_t g_fpu;
+static uint8_t    *g_fpu_init_image = NULL;
+// 레지스터에 상태가 올라가 있는 태스크는 CPU마다 다르다: this_cpu()->fpu_owner
+
+static inline uint64_t read_cr0(void)
+{
+    uint64_t v;
+    __asm__ volatile("mov %%cr0, %0" : "=r"(v));
+    return v;
+}
+
+static inline void write_cr0(uint64_t v)
+{
+    __asm__ volatile("mov %0, %%cr0" ::"r"(v) : "memory");
+}
+
+static inline void fpu_set_ts(void)
+{
+    uint64_t cr0 = read_cr0();
+    if (!(cr0 & CR0_TS))
+        write_cr0(cr0 | CR0_TS);
+}
+
+static inline void fpu_clts(void)
+{
+    __asm__ volatile("clts");
+}
+
+static void fpu_save(uint8_t *area)
+{
+    if (g_fpu.use_xsave)
+        __asm__ volatile("xsave64 (%0)" ::"r"(area), "a"(0xFFFFFFFFu), "d"(0xFFFFFFFFu) : "memory");
+    else
+        __asm__ volatile("fxsave64 (%0)" ::"r"(area) : "memory");
+}
+
+static void fpu_restore(const uint8_t *area)
+{
+    if (g_fpu.use_xsave)
+        __asm__ volatile("xrstor64 (%0)" ::"r"(area), "a"(0xFFFFFFFFu), "d"(0xFFFFFFFFu) : "memory");
+    else
+        __asm__ volatile("fxrstor64 (%0)" ::"r"(area) : "memory");
+}
+
+// 64-byte aligned area; the raw pointer is kept right before it for kfree.
+static uint8_t *fpu_area_alloc(void)
+{
+    size_t sz = g_fpu.area_size + FPU_AREA_ALIGN + sizeof(void *);
+    uint8_t *raw = kmalloc_tag(sz, KMEM_TAG_TASK);
+    if (!raw)
+        return NULL;
+    uintptr_t p = ((uintptr_t)raw + sizeof(void *) + FPU_AREA_ALIGN - 1) & ~(uintptr_t)(FPU_AREA_ALIGN - 1);
+    ((void **)p)[-1] = raw;
+    memset((void *)p, 0, g_fpu.area_size);
+    return (uint8_t *)p;
+}
+
+static void fpu_area_free(uint8_t *area)
+{
+    if (area)
+        kfree(((void **)area)[-1]);
+}
+
+/* #NM: CR0.TS가 선 상태에서 x87/SSE 명령을 실행하면 들어온다. */
+static void fpu_nm_handler(void)
+{
+    cpu_t *c = this_cpu();
+    task_t *cur = c->current;
+
+    fpu_clts();
+    g_fpu.traps++;
+
+    if (!cur || c->fpu_owner == cur)
+        return;
+
+    // 저장 영역은 태스크를 만들 때 잡는다 (fpu_task_init). 예외 문맥에서는 할당하지 않는다.
+    if (!cur->fpu_state)
+    {
+        // 저장 공간이 없으면 소유권을 넘길 수 없다: 이전 소유자 상태를 그대로 공유
+        serial_printf("[FPU] task %u has no state area\n", cur->tid);
+        return;
+    }
+
+    if (c->fpu_owner && c->fpu_owner->fpu_state)
+    {
+        fpu_save(c->fpu_owner->fpu_state);
+        g_fpu.saves++;
+    }
+
+    if (cur->fpu_used)
+    {
+        fpu_restore(cur->fpu_state);
+        g_fpu.restores++;
+    }
+    else
+    {
+        // 첫 사용: 다른 태스크의 레지스터 값이 보이지 않도록 깨끗한 초기 상태로
+        fpu_restore(g_fpu_init_image);
+        cur->fpu_used = 1;
+        g_fpu.first_use++;
+    }
+    c->fpu_owner = cur;
+}
+
+void fpu_init(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+
+    memset(&g_fpu, 0, sizeof(g_fpu));
+    g_fpu.area_size = FXSAVE_SIZE;
+
+    if (cpuid(1, 0, &eax, &ebx, &ecx, &edx) && (ecx & (1u << 26)))
+    {
+        uint64_t cr4;
+        __asm__ volatile("mov %%cr4, %0" : "=r"(cr4));
+        __asm__ volatile("mov %0, %%cr4" ::"r"(cr4 | CR4_OSXSAVE));
+
+        uint64_t xcr0 = XCR0_X87 | XCR0_SSE;
+        if (ecx & (1u << 28))
+            xcr0 |= XCR0_AVX;
+        __asm__ volatile("xsetbv" ::"c"(0), "a"((uint32_t)xcr0), "d"((uint32_t)(xcr0 >> 32)));
+
+        // EBX of leaf 0xD/0 = size required by the components enabled in XCR0
+        if (cpuid(0xD, 0, &eax, &ebx, &ecx, &edx) && ebx >= FXSAVE_SIZE)
+        {
+            g_fpu.use_xsave = 1;
+            g_fpu.xcr0 = xcr0;
+            g_fpu.area_size = ebx;
+        }
+    }
+
+    g_fpu_init_image = fpu_area_alloc();
+    if (!g_fpu_init_image)
+    {
+        serial_printf("[FPU] init image alloc failed, lazy switching disabled\n");
+        return;
+    }
+
+    // 깨끗한 초기 상태 캡처 (FCW=0x37F, MXCSR=0x1F80)
+    uint32_t mxcsr = 0x1F80;
+    fpu_clts();
+    __asm__ volatile("fninit");
+    __asm__ volatile("ldmxcsr %0" ::"m"(mxcsr));
+    fpu_save(g_fpu_init_image);
+
+    isr_register_handler(NM_VECTOR, fpu_nm_handler);
+
+    // 지금부터 첫 x87/SSE 명령은 #NM을 거친다
+    this_cpu()->fpu_owner = NULL;
+    fpu_set_ts();
+
+    serial_printf("[FPU] %s, %u bytes/task, xcr0=0x%llx\n",
+                  g_fpu.use_xsave ? "XSAVE" : "FXSAVE", g_fpu.area_size,
+                  (unsigned long long)g_fpu.xcr0);
+}
+
+/* AP: init_fpu_sse()와 같은 CR0/CR4 설정 + BSP가 고른 XCR0를 그대로 적용 */
+void fpu_init_ap(void)
+{
+    uint64_t cr0 = read_cr0(), cr4;
+    cr0 &= ~(1ull << 2);   // EM = 0
+    cr0 |=  (1ull << 1);   // MP = 1
+    write_cr0(cr0);
+
+    __asm__ volatile("mov %%cr4, %0" : "=r"(cr4));
+    cr4 |= (1ull << 9) | (1ull << 10);   // OSFXSR, OSXMMEXCPT
+    if (g_fpu.use_xsave)
+        cr4 |= CR4_OSXSAVE;
+    __asm__ volatile("mov %0, %%cr4" ::"r"(cr4));
+    if (g_fpu.use_xsave)
+        __asm__ volatile("xsetbv" ::"c"(0), "a"((uint32_t)g_fpu.xcr0), "d"((uint32_t)(g_fpu.xcr0 >> 32)));
+
+    __asm__ volatile("fninit");
+    this_cpu()->fpu_owner = NULL;
+    if (g_fpu_init_image)
+        fpu_set_ts();
+}
+
+void fpu_switch_to(task_t *next)
+{
+    if (!g_fpu_init_image)
+        return;
+    // 다음 태스크가 이미 레지스터를 소유하고 있으면 트랩할 필요가 없다
+    if (next == this_cpu()->fpu_owner)
+        fpu_clts();
+    else
+        fpu_set_ts();
+}
+
+int fpu_task_init(task_t *t)
+{
+    // fpu_init 전이거나 lazy 전환이 꺼져 있으면 #NM이 오지 않는다
+    if (!t || !g_fpu_init_image || t->fpu_state)
+        return 0;
+    t->fpu_state = fpu_area_alloc();
+    return t->fpu_state ? 0 : -1;
+}
+
+void fpu_task_release(task_t *t)
+{
+    if (!t)
+        return;
+    for (uint32_t i = 0; i < g_cpu_count; ++i)
+        if (g_cpus[i].fpu_owner == t)
+            g_cpus[i].fpu_owner = NULL;
+    fpu_area_free(t->fpu_state);
+    t->fpu_state = NULL;
+    t->fpu_used = 0;
+}
+
+const fpu_stats_t *fpu_stats(void)
+{
+    return &g_fpu;
+}
+
+void fpu_dump(void)
+{
+    serial_printf("[FPU] mode=%s size=%u traps=%u saves=%u restores=%u first=%u owner=%s\n",
+                  g_fpu.use_xsave ? "XSAVE" : "FXSAVE", g_fpu.area_size,
+                  g_fpu.traps, g_fpu.saves, g_fpu.restores, g_fpu.first_use,
+                  this_cpu()->fpu_owner && this_cpu()->fpu_owner->name ? this_cpu()->fpu_owner->name : "-");
+}
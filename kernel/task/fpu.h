@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+struct task;
+
+// Lazy FPU/SSE(/AVX) state switching.
+// - 컨텍스트 스위치 때는 CR0.TS만 세우고 레지스터는 건드리지 않는다.
+// - 태스크가 처음 x87/SSE 명령을 쓰면 #NM(vector 7)이 발생하고, 그때
+//   이전 소유자의 상태를 저장한 뒤 현재 태스크의 상태를 복원한다.
+// - 저장 영역은 태스크를 만들 때 할당한다 (#NM 핸들러는 할당하지 않는다).
+// XSAVE가 있으면 XSAVE/XRSTOR, 없으면 FXSAVE/FXRSTOR(512 B)를 쓴다.
+
+#define FPU_AREA_ALIGN 64
+
+typedef struct
+{
+    int      use_xsave;
+    uint32_t area_size;  // bytes per task
+    uint64_t xcr0;       // enabled state components (XSAVE only)
+    uint32_t traps;      // #NM count
+    uint32_t saves;      // state saved for a previous owner
+    uint32_t restores;   // saved state loaded back
+    uint32_t first_use;  // tasks that got a fresh (init) state
+} fpu_stats_t;
+
+// Called once after init_fpu_sse(): picks XSAVE/FXSAVE, captures the clean
+// init image and installs the #NM handler.
+void fpu_init(void);
+// Per-AP CR0/CR4/XCR0 setup matching the BSP.
+void fpu_init_ap(void);
+// Scheduler hook: called right before switching to 'next'.
+void fpu_switch_to(struct task *next);
+// Allocate the task's save area at creation time. -1 if out of memory.
+int  fpu_task_init(struct task *t);
+// Drop a task's FPU state (task exit).
+void fpu_task_release(struct task *t);
+const fpu_stats_t *fpu_stats(void);
+void fpu_dump(void);
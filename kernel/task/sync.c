@@ -0,0 +1,339 @@
+#include "sync.h"
+#include "task.h"
+#include "ktimer.h"
+#include "clock.h"
+#include "serial.h"
+
+/* ---- 대기열 (호출자가 wq->lock 보유) ---- */
+
+static void wq_enqueue(wait_queue_t *wq, wait_entry_t *e)
+{
+    e->next = NULL;
+    if (wq->tail)
+        wq->tail->next = e;
+    else
+        wq->head = e;
+    wq->tail = e;
+}
+
+static wait_entry_t *wq_dequeue(wait_queue_t *wq)
+{
+    wait_entry_t *e = wq->head;
+    if (e)
+    {
+        wq->head = e->next;
+        if (!wq->head)
+            wq->tail = NULL;
+        e->next = NULL;
+    }
+    return e;
+}
+
+static void wq_remove(wait_queue_t *wq, wait_entry_t *e)
+{
+    wait_entry_t *prev = NULL;
+    for (wait_entry_t *it = wq->head; it; prev = it, it = it->next)
+    {
+        if (it != e)
+            continue;
+        if (prev)
+            prev->next = e->next;
+        else
+            wq->head = e->next;
+        if (wq->tail == e)
+            wq->tail = prev;
+        e->next = NULL;
+        return;
+    }
+}
+
+/* woken을 세운 뒤에는 e가 (대기자의 스택에서) 사라질 수 있으므로 먼저 task를 읽어 둔다 */
+static void wake_entry(wait_entry_t *e)
+{
+    struct task *t = e->task;
+    e->woken = 1;
+    task_wake(t);
+}
+
+static void wait_timeout_fn(void *arg)
+{
+    task_wake((struct task *)arg);
+}
+
+/* wq->lock을 잡은 채(인터럽트 꺼짐) 호출하고, 다시 잡은 채로 돌아온다.
+   1: 깨우는 쪽이 대기열에서 꺼내 줌, 0: 시간 초과.
+   fl은 lock을 잡기 전의 인터럽트 상태 (스케줄러 시작 전 대기에만 쓴다). */
+static int sleep_locked(wait_queue_t *wq, uint64_t timeout_ms, uint64_t fl)
+{
+    wait_entry_t e = { current_task(), NULL, 0 };
+    int timed = timeout_ms != WAIT_FOREVER;
+    int can_block = task_can_block();
+    uint64_t deadline = timed ? ktime_ms() + timeout_ms : 0;
+    ktimer_t timer;
+
+    wq_enqueue(wq, &e);
+    if (timed && can_block)
+    {
+        ktimer_init(&timer, wait_timeout_fn, e.task);
+        ktimer_add(&timer, deadline);
+    }
+
+    while (!e.woken)
+    {
+        if (!can_block)
+        {
+            if (timed && ktime_ms() >= deadline)
+                break;
+            spin_unlock(&wq->lock);
+            irq_restore(fl);
+            __asm__ volatile("pause");
+            irq_save();
+            spin_lock(&wq->lock);
+            continue;
+        }
+
+        // BLOCKED를 먼저 세운 뒤 타이머를 확인해야 만료와 엇갈려도 깨움을 놓치지 않는다
+        task_set_state(TASK_BLOCKED);
+        if (timed && !timer.pending)
+        {
+            task_set_state(TASK_RUNNING);
+            break;
+        }
+        spin_unlock(&wq->lock);
+        task_block();
+        spin_lock(&wq->lock);
+    }
+
+    if (!e.woken)
+        wq_remove(wq, &e);
+    if (timed && can_block)
+        ktimer_cancel(&timer);
+    return e.woken;
+}
+
+/* ---- wait queue ---- */
+
+void wq_init(wait_queue_t *wq)
+{
+    spin_init(&wq->lock);
+    wq->head = NULL;
+    wq->tail = NULL;
+}
+
+int wq_wait_cond(wait_queue_t *wq, int (*cond)(void *arg), void *arg, uint64_t timeout_ms)
+{
+    uint64_t deadline = (timeout_ms == WAIT_FOREVER) ? WAIT_FOREVER : ktime_ms() + timeout_ms;
+    uint64_t fl = spin_lock_irqsave(&wq->lock);
+    int ok;
+    for (;;)
+    {
+        if (cond(arg))
+        {
+            ok = 1;
+            break;
+        }
+        uint64_t left = WAIT_FOREVER;
+        if (deadline != WAIT_FOREVER)
+        {
+            uint64_t now = ktime_ms();
+            if (now >= deadline)
+            {
+                ok = 0;
+                break;
+            }
+            left = deadline - now;
+        }
+        sleep_locked(wq, left, fl);
+    }
+    spin_unlock_irqrestore(&wq->lock, fl);
+    return ok;
+}
+
+int wq_wake_one(wait_queue_t *wq)
+{
+    uint64_t fl = spin_lock_irqsave(&wq->lock);
+    wait_entry_t *e = wq_dequeue(wq);
+    if (e)
+        wake_entry(e);
+    spin_unlock_irqrestore(&wq->lock, fl);
+    return e ? 1 : 0;
+}
+
+int wq_wake_all(wait_queue_t *wq)
+{
+    int n = 0;
+    uint64_t fl = spin_lock_irqsave(&wq->lock);
+    wait_entry_t *e;
+    while ((e = wq_dequeue(wq)) != NULL)
+    {
+        wake_entry(e);
+        n++;
+    }
+    spin_unlock_irqrestore(&wq->lock, fl);
+    return n;
+}
+
+/* ---- mutex ---- */
+
+void mutex_init(mutex_t *m)
+{
+    wq_init(&m->wq);
+    m->owner = NULL;
+    m->contended = 0;
+}
+
+void mutex_lock(mutex_t *m)
+{
+    struct task *self = current_task();
+    uint64_t fl = spin_lock_irqsave(&m->wq.lock);
+    if (!m->owner)
+    {
+        m->owner = self;
+    }
+    else
+    {
+        m->contended++;
+        // mutex_unlock이 owner를 우리로 바꾼 뒤 깨운다
+        while (m->owner != self)
+            sleep_locked(&m->wq, WAIT_FOREVER, fl);
+    }
+    spin_unlock_irqrestore(&m->wq.lock, fl);
+}
+
+int mutex_trylock(mutex_t *m)
+{
+    uint64_t fl = spin_lock_irqsave(&m->wq.lock);
+    int ok = m->owner == NULL;
+    if (ok)
+        m->owner = current_task();
+    spin_unlock_irqrestore(&m->wq.lock, fl);
+    return ok;
+}
+
+void mutex_unlock(mutex_t *m)
+{
+    uint64_t fl = spin_lock_irqsave(&m->wq.lock);
+    if (m->owner != current_task())
+        serial_printf("[mutex] unlock by non-owner %p (owner %p)\n",
+                      (void *)current_task(), (void *)m->owner);
+    wait_entry_t *e = wq_dequeue(&m->wq);
+    if (e)
+    {
+        m->owner = e->task;   // hand-off
+        wake_entry(e);
+    }
+    else
+    {
+        m->owner = NULL;
+    }
+    spin_unlock_irqrestore(&m->wq.lock, fl);
+}
+
+int mutex_held(const mutex_t *m)
+{
+    return m->owner == current_task();
+}
+
+/* ---- semaphore ---- */
+
+void sem_init(semaphore_t *s, int32_t count)
+{
+    wq_init(&s->wq);
+    s->count = count;
+}
+
+int sem_down_timeout(semaphore_t *s, uint64_t timeout_ms)
+{
+    uint64_t fl = spin_lock_irqsave(&s->wq.lock);
+    int ok = 1;
+    if (s->count > 0)
+        s->count--;
+    else
+        ok = sleep_locked(&s->wq, timeout_ms, fl);   // sem_up이 한 단위를 넘겨 준다
+    spin_unlock_irqrestore(&s->wq.lock, fl);
+    return ok ? 0 : -1;
+}
+
+void sem_down(semaphore_t *s)
+{
+    sem_down_timeout(s, WAIT_FOREVER);
+}
+
+int sem_trydown(semaphore_t *s)
+{
+    uint64_t fl = spin_lock_irqsave(&s->wq.lock);
+    int ok = s->count > 0;
+    if (ok)
+        s->count--;
+    spin_unlock_irqrestore(&s->wq.lock, fl);
+    return ok;
+}
+
+void sem_up(semaphore_t *s)
+{
+    uint64_t fl = spin_lock_irqsave(&s->wq.lock);
+    wait_entry_t *e = wq_dequeue(&s->wq);
+    if (e)
+        wake_entry(e);
+    else
+        s->count++;
+    spin_unlock_irqrestore(&s->wq.lock, fl);
+}
+
+/* ---- completion ---- */
+
+#define COMPLETION_ALL 0x80000000u
+
+void completion_init(completion_t *c)
+{
+    wq_init(&c->wq);
+    c->done = 0;
+}
+
+void reinit_completion(completion_t *c)
+{
+    c->done = 0;
+}
+
+void complete(completion_t *c)
+{
+    uint64_t fl = spin_lock_irqsave(&c->wq.lock);
+    wait_entry_t *e = wq_dequeue(&c->wq);
+    if (e)
+        wake_entry(e);   // 대기자에게 바로 넘긴다
+    else if (c->done != COMPLETION_ALL)
+        c->done++;
+    spin_unlock_irqrestore(&c->wq.lock, fl);
+}
+
+void complete_all(completion_t *c)
+{
+    uint64_t fl = spin_lock_irqsave(&c->wq.lock);
+    c->done = COMPLETION_ALL;
+    wait_entry_t *e;
+    while ((e = wq_dequeue(&c->wq)) != NULL)
+        wake_entry(e);
+    spin_unlock_irqrestore(&c->wq.lock, fl);
+}
+
+int wait_for_completion_timeout(completion_t *c, uint64_t timeout_ms)
+{
+    uint64_t fl = spin_lock_irqsave(&c->wq.lock);
+    int ok = 1;
+    if (c->done)
+    {
+        if (c->done != COMPLETION_ALL)
+            c->done--;
+    }
+    else
+    {
+        ok = sleep_locked(&c->wq, timeout_ms, fl);
+    }
+    spin_unlock_irqrestore(&c->wq.lock, fl);
+    return ok ? 0 : -1;
+}
+
+void wait_for_completion(completion_t *c)
+{
+    wait_for_completion_timeout(c, WAIT_FOREVER);
+}
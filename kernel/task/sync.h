@@ -0,0 +1,82 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "spinlock.h"
+
+struct task;
+
+// Sleeping synchronisation primitives.
+// - 대기 중인 태스크는 BLOCKED로 런큐에서 빠지고, 깨울 때 다시 들어간다.
+// - 깨우기(wq_wake_*, mutex_unlock, sem_up, complete*)는 IRQ 핸들러에서도
+//   부를 수 있다. 잠드는 쪽(*_lock, *_down, *_wait*)은 태스크 문맥에서만.
+// - mutex와 semaphore는 hand-off 방식: 풀어 주는 쪽이 첫 대기자에게 직접
+//   소유권을 넘기므로 깨어난 태스크가 다시 경쟁하지 않는다 (FIFO).
+// - 스케줄러 시작 전에는 잠들지 않고 조건이 풀릴 때까지 돈다.
+
+#define WAIT_FOREVER (~0ull)
+
+typedef struct wait_entry
+{
+    struct task       *task;
+    struct wait_entry *next;
+    volatile int       woken;   // 깨우는 쪽이 대기열에서 뺀 뒤 1로 만든다
+} wait_entry_t;
+
+typedef struct wait_queue
+{
+    spinlock_t    lock;
+    wait_entry_t *head;
+    wait_entry_t *tail;
+} wait_queue_t;
+
+#define WAIT_QUEUE_INIT { SPINLOCK_INIT, NULL, NULL }
+
+void wq_init(wait_queue_t *wq);
+// Sleep until cond(arg) is true, re-checking after every wake-up. The waker
+// must make the condition true before calling wq_wake_*(). Returns 1 when
+// the condition holds, 0 on timeout (timeout_ms may be WAIT_FOREVER).
+int  wq_wait_cond(wait_queue_t *wq, int (*cond)(void *arg), void *arg, uint64_t timeout_ms);
+// Number of tasks woken.
+int  wq_wake_one(wait_queue_t *wq);
+int  wq_wake_all(wait_queue_t *wq);
+
+typedef struct mutex
+{
+    wait_queue_t       wq;      // wq.lock also protects owner
+    struct task *volatile owner;
+    uint32_t           contended;
+} mutex_t;
+
+#define MUTEX_INIT { WAIT_QUEUE_INIT, NULL, 0 }
+
+void mutex_init(mutex_t *m);
+void mutex_lock(mutex_t *m);
+int  mutex_trylock(mutex_t *m);   // 1 on success
+void mutex_unlock(mutex_t *m);
+int  mutex_held(const mutex_t *m);   // by the current task
+
+typedef struct semaphore
+{
+    wait_queue_t wq;
+    int32_t      count;
+} semaphore_t;
+
+void sem_init(semaphore_t *s, int32_t count);
+void sem_down(semaphore_t *s);
+int  sem_trydown(semaphore_t *s);                       // 1 on success
+int  sem_down_timeout(semaphore_t *s, uint64_t timeout_ms); // 0 ok, -1 timeout
+void sem_up(semaphore_t *s);
+
+typedef struct completion
+{
+    wait_queue_t wq;
+    uint32_t     done;
+} completion_t;
+
+void completion_init(completion_t *c);
+void complete(completion_t *c);       // release one waiter (or the next one to come)
+void complete_all(completion_t *c);   // release every current and future waiter
+void wait_for_completion(completion_t *c);
+int  wait_for_completion_timeout(completion_t *c, uint64_t timeout_ms);   // 0 ok, -1 timeout
+// Make a completed completion_t usable again.
+void reinit_completion(completion_t *c);
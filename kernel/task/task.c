@@ -3,307 +3,1277 @@
 #include "gdt.h"
 #include "mm/vmm.h"
 #include "serial.h"
+#include "fpu.h"
+#include "percpu.h"
+#include "mp.h"
+#include "tick.h"
+#include "pit.h"
+#include "ktimer.h"
+#include "clock.h"
+#include "sync.h"
+#include "kheap.h"
+#include "exec.h"
 #include <string.h>
 #include <stdint.h>
 
 /* externs from kernel */
-extern uint32_t *pgdir;
-extern void      ctx_switch(uint32_t *prev_esp, uint32_t *next_esp);
-extern void      pic_send_eoi(int irq);
+extern void      ctx_switch(uint64_t *prev_rsp, uint64_t *next_rsp);
+extern void      kthread_start(void);
 
 /* 설정 */
 #define KSTACK_SIZE        (16 * 1024)
-#define TIME_SLICE_TICKS   5
 
-/* 전역 */
-static task_t   *g_current     = NULL;
-static task_t   *g_readyq      = NULL;   /* 원형 큐 헤드 */
+_Static_assert(SCHED_PRIOS == NICE_MAX - NICE_MIN + 1, "nice range must match run queues");
+_Static_assert(SCHED_PRIOS <= 64, "rq_bitmap holds one bit per priority");
+
+/* 전역
+ * - 런큐는 CPU마다 하나: 우선순위별 FIFO + 비어 있지 않은 큐의 비트맵.
+ *   실행 중인 태스크와 idle 태스크는 큐 밖에 둔다.
+ * - g_all_tasks는 태스크 매니저 열거용 전체 목록. */
 static uint32_t  g_next_tid    = 1;
 static int       sched_enabled = 0;
-static task_t   *g_idle_task   = NULL;
-static uint64_t  g_cpu_total_ticks = 0;
-static uint64_t  g_cpu_idle_ticks  = 0;
+static task_t   *g_all_tasks   = NULL;
+static spinlock_t g_all_lock   = SPINLOCK_INIT;
+static task_t   *g_input_task  = NULL;
+/* EDF 예산 집행: 이 CPU의 EDF 태스크가 예산을 다 쓰는 시각에 need_resched */
+static ktimer_t  g_dl_enforce[MAX_CPUS];
 
 /* 외부에서 현재 태스크 조회 */
-task_t* current_task(void) { return g_current; }
+task_t* current_task(void) { return this_cpu()->current; }
+
+/* 우선순위별 타임 슬라이스 (jiffies): nice -20 → 10, nice 0 → 5, nice 19 → 1 */
+static inline int sched_slice(int prio) {
+    int s = (SCHED_PRIOS - prio) / 4;
+    return s > 0 ? s : 1;
+}
+
+static inline int task_eff_prio(const task_t *t) {
+    int p = t->prio - t->boost;
+    return p < 0 ? 0 : p;
+}
+
+static inline uint64_t ns_to_ms_ceil(uint64_t ns) {
+    return (ns + 999999u) / 1000000u;
+}
 
-/* 원형 큐 유틸 */
-static void rq_push(task_t *t) {
-    if (!g_readyq) {
-        g_readyq = t->next = t;
+/* EDF 태스크는 prio 큐 대신 마감 순 리스트에 (개수가 적어 삽입 정렬로 충분) */
+static void dl_enqueue(cpu_t *c, task_t *t) {
+    task_t *prev = NULL, *n = c->dl_head;
+    while (n && n->dl_abs_deadline <= t->dl_abs_deadline) {
+        prev = n;
+        n = n->next;
+    }
+    t->rq_prev = prev;
+    t->next = n;
+    if (prev) prev->next = t;
+    else      c->dl_head = t;
+    if (n)    n->rq_prev = t;
+    t->rq_prio = -1;
+}
+
+/* READY 큐 유틸 (호출자가 c->rq_lock 보유).
+   head: 슬라이스가 남은 채 선점된 태스크는 같은 우선순위의 맨 앞으로 */
+static void rq_enqueue(cpu_t *c, task_t *t, int head) {
+    t->queued     = 1;
+    t->wait_start = ktime_ns();
+    if (t->dl) {
+        dl_enqueue(c, t);
+        return;
+    }
+    int p = task_eff_prio(t);
+    t->rq_prio = p;
+    if (!c->rq_head[p]) {
+        t->next = t->rq_prev = NULL;
+        c->rq_head[p] = c->rq_tail[p] = t;
+        c->rq_bitmap |= 1ull << p;
+    } else if (head) {
+        t->rq_prev = NULL;
+        t->next = c->rq_head[p];
+        c->rq_head[p]->rq_prev = t;
+        c->rq_head[p] = t;
     } else {
-        t->next = g_readyq->next;
-        g_readyq->next = t;
+        t->next = NULL;
+        t->rq_prev = c->rq_tail[p];
+        c->rq_tail[p]->next = t;
+        c->rq_tail[p] = t;
+    }
+}
+
+static void rq_dequeue(cpu_t *c, task_t *t) {
+    int p = t->rq_prio;
+    if (p < 0) {
+        if (t->rq_prev) t->rq_prev->next = t->next;
+        else            c->dl_head = t->next;
+        if (t->next)    t->next->rq_prev = t->rq_prev;
+    } else {
+        if (t->rq_prev) t->rq_prev->next = t->next;
+        else            c->rq_head[p] = t->next;
+        if (t->next)    t->next->rq_prev = t->rq_prev;
+        else            c->rq_tail[p] = t->rq_prev;
+        if (!c->rq_head[p])
+            c->rq_bitmap &= ~(1ull << p);
+    }
+    t->next = t->rq_prev = NULL;
+    t->queued = 0;
+    t->wait_ns += ktime_ns() - t->wait_start;
+}
+
+/* EDF 태스크가 있으면 마감이 가장 이른 것, 없으면 가장 높은 우선순위 큐의 맨 앞
+   (비트맵 최하위 비트 하나로 O(1)) */
+static task_t *rq_pick(cpu_t *c) {
+    task_t *t = c->dl_head;
+    if (!t) {
+        if (!c->rq_bitmap)
+            return NULL;
+        t = c->rq_head[__builtin_ctzll(c->rq_bitmap)];
+    }
+    rq_dequeue(c, t);
+    return t;
+}
+
+/* 런큐 소속 (nr_tasks는 실행 중인 태스크까지 센다) */
+static void rq_attach(cpu_t *c, task_t *t) {
+    t->cpu = c->id;
+    t->on_rq = 1;
+    c->nr_tasks++;
+}
+
+static void rq_detach(cpu_t *c, task_t *t) {
+    if (t->queued)
+        rq_dequeue(c, t);
+    t->on_rq = 0;
+    c->nr_tasks--;
+}
+
+/* 큐에 든 t가 c의 현재 태스크보다 급하면 선점을 요청한다.
+   로컬이면 need_resched만 세우고(IRQ 출구/다음 틱에서 처리), 원격이면 1을 돌려 IPI를 맡긴다. */
+static int task_preempts(const task_t *t, const task_t *cur) {
+    if (t->dl)
+        return !cur->dl || t->dl_abs_deadline < cur->dl_abs_deadline;
+    return !cur->dl && task_eff_prio(t) < task_eff_prio(cur);
+}
+
+static int rq_check_preempt(cpu_t *c, task_t *t) {
+    task_t *cur = c->current;
+    if (cur && cur != c->idle && !task_preempts(t, cur))
+        return 0;
+    if (c == this_cpu()) {
+        c->need_resched = 1;
+        return 0;
     }
+    return 1;
+}
+
+/* t가 속한 CPU의 런큐 락을 잡는다. READY 태스크는 락을 잡기 전에 훔쳐질 수 있으므로 다시 확인 */
+static cpu_t *task_rq_lock(task_t *t, uint64_t *fl) {
+    for (;;) {
+        cpu_t *c = &g_cpus[t->cpu];
+        *fl = spin_lock_irqsave(&c->rq_lock);
+        if (t->cpu == c->id)
+            return c;
+        spin_unlock_irqrestore(&c->rq_lock, *fl);
+    }
+}
+
+/* 새 주기 시작: 예산을 채우고 마감을 다시 잡는다 */
+static void dl_replenish(task_t *t, uint64_t release) {
+    t->dl_release      = release;
+    t->dl_abs_deadline = release + t->dl_deadline;
+    t->dl_budget       = (int64_t)t->dl_runtime;
+    t->dl_throttled    = 0;
+}
+
+/* 예산을 다 쓴 EDF 태스크: 다음 주기 시작까지 큐에 넣지 않는다 (호출자가 rq_lock 보유) */
+static void dl_throttle(cpu_t *c, task_t *t, uint64_t now) {
+    uint64_t next = t->dl_release + t->dl_period;
+    t->dl_overruns++;
+    if (next <= now) {
+        dl_replenish(t, now);
+        rq_enqueue(c, t, 0);
+        return;
+    }
+    t->dl_throttled = 1;
+    t->dl_release   = next;
+    ktimer_add(&t->dl_timer, ns_to_ms_ceil(next));
+}
+
+/* dl_timer: 다음 주기가 시작됐으니 큐로 되돌린다 */
+static void dl_unthrottle_fn(void *arg) {
+    task_t *t = (task_t *)arg;
+    uint64_t fl;
+    cpu_t *c = task_rq_lock(t, &fl);
+    int ipi = 0;
+    if (t->dl && t->dl_throttled) {
+        uint64_t now = ktime_ns();
+        dl_replenish(t, t->dl_release > now ? t->dl_release : now);
+        if (t->on_rq && !t->queued && t != c->current) {
+            rq_enqueue(c, t, 0);
+            ipi = rq_check_preempt(c, t);
+        }
+    }
+    spin_unlock_irqrestore(&c->rq_lock, fl);
+    if (ipi)
+        mp_send_resched(c->id);
+}
+
+static void dl_enforce_fn(void *arg) {
+    cpu_t *c = (cpu_t *)arg;
+    if (c == this_cpu())
+        c->need_resched = 1;
+    else
+        mp_send_resched(c->id);   /* PIT 모드: BSP가 모든 휠을 돌린다 */
+}
+
+/* 고른 태스크가 EDF면 남은 예산만큼 뒤에 선점 타이머를 건다 */
+static void dl_arm_enforce(cpu_t *c, task_t *t, uint64_t now) {
+    ktimer_t *kt = &g_dl_enforce[c->id];
+    if (t->dl) {
+        uint64_t left = t->dl_budget > 0 ? (uint64_t)t->dl_budget : 0;
+        ktimer_add(kt, ns_to_ms_ceil(now + left));
+    } else if (kt->pending) {
+        ktimer_cancel(kt);
+    }
+}
+
+static void all_tasks_add(task_t *t) {
+    uint64_t fl = spin_lock_irqsave(&g_all_lock);
+    t->all_next = g_all_tasks;
+    g_all_tasks = t;
+    spin_unlock_irqrestore(&g_all_lock, fl);
+}
+
+/* 새 태스크를 둘 CPU: 온라인 CPU 중 런큐가 가장 짧은 곳 */
+static cpu_t *sched_pick_cpu(void) {
+    cpu_t *best = this_cpu();
+    for (uint32_t i = 0; i < g_cpu_count; ++i) {
+        cpu_t *c = &g_cpus[i];
+        if (c->online && c->nr_tasks < best->nr_tasks)
+            best = c;
+    }
+    return best;
 }
 
 /* 최초 idle 스레드 */
 static void idle_thread(void *arg) {
     (void)arg;
-    for (;;) {
-        __asm__ __volatile__("sti; hlt");
-    }
+    sched_idle_loop();
 }
 
-/* kthread 트램펄린 (ret 도착점) */
-static void kthread_trampoline(void) {
-    void (*entry)(void*);
-    void *arg;
+static void schedule_ex(int yielding);
+static void schedule(void) { schedule_ex(0); }
+static void task_exit_notify(task_t *t);
 
-    /* prepare_kthread_stack에서 쌓아둔 entry, arg */
-    __asm__ __volatile__(
-        "pop %0\n"
-        "pop %1\n"
-        : "=r"(entry), "=r"(arg)
-    );
-
-    __asm__ __volatile__("sti");
-    entry(arg);
+/* 마지막 정산 이후 흐른 jiffies를 busy/idle로 나눠 기록하고 그 양을 돌려준다.
+   tickless idle에서는 타이머가 매 jiffy 오지 않으므로 틱 수 대신 경과 시간으로 센다. */
+static uint64_t sched_account(cpu_t *c) {
+    uint64_t now = jiffies;
+    uint64_t d = now - c->acct_jiffies;
+    if (!d)
+        return 0;
+    c->acct_jiffies = now;
+    c->ticks_total += d;
+    if (c->current == c->idle || c->in_hlt)
+        c->ticks_idle += d;
+    return d;
+}
 
-    g_current->state = TASK_ZOMBIE;
-    /* 단순 종료 처리: 다음 태스크로 */
+/* 엔트리 함수가 돌아오면 kthread_start가 호출 */
+void kthread_exit(void) {
+    task_t *self = current_task();
+    if (self->dl)
+        task_clear_deadline(self);
+    __asm__ __volatile__("cli");
+    fpu_task_release(self);
+    self->state = TASK_ZOMBIE;
+    /* schedule()이 런큐에서 빼고, 이 CPU를 완전히 떠난 뒤 sched_finish_switch가
+       reaper(또는 joiner)에게 넘긴다. 다시 선택되지 않는다. */
     for (;;){
-        __asm__ __volatile__("cli");
-        /* 현재 태스크를 READY에서 제외하려면 별도 정리 로직 필요 */
+        schedule();
         __asm__ __volatile__("sti");
         __asm__ __volatile__("hlt");
     }
 }
 
-/* kthread 스택: [ret=kthread_trampoline][edi][esi][ebx][ebp][entry][arg] */
+/* kthread 스택 (위→아래):
+   [ret=kthread_start][rbp][rbx][r12=entry][r13=arg][r14][r15]  ← ctx.rsp
+   ctx_switch가 r15..rbp를 pop한 뒤 ret 하면 kthread_start로 들어간다. */
 static void prepare_kthread_stack(task_t *t, void (*entry)(void*), void *arg) {
-    uint32_t *sp = (uint32_t *)(t->kstack_base + t->kstack_size);
-    sp = (uint32_t *)((uintptr_t)sp & ~0xF);
+    uint64_t *sp = (uint64_t *)(t->kstack_base + t->kstack_size);
+    sp = (uint64_t *)((uintptr_t)sp & ~(uintptr_t)0xF);
+
+    *(--sp) = (uint64_t)(uintptr_t)kthread_start; /* ret → 이후 RSP는 16바이트 경계 */
 
-    *(--sp) = (uint32_t)kthread_trampoline; /* ret */
+    *(--sp) = 0;                        /* rbp */
+    *(--sp) = 0;                        /* rbx */
+    *(--sp) = (uint64_t)(uintptr_t)entry; /* r12 */
+    *(--sp) = (uint64_t)(uintptr_t)arg;   /* r13 */
+    *(--sp) = 0;                        /* r14 */
+    *(--sp) = 0;                        /* r15 */
 
-    *(--sp) = 0; /* edi */
-    *(--sp) = 0; /* esi */
-    *(--sp) = 0; /* ebx */
-    *(--sp) = 0; /* ebp */
+    t->ctx.rsp = (uint64_t)(uintptr_t)sp;
+}
+
+/* --------- task_t / 커널 스택 캐시 ---------
+   회수한 task_t와 스택을 free list에 모아 두었다가 다시 쓴다. 정상 상태에서
+   스레드 생성은 리스트 pop 하나로 끝나고 힙을 건드리지 않는다.
+   힙이 모자라면 shrinker가 캐시를 돌려준다. */
+#define TASK_CACHE_MAX 32
+
+typedef struct cache_node { struct cache_node *next; } cache_node_t;
+
+typedef struct {
+    cache_node_t *head;
+    uint32_t      count;
+    size_t        size;      /* 원소 크기 */
+    uint32_t      hits, misses;
+} obj_cache_t;
 
-    *(--sp) = (uint32_t)entry;
-    *(--sp) = (uint32_t)arg;
+static obj_cache_t g_stack_cache = { NULL, 0, KSTACK_SIZE, 0, 0 };
+static obj_cache_t g_task_cache  = { NULL, 0, sizeof(task_t), 0, 0 };
+static spinlock_t  g_cache_lock  = SPINLOCK_INIT;
 
-    t->ctx.esp = (uint32_t)sp;
+static void *cache_alloc(obj_cache_t *oc) {
+    uint64_t fl = spin_lock_irqsave(&g_cache_lock);
+    cache_node_t *n = oc->head;
+    if (n) {
+        oc->head = n->next;
+        oc->count--;
+        oc->hits++;
+    } else {
+        oc->misses++;
+    }
+    spin_unlock_irqrestore(&g_cache_lock, fl);
+    /* kmalloc는 shrinker를 부를 수 있으므로 락 밖에서 */
+    return n ? (void *)n : kmalloc_tag(oc->size, KMEM_TAG_TASK);
 }
 
-/* kmalloc는 커널 힙으로 가정 */
-extern void *kmalloc(size_t sz);
+static void cache_free(obj_cache_t *oc, void *p) {
+    if (!p)
+        return;
+    uint64_t fl = spin_lock_irqsave(&g_cache_lock);
+    int keep = oc->count < TASK_CACHE_MAX;
+    if (keep) {
+        cache_node_t *n = (cache_node_t *)p;
+        n->next = oc->head;
+        oc->head = n;
+        oc->count++;
+    }
+    spin_unlock_irqrestore(&g_cache_lock, fl);
+    if (!keep)
+        kfree(p);
+}
+
+static size_t task_cache_count(void *user) {
+    (void)user;
+    return g_stack_cache.count * g_stack_cache.size + g_task_cache.count * g_task_cache.size;
+}
+
+static size_t task_cache_scan(size_t want, void *user) {
+    (void)user;
+    size_t got = 0;
+    obj_cache_t *caches[2] = { &g_stack_cache, &g_task_cache };
+    for (int i = 0; i < 2; ++i) {
+        while (got < want) {
+            uint64_t fl = spin_lock_irqsave(&g_cache_lock);
+            cache_node_t *n = caches[i]->head;
+            if (n) {
+                caches[i]->head = n->next;
+                caches[i]->count--;
+            }
+            spin_unlock_irqrestore(&g_cache_lock, fl);
+            if (!n)
+                break;
+            kfree(n);
+            got += caches[i]->size;
+        }
+    }
+    return got;
+}
 
 static task_t* task_alloc(const char *name) {
-    task_t *t = (task_t*)kmalloc(sizeof(task_t));
+    task_t *t = (task_t*)cache_alloc(&g_task_cache);
+    if (!t)
+        return NULL;
     memset(t, 0, sizeof(*t));
-    t->tid        = g_next_tid++;
+    t->tid        = __atomic_fetch_add(&g_next_tid, 1, __ATOMIC_RELAXED);
     t->state      = TASK_READY;
-    t->time_slice = TIME_SLICE_TICKS;
+    t->prio       = -NICE_MIN;
+    t->time_slice = sched_slice(t->prio);
     t->name       = name;
+    t->detached   = 1;
     return t;
 }
 
-task_t* kthread_create(void (*entry)(void *), void *arg, const char *name) {
+/* 바쁜 CPU에 READY 태스크가 생겼을 때 잠든 idle CPU 하나를 깨워 훔쳐가게 한다.
+   tickless idle CPU는 스스로 깨어나 런큐를 살피지 않는다. */
+static void sched_kick_idle(cpu_t *busy) {
+    for (uint32_t i = 0; i < g_cpu_count; ++i) {
+        cpu_t *o = &g_cpus[i];
+        if (o != busy && o->online && o->current == o->idle) {
+            if (o == this_cpu())
+                o->need_resched = 1;
+            else
+                mp_send_resched(o->id);
+            return;
+        }
+    }
+}
+
+/* 런큐 락을 푼 뒤: 선점 IPI를 보내고, 대상 CPU가 바쁘면 놀고 있는 CPU를 깨운다 */
+static void sched_notify(cpu_t *c, task_t *t, int ipi, int busy) {
+    if (ipi)
+        mp_send_resched(c->id);
+    if (busy && !t->pinned)
+        sched_kick_idle(c);
+}
+
+/* 새 태스크를 런큐에 넣는다 */
+static void sched_enqueue(task_t *t) {
+    cpu_t *c = t->pinned ? &g_cpus[t->cpu] : sched_pick_cpu();
+    uint64_t fl = spin_lock_irqsave(&c->rq_lock);
+    rq_attach(c, t);
+    rq_enqueue(c, t, 0);
+    int ipi  = rq_check_preempt(c, t);
+    int busy = c->current != c->idle;
+    spin_unlock_irqrestore(&c->rq_lock, fl);
+    sched_notify(c, t, ipi, busy);
+}
+
+static task_t* kthread_alloc(void (*entry)(void *), void *arg, const char *name) {
     task_t *t = task_alloc(name ? name : "kthread");
+    if (!t)
+        return NULL;
     t->kstack_size = KSTACK_SIZE;
-    t->kstack_base = (uint8_t*)kmalloc(KSTACK_SIZE);
-    t->pgdir       = pgdir;   /* 커널 주소공간 공유 */
+    t->kstack_base = (uint8_t*)cache_alloc(&g_stack_cache);
+    if (!t->kstack_base || fpu_task_init(t) != 0) {
+        cache_free(&g_stack_cache, t->kstack_base);
+        cache_free(&g_task_cache, t);
+        return NULL;
+    }
     t->is_user     = 0;
 
     /* (필요 시) 스택 페이지 매핑 보증: kmalloc가 이미 매핑해주면 생략 가능 */
 
     prepare_kthread_stack(t, entry, arg);
-    rq_push(t);
+    all_tasks_add(t);
     return t;
 }
 
-/* 가장 단순한 RR 스케줄러 */
-static void schedule(void) {
-    __asm__ __volatile__("cli");
+task_t* kthread_create(void (*entry)(void *), void *arg, const char *name) {
+    task_t *t = kthread_alloc(entry, arg, name);
+    if (t)
+        sched_enqueue(t);
+    return t;
+}
+
+task_t* kthread_create_joinable(void (*entry)(void *), void *arg, const char *name) {
+    task_t *t = kthread_alloc(entry, arg, name);
+    if (t) {
+        t->detached = 0;
+        sched_enqueue(t);
+    }
+    return t;
+}
+
+task_t* kthread_create_pinned(void (*entry)(void *), void *arg, const char *name, uint32_t cpu) {
+    if (cpu >= g_cpu_count)
+        return NULL;
+    task_t *t = kthread_alloc(entry, arg, name);
+    if (t) {
+        t->detached = 0;
+        t->cpu      = cpu;
+        t->pinned   = 1;
+        sched_enqueue(t);
+    }
+    return t;
+}
 
-    task_t *prev = g_current;
+/* 다른 CPU 런큐에서 READY 태스크 하나를 가져온다 (호출자가 c->rq_lock 보유).
+   원격 락은 trylock만 써서 두 CPU가 서로 훔치려 할 때 교착을 피한다.
+   그 CPU의 FPU 레지스터를 들고 있는 태스크는 옮기지 않는다. */
+static task_t *steal_task(cpu_t *c) {
+    for (uint32_t k = 1; k < g_cpu_count; ++k) {
+        cpu_t *o = &g_cpus[(c->id + k) % g_cpu_count];
+        if (!o->online || !o->rq_bitmap || !spin_trylock(&o->rq_lock))
+            continue;
 
-    task_t *cand = g_readyq ? g_readyq->next : NULL;
-    if (!cand) { __asm__ __volatile__("sti"); return; }
+        /* 높은 우선순위부터 옮길 수 있는 첫 태스크 */
+        task_t *found = NULL;
+        uint64_t bits = o->rq_bitmap;
+        while (bits && !found) {
+            int p = __builtin_ctzll(bits);
+            bits &= bits - 1;
+            for (task_t *t = o->rq_head[p]; t; t = t->next) {
+                if (!t->on_cpu && !t->pinned && o->fpu_owner != t) {
+                    found = t;
+                    break;
+                }
+            }
+        }
+        if (found)
+            rq_detach(o, found);
+        spin_unlock(&o->rq_lock);
 
-    for (int i = 0; cand && i < 1024; ++i) {
-        if (cand->state == TASK_READY) break;
-        cand = cand->next;
-        if (cand == g_readyq->next) break;
+        if (found) {
+            rq_attach(c, found);
+            c->steals++;
+            return found;
+        }
     }
+    return NULL;
+}
+
+/* CPU별 우선순위 스케줄러.
+   prev가 아직 실행 가능하면 먼저 큐에 되돌린다: 슬라이스가 남았으면(선점) 맨 앞,
+   다 썼으면 슬라이스를 채우고 부스트를 하나 깎아 맨 뒤. 그다음
+   로컬 최고 우선순위 → 다른 CPU에서 훔치기 → idle 순으로 고른다. */
+static void schedule_ex(int yielding) {
+    uint64_t flags = irq_save();
+    cpu_t *c = this_cpu();
+    spin_lock(&c->rq_lock);
 
-    if (!cand || cand->state != TASK_READY) { __asm__ __volatile__("sti"); return; }
+    tick_update_jiffies();
+    sched_account(c);
+    task_t *prev = c->current;
+    c->need_resched = 0;
+
+    uint64_t now = ktime_ns();
+    uint64_t ran = now - prev->exec_start;
+    prev->runtime_ns += ran;
+    prev->exec_start = now;
+    if (prev->dl)
+        prev->dl_budget -= (int64_t)ran;
+
+    /* READY인 prev: 재우려다 그 전에 task_wake()가 먼저 도착한 경우 */
+    int runnable = prev->state == TASK_RUNNING || prev->state == TASK_READY;
+    if (prev != c->idle) {
+        if (runnable) {
+            prev->state = TASK_READY;
+            if (prev->dl) {
+                if (prev->dl_budget <= 0)
+                    dl_throttle(c, prev, now);
+                else
+                    rq_enqueue(c, prev, 0);
+            } else if (yielding || prev->time_slice <= 0) {
+                if (!yielding && prev->boost > 0)
+                    prev->boost--;
+                prev->time_slice = sched_slice(prev->prio);
+                rq_enqueue(c, prev, 0);
+            } else {
+                rq_enqueue(c, prev, 1);
+            }
+        } else if (prev->on_rq) {
+            /* 잠든/끝난 태스크는 런큐에서 뺀다 (task_wake가 되돌림) */
+            rq_detach(c, prev);
+        }
+    }
+
+    task_t *cand = rq_pick(c);
+    if (!cand)
+        cand = steal_task(c);
+    if (!cand)
+        cand = c->idle;
+
+    dl_arm_enforce(c, cand, now);
 
     if (prev == cand) {
-        cand->time_slice = TIME_SLICE_TICKS;
-        __asm__ __volatile__("sti");
+        prev->state = TASK_RUNNING;
+        spin_unlock(&c->rq_lock);
+        irq_restore(flags);
         return;
     }
-
-    if (cand->pgdir && prev && cand->pgdir != prev->pgdir) {
-        vmm_switch_pagedir(cand->pgdir);
+    if (prev != c->idle) {
+        if (runnable && !yielding) prev->nivcsw++;
+        else                       prev->nvcsw++;
     }
 
+    /* 커널 스레드(cr3 0)로 넘어갈 때도 커널 CR3로 돌아간다:
+       떠난 유저 주소공간은 reaper가 곧 회수할 수 있다 */
+    if (cand->cr3 != (prev ? prev->cr3 : 0))
+        vmm_switch_cr3(cand->cr3 ? cand->cr3 : kernel_pagemap.top_level_phys);
+
     /* ring0 인터럽트 진입용 커널 스택 */
-    tss_set_kernel_stack((uint32_t)(cand->kstack_base + cand->kstack_size));
+    if (cand->kstack_base)
+        tss_set_kernel_stack((uint64_t)(uintptr_t)(cand->kstack_base + cand->kstack_size));
+
+    cand->state      = TASK_RUNNING;
+    cand->on_cpu     = 1;
+    cand->exec_start = now;
 
-    cand->state = TASK_RUNNING;
-    if (prev && prev->state == TASK_RUNNING) prev->state = TASK_READY;
+    c->current = cand;
+    c->switch_prev = prev;
+    c->in_hlt = 0;
+    c->switches++;
 
-    task_t *old = g_current;
-    g_current = cand;
-    g_readyq  = cand;
+    /* FPU 레지스터는 그대로 두고 CR0.TS만 조정 (실제 교체는 #NM에서) */
+    fpu_switch_to(cand);
 
-    ctx_switch(&old->ctx.esp, &cand->ctx.esp);
+    ctx_switch(&prev->ctx.rsp, &cand->ctx.rsp);
 
-    __asm__ __volatile__("sti");
+    /* 여기서부터는 다른 CPU일 수도 있다: this_cpu()를 다시 읽는다 */
+    sched_finish_switch();
+    irq_restore(flags);
 }
 
-/* PIT ISR에서 호출 */
-void schedule_from_timer(void) {
-    if (!sched_enabled || !g_current) return;
-
-    g_cpu_total_ticks++;
-    if (g_idle_task && g_current == g_idle_task)
-        g_cpu_idle_ticks++;
-    if (--g_current->time_slice <= 0) {
-        g_current->time_slice = TIME_SLICE_TICKS;
+/* 스위치를 수행한 CPU의 런큐 락을 풀고, 이전 태스크를 훔쳐갈 수 있게 표시.
+   idle ↔ 태스크 전환에 맞춰 이 CPU의 틱을 켜고 끈다. */
+void sched_finish_switch(void) {
+    cpu_t *c = this_cpu();
+    task_t *prev = c->switch_prev;
+    if (prev) {
+        prev->on_cpu = 0;
+        c->switch_prev = NULL;
+    }
+    spin_unlock(&c->rq_lock);
+    /* 끝난 태스크의 스택에서 완전히 내려왔으니 이제 회수할 수 있다 */
+    if (prev && prev->state == TASK_ZOMBIE)
+        task_exit_notify(prev);
+    tick_program();
+}
+
+/* 타이머 ISR에서 호출 (PIT 틱 또는 LAPIC 타이머) */
+void schedule_from_timer(void) {
+    cpu_t *c = this_cpu();
+    if (!sched_enabled || !c->current) return;
+
+    uint64_t d = sched_account(c);
+    /* idle이면 로컬/원격 작업이 생겼는지 확인 */
+    if (c->current == c->idle || c->need_resched) {
         schedule();
+        return;
     }
+    /* EDF 태스크는 슬라이스 대신 예산 타이머(dl_enforce)로 선점된다 */
+    if (d == 0 || c->current->dl)
+        return;
+    c->current->time_slice -= (int)d;
+    if (c->current->time_slice <= 0)
+        schedule();
+}
+
+/* reschedule IPI: 원격 wakeup / 새 태스크 도착 */
+void sched_resched(void) {
+    cpu_t *c = this_cpu();
+    c->ipis++;
+    if (!sched_enabled || !c->current)
+        return;
+    schedule();
 }
 
-/* 자발적 양보 */
+/* IRQ 핸들러가 끝난 뒤 (isr_common_handler): 깨운 태스크가 더 급하면 바로 전환 */
+void sched_irq_exit(void) {
+    cpu_t *c = this_cpu();
+    if (sched_enabled && c->current && c->need_resched)
+        schedule();
+}
+
+/* 자발적 양보: 같은 우선순위의 맨 뒤로 (부스트는 유지) */
 void yield(void) {
     if (!sched_enabled) return;
+    schedule_ex(1);
+}
+
+/* 깨우기/부스트 공통. wake면 BLOCKED를 READY로 되돌리고, 큐에 든 태스크가
+   현재 태스크보다 급해지면 그 CPU에 선점을 요청한다. */
+static void task_wake_common(task_t *t, int boost, int wake) {
+    if (!t)
+        return;
+    uint64_t fl;
+    cpu_t *c = task_rq_lock(t, &fl);
+
+    if (boost > 0 && !t->dl) {
+        t->boost += boost;
+        if (t->boost > SCHED_BOOST_MAX)
+            t->boost = SCHED_BOOST_MAX;
+        /* 이미 큐에 있으면 새 우선순위 큐로 옮긴다 */
+        if (t->queued && t->rq_prio != task_eff_prio(t)) {
+            rq_dequeue(c, t);
+            rq_enqueue(c, t, 0);
+        }
+    }
+    if (wake && t->state == TASK_BLOCKED) {
+        t->state = TASK_READY;
+        t->time_slice = sched_slice(t->prio);
+        /* EDF: 남은 예산으로 마감을 못 지키면 지금부터 새 주기 */
+        if (t->dl) {
+            uint64_t now = ktime_ns();
+            if (now + (uint64_t)(t->dl_budget > 0 ? t->dl_budget : 0) > t->dl_abs_deadline)
+                dl_replenish(t, now);
+        }
+        /* 아직 schedule()에 이르지 못했다면 런큐에 그대로 있다 (prev 경로가 처리) */
+        if (!t->on_rq) {
+            rq_attach(c, t);
+            rq_enqueue(c, t, 0);
+        }
+    }
+    int ipi  = t->queued ? rq_check_preempt(c, t) : 0;
+    int busy = c->current != c->idle;
+    spin_unlock_irqrestore(&c->rq_lock, fl);
+    if (wake)
+        sched_notify(c, t, ipi, busy);
+    else if (ipi)
+        mp_send_resched(c->id);
+}
+
+void task_wake(task_t *t)                   { task_wake_common(t, 0, 1); }
+void task_wake_boost(task_t *t, int amount) { task_wake_common(t, amount, 1); }
+void task_boost(task_t *t, int amount)      { task_wake_common(t, amount, 0); }
+
+int task_set_nice(task_t *t, int nice) {
+    if (!t)
+        return -1;
+    if (nice < NICE_MIN) nice = NICE_MIN;
+    if (nice > NICE_MAX) nice = NICE_MAX;
+
+    uint64_t fl;
+    cpu_t *c = task_rq_lock(t, &fl);
+    t->nice = nice;
+    t->prio = nice - NICE_MIN;
+    if (t->time_slice > sched_slice(t->prio))
+        t->time_slice = sched_slice(t->prio);
+    if (t->queued) {
+        rq_dequeue(c, t);
+        rq_enqueue(c, t, 0);
+    }
+    spin_unlock_irqrestore(&c->rq_lock, fl);
+    return 0;
+}
+
+/* --------- EDF 클래스 --------- */
+
+static int dl_check_params(uint64_t runtime, uint64_t *deadline, uint64_t period) {
+    if (!*deadline)
+        *deadline = period;
+    /* 타이머 해상도가 1ms라 그보다 짧은 주기는 지킬 수 없다 */
+    if (!runtime || period < 1000000u || runtime > *deadline || *deadline > period)
+        return -1;
+    return 0;
+}
+
+static inline uint64_t dl_bw_of(uint64_t runtime, uint64_t period) {
+    return (uint64_t)(((unsigned __int128)runtime << DL_BW_SHIFT) / period);
+}
+
+int task_set_deadline(task_t *t, uint64_t runtime, uint64_t deadline, uint64_t period) {
+    if (!t || dl_check_params(runtime, &deadline, period) != 0)
+        return -1;
+    uint64_t bw = dl_bw_of(runtime, period);
+
+    uint64_t fl;
+    cpu_t *c = task_rq_lock(t, &fl);
+    uint64_t old = t->dl ? t->dl_bw : 0;
+    if (c->dl_bw - old + bw > DL_BW_MAX) {
+        spin_unlock_irqrestore(&c->rq_lock, fl);
+        serial_printf("[sched] EDF admission refused: %s on cpu%u (%u%% + %u%%)\n",
+                      t->name, c->id, (uint32_t)(((c->dl_bw - old) * 100) >> DL_BW_SHIFT),
+                      (uint32_t)((bw * 100) >> DL_BW_SHIFT));
+        return -2;
+    }
+    c->dl_bw = c->dl_bw - old + bw;
+
+    int queued = t->queued;
+    if (queued)
+        rq_dequeue(c, t);
+    if (!t->dl)
+        ktimer_init(&t->dl_timer, dl_unthrottle_fn, t);
+    t->dl          = 1;
+    t->pinned      = 1;   /* 대역폭은 CPU별로 받았으니 옮기지 않는다 */
+    t->dl_runtime  = runtime;
+    t->dl_deadline = deadline;
+    t->dl_period   = period;
+    t->dl_bw       = bw;
+    dl_replenish(t, ktime_ns());
+    int ipi = 0;
+    if (queued) {
+        rq_enqueue(c, t, 0);
+        ipi = rq_check_preempt(c, t);
+    }
+    spin_unlock_irqrestore(&c->rq_lock, fl);
+    if (ipi)
+        mp_send_resched(c->id);
+    return 0;
+}
+
+/* 일반 클래스로 되돌린다. CPU 고정은 그대로 둔다. */
+void task_clear_deadline(task_t *t) {
+    if (!t || !t->dl)
+        return;
+    /* 콜백이 rq_lock을 잡으므로 락 밖에서 먼저 취소 */
+    ktimer_cancel(&t->dl_timer);
+
+    uint64_t fl;
+    cpu_t *c = task_rq_lock(t, &fl);
+    c->dl_bw -= t->dl_bw;
+    int queued = t->queued;
+    if (queued)
+        rq_dequeue(c, t);
+    int throttled = t->dl_throttled;
+    t->dl = 0;
+    t->dl_throttled = 0;
+    t->dl_bw = 0;
+    if (queued || (throttled && t->on_rq && t != c->current))
+        rq_enqueue(c, t, 0);
+    spin_unlock_irqrestore(&c->rq_lock, fl);
+}
+
+task_t* kthread_create_dl(void (*entry)(void *), void *arg, const char *name,
+                          uint64_t runtime, uint64_t deadline, uint64_t period) {
+    if (dl_check_params(runtime, &deadline, period) != 0)
+        return NULL;
+    uint64_t bw = dl_bw_of(runtime, period);
+
+    /* 대역폭이 가장 많이 남은 CPU에 미리 자리를 잡아 둔다 */
+    cpu_t *c = NULL;
+    for (uint32_t i = 0; i < g_cpu_count; ++i) {
+        cpu_t *o = &g_cpus[i];
+        if (o->online && (!c || o->dl_bw < c->dl_bw))
+            c = o;
+    }
+    if (!c)
+        c = this_cpu();
+    uint64_t fl = spin_lock_irqsave(&c->rq_lock);
+    int ok = c->dl_bw + bw <= DL_BW_MAX;
+    if (ok)
+        c->dl_bw += bw;
+    spin_unlock_irqrestore(&c->rq_lock, fl);
+    if (!ok) {
+        serial_printf("[sched] EDF admission refused: %s (%u%% on every CPU)\n",
+                      name ? name : "kthread", (uint32_t)((bw * 100) >> DL_BW_SHIFT));
+        return NULL;
+    }
+
+    task_t *t = kthread_alloc(entry, arg, name);
+    if (!t) {
+        /* 예약한 대역폭을 돌려준다 */
+        fl = spin_lock_irqsave(&c->rq_lock);
+        c->dl_bw -= bw;
+        spin_unlock_irqrestore(&c->rq_lock, fl);
+        return NULL;
+    }
+    ktimer_init(&t->dl_timer, dl_unthrottle_fn, t);
+    t->cpu         = c->id;
+    t->pinned      = 1;
+    t->dl          = 1;
+    t->dl_runtime  = runtime;
+    t->dl_deadline = deadline;
+    t->dl_period   = period;
+    t->dl_bw       = bw;
+    dl_replenish(t, ktime_ns());
+    sched_enqueue(t);
+    return t;
+}
+
+void sched_dl_next_period(void) {
+    task_t *self = current_task();
+    if (!self->dl) {
+        yield();
+        return;
+    }
+
+    uint64_t fl;
+    cpu_t *c = task_rq_lock(self, &fl);
+    uint64_t now = ktime_ns();
+    self->dl_jobs++;
+    if (now > self->dl_abs_deadline) {
+        self->dl_misses++;
+        c->dl_misses++;
+    }
+    /* 주기를 통째로 놓쳤으면 밀린 주기를 건너뛰고 지금부터 */
+    uint64_t next = self->dl_release + self->dl_period;
+    dl_replenish(self, next > now ? next : now);
+    spin_unlock_irqrestore(&c->rq_lock, fl);
+
+    while ((now = ktime_ns()) < next)
+        schedule_timeout(ns_to_ms_ceil(next - now));
+}
+
+void sched_dl_dump(void) {
+    for (uint32_t i = 0; i < g_cpu_count; ++i) {
+        cpu_t *c = &g_cpus[i];
+        if (!c->online)
+            continue;
+        serial_printf("[sched] cpu%u EDF bw %u%% (limit %u%%) misses %u\n", c->id,
+                      (uint32_t)((c->dl_bw * 100) >> DL_BW_SHIFT),
+                      (uint32_t)((DL_BW_MAX * 100) >> DL_BW_SHIFT), c->dl_misses);
+    }
+    uint64_t fl = spin_lock_irqsave(&g_all_lock);
+    for (task_t *t = g_all_tasks; t; t = t->all_next) {
+        if (!t->dl)
+            continue;
+        serial_printf("  %u %s cpu%u rt/dl/per %u/%u/%u us jobs %u misses %u overruns %u%s\n",
+                      t->tid, t->name, t->cpu,
+                      (uint32_t)(t->dl_runtime / 1000u), (uint32_t)(t->dl_deadline / 1000u),
+                      (uint32_t)(t->dl_period / 1000u), t->dl_jobs, t->dl_misses,
+                      t->dl_overruns, t->dl_throttled ? " throttled" : "");
+    }
+    spin_unlock_irqrestore(&g_all_lock, fl);
+}
+
+void sched_set_input_task(task_t *t) {
+    g_input_task = t;
+}
+
+/* 키보드/마우스 IRQ: 입력을 소비하는 태스크를 끌어올려 바로 반응하게 한다 */
+void sched_input_event(void) {
+    task_t *t = g_input_task;
+    if (t)
+        task_boost(t, SCHED_BOOST_INPUT);
+}
+
+/* 현재 태스크를 재운다. 호출자는 인터럽트를 끈 채 state를 TASK_BLOCKED로 바꾸고
+   깨울 수단(타이머, 대기 큐)을 등록한 뒤 부른다. task_wake()가 먼저 왔으면 곧바로 돌아온다. */
+void task_block(void) {
+    uint64_t fl = irq_save();
     schedule();
+    irq_restore(fl);
+}
+
+void task_set_state(task_state_t st) {
+    uint64_t fl = irq_save();
+    cpu_t *c = this_cpu();
+    spin_lock(&c->rq_lock);
+    c->current->state = st;
+    spin_unlock(&c->rq_lock);
+    irq_restore(fl);
+}
+
+int task_can_block(void) {
+    cpu_t *c = this_cpu();
+    return sched_enabled && c->current && c->current != c->idle;
+}
+
+void sched_wait_irq(void) {
+    cpu_t *c = this_cpu();
+    c->in_hlt = 1;
+    __asm__ __volatile__("sti; hlt");
+    c->in_hlt = 0;
+    tick_update_jiffies();
+}
+
+void sched_idle_loop(void) {
+    for (;;) {
+        __asm__ __volatile__("sti; hlt");
+        tick_update_jiffies();
+    }
+}
+
+/* --------- 종료한 태스크 회수 ---------
+   detached 태스크는 reaper 스레드가, joinable 태스크는 kthread_join()을 부른 쪽이
+   전체 목록에서 빼고 task_t와 스택을 캐시로 돌려준다. */
+static task_t       *g_zombies   = NULL;   /* reaper 대기열 (next로 연결) */
+static spinlock_t    g_reap_lock = SPINLOCK_INIT;
+static wait_queue_t  g_reap_wq   = WAIT_QUEUE_INIT;
+static wait_queue_t  g_exit_wq   = WAIT_QUEUE_INIT;   /* joiner들 */
+static uint32_t      g_reaped    = 0;
+
+static void all_tasks_remove(task_t *t) {
+    uint64_t fl = spin_lock_irqsave(&g_all_lock);
+    task_t **pp = &g_all_tasks;
+    while (*pp && *pp != t)
+        pp = &(*pp)->all_next;
+    if (*pp)
+        *pp = t->all_next;
+    spin_unlock_irqrestore(&g_all_lock, fl);
+}
+
+static void task_free(task_t *t) {
+    all_tasks_remove(t);
+    if (t->uspace)
+        uspace_destroy(t->uspace);
+    fpu_task_release(t);
+    cache_free(&g_stack_cache, t->kstack_base);
+    cache_free(&g_task_cache, t);
+    __atomic_fetch_add(&g_reaped, 1, __ATOMIC_RELAXED);
+}
+
+/* sched_finish_switch에서: t는 런큐에도 CPU 위에도 없다 */
+static void task_exit_notify(task_t *t) {
+    if (t->detached) {
+        uint64_t fl = spin_lock_irqsave(&g_reap_lock);
+        t->next = g_zombies;
+        g_zombies = t;
+        spin_unlock_irqrestore(&g_reap_lock, fl);
+        wq_wake_one(&g_reap_wq);
+    } else {
+        t->exited = 1;
+        wq_wake_all(&g_exit_wq);
+    }
+}
+
+static int reap_pending(void *arg) {
+    (void)arg;
+    return g_zombies != NULL;
+}
+
+static void reaper_thread(void *arg) {
+    (void)arg;
+    for (;;) {
+        wq_wait_cond(&g_reap_wq, reap_pending, NULL, WAIT_FOREVER);
+        uint64_t fl = spin_lock_irqsave(&g_reap_lock);
+        task_t *list = g_zombies;
+        g_zombies = NULL;
+        spin_unlock_irqrestore(&g_reap_lock, fl);
+        while (list) {
+            task_t *n = list->next;
+            task_free(list);
+            list = n;
+        }
+    }
+}
+
+static int task_exited(void *arg) {
+    return ((task_t *)arg)->exited;
+}
+
+int kthread_join(task_t *t) {
+    if (!t || t->detached || t == current_task())
+        return -1;
+    wq_wait_cond(&g_exit_wq, task_exited, t, WAIT_FOREVER);
+    task_free(t);
+    return 0;
+}
+
+void task_dump(void) {
+    serial_printf("[task] reaped %u, stack cache %u (hit %u miss %u), task cache %u (hit %u miss %u)\n",
+                  g_reaped, g_stack_cache.count, g_stack_cache.hits, g_stack_cache.misses,
+                  g_task_cache.count, g_task_cache.hits, g_task_cache.misses);
+    uint64_t fl = spin_lock_irqsave(&g_all_lock);
+    for (task_t *t = g_all_tasks; t; t = t->all_next) {
+        static const char *const st[] = { "ready", "running", "blocked", "zombie" };
+        serial_printf("  %u %s cpu%u %s%s\n", t->tid, t->name, t->cpu, st[t->state],
+                      t->detached ? "" : " joinable");
+    }
+    spin_unlock_irqrestore(&g_all_lock, fl);
 }
 
 /* 부팅 스레드 래핑 + idle 생성 */
 static task_t g_bootstrap;
 
 void tasking_init(void) {
+    cpu_t *c = this_cpu();
+
     memset(&g_bootstrap, 0, sizeof(g_bootstrap));
     g_bootstrap.tid         = g_next_tid++;
     g_bootstrap.state       = TASK_RUNNING;
-    g_bootstrap.pgdir       = pgdir;
     g_bootstrap.name        = "bootstrap";
     g_bootstrap.kstack_size = KSTACK_SIZE;
-    g_bootstrap.kstack_base = (uint8_t*)kmalloc(KSTACK_SIZE);
-    tss_set_kernel_stack((uint32_t)(g_bootstrap.kstack_base + g_bootstrap.kstack_size));
+    g_bootstrap.kstack_base = (uint8_t*)cache_alloc(&g_stack_cache);
+    g_bootstrap.pinned      = 1;   /* 부팅 흐름은 BSP에 고정 (초기화 뒤 GUI 스레드를 기다린다) */
+    g_bootstrap.on_cpu      = 1;
+    g_bootstrap.nice        = -5;  /* 대화형: 워커보다 먼저, 슬라이스도 길게 */
+    g_bootstrap.prio        = g_bootstrap.nice - NICE_MIN;
+    g_bootstrap.time_slice  = sched_slice(g_bootstrap.prio);
+    tss_set_kernel_stack((uint64_t)(uintptr_t)(g_bootstrap.kstack_base + g_bootstrap.kstack_size));
+    fpu_task_init(&g_bootstrap);
+
+    for (uint32_t i = 0; i < MAX_CPUS; ++i)
+        ktimer_init(&g_dl_enforce[i], dl_enforce_fn, &g_cpus[i]);
+    shrinker_register("task-cache", task_cache_count, task_cache_scan, NULL, 5);
+    spin_register(&g_all_lock, "task.all");
+    spin_register(&g_cache_lock, "task.cache");
+    spin_register(&g_reap_lock, "task.reap");
 
-    g_current       = &g_bootstrap;
-    g_readyq        = &g_bootstrap;
-    g_bootstrap.next= &g_bootstrap;
+    c->current = &g_bootstrap;
+    c->acct_jiffies = jiffies;
+    rq_attach(c, &g_bootstrap);
+    all_tasks_add(&g_bootstrap);
+    sched_set_input_task(&g_bootstrap);
+
+    /* idle: 런큐 밖에 두고 할 일이 없을 때만 선택 */
+    c->idle = kthread_alloc(idle_thread, 0, "idle");
+    c->idle->pinned = 1;
+}
 
-    /* idle */
-    g_idle_task = kthread_create(idle_thread, 0, "idle");
+/* AP: Limine이 준 부팅 스택 위의 흐름을 그대로 이 CPU의 idle 태스크로 쓴다 */
+void sched_init_ap(void) {
+    cpu_t *c = this_cpu();
+    task_t *t = task_alloc("idle");
+    t->state  = TASK_RUNNING;
+    t->pinned = 1;
+    t->on_cpu = 1;
+    t->cpu    = c->id;
+    t->exec_start = ktime_ns();
+    fpu_task_init(t);
+    all_tasks_add(t);
+    c->idle    = t;
+    c->current = t;
+    c->acct_jiffies = jiffies;
 }
 
-/* 데모용 커널 스레드 */
+/* 데모용 커널 스레드 (1초에 한 번, 어느 CPU에서 도는지 출력) */
 static void test_worker(void *arg) {
     (void)arg;
     for (;;) {
-        extern volatile uint64_t jiffies;
-        serial_printf("[worker %u] j=%u\n", current_task()->tid, (unsigned)jiffies);
-        for (volatile int i=0;i<1000000;i++) { }
-        yield();
+        msleep(1000);
+        serial_printf("[worker %u] cpu%u j=%u\n", current_task()->tid,
+                      this_cpu()->id, (unsigned)jiffies);
     }
 }
 
 void start_scheduler(void) {
+    kthread_create(reaper_thread, 0, "reaper");
     kthread_create(test_worker, 0, "worker#1");
     kthread_create(test_worker, 0, "worker#2");
-    /* 비차단형 시작: PIT에서만 스케줄 */
+    /* 실행 시간은 clock_init 이후부터 잰다 */
+    current_task()->exec_start = ktime_ns();
+    /* 비차단형 시작: 타이머 틱에서 선점 */
     sched_enabled = 1;
 }
 
 /* --------- (선택) 유저모드 진입 골격 --------- */
 extern void usermode_iret_trampoline(void);
 
-static void prepare_user_first_switch(task_t *t, uint32_t entry_user, uint32_t user_stack_top) {
-    uint32_t *sp = (uint32_t *)(t->kstack_base + t->kstack_size);
-    sp = (uint32_t *)((uintptr_t)sp & ~0xF);
+/* 첫 스위치: ctx_switch가 6개 레지스터를 pop → ret로 트램펄린 → iretq.
+   스택 (위→아래): [SS][RSP][RFLAGS][CS][RIP][ret=trampoline][rbp..r15] */
+static void prepare_user_first_switch(task_t *t, uint64_t entry_user, uint64_t user_stack_top) {
+    uint64_t *sp = (uint64_t *)(t->kstack_base + t->kstack_size);
+    sp = (uint64_t *)((uintptr_t)sp & ~(uintptr_t)0xF);
 
-    /* ctx_switch 복원용 4레지스터 */
-    *(--sp) = 0; /* edi */
-    *(--sp) = 0; /* esi */
-    *(--sp) = 0; /* ebx */
-    *(--sp) = 0; /* ebp */
+    /* iretq 프레임 */
+    *(--sp) = GDT_SEL_USER_DATA; /* SS (USER_DS | RPL3) */
+    *(--sp) = user_stack_top; /* RSP */
+    *(--sp) = 0x202;          /* RFLAGS (IF=1) */
+    *(--sp) = GDT_SEL_USER_CODE; /* CS (USER_CS | RPL3) */
+    *(--sp) = entry_user;     /* RIP */
 
-    /* ret → 트램펄린 (트램펄린 내부에서 iret 수행) */
-    *(--sp) = (uint32_t)usermode_iret_trampoline;
+    /* ret → 트램펄린 (트램펄린 내부에서 iretq 수행) */
+    *(--sp) = (uint64_t)(uintptr_t)usermode_iret_trampoline;
 
-    /* 트램펄린이 iret용으로 꺼내쓸 프레임 (아래 5개) */
-    *(--sp) = 0x1B;           /* SS (USER_DS) */
-    *(--sp) = user_stack_top; /* ESP */
-    *(--sp) = 0x202;          /* EFLAGS (IF=1) */
-    *(--sp) = 0x23;           /* CS (USER_CS) */
-    *(--sp) = entry_user;     /* EIP */
+    /* ctx_switch 복원용 6레지스터 */
+    for (int i = 0; i < 6; ++i)
+        *(--sp) = 0;          /* rbp, rbx, r12, r13, r14, r15 */
 
-    t->ctx.esp = (uint32_t)sp;
+    t->ctx.rsp = (uint64_t)(uintptr_t)sp;
 }
 
-task_t* proc_create_user(uint32_t entry_user, uint32_t user_stack_top,
-                         uint32_t *pgdir_user, const char *name) {
+task_t* proc_create_user(uint64_t entry_user, uint64_t user_stack_top,
+                         uint64_t cr3, struct uspace *us, const char *name) {
     task_t *t = task_alloc(name ? name : "proc");
+    if (!t)
+        return NULL;
     t->kstack_size = KSTACK_SIZE;
-    t->kstack_base = (uint8_t*)kmalloc(KSTACK_SIZE);
-    t->pgdir       = pgdir_user;
+    t->kstack_base = (uint8_t*)cache_alloc(&g_stack_cache);
+    if (!t->kstack_base || fpu_task_init(t) != 0) {
+        cache_free(&g_stack_cache, t->kstack_base);
+        cache_free(&g_task_cache, t);
+        return NULL;
+    }
+    t->cr3         = cr3;
+    t->uspace      = us;
     t->is_user     = 1;
 
     prepare_user_first_switch(t, entry_user, user_stack_top);
-    rq_push(t);
+    all_tasks_add(t);
+    sched_enqueue(t);
     return t;
 }
 
 /* CPU usage helpers for System Monitor */
-uint32_t task_cpu_usage_percent(void)
+void sched_sample_load(void)
 {
-    static uint64_t prev_total = 0;
-    static uint64_t prev_idle  = 0;
+    for (uint32_t i = 0; i < g_cpu_count; ++i) {
+        cpu_t *c = &g_cpus[i];
+        uint64_t total64 = c->ticks_total;
+        uint64_t idle64  = c->ticks_idle;
+        /* 타이머가 꺼진 idle CPU는 정산이 밀려 있다: 그 시간은 idle로 본다 */
+        if (c->online && c->current == c->idle) {
+            uint64_t pending = jiffies - c->acct_jiffies;
+            if ((int64_t)pending > 0) {
+                total64 += pending;
+                idle64  += pending;
+            }
+        }
 
-    uint64_t total64 = g_cpu_total_ticks;
-    uint64_t idle64  = g_cpu_idle_ticks;
+        uint64_t delta_total = total64 - c->prev_total;
+        uint64_t delta_idle  = idle64  - c->prev_idle;
 
-    uint64_t delta_total = total64 - prev_total;
-    uint64_t delta_idle  = idle64  - prev_idle;
+        c->prev_total = total64;
+        c->prev_idle  = idle64;
 
-    prev_total = total64;
-    prev_idle  = idle64;
+        if (delta_total == 0) {
+            // No ticks since last sample; keep the previous reading.
+            continue;
+        }
 
-    if (delta_total == 0) {
-        // No time elapsed since last sample; keep previous reading (assume 0%).
-        return 0;
+        uint64_t delta_busy = (delta_total > delta_idle) ? (delta_total - delta_idle) : 0;
+        uint32_t pct = (uint32_t)((delta_busy * 100u) / delta_total);
+        c->load_pct = (pct > 100u) ? 100u : pct;
     }
+}
 
-    uint64_t delta_busy = (delta_total > delta_idle) ? (delta_total - delta_idle) : 0;
-    uint32_t pct = (uint32_t)((delta_busy * 100u) / delta_total);
-    if (pct > 100u)
-        pct = 100u;
-    return pct;
+uint32_t sched_cpu_load(uint32_t cpu)
+{
+    cpu_t *c = cpu_get(cpu);
+    return (c && c->online) ? c->load_pct : 0;
+}
+
+/* 온라인 CPU 평균 */
+uint32_t task_cpu_usage_percent(void)
+{
+    uint32_t sum = 0, n = 0;
+    for (uint32_t i = 0; i < g_cpu_count; ++i) {
+        if (!g_cpus[i].online)
+            continue;
+        sum += g_cpus[i].load_pct;
+        n++;
+    }
+    return n ? sum / n : 0;
 }
 
 void task_cpu_reset(void)
 {
-    g_cpu_total_ticks = 0;
-    g_cpu_idle_ticks = 0;
+    for (uint32_t i = 0; i < g_cpu_count; ++i) {
+        g_cpus[i].ticks_total = g_cpus[i].prev_total = 0;
+        g_cpus[i].ticks_idle  = g_cpus[i].prev_idle  = 0;
+        g_cpus[i].load_pct = 0;
+    }
 }
 
 /* Task enumeration helpers for GUI (task manager) */
 task_t* task_enum_head(void)
 {
-    if (!g_readyq)
-        return NULL;
-    return g_readyq->next;
+    return g_all_tasks;
 }
 
 task_t* task_enum_next(task_t *t)
 {
-    if (!t || !g_readyq)
-        return NULL;
-    task_t *next = t->next;
-    if (!next)
-        return NULL;
-    /* Stop after one full cycle around the ready queue ring */
-    if (next == g_readyq->next)
-        return NULL;
-    return next;
+    return t ? t->all_next : NULL;
+}
+
+uint32_t task_count(void)
+{
+    uint32_t n = 0;
+    uint64_t fl = spin_lock_irqsave(&g_all_lock);
+    for (task_t *t = g_all_tasks; t; t = t->all_next)
+        n++;
+    spin_unlock_irqrestore(&g_all_lock, fl);
+    return n;
+}
+
+/* 전체 목록을 락 아래에서 복사한다. 실행 중인 태스크의 시간은 마지막 전환 이후분을 더한다. */
+int task_snapshot(task_stat_t *out, int max)
+{
+    int n = 0;
+    uint64_t now = ktime_ns();
+    uint64_t fl = spin_lock_irqsave(&g_all_lock);
+    for (task_t *t = g_all_tasks; t && n < max; t = t->all_next, ++n) {
+        task_stat_t *s = &out[n];
+        s->tid        = t->tid;
+        s->name       = t->name;
+        s->state      = t->state;
+        s->cpu        = t->cpu;
+        s->nice       = t->nice;
+        s->prio       = task_eff_prio(t);
+        s->runtime_ns = t->runtime_ns;
+        s->wait_ns    = t->wait_ns;
+        s->nvcsw      = t->nvcsw;
+        s->nivcsw     = t->nivcsw;
+        s->dl         = t->dl;
+        s->dl_misses  = t->dl_misses;
+        if (t->state == TASK_RUNNING && now > t->exec_start)
+            s->runtime_ns += now - t->exec_start;
+        else if (t->queued && now > t->wait_start)
+            s->wait_ns += now - t->wait_start;
+    }
+    spin_unlock_irqrestore(&g_all_lock, fl);
+    return n;
 }
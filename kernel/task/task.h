@@ -1,6 +1,7 @@
 #pragma once
 #include <stdint.h>
 #include <stddef.h>
+#include "ktimer.h"
 
 typedef enum {
     TASK_READY = 0,
@@ -10,9 +11,10 @@ typedef enum {
 } task_state_t;
 
 
+/* ctx_switch가 callee-saved 레지스터(rbp,rbx,r12-r15)와 복귀 RIP를
+   스택에 쌓은 뒤의 RSP. 나머지 상태는 모두 그 스택 위에 있다. */
 typedef struct cpu_ctx {
-
-    uint32_t esp;     
+    uint64_t rsp;
 } cpu_ctx_t;
 
 typedef struct task {
@@ -20,7 +22,8 @@ typedef struct task {
     task_state_t    state;
     cpu_ctx_t       ctx;
 
-    uint32_t       *pgdir;
+    uint64_t        cr3;          /* 주소공간 top-level phys (0: 커널 주소공간) */
+    struct uspace  *uspace;       /* exec()으로 만든 유저 이미지 (task/exec.c) */
 
     uint8_t        *kstack_base;
     size_t          kstack_size;
@@ -30,15 +33,129 @@ typedef struct task {
 
     const char     *name;
     int             is_user;      
+
+    /* lazy FPU: #NM에서 처음 SIMD를 쓸 때 할당 (task/fpu.c) */
+    uint8_t        *fpu_state;
+    int             fpu_used;
+
+    /* SMP: 소속 CPU 런큐, 고정 여부, 실제로 CPU 위에 있는지(스위치 완료 전 포함) */
+    uint32_t        cpu;
+    int             pinned;
+    volatile int    on_cpu;
+    int             on_rq;        /* CPU 런큐 소속 (실행 중 포함, BLOCKED/ZOMBIE는 빠진다) */
+    struct task    *all_next;     /* 전체 태스크 목록 (열거용) */
+    int             detached;     /* 1: 끝나면 reaper가 회수, 0: kthread_join()이 회수 */
+    volatile int    exited;       /* joinable 태스크가 CPU를 완전히 떠났다 */
+
+    /* 우선순위: prio = nice + 20, 실효 우선순위 = prio - boost */
+    int             nice;
+    int             prio;
+    int             boost;        /* 입력/오디오 IRQ로 깨어날 때 올라가고 슬라이스를 다 쓰면 줄어든다 */
+    int             queued;       /* READY 큐에 들어 있음 (실행 중이면 0) */
+    int             rq_prio;      /* 들어간 큐의 인덱스 */
+    struct task    *rq_prev;      /* 큐 내 이전 (다음은 next) */
+
+    /* SysMon 통계 (ns) */
+    uint64_t        runtime_ns;   /* CPU 위에서 보낸 시간 */
+    uint64_t        wait_ns;      /* READY 큐에서 기다린 시간 */
+    uint64_t        exec_start;
+    uint64_t        wait_start;
+    uint32_t        nvcsw;        /* 자발적 전환 (잠듦/양보) */
+    uint32_t        nivcsw;       /* 선점 */
+
+    /* EDF (task_set_deadline): 일반 우선순위보다 항상 먼저, 마감이 이른 순 */
+    int             dl;
+    int             dl_throttled; /* 예산 소진: 다음 주기 시작까지 큐 밖 */
+    uint64_t        dl_runtime;   /* 주기당 예산 (ns) */
+    uint64_t        dl_deadline;  /* 주기 시작 기준 상대 마감 (ns) */
+    uint64_t        dl_period;    /* ns */
+    uint64_t        dl_bw;        /* runtime/period << DL_BW_SHIFT */
+    uint64_t        dl_release;   /* 이번 주기 시작 (ktime_ns) */
+    uint64_t        dl_abs_deadline;
+    int64_t         dl_budget;    /* 이번 주기 남은 예산 */
+    uint32_t        dl_jobs;
+    uint32_t        dl_misses;    /* 마감을 넘겨 끝난 작업 */
+    uint32_t        dl_overruns;  /* 예산을 다 써서 스로틀된 횟수 */
+    ktimer_t        dl_timer;     /* 스로틀 해제 (다음 주기 시작) */
 } task_t;
 
+#define NICE_MIN        (-20)
+#define NICE_MAX        19
+#define SCHED_BOOST_MAX 10
+/* 입력 IRQ가 입력 태스크에 주는 부스트 */
+#define SCHED_BOOST_INPUT 6
+
+/* EDF 대역폭: CPU마다 runtime/period 합이 95%를 넘지 않게 받는다 */
+#define DL_BW_SHIFT 20
+#define DL_BW_MAX   ((95ull << DL_BW_SHIFT) / 100)
+
 void     tasking_init(void);
 task_t*  kthread_create(void (*entry)(void *), void *arg, const char *name);
+void     kthread_exit(void) __attribute__((__noreturn__));
+/* 끝나도 회수되지 않고 kthread_join()을 기다리는 스레드 */
+task_t*  kthread_create_joinable(void (*entry)(void *), void *arg, const char *name);
+/* t가 끝날 때까지 잔 뒤 회수한다. 이후 t는 쓰면 안 된다. 0 / -1 (detached, 자기 자신) */
+int      kthread_join(task_t *t);
+/* cpu에 고정된 joinable 스레드 (BSP를 떠나면 안 되는 GUI 스레드 등) */
+task_t*  kthread_create_pinned(void (*entry)(void *), void *arg, const char *name, uint32_t cpu);
+void     task_dump(void);
 void     schedule_from_timer(void);   
 void     yield(void);              
 task_t*  current_task(void);
 
+/* SMP 스케줄러 보조 */
+void     task_wake(task_t *t);        /* BLOCKED → READY, 필요하면 원격 CPU에 IPI */
+void     task_block(void);            /* state=BLOCKED로 바꾼 현재 태스크를 재운다 (task/sync.c) */
+void     task_set_state(task_state_t st);   /* 현재 태스크 상태 변경 (task_wake와 직렬화) */
+int      task_can_block(void);        /* 스케줄러가 돌고 있고 idle이 아니면 1 */
+void     sched_resched(void);         /* reschedule IPI 핸들러 */
+void     sched_irq_exit(void);        /* IRQ 핸들러 직후: need_resched면 선점 */
+
+/* 우선순위 / 대화형 부스트 */
+int      task_set_nice(task_t *t, int nice);
+void     task_boost(task_t *t, int amount);       /* 부스트를 주고 필요하면 선점 */
+void     task_wake_boost(task_t *t, int amount);  /* IRQ에서 깨우는 쪽: task_wake + 부스트 */
+void     sched_set_input_task(task_t *t);         /* 키보드/마우스 입력을 소비하는 태스크 */
+void     sched_input_event(void);                 /* 입력 IRQ 핸들러에서 호출 */
+
+/* EDF 클래스. 시간은 ns, deadline 0이면 period와 같다 (runtime <= deadline <= period).
+   반환: 0, -1 잘못된 인자, -2 대역폭 초과로 거절 */
+int      task_set_deadline(task_t *t, uint64_t runtime, uint64_t deadline, uint64_t period);
+void     task_clear_deadline(task_t *t);
+/* 대역폭이 남는 CPU에 고정된 EDF 스레드를 만든다 (거절되면 NULL) */
+task_t*  kthread_create_dl(void (*entry)(void *), void *arg, const char *name,
+                           uint64_t runtime, uint64_t deadline, uint64_t period);
+/* 이번 주기 작업 끝: 마감을 넘겼으면 miss로 세고 다음 주기 시작까지 잔다 */
+void     sched_dl_next_period(void);
+void     sched_dl_dump(void);
+
+/* SysMon용 태스크 스냅샷 (전체 목록 락 아래에서 복사) */
+typedef struct {
+    uint32_t     tid;
+    const char  *name;
+    task_state_t state;
+    uint32_t     cpu;
+    int          nice;
+    int          prio;        /* 실효 우선순위 */
+    uint64_t     runtime_ns;
+    uint64_t     wait_ns;
+    uint32_t     nvcsw, nivcsw;
+    int          dl;
+    uint32_t     dl_misses;
+} task_stat_t;
+int      task_snapshot(task_stat_t *out, int max);
+uint32_t task_count(void);
+void     sched_finish_switch(void);   /* ctx_switch 직후 (새 스레드는 kthread_start에서) */
+void     sched_init_ap(void);         /* AP 부팅 흐름을 그 CPU의 idle 태스크로 등록 */
+void     sched_idle_loop(void) __attribute__((__noreturn__));
+/* 인터럽트 대기 (sti; hlt). 대기 중 틱은 idle로 집계된다. */
+void     sched_wait_irq(void);
+/* CPU별 부하 갱신 (1초마다) */
+void     sched_sample_load(void);
+uint32_t sched_cpu_load(uint32_t cpu);
+
 // Simple task enumeration helpers for kernel GUI (task manager)
+// 끝난 태스크는 회수되므로 락 없이 들고 있지 말 것 (통계는 task_snapshot)
 task_t*  task_enum_head(void);
 task_t*  task_enum_next(task_t *t);
 
@@ -47,8 +164,10 @@ uint32_t task_cpu_usage_percent(void);
 void     task_cpu_reset(void);
 
 
-task_t*  proc_create_user(uint32_t entry_user, uint32_t user_stack_top,
-                          uint32_t *pgdir, const char *name);
+/* 유저 태스크: cr3 0이면 커널 주소공간을 그대로 쓴다. us는 태스크가
+   회수될 때 uspace_destroy()로 함께 풀린다. */
+task_t*  proc_create_user(uint64_t entry_user, uint64_t user_stack_top,
+                          uint64_t cr3, struct uspace *us, const char *name);
 
 void     start_scheduler(void);
 
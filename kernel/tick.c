@@ -0,0 +1,176 @@
+#include "tick.h"
+#include "apic.h"
+#include "irq.h"
+#include "pit.h"
+#include "isr.h"
+#include "percpu.h"
+#include "serial.h"
+#include "clock.h"
+#include "ktimer.h"
+#include "task/task.h"
+#include <sys/cpu.h>
+
+static int      g_mode = TICK_MODE_PIT;
+static uint64_t g_tsc_per_sec = 0;
+static uint64_t g_tsc_per_jiffy = 0;
+static uint32_t g_lapic_per_sec = 0;
+// jiffies = g_jiffies_base + (rdtsc() - g_tsc_base) / g_tsc_per_jiffy
+static uint64_t g_tsc_base = 0;
+static uint64_t g_jiffies_base = 0;
+
+void tick_update_jiffies(void)
+{
+    if (g_mode == TICK_MODE_PIT)
+        return;
+    uint64_t now = g_jiffies_base + (rdtsc() - g_tsc_base) / g_tsc_per_jiffy;
+    // 여러 CPU가 갱신하므로 뒤로 가지 않도록 큰 값만 기록
+    uint64_t cur = __atomic_load_n(&jiffies, __ATOMIC_RELAXED);
+    while (now > cur &&
+           !__atomic_compare_exchange_n(&jiffies, &cur, now, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+void tick_program(void)
+{
+    if (g_mode == TICK_MODE_PIT)
+        return;
+
+    uint64_t fl = irq_save();
+    cpu_t *c = this_cpu();
+    uint64_t now = rdtsc();
+    uint64_t next = TICK_NEVER;
+
+    // 태스크가 돌고 있으면 다음 jiffy 경계에 틱 (time slice + jiffies 폴링)
+    if (c->current && c->current != c->idle)
+    {
+        uint64_t j = (now - g_tsc_base) / g_tsc_per_jiffy + 1;
+        next = g_tsc_base + j * g_tsc_per_jiffy;
+    }
+    uint64_t kt = ktimer_next_expiry();
+    if (kt != KTIMER_NEVER)
+    {
+        // ktime ms → TSC. 1초 이상 남았으면 1초 뒤에 깨어 다시 건다
+        uint64_t now_ns = ktime_ns();
+        uint64_t at_ns = kt * 1000000ull;
+        uint64_t delta_ns = at_ns > now_ns ? at_ns - now_ns : 0;
+        if (delta_ns > 1000000000ull)
+            delta_ns = 1000000000ull;
+        uint64_t at = now + delta_ns * g_tsc_per_sec / 1000000000ull;
+        if (at < next)
+            next = at;
+    }
+
+    if (next == c->next_event)
+    {
+        irq_restore(fl);
+        return;   // 이미 같은 시점으로 걸려 있음
+    }
+    c->next_event = next;
+
+    if (next == TICK_NEVER)
+    {
+        apic_timer_stop(g_mode == TICK_MODE_TSC_DEADLINE);
+        c->nohz_stops++;
+    }
+    else if (g_mode == TICK_MODE_TSC_DEADLINE)
+    {
+        apic_timer_deadline(next > now ? next : now + 1);
+    }
+    else
+    {
+        uint64_t delta = (next > now) ? next - now : 1;
+        if (delta > g_tsc_per_sec)
+            delta = g_tsc_per_sec;   // 1초 이상은 나눠서 (일찍 깨면 다시 건다)
+        uint64_t lt = delta * g_lapic_per_sec / g_tsc_per_sec;
+        apic_timer_oneshot(lt > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)lt);
+    }
+    irq_restore(fl);
+}
+
+static void tick_irq(void)
+{
+    cpu_t *c = this_cpu();
+    c->timer_irqs++;
+    c->next_event = 0;   // 걸어둔 이벤트는 소비됨
+
+    tick_update_jiffies();
+
+    ktimer_run();
+    schedule_from_timer();
+    tick_program();
+}
+
+void tick_cpu_start(void)
+{
+    if (g_mode == TICK_MODE_PIT)
+        return;
+    cpu_t *c = this_cpu();
+    c->next_event = 0;
+    c->acct_jiffies = jiffies;
+    apic_timer_setup(g_mode == TICK_MODE_TSC_DEADLINE);
+    tick_program();
+}
+
+int tick_init(void)
+{
+    if (apic_init() != 0)
+    {
+        serial_printf("[tick] no local APIC, keeping the PIT tick\n");
+        return -1;
+    }
+    if (apic_timer_calibrate(&g_tsc_per_sec) != 0 || g_tsc_per_sec < HZ)
+    {
+        serial_printf("[tick] LAPIC/TSC calibration failed, keeping the PIT tick\n");
+        return -1;
+    }
+    // clocksource가 HPET으로 잰 값이 있으면 그쪽이 더 정확하다
+    if (clock_tsc_hz())
+        g_tsc_per_sec = clock_tsc_hz();
+    g_lapic_per_sec = apic_timer_ticks_per_sec();
+    g_tsc_per_jiffy = g_tsc_per_sec / HZ;
+
+    isr_register_handler(APIC_VEC_TIMER, tick_irq);
+
+    // PIT → LAPIC 인계: IRQ0을 막고 지금 시점을 기준으로 jiffies를 이어간다
+    uint64_t fl = irq_save();
+    irq_disable(0);
+    g_jiffies_base = jiffies;
+    g_tsc_base = rdtsc();
+    g_mode = apic_tsc_deadline_supported() ? TICK_MODE_TSC_DEADLINE : TICK_MODE_ONESHOT;
+    irq_restore(fl);
+
+    tick_cpu_start();
+    serial_printf("[tick] LAPIC %s, %llu TSC cycles/jiffy\n",
+                  g_mode == TICK_MODE_TSC_DEADLINE ? "TSC-deadline" : "one-shot",
+                  (unsigned long long)g_tsc_per_jiffy);
+    return 0;
+}
+
+int tick_mode(void)
+{
+    return g_mode;
+}
+
+uint64_t tick_tsc_per_sec(void)
+{
+    return g_tsc_per_sec;
+}
+
+uint64_t tick_tsc_per_jiffy(void)
+{
+    return g_tsc_per_jiffy;
+}
+
+void tick_dump(void)
+{
+    static const char *const names[] = { "PIT", "one-shot", "TSC-deadline" };
+    serial_printf("[tick] mode=%s jiffies=%llu\n", names[g_mode], (unsigned long long)jiffies);
+    for (uint32_t i = 0; i < g_cpu_count; ++i)
+    {
+        cpu_t *c = &g_cpus[i];
+        if (!c->online)
+            continue;
+        serial_printf("[tick] cpu%u irqs=%u nohz_stops=%u next=%s\n", i, c->timer_irqs,
+                      c->nohz_stops, c->next_event == TICK_NEVER ? "none" : "armed");
+    }
+}
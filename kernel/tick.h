@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+
+// Tick management on top of the LAPIC timer.
+// - Each CPU's LAPIC timer runs in TSC-deadline mode when the CPU supports
+//   it, otherwise in one-shot mode. It is re-armed for the next event only.
+// - A CPU that runs a task gets a tick every 1/HZ for time slicing and for
+//   code that polls jiffies. An idle CPU arms only for its next ktimer
+//   (ktimer.c), and with none pending the timer is switched off (tickless
+//   idle).
+// - jiffies is derived from the TSC and refreshed on every timer interrupt
+//   and after every hlt wake-up. Existing readers keep working unchanged.
+// - If there is no LAPIC, the PIT keeps its 100 Hz tick as before.
+
+#define HZ 100
+#define TICK_NEVER (~0ull)   // "no deadline"
+
+enum { TICK_MODE_PIT = 0, TICK_MODE_ONESHOT, TICK_MODE_TSC_DEADLINE };
+
+// BSP: calibrate, move the tick from the PIT to the LAPIC. Interrupts on.
+int      tick_init(void);
+// AP: arm this CPU's LAPIC timer in the mode picked by tick_init().
+void     tick_cpu_start(void);
+// Re-arm this CPU's timer for its next event (after a switch or before idle).
+void     tick_program(void);
+// Bring jiffies up to date from the TSC.
+void     tick_update_jiffies(void);
+
+int      tick_mode(void);
+uint64_t tick_tsc_per_sec(void);
+uint64_t tick_tsc_per_jiffy(void);
+void     tick_dump(void);
@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include "gdt.h"   // struct tss64, extern struct tss64 g_tss;
 #include "tss.h"
+#include "percpu.h"
 
 /*
  * Long mode TSS 초기화.
@@ -15,8 +16,10 @@ void tss_init_fields(void) {
 
 /*
  * 스케줄러(task.c)에서 쓰는 커널 스택 설정 함수.
- * 현재 실행 중인 태스크에 맞게 RSP0를 바꿉니다.
+ * 현재 실행 중인 태스크에 맞게 이 CPU의 TSS RSP0를 바꿉니다.
  */
 void tss_set_kernel_stack(uint64_t stack_top) {
-    g_tss.rsp0 = stack_top;
+    cpu_t *c = this_cpu();
+    c->tss->rsp0 = stack_top;
+    c->syscall_rsp = stack_top;   // SYSCALL은 TSS를 거치지 않으므로 따로 둔다
 }
@@ -0,0 +1,458 @@
+#include "uring.h"
+#include "syscall.h"
+#include "serial.h"
+#include "clock.h"
+#include "kheap.h"
+#include "fb.h"
+#include "gui_event.h"
+#include "spinlock.h"
+#include "mm/vmm.h"
+#include "task/task.h"
+#include "task/exec.h"
+#include "task/sync.h"
+#include <string.h>
+
+void *pmm_alloc_contig_tag(uint32_t pages, kmem_tag_t tag);
+
+_Static_assert(sizeof(uring_sqe_t) == 48, "uring_bench.asm SQE stride");
+_Static_assert(sizeof(uring_cqe_t) == 16, "uring_bench.asm CQE stride");
+_Static_assert(sizeof(uring_hdr_t) == URING_SQ_OFF, "SQ follows the header");
+_Static_assert(__builtin_offsetof(uring_shared_t, cq) == URING_CQ_OFF, "CQ follows the SQ");
+_Static_assert(sizeof(uring_shared_t) <= URING_PAGES * 0x1000, "shared ring pages");
+_Static_assert(URING_PAGES * 0x1000 <= USER_RING_SIZE, "ring VA reservation");
+_Static_assert((URING_SQ_ENTRIES & (URING_SQ_ENTRIES - 1)) == 0, "power of two");
+_Static_assert((URING_CQ_ENTRIES & (URING_CQ_ENTRIES - 1)) == 0, "power of two");
+
+#define URING_PATH_MAX       64
+#define URING_WRITE_MAX      (64u * 1024u)
+#define URING_BOUNCE         4096u
+#define URING_SQPOLL_IDLE_NS 2000000ull   // 이만큼 할 일이 없으면 폴링 스레드가 잠든다
+
+typedef struct uring
+{
+    uspace_t       *us;
+    uring_shared_t *sh;          // 공유 페이지의 HHDM 주소
+    mutex_t         lock;        // SQ 소비자(enter / 폴링 스레드)와 fd 테이블
+    wait_queue_t    cq_wq;       // min_complete 대기자
+    wait_queue_t    sq_wq;       // 잠든 폴링 스레드
+    uint32_t        cq_want;
+    task_t         *poller;
+    volatile int    stop;
+    uint8_t        *bounce;
+    fat32_file_t    files[URING_MAX_FILES];
+    char            paths[URING_MAX_FILES][URING_PATH_MAX];
+    uint8_t         used[URING_MAX_FILES];
+    uint64_t        sqes;        // 처리한 SQE
+    uint64_t        enters;      // SYS_URING_ENTER 횟수
+    uint64_t        wakeups;     // 폴링 스레드가 잠들었다 깬 횟수
+} uring_t;
+
+/* --------- GUI 그리기 큐 ---------
+ * 프레임버퍼는 GUI 루프만 만진다. 링은 요청을 여기 쌓고
+ * uring_gui_drain()이 다음 프레임에 전면 버퍼에 그린다. */
+
+#define URING_DRAW_QUEUE 64
+#define URING_TEXT_MAX   64
+
+typedef struct
+{
+    uint8_t  op;
+    int32_t  x, y, w, h;
+    uint32_t fg, bg;
+    char     text[URING_TEXT_MAX];
+} uring_draw_t;
+
+static spinlock_t   g_draw_lock = SPINLOCK_INIT;
+static uring_draw_t g_draw_q[URING_DRAW_QUEUE];
+static uint32_t     g_draw_head, g_draw_tail;
+
+static int draw_push(const uring_draw_t *d)
+{
+    int rc = URING_EBUSY;
+    uint64_t fl = spin_lock_irqsave(&g_draw_lock);
+    if (g_draw_tail - g_draw_head < URING_DRAW_QUEUE)
+    {
+        g_draw_q[g_draw_tail++ % URING_DRAW_QUEUE] = *d;
+        rc = 0;
+    }
+    spin_unlock_irqrestore(&g_draw_lock, fl);
+    if (rc == 0)
+        gui_event_post(GUI_EV_DRAW);
+    return rc;
+}
+
+void uring_gui_drain(void)
+{
+    for (;;)
+    {
+        uring_draw_t d;
+        uint64_t fl = spin_lock_irqsave(&g_draw_lock);
+        if (g_draw_head == g_draw_tail)
+        {
+            spin_unlock_irqrestore(&g_draw_lock, fl);
+            return;
+        }
+        d = g_draw_q[g_draw_head++ % URING_DRAW_QUEUE];
+        spin_unlock_irqrestore(&g_draw_lock, fl);
+
+        if (d.op == URING_OP_DRAW_RECT)
+            draw_rect_front(d.x, d.y, d.w, d.h, d.fg);
+        else
+            draw_text_front(d.x, d.y, d.text, d.fg, d.bg);
+    }
+}
+
+/* --------- 요청 처리 --------- */
+
+static int64_t map_fs_err(int rc)
+{
+    return rc == -4 || rc == -3 ? URING_ENOENT : URING_EIO;
+}
+
+static int64_t op_open(uring_t *r, const uring_sqe_t *s)
+{
+    disk_read_fn rd;
+    fat32_vol_t *vol = exec_volume(&rd, NULL);
+    char path[URING_PATH_MAX];
+    if (uspace_copy_str(r->us, path, s->addr, sizeof(path)) < 0)
+        return URING_EFAULT;
+    if (!vol)
+        return URING_EIO;
+
+    int fd = 0;
+    while (fd < URING_MAX_FILES && r->used[fd])
+        fd++;
+    if (fd == URING_MAX_FILES)
+        return URING_EMFILE;
+    int rc = fat32_open_path(vol, rd, path, &r->files[fd]);
+    if (rc != 0)
+        return map_fs_err(rc);
+    memcpy(r->paths[fd], path, sizeof(path));
+    r->used[fd] = 1;
+    return fd;
+}
+
+static int64_t op_read(uring_t *r, const uring_sqe_t *s)
+{
+    disk_read_fn rd;
+    fat32_vol_t *vol = exec_volume(&rd, NULL);
+    fat32_file_t *f = &r->files[s->fd];
+    if (s->off >= f->size)
+        return 0;
+    uint64_t left = f->size - s->off;
+    if (left > s->len)
+        left = s->len;
+
+    uint64_t done = 0;
+    while (done < left)
+    {
+        uint32_t chunk = left - done > URING_BOUNCE ? URING_BOUNCE : (uint32_t)(left - done);
+        uint32_t n = 0;
+        if (fat32_read_at(vol, rd, f, (uint32_t)(s->off + done), r->bounce, chunk, &n) != 0 || n == 0)
+            return done ? (int64_t)done : URING_EIO;
+        if (uspace_copy_out(r->us, s->addr + done, r->bounce, n) != 0)
+            return URING_EFAULT;
+        done += n;
+    }
+    return (int64_t)done;
+}
+
+static int64_t op_write(uring_t *r, const uring_sqe_t *s)
+{
+    disk_read_fn rd;
+    disk_write_fn wr;
+    fat32_vol_t *vol = exec_volume(&rd, &wr);
+    // FAT 쪽에는 경로 단위 통째 쓰기만 있다: 오프셋 쓰기는 받지 않는다
+    if (s->off != 0 || s->len > URING_WRITE_MAX || !wr)
+        return URING_EINVAL;
+
+    uint8_t *buf = s->len ? kmalloc_tag(s->len, KMEM_TAG_FS) : NULL;
+    if (s->len && !buf)
+        return URING_EIO;
+    int64_t res = s->len;
+    if (s->len && uspace_copy_in(r->us, buf, s->addr, s->len) != 0)
+        res = URING_EFAULT;
+    else if (fat32_write_file_path(vol, rd, wr, r->paths[s->fd], buf ? (const void *)buf : "", s->len) != 0)
+        res = URING_EIO;
+    // 클러스터 체인과 크기가 바뀌었으니 다시 연다
+    else if (fat32_open_path(vol, rd, r->paths[s->fd], &r->files[s->fd]) != 0)
+        res = URING_EIO;
+    if (buf)
+        kfree(buf);
+    return res;
+}
+
+static int64_t op_stat(uring_t *r, const uring_sqe_t *s)
+{
+    disk_read_fn rd;
+    fat32_vol_t *vol = exec_volume(&rd, NULL);
+    char path[URING_PATH_MAX];
+    fat32_file_t f;
+    if (uspace_copy_str(r->us, path, s->addr, sizeof(path)) < 0)
+        return URING_EFAULT;
+    if (!vol)
+        return URING_EIO;
+    int rc = fat32_open_path(vol, rd, path, &f);
+    return rc == 0 ? (int64_t)f.size : map_fs_err(rc);
+}
+
+static int64_t op_draw(uring_t *r, const uring_sqe_t *s)
+{
+    uring_draw_t d;
+    memset(&d, 0, sizeof(d));
+    d.op = s->op;
+    d.x = (int32_t)(uint32_t)s->off;
+    d.y = (int32_t)(uint32_t)(s->off >> 32);
+    d.fg = s->len;
+    if (s->op == URING_OP_DRAW_RECT)
+    {
+        d.w = (int32_t)(uint32_t)s->arg;
+        d.h = (int32_t)(uint32_t)(s->arg >> 32);
+    }
+    else
+    {
+        d.bg = (uint32_t)s->arg;
+        if (uspace_copy_str(r->us, d.text, s->addr, sizeof(d.text)) < 0)
+            return URING_EFAULT;
+    }
+    return draw_push(&d);
+}
+
+static int64_t uring_do(uring_t *r, const uring_sqe_t *s)
+{
+    switch (s->op)
+    {
+    case URING_OP_NOP:
+        return 0;
+    case URING_OP_OPEN:
+        return op_open(r, s);
+    case URING_OP_STAT:
+        return op_stat(r, s);
+    case URING_OP_DRAW_RECT:
+    case URING_OP_DRAW_TEXT:
+        return op_draw(r, s);
+    case URING_OP_CLOSE:
+    case URING_OP_READ:
+    case URING_OP_WRITE:
+        if (s->fd >= URING_MAX_FILES || !r->used[s->fd])
+            return URING_EBADF;
+        if (s->op == URING_OP_READ)
+            return op_read(r, s);
+        if (s->op == URING_OP_WRITE)
+            return op_write(r, s);
+        r->used[s->fd] = 0;
+        return 0;
+    default:
+        r->sh->hdr.sq_dropped++;
+        return URING_EINVAL;
+    }
+}
+
+// 유저가 쓰는 인덱스는 믿지 않는다: 범위를 벗어나면 빈 것으로 본다
+static uint32_t sq_pending(const uring_hdr_t *h)
+{
+    uint32_t n = __atomic_load_n(&h->sq_tail, __ATOMIC_ACQUIRE) - h->sq_head;
+    return n <= URING_SQ_ENTRIES ? n : 0;
+}
+
+static int cq_full(const uring_hdr_t *h)
+{
+    return h->cq_tail - __atomic_load_n(&h->cq_head, __ATOMIC_ACQUIRE) >= URING_CQ_ENTRIES;
+}
+
+// SQE를 max개까지 가져가 처리하고 CQE를 낸다. 가져간 수.
+static uint32_t uring_submit(uring_t *r, uint32_t max)
+{
+    uring_hdr_t *h = &r->sh->hdr;
+    uint32_t done = 0;
+
+    mutex_lock(&r->lock);
+    while (done < max && sq_pending(h) && !cq_full(h))
+    {
+        uint32_t head = h->sq_head;
+        // 유저가 처리 중에 SQE를 바꿔도 상관없도록 복사해 둔다
+        uring_sqe_t sqe = r->sh->sq[head & (URING_SQ_ENTRIES - 1)];
+        __atomic_store_n(&h->sq_head, head + 1, __ATOMIC_RELEASE);
+
+        int64_t res = uring_do(r, &sqe);
+
+        uint32_t tail = h->cq_tail;
+        uring_cqe_t *c = &r->sh->cq[tail & (URING_CQ_ENTRIES - 1)];
+        c->user_data = sqe.user_data;
+        c->res = res;
+        __atomic_store_n(&h->cq_tail, tail + 1, __ATOMIC_RELEASE);
+        done++;
+    }
+    r->sqes += done;
+    mutex_unlock(&r->lock);
+
+    if (done)
+        wq_wake_all(&r->cq_wq);
+    return done;
+}
+
+/* --------- SQPOLL 스레드 --------- */
+
+static int sq_has_work(void *arg)
+{
+    uring_t *r = arg;
+    return r->stop || (sq_pending(&r->sh->hdr) && !cq_full(&r->sh->hdr));
+}
+
+static void uring_poll_thread(void *arg)
+{
+    uring_t *r = arg;
+    uring_hdr_t *h = &r->sh->hdr;
+    uint64_t idle_since = ktime_ns();
+
+    while (!r->stop)
+    {
+        if (uring_submit(r, URING_SQ_ENTRIES))
+        {
+            idle_since = ktime_ns();
+            continue;
+        }
+        if (ktime_ns() - idle_since < URING_SQPOLL_IDLE_NS)
+        {
+            yield();
+            continue;
+        }
+        // 플래그를 먼저 세우고 조건을 다시 보므로 그 사이에 올라온 SQE를 놓치지 않는다
+        __atomic_or_fetch(&h->flags, URING_SQ_NEED_WAKEUP, __ATOMIC_SEQ_CST);
+        wq_wait_cond(&r->sq_wq, sq_has_work, r, WAIT_FOREVER);
+        __atomic_and_fetch(&h->flags, ~URING_SQ_NEED_WAKEUP, __ATOMIC_SEQ_CST);
+        r->wakeups++;
+        idle_since = ktime_ns();
+    }
+}
+
+/* --------- 시스템콜 --------- */
+
+int64_t uring_setup(uint32_t flags)
+{
+    uspace_t *us = current_task()->uspace;
+    if (!us || (flags & ~URING_SETUP_SQPOLL))
+        return URING_EINVAL;
+
+    // 페이지 테이블은 us->lock이 지킨다: SQPOLL 스레드의 uspace_fault_in과 겹치지 않게
+    mutex_lock(&us->lock);
+    if (us->ring)
+    {
+        mutex_unlock(&us->lock);
+        return (int64_t)USER_RING_VA;
+    }
+
+    uint32_t mapped = 0;
+    uring_t *r = kzalloc_tag(sizeof(*r), KMEM_TAG_TASK);
+    uint8_t *pages = pmm_alloc_contig_tag(URING_PAGES, KMEM_TAG_USER);
+    uint8_t *bounce = kmalloc_tag(URING_BOUNCE, KMEM_TAG_FS);
+    if (!r || !pages || !bounce)
+        goto fail;
+
+    // 공유 페이지는 주소공간 소유: vmm_space_destroy가 다른 유저 페이지와 같이 회수한다
+    for (; mapped < URING_PAGES; ++mapped)
+    {
+        uint64_t pa = (uint64_t)(uintptr_t)(pages + mapped * 0x1000) - vmm_hhdm_offset();
+        if (vmm_space_map(us->cr3, USER_RING_VA + mapped * 0x1000, pa, VMM_P | VMM_RW | VMM_US) != 0)
+            goto fail;
+    }
+
+    r->us = us;
+    r->sh = (uring_shared_t *)pages;
+    r->bounce = bounce;
+    r->sh->hdr.sq_entries = URING_SQ_ENTRIES;
+    r->sh->hdr.cq_entries = URING_CQ_ENTRIES;
+    mutex_init(&r->lock);
+    wq_init(&r->cq_wq);
+    wq_init(&r->sq_wq);
+    if (flags & URING_SETUP_SQPOLL)
+    {
+        r->poller = kthread_create_joinable(uring_poll_thread, r, "uring-sqpoll");
+        if (!r->poller)
+            goto fail;
+    }
+    us->ring = r;
+    mutex_unlock(&us->lock);
+    serial_printf("[uring] %s: ring at 0x%llx (%u SQ / %u CQ)%s\n", us->path,
+                  (unsigned long long)USER_RING_VA, URING_SQ_ENTRIES, URING_CQ_ENTRIES,
+                  r->poller ? ", SQPOLL" : "");
+    return (int64_t)USER_RING_VA;
+
+fail:
+    // 반쯤 만든 링이 유저에게 RW로 보이면 안 된다: 매핑은 떼어낸다.
+    // PMM은 되돌릴 수 없으므로 페이지 자체는 버린다.
+    if (mapped)
+        vmm_space_unmap_range(us->cr3, USER_RING_VA, mapped);
+    mutex_unlock(&us->lock);
+    if (bounce)
+        kfree(bounce);
+    if (r)
+        kfree(r);
+    return URING_EIO;
+}
+
+static int cq_ready(void *arg)
+{
+    uring_t *r = arg;
+    const uring_hdr_t *h = &r->sh->hdr;
+    return h->cq_tail - __atomic_load_n(&h->cq_head, __ATOMIC_ACQUIRE) >= r->cq_want;
+}
+
+int64_t uring_enter(uint32_t to_submit, uint32_t min_complete, uint32_t flags)
+{
+    uspace_t *us = current_task()->uspace;
+    uring_t *r = us ? us->ring : NULL;
+    if (!r)
+        return URING_EINVAL;
+    r->enters++;
+
+    int64_t n = 0;
+    if (r->poller)
+    {
+        if (flags & URING_ENTER_SQ_WAKEUP)
+            wq_wake_one(&r->sq_wq);
+    }
+    else
+    {
+        n = uring_submit(r, to_submit);
+    }
+
+    // 폴링 스레드가 없으면 완료를 낼 쪽이 없으니 기다리지 않는다
+    if (min_complete && r->poller)
+    {
+        r->cq_want = min_complete < URING_CQ_ENTRIES ? min_complete : URING_CQ_ENTRIES;
+        wq_wait_cond(&r->cq_wq, cq_ready, r, WAIT_FOREVER);
+    }
+    return n;
+}
+
+void uring_destroy(uring_t *r)
+{
+    if (r->poller)
+    {
+        r->stop = 1;
+        wq_wake_all(&r->sq_wq);
+        kthread_join(r->poller);
+    }
+    serial_printf("[uring] %s: %llu SQEs in %llu enters, %llu poller wakeups\n", r->us->path,
+                  (unsigned long long)r->sqes, (unsigned long long)r->enters,
+                  (unsigned long long)r->wakeups);
+    r->us->ring = NULL;
+    kfree(r->bounce);
+    kfree(r);
+}
+
+/* --------- 벤치마크 --------- */
+
+extern const uint8_t uring_bench_user_start[];
+extern const uint8_t uring_bench_user_end[];
+
+void uring_bench(void)
+{
+    size_t len = (size_t)(uring_bench_user_end - uring_bench_user_start);
+    int tid = exec_image("uringbench", uring_bench_user_start, len);
+    if (tid < 0)
+        serial_printf("[uring] bench: start failed\n");
+    else
+        serial_printf("[uring] bench: ring 3 task tid %d started\n", tid);
+}
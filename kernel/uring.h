@@ -0,0 +1,103 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Submission/completion ring (io_uring 스타일)
+// - 프로세스마다 하나. 커널은 HHDM으로, 유저는 USER_RING_VA로 같은 페이지를 본다.
+// - 유저가 SQE를 채우고 sq_tail을 올린 뒤 SYS_URING_ENTER 한 번으로 여러 요청을
+//   넘긴다. URING_SETUP_SQPOLL이면 커널 스레드가 sq_tail을 지켜보다가 직접
+//   가져가므로 시스템콜 없이도 처리된다 (쉬러 갈 때 URING_SQ_NEED_WAKEUP).
+// - 완료는 CQE(user_data, res)로 돌아온다. res는 바이트 수/fd 또는 음수.
+// - CQ가 가득 차면 SQE를 더 가져가지 않는다 (유저가 cq_head를 올릴 때까지).
+//
+// 헤더의 인덱스는 계속 증가하는 카운터이고 배열 위치는 & (ENTRIES-1).
+// 유저 블롭(uring_bench.asm)이 오프셋을 직접 쓰므로 레이아웃을 바꾸면 같이 고친다.
+
+#define URING_SQ_ENTRIES  64
+#define URING_CQ_ENTRIES  128
+#define URING_MAX_FILES   16
+#define URING_PAGES       2
+
+// SYS_URING_SETUP flags
+#define URING_SETUP_SQPOLL   (1u << 0)
+// SYS_URING_ENTER flags
+#define URING_ENTER_SQ_WAKEUP (1u << 0)   // 잠든 폴링 스레드를 깨운다
+// uring_hdr_t.flags (커널이 쓴다)
+#define URING_SQ_NEED_WAKEUP  (1u << 0)
+
+enum {
+    URING_OP_NOP = 0,
+    URING_OP_OPEN,        // addr = 경로                    → fd
+    URING_OP_CLOSE,       // fd                              → 0
+    URING_OP_READ,        // fd, off, addr = 버퍼, len       → 읽은 바이트
+    URING_OP_WRITE,       // fd, addr, len: 파일 전체를 바꾼다 (off는 0) → len
+    URING_OP_STAT,        // addr = 경로                    → 파일 크기
+    URING_OP_DRAW_RECT,   // off = x | y<<32, arg = w | h<<32, len = ARGB
+    URING_OP_DRAW_TEXT,   // off = x | y<<32, addr = 문자열, len = fg, arg = bg
+    URING_OP_MAX
+};
+
+// 완료 결과 (res < 0)
+#define URING_EINVAL  -1
+#define URING_EFAULT  -2
+#define URING_EBADF   -3
+#define URING_ENOENT  -4
+#define URING_EIO     -5
+#define URING_EMFILE  -6
+#define URING_EBUSY   -7
+
+typedef struct {
+    uint8_t  op;
+    uint8_t  flags;
+    uint16_t fd;
+    uint32_t len;
+    uint64_t off;
+    uint64_t addr;
+    uint64_t arg;
+    uint64_t user_data;
+    uint64_t resv;
+} uring_sqe_t;   // 48 bytes
+
+typedef struct {
+    uint64_t user_data;
+    int64_t  res;
+} uring_cqe_t;   // 16 bytes
+
+typedef struct {
+    volatile uint32_t sq_head;    // 커널
+    volatile uint32_t sq_tail;    // 유저
+    volatile uint32_t cq_head;    // 유저
+    volatile uint32_t cq_tail;    // 커널
+    volatile uint32_t flags;      // URING_SQ_NEED_WAKEUP
+    volatile uint32_t sq_dropped; // 잘못된 op 등으로 버린 SQE (완료는 낸다)
+    uint32_t          sq_entries;
+    uint32_t          cq_entries;
+    uint8_t           pad[32];
+} uring_hdr_t;   // 64 bytes
+
+#define URING_SQ_OFF  64
+#define URING_CQ_OFF  (URING_SQ_OFF + URING_SQ_ENTRIES * 48)
+
+typedef struct {
+    uring_hdr_t hdr;
+    uring_sqe_t sq[URING_SQ_ENTRIES];
+    uring_cqe_t cq[URING_CQ_ENTRIES];
+} uring_shared_t;
+
+struct uspace;
+struct uring;
+
+// SYS_URING_SETUP: 현재 프로세스의 링을 만들고 유저 주소를 돌려준다 (이미 있으면 그대로).
+int64_t uring_setup(uint32_t flags);
+// SYS_URING_ENTER: to_submit개까지 처리하고 CQ에 min_complete개가 쌓일 때까지 잔다.
+// 가져간 SQE 수 또는 음수.
+int64_t uring_enter(uint32_t to_submit, uint32_t min_complete, uint32_t flags);
+// uspace_destroy에서: 폴링 스레드를 멈추고 fd 테이블을 정리한다.
+// 공유 페이지는 주소공간과 함께 풀린다.
+void    uring_destroy(struct uring *r);
+
+// GUI 루프가 매 프레임 부른다: 링에서 들어온 그리기 요청을 전면 버퍼에 그린다.
+void    uring_gui_drain(void);
+
+// 셸 명령: 시스템콜 하나씩 vs 묶어서 제출하는 ring 3 벤치마크
+void    uring_bench(void);
@@ -0,0 +1,120 @@
+; =======================================================
+; 제출 링 벤치마크 (ring 3, 위치 독립)
+;  - uring_bench() 가 exec_image 로 이 바이트들을 새 주소공간에 올려 실행
+;  - SYS_URING_SETUP 으로 링을 받고 NOP SQE 를 N개 처리한다
+;      1) SQE 하나마다 SYS_URING_ENTER 한 번 (시스템콜 하나씩)
+;      2) BATCH 개를 채운 뒤 SYS_URING_ENTER 한 번
+;  - rdtsc 로 잰 총 사이클을 SYS_BENCH_REPORT 로 넘긴 뒤 SYS_EXIT
+; =======================================================
+BITS 64
+section .rodata align=16
+
+; syscall.h 의 번호와 같아야 한다
+%define SYS_EXIT          6
+%define SYS_BENCH_REPORT  7
+%define SYS_URING_SETUP   8
+%define SYS_URING_ENTER   9
+%define BENCH_URING_PERCALL_VS_BATCH 1
+
+; uring.h 의 레이아웃과 같아야 한다
+%define URING_SQ_TAIL       4
+%define URING_CQ_HEAD       8
+%define URING_CQ_TAIL       12
+%define URING_SQ_OFF        64
+%define URING_SQ_MASK       63
+%define URING_SQE_SIZE      48
+%define URING_SQE_USER_DATA 32
+%define URING_OP_NOP        0
+
+%define BENCH_ITERS  32768
+%define BENCH_BATCH  32
+
+global uring_bench_user_start
+global uring_bench_user_end
+
+%macro RDTSC64 0
+    rdtsc
+    shl rdx, 32
+    or rax, rdx
+%endmacro
+
+uring_bench_user_start:
+    xor edi, edi            ; 폴링 스레드 없이 enter 에서 처리
+    mov eax, SYS_URING_SETUP
+    syscall
+    test rax, rax
+    js .exit
+    mov r15, rax            ; 링 주소
+
+    ; SQE 하나마다 enter
+    mov r12, BENCH_ITERS
+    RDTSC64
+    mov r13, rax
+.percall_loop:
+    call .push_nop
+    mov edi, 1
+    mov esi, 1
+    xor edx, edx
+    mov eax, SYS_URING_ENTER
+    syscall
+    call .reap
+    dec r12
+    jnz .percall_loop
+    RDTSC64
+    sub rax, r13
+    mov r14, rax
+
+    ; BATCH 개씩 묶어서 enter
+    mov r12, BENCH_ITERS / BENCH_BATCH
+    RDTSC64
+    mov r13, rax
+.batch_loop:
+    mov ebx, BENCH_BATCH
+.fill_loop:
+    call .push_nop
+    dec ebx
+    jnz .fill_loop
+    mov edi, BENCH_BATCH
+    mov esi, BENCH_BATCH
+    xor edx, edx
+    mov eax, SYS_URING_ENTER
+    syscall
+    call .reap
+    dec r12
+    jnz .batch_loop
+    RDTSC64
+    sub rax, r13
+
+    mov rdi, r14            ; enter-per-SQE 총 사이클
+    mov rsi, rax            ; batched 총 사이클
+    mov edx, BENCH_ITERS
+    mov r10d, BENCH_URING_PERCALL_VS_BATCH
+    mov eax, SYS_BENCH_REPORT
+    syscall
+    xor eax, eax
+
+.exit:
+    mov rdi, rax
+    mov eax, SYS_EXIT
+    syscall
+    ud2
+
+; sq[sq_tail & MASK] = NOP, sq_tail++
+.push_nop:
+    mov eax, [r15 + URING_SQ_TAIL]
+    mov ecx, eax
+    and ecx, URING_SQ_MASK
+    imul ecx, ecx, URING_SQE_SIZE
+    lea rdx, [r15 + URING_SQ_OFF + rcx]
+    mov byte [rdx], URING_OP_NOP
+    mov [rdx + URING_SQE_USER_DATA], rax
+    inc eax
+    mov [r15 + URING_SQ_TAIL], eax      ; x86 은 저장 순서를 지키므로 SQE 가 먼저 보인다
+    ret
+
+; 완료는 세지 않고 모두 소비 (cq_head = cq_tail)
+.reap:
+    mov eax, [r15 + URING_CQ_TAIL]
+    mov [r15 + URING_CQ_HEAD], eax
+    ret
+uring_bench_user_end:
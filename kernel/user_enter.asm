@@ -11,17 +11,17 @@ enter_user_mode:
     mov edx, [esp+8]     ; user_esp
 
     ; DS/ES/FS/GS를 유저 데이터로 바꿀 준비 (RPL=3)
-    mov ax, 0x23         ; GDT_UDATA
+    mov ax, 0x1B         ; GDT_UDATA
     mov ds, ax
     mov es, ax
     mov fs, ax
     mov gs, ax
 
     ; iret 프레임: SS, ESP, EFLAGS, CS, EIP
-    push dword 0x23      ; SS (user data | RPL=3)
+    push dword 0x1B      ; SS (user data | RPL=3)
     push edx             ; ESP
     pushfd
     or dword [esp], 0x200 ; IF=1
-    push dword 0x1B      ; CS (user code | RPL=3)
+    push dword 0x23      ; CS (user code | RPL=3)
     push eax             ; EIP
     iretd
@@ -0,0 +1,510 @@
+#include "uwin.h"
+#include "wm.h"
+#include "fb.h"
+#include "ui.h"
+#include "desktop.h"
+#include "serial.h"
+#include "kheap.h"
+#include "clock.h"
+#include "mm/vmm.h"
+#include "task/task.h"
+#include "task/exec.h"
+#include "task/sync.h"
+#include <string.h>
+
+void *pmm_alloc_contig_tag(uint32_t pages, kmem_tag_t tag);
+
+_Static_assert(sizeof(uwin_event_t) == 24, "uwin_demo.asm event stride");
+_Static_assert(__builtin_offsetof(uwin_shared_t, ev) == 64, "uwin_demo.asm event ring offset");
+_Static_assert(sizeof(uwin_shared_t) <= UWIN_PIXELS_OFF, "header fits the first page");
+_Static_assert(UWIN_PIXELS_OFF + UWIN_MAX_W * UWIN_MAX_H * 4 <= USER_WIN_SIZE, "window VA reservation");
+
+#define UWIN_EINVAL  -1
+#define UWIN_EFAULT  -2
+#define UWIN_EBUSY   -3
+#define UWIN_ENOMEM  -4
+
+// 내장 창들과 같은 장식
+#define UWIN_TITLE_H  22
+#define UWIN_BORDER   2
+#define UWIN_CLOSE_W  18
+
+typedef struct uwin
+{
+    int            used;        // 프로세스가 붙어 있다
+    int            open;        // WM open flag (닫기 단추로 0)
+    int            minimized;
+    int            wm_id;
+    int            focused;
+    uspace_t      *us;
+    uwin_shared_t *sh;          // 서피스 버퍼 (HHDM): 헤더 페이지 + 픽셀
+    uint32_t      *pixels;
+    uint32_t       cap_pages;   // 슬롯에 남아 있는 버퍼 크기
+    uint32_t       map_pages;   // 지금 유저에 매핑된 페이지
+    int            wx, wy, ww, wh;   // 클라이언트 영역 (화면 좌표)
+    int            drag_offx, drag_offy;
+    char           title[32];
+    wait_queue_t   wq;          // SYS_WIN_WAIT
+    uint32_t       damages;
+    uint32_t       events;
+} uwin_t;
+
+static uwin_t  g_uwin[UWIN_MAX];
+static mutex_t g_uwin_lock = MUTEX_INIT;   // 슬롯 상태와 z 순서
+static int     g_order[UWIN_MAX];          // 아래 → 위
+static int     g_norder;
+static uwin_t *g_drag;                     // 제목 표시줄을 잡고 있는 창
+static uwin_t *g_capture;                  // 내용 안에서 눌린 버튼이 떼어질 때까지
+static int     g_last_mx = -1, g_last_my = -1;
+
+/* --------- 이벤트 --------- */
+
+static void ev_push(uwin_t *w, uint32_t type, uint32_t code, int x, int y)
+{
+    uwin_shared_t *sh = w->sh;
+    uint32_t tail = sh->ev_tail;
+    uint32_t head = __atomic_load_n(&sh->ev_head, __ATOMIC_ACQUIRE);
+
+    // 아직 안 읽은 마지막 이벤트가 이동이면 덮어써서 마우스 폭주를 한 칸으로 줄인다
+    if (type == UWIN_EV_MOUSE_MOVE && tail != head)
+    {
+        uwin_event_t *last = &sh->ev[(tail - 1) & (UWIN_EV_ENTRIES - 1)];
+        if (last->type == UWIN_EV_MOUSE_MOVE)
+        {
+            last->code = code;
+            last->x = x;
+            last->y = y;
+            last->time_ns = ktime_ns();
+            return;
+        }
+    }
+    if (tail - head >= UWIN_EV_ENTRIES)
+    {
+        sh->ev_dropped++;
+        return;
+    }
+    uwin_event_t *e = &sh->ev[tail & (UWIN_EV_ENTRIES - 1)];
+    e->type = type;
+    e->code = code;
+    e->x = x;
+    e->y = y;
+    e->time_ns = ktime_ns();
+    __atomic_store_n(&sh->ev_tail, tail + 1, __ATOMIC_RELEASE);
+    w->events++;
+    wq_wake_all(&w->wq);
+}
+
+/* --------- z 순서 / 포커스 --------- */
+
+static void order_remove(uwin_t *w)
+{
+    int idx = (int)(w - g_uwin), j = 0;
+    for (int i = 0; i < g_norder; ++i)
+        if (g_order[i] != idx)
+            g_order[j++] = g_order[i];
+    g_norder = j;
+}
+
+static void order_raise(uwin_t *w)
+{
+    order_remove(w);
+    g_order[g_norder++] = (int)(w - g_uwin);
+}
+
+static int visible(const uwin_t *w)
+{
+    return w->used && w->open && !w->minimized;
+}
+
+static void taskbar_click(wm_entry_t *e, void *user)
+{
+    (void)e;
+    uwin_t *w = user;
+    mutex_lock(&g_uwin_lock);
+    if (w->used && w->open)
+    {
+        w->minimized = !w->minimized;
+        if (!w->minimized)
+            order_raise(w);
+    }
+    mutex_unlock(&g_uwin_lock);
+    desktop_mark_dirty();
+}
+
+void uwin_init(void)
+{
+    // WM에는 해제가 없으니 슬롯마다 미리 한 번 등록해 두고 open 플래그로 켠다
+    for (int i = 0; i < UWIN_MAX; ++i)
+    {
+        uwin_t *w = &g_uwin[i];
+        memcpy(w->title, "user", 5);
+        wq_init(&w->wq);
+        w->wm_id = wm_register_window(w->title, 0xFF66AA55, &w->open, &w->minimized,
+                                      taskbar_click, w);
+    }
+}
+
+/* --------- 시스템콜 --------- */
+
+int64_t uwin_create(uint32_t width, uint32_t height, uint64_t utitle)
+{
+    uspace_t *us = current_task()->uspace;
+    if (!us || width == 0 || height == 0 || width > UWIN_MAX_W || height > UWIN_MAX_H)
+        return UWIN_EINVAL;
+    if (us->win)
+        return UWIN_EBUSY;
+
+    char title[32];
+    if (!utitle)
+        memcpy(title, "user", 5);
+    else if (uspace_copy_str(us, title, utitle, sizeof(title)) < 0)
+        return UWIN_EFAULT;
+
+    uint32_t pages = (UWIN_PIXELS_OFF + width * height * 4 + 0xFFF) / 0x1000;
+    int64_t rc = UWIN_EBUSY;
+    mutex_lock(&g_uwin_lock);
+
+    // 버퍼가 충분히 큰 빈 슬롯을 먼저, 없으면 아무 빈 슬롯에 새 버퍼
+    uwin_t *w = NULL;
+    for (int i = 0; i < UWIN_MAX && !w; ++i)
+        if (!g_uwin[i].used && g_uwin[i].cap_pages >= pages)
+            w = &g_uwin[i];
+    for (int i = 0; i < UWIN_MAX && !w; ++i)
+        if (!g_uwin[i].used)
+            w = &g_uwin[i];
+    if (!w)
+        goto out;
+    if (w->cap_pages < pages)
+    {
+        // PMM은 해제가 없다: 작은 옛 버퍼는 버리고 이 슬롯은 앞으로 큰 버퍼를 쓴다
+        void *buf = pmm_alloc_contig_tag(pages, KMEM_TAG_WM);
+        rc = UWIN_ENOMEM;
+        if (!buf)
+            goto out;
+        w->sh = buf;
+        w->cap_pages = pages;
+    }
+    memset(w->sh, 0, (size_t)pages * 0x1000);   // 앞 프로세스의 픽셀을 넘기지 않는다
+
+    // 페이지 테이블은 us->lock이 지킨다 (uspace_fault_in, uring_setup과 같이)
+    uint64_t base_pa = (uint64_t)(uintptr_t)w->sh - vmm_hhdm_offset();
+    mutex_lock(&us->lock);
+    for (uint32_t i = 0; i < pages; ++i)
+    {
+        if (vmm_space_map(us->cr3, USER_WIN_VA + i * 0x1000, base_pa + i * 0x1000,
+                          VMM_P | VMM_RW | VMM_US) != 0)
+        {
+            vmm_space_unmap_range(us->cr3, USER_WIN_VA, i);
+            mutex_unlock(&us->lock);
+            rc = UWIN_ENOMEM;
+            goto out;
+        }
+    }
+    mutex_unlock(&us->lock);
+
+    int slot = (int)(w - g_uwin);
+    w->sh->width = width;
+    w->sh->height = height;
+    w->sh->stride = width;
+    w->sh->pixels_off = UWIN_PIXELS_OFF;
+    w->pixels = (uint32_t *)((uint8_t *)w->sh + UWIN_PIXELS_OFF);
+    w->map_pages = pages;
+    w->us = us;
+    w->ww = (int)width;
+    w->wh = (int)height;
+    w->wx = 120 + slot * 30;
+    w->wy = 100 + slot * 30;
+    if (w->wx + w->ww > (int)fb.width)
+        w->wx = (int)fb.width > w->ww ? (int)fb.width - w->ww : 0;
+    if (w->wy + w->wh > (int)fb.height)
+        w->wy = (int)fb.height > w->wh + UWIN_TITLE_H ? (int)fb.height - w->wh : UWIN_TITLE_H;
+    memcpy(w->title, title, sizeof(title));
+    w->focused = 0;
+    w->damages = 0;
+    w->events = 0;
+    w->minimized = 0;
+    w->open = 1;
+    w->used = 1;
+    us->win = w;
+    order_raise(w);
+    wm_set_front(w->wm_id);
+    rc = (int64_t)USER_WIN_VA;
+    serial_printf("[uwin] %s: window %ux%u '%s' in slot %d (%u pages shared)\n",
+                  us->path, width, height, w->title, slot, pages);
+out:
+    mutex_unlock(&g_uwin_lock);
+    if (rc > 0)
+        desktop_mark_dirty();
+    return rc;
+}
+
+int64_t uwin_damage(uint64_t xy, uint64_t wh)
+{
+    uspace_t *us = current_task()->uspace;
+    uwin_t *w = us ? us->win : NULL;
+    if (!w)
+        return UWIN_EINVAL;
+    uint32_t x = (uint32_t)xy, y = (uint32_t)(xy >> 32);
+    uint32_t dw = (uint32_t)wh, dh = (uint32_t)(wh >> 32);
+    if (x >= (uint32_t)w->ww || y >= (uint32_t)w->wh || dw == 0 || dh == 0)
+        return UWIN_EINVAL;
+    w->damages++;
+    // 화면은 매 프레임 통째로 다시 합성되므로 영역은 검사만 하고 다음 프레임을 요청한다
+    if (visible(w))
+        desktop_mark_dirty();
+    return 0;
+}
+
+typedef struct
+{
+    uwin_t  *w;
+    uint32_t frames;
+} wait_arg_t;
+
+static int wait_ready(void *arg)
+{
+    wait_arg_t *a = arg;
+    const uwin_shared_t *sh = a->w->sh;
+    return sh->ev_tail != sh->ev_head || sh->frames != a->frames || !a->w->open;
+}
+
+int64_t uwin_wait(uint64_t timeout_ms)
+{
+    uspace_t *us = current_task()->uspace;
+    uwin_t *w = us ? us->win : NULL;
+    if (!w)
+        return UWIN_EINVAL;
+    wait_arg_t a = { w, w->sh->frames };
+    if (timeout_ms)
+        wq_wait_cond(&w->wq, wait_ready, &a, timeout_ms);
+    return (int64_t)(uint32_t)(w->sh->ev_tail - w->sh->ev_head);
+}
+
+void uwin_destroy(uwin_t *w)
+{
+    mutex_lock(&g_uwin_lock);
+    // 서피스 페이지는 슬롯 것이다: 주소공간이 풀 때 같이 가져가지 않게 먼저 뗀다
+    mutex_lock(&w->us->lock);
+    vmm_space_unmap_range(w->us->cr3, USER_WIN_VA, w->map_pages);
+    mutex_unlock(&w->us->lock);
+    serial_printf("[uwin] %s: window closed, %u damage posts, %u events (%u dropped)\n",
+                  w->us->path, w->damages, w->events, w->sh->ev_dropped);
+    w->us->win = NULL;
+    w->us = NULL;
+    w->map_pages = 0;
+    w->open = 0;
+    w->used = 0;
+    if (g_drag == w)
+        g_drag = NULL;
+    if (g_capture == w)
+        g_capture = NULL;
+    order_remove(w);
+    mutex_unlock(&g_uwin_lock);
+    desktop_mark_dirty();
+}
+
+/* --------- 컴포지터 --------- */
+
+static void blit_surface(const uwin_t *w)
+{
+    int x0 = w->wx < 0 ? -w->wx : 0;
+    int y0 = w->wy < 0 ? -w->wy : 0;
+    int x1 = w->ww, y1 = w->wh;
+    if (w->wx + x1 > (int)fb.width)
+        x1 = (int)fb.width - w->wx;
+    if (w->wy + y1 > (int)fb.height)
+        y1 = (int)fb.height - w->wy;
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    const uint32_t *src = w->pixels + (size_t)y0 * w->ww + x0;
+    if (fb.bpp == 32)
+    {
+        // ARGB와 32bpp 프레임버퍼(B,G,R,X)는 메모리 배치가 같다: 줄 단위 복사
+        uint8_t *dst = fb.back + (size_t)(w->wy + y0) * fb.pitch + (size_t)(w->wx + x0) * 4;
+        size_t bytes = (size_t)(x1 - x0) * 4;
+        for (int y = y0; y < y1; ++y, src += w->ww, dst += fb.pitch)
+            memcpy(dst, src, bytes);
+        return;
+    }
+    for (int y = y0; y < y1; ++y, src += w->ww)
+        for (int x = 0; x < x1 - x0; ++x)
+            fb_putpixel(w->wx + x0 + x, w->wy + y, src[x] | 0xFF000000u);
+}
+
+void uwin_composite(void)
+{
+    int front = wm_get_front();
+    mutex_lock(&g_uwin_lock);
+    for (int i = 0; i < g_norder; ++i)
+    {
+        uwin_t *w = &g_uwin[g_order[i]];
+        int focused = visible(w) && w->wm_id == front;
+        if (focused != w->focused)
+        {
+            w->focused = focused;
+            ev_push(w, UWIN_EV_FOCUS, (uint32_t)focused, 0, 0);
+        }
+        if (!visible(w))
+            continue;
+
+        int wx = w->wx, wy = w->wy, ww = w->ww, wh = w->wh;
+        draw_rect(wx - UWIN_BORDER, wy - UWIN_TITLE_H - UWIN_BORDER, ww + 2 * UWIN_BORDER,
+                  wh + UWIN_TITLE_H + 2 * UWIN_BORDER, focused ? 0xFF4C8DFF : 0xFF101010);
+        ui_draw_hgrad_rect(wx, wy - UWIN_TITLE_H, ww, UWIN_TITLE_H - 2, 0xFF2F3948, 0xFF252E3A);
+        draw_text(wx + 8, wy - 20, w->title, 0xFFE7EEF9, 0x00000000);
+        int close_x = wx + ww - UWIN_CLOSE_W - 6;
+        ui_draw_hgrad_rect(close_x, wy - 20, UWIN_CLOSE_W, 14, 0xFF6E2B2B, 0xFF581F1F);
+        draw_text(close_x + 5, wy - 21, "X", 0xFFFBECEC, 0x00000000);
+        blit_surface(w);
+
+        // 프레임 페이싱: 이 프레임에 실린 창의 대기자를 깨운다
+        __atomic_add_fetch(&w->sh->frames, 1, __ATOMIC_RELEASE);
+        wq_wake_all(&w->wq);
+    }
+    mutex_unlock(&g_uwin_lock);
+}
+
+/* --------- 입력 --------- */
+
+static int in_frame(const uwin_t *w, int mx, int my)
+{
+    return mx >= w->wx - UWIN_BORDER && mx < w->wx + w->ww + UWIN_BORDER &&
+           my >= w->wy - UWIN_TITLE_H - UWIN_BORDER && my < w->wy + w->wh + UWIN_BORDER;
+}
+
+static int in_content(const uwin_t *w, int mx, int my)
+{
+    return mx >= w->wx && mx < w->wx + w->ww && my >= w->wy && my < w->wy + w->wh;
+}
+
+int uwin_mouse(int mx, int my, int btn, int prev_btn)
+{
+    int pressed = btn & ~prev_btn, released = prev_btn & ~btn;
+    int moved = mx != g_last_mx || my != g_last_my;
+    int consumed = 0;
+    g_last_mx = mx;
+    g_last_my = my;
+    if (!g_norder)
+        return 0;
+
+    mutex_lock(&g_uwin_lock);
+    if (g_drag)
+    {
+        if (btn & 1)
+        {
+            uwin_t *w = g_drag;
+            int nx = mx - w->drag_offx, ny = my - w->drag_offy;
+            if (nx < 0) nx = 0;
+            if (ny < 24) ny = 24;
+            if (nx + w->ww > (int)fb.width) nx = (int)fb.width - w->ww;
+            if (ny + w->wh > (int)fb.height) ny = (int)fb.height - w->wh;
+            if (nx != w->wx || ny != w->wy)
+            {
+                w->wx = nx;
+                w->wy = ny;
+                desktop_mark_dirty();
+            }
+        }
+        else
+        {
+            g_drag = NULL;
+        }
+        consumed = 1;
+        goto out;
+    }
+    if (g_capture)
+    {
+        uwin_t *w = g_capture;
+        if (moved)
+            ev_push(w, UWIN_EV_MOUSE_MOVE, (uint32_t)btn, mx - w->wx, my - w->wy);
+        if (pressed)
+            ev_push(w, UWIN_EV_MOUSE_DOWN, (uint32_t)pressed, mx - w->wx, my - w->wy);
+        if (released)
+            ev_push(w, UWIN_EV_MOUSE_UP, (uint32_t)released, mx - w->wx, my - w->wy);
+        if (!btn)
+            g_capture = NULL;
+        consumed = 1;
+        goto out;
+    }
+
+    uwin_t *hit = NULL;
+    for (int i = g_norder - 1; i >= 0 && !hit; --i)
+        if (visible(&g_uwin[g_order[i]]) && in_frame(&g_uwin[g_order[i]], mx, my))
+            hit = &g_uwin[g_order[i]];
+    if (!hit)
+        goto out;
+
+    if (pressed)
+    {
+        order_raise(hit);
+        wm_set_front(hit->wm_id);
+        desktop_mark_dirty();
+        consumed = 1;
+        if (in_content(hit, mx, my))
+        {
+            ev_push(hit, UWIN_EV_MOUSE_DOWN, (uint32_t)pressed, mx - hit->wx, my - hit->wy);
+            g_capture = hit;
+        }
+        else if ((pressed & 1) && my < hit->wy)
+        {
+            int close_x = hit->wx + hit->ww - UWIN_CLOSE_W - 6;
+            if (mx >= close_x && mx < close_x + UWIN_CLOSE_W)
+            {
+                // 창은 숨기고 정리는 프로세스가 끝날 때 한다
+                hit->open = 0;
+                ev_push(hit, UWIN_EV_CLOSE, 0, 0, 0);
+            }
+            else
+            {
+                g_drag = hit;
+                hit->drag_offx = mx - hit->wx;
+                hit->drag_offy = my - hit->wy;
+            }
+        }
+    }
+    else if (moved && in_content(hit, mx, my))
+    {
+        ev_push(hit, UWIN_EV_MOUSE_MOVE, (uint32_t)btn, mx - hit->wx, my - hit->wy);
+    }
+    else if (released)
+    {
+        consumed = 1;
+    }
+out:
+    mutex_unlock(&g_uwin_lock);
+    return consumed;
+}
+
+int uwin_key(uint8_t scode, int release, char ch)
+{
+    int front = wm_get_front(), taken = 0;
+    mutex_lock(&g_uwin_lock);
+    for (int i = 0; i < UWIN_MAX; ++i)
+    {
+        uwin_t *w = &g_uwin[i];
+        if (visible(w) && w->wm_id == front)
+        {
+            ev_push(w, UWIN_EV_KEY, scode, !release, (uint8_t)ch);
+            taken = 1;
+            break;
+        }
+    }
+    mutex_unlock(&g_uwin_lock);
+    return taken;
+}
+
+/* --------- 데모 --------- */
+
+extern const uint8_t uwin_demo_user_start[];
+extern const uint8_t uwin_demo_user_end[];
+
+void uwin_demo(void)
+{
+    size_t len = (size_t)(uwin_demo_user_end - uwin_demo_user_start);
+    int tid = exec_image("uwindemo", uwin_demo_user_start, len);
+    if (tid < 0)
+        serial_printf("[uwin] demo: start failed\n");
+    else
+        serial_printf("[uwin] demo: ring 3 client tid %d started\n", tid);
+}
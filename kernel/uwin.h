@@ -0,0 +1,65 @@
+#pragma once
+#include <stdint.h>
+
+// User-mode GUI windows.
+// - SYS_WIN_CREATE가 WM에 창을 등록하고 공유 블록을 USER_WIN_VA에 매핑한다:
+//   첫 페이지는 uwin_shared_t (입력 이벤트 링 포함), 그 뒤가 ARGB 픽셀.
+// - 프로세스는 픽셀에 직접 그리고 SYS_WIN_DAMAGE로 바뀐 영역만 알린다.
+//   컴포지터(desktop_render)는 같은 물리 페이지를 HHDM으로 읽어 백버퍼에
+//   바로 복사한다. 시스템콜로 픽셀을 넘기는 일은 없다.
+// - 키/마우스는 uwin_shared_t.ev 링으로 간다. SYS_WIN_WAIT은 이벤트나
+//   다음 프레임 합성까지 잔다 (프레임 페이싱).
+// - 유저 창은 내장 앱 창들 위 레이어에 그려지고 그 순서대로 마우스를 먼저 받는다.
+// - 프로세스당 창 하나. 서피스 메모리는 창이 닫혀도 슬롯에 남겨 다음 창이 쓴다.
+
+#define UWIN_MAX          8
+#define UWIN_MAX_W        1024
+#define UWIN_MAX_H        768
+#define UWIN_EV_ENTRIES   64
+#define UWIN_PIXELS_OFF   4096
+
+enum {
+    UWIN_EV_KEY = 1,      // code = 스캔코드(7비트), x = 눌림 1 / 뗌 0, y = 문자 (없으면 0)
+    UWIN_EV_MOUSE_MOVE,   // x, y = 서피스 좌표, code = 버튼 비트
+    UWIN_EV_MOUSE_DOWN,   // code = 바뀐 버튼 비트
+    UWIN_EV_MOUSE_UP,
+    UWIN_EV_FOCUS,        // code = 1 얻음 / 0 잃음
+    UWIN_EV_CLOSE,        // 닫기 단추: 창은 숨겨지고 프로세스가 끝내기를 기다린다
+};
+
+typedef struct {
+    uint32_t type;
+    uint32_t code;
+    int32_t  x, y;
+    uint64_t time_ns;
+} uwin_event_t;   // 24 bytes
+
+typedef struct {
+    uint32_t          width, height;
+    uint32_t          stride;        // 픽셀 단위
+    uint32_t          pixels_off;    // UWIN_PIXELS_OFF
+    volatile uint32_t ev_head;       // 유저
+    volatile uint32_t ev_tail;       // 커널
+    volatile uint32_t ev_dropped;
+    volatile uint32_t frames;        // 이 창을 합성한 프레임 수
+    uint8_t           pad[32];
+    uwin_event_t      ev[UWIN_EV_ENTRIES];
+} uwin_shared_t;
+
+struct uwin;
+
+// 시스템콜 (syscall.c)
+int64_t uwin_create(uint32_t w, uint32_t h, uint64_t title);   // 유저 주소 또는 음수
+int64_t uwin_damage(uint64_t xy, uint64_t wh);                 // x | y<<32, w | h<<32
+int64_t uwin_wait(uint64_t timeout_ms);                        // 대기 중인 이벤트 수
+// uspace_destroy에서: 창을 내리고 서피스를 주소공간에서 떼어 슬롯에 돌려준다.
+void    uwin_destroy(struct uwin *w);
+
+// GUI 루프 (kernel.c)
+void    uwin_init(void);                       // 다른 창들과 함께 WM 슬롯 등록
+void    uwin_composite(void);                  // desktop_render: 내장 창 다음에, 대기자도 깨운다
+int     uwin_mouse(int mx, int my, int btn, int prev_btn);   // 1이면 소비
+int     uwin_key(uint8_t scode, int release, char ch);      // 1이면 앞 창이 받았다
+
+// 셸 명령: ring 3 데모 클라이언트
+void    uwin_demo(void);
@@ -0,0 +1,113 @@
+; =======================================================
+; 공유 창 서피스 데모 클라이언트 (ring 3, 위치 독립)
+;  - uwin_demo() 가 exec_image 로 이 바이트들을 새 주소공간에 올려 실행
+;  - SYS_WIN_CREATE 로 받은 픽셀에 프레임마다 움직이는 그라디언트를 그리고
+;    SYS_WIN_DAMAGE 로 알린 뒤 SYS_WIN_WAIT 으로 다음 프레임/입력을 기다린다
+;  - 이벤트 링을 비우다가 UWIN_EV_CLOSE 를 보면 SYS_EXIT
+; =======================================================
+BITS 64
+section .rodata align=16
+
+; syscall.h 의 번호와 같아야 한다
+%define SYS_EXIT          6
+%define SYS_WIN_CREATE    10
+%define SYS_WIN_DAMAGE    11
+%define SYS_WIN_WAIT      12
+
+; uwin.h 의 레이아웃과 같아야 한다
+%define UWIN_EV_HEAD      16
+%define UWIN_EV_TAIL      20
+%define UWIN_FRAMES       28
+%define UWIN_EV_OFF       64
+%define UWIN_EV_SIZE      24
+%define UWIN_EV_MASK      63
+%define UWIN_PIXELS_OFF   4096
+%define UWIN_EV_KEY       1
+%define UWIN_EV_CLOSE     6
+
+%define DEMO_W  256
+%define DEMO_H  160
+%define SC_ESC  1
+
+global uwin_demo_user_start
+global uwin_demo_user_end
+
+uwin_demo_user_start:
+    mov edi, DEMO_W
+    mov esi, DEMO_H
+    lea rdx, [rel .title]
+    mov eax, SYS_WIN_CREATE
+    syscall
+    test rax, rax
+    js .exit
+    mov r15, rax            ; 공유 블록
+
+.frame:
+    ; 입력: CLOSE 또는 Esc 누름이면 끝
+    mov eax, [r15 + UWIN_EV_HEAD]
+.ev_loop:
+    cmp eax, [r15 + UWIN_EV_TAIL]
+    je .ev_done
+    mov ecx, eax
+    and ecx, UWIN_EV_MASK
+    imul ecx, ecx, UWIN_EV_SIZE
+    lea rdx, [r15 + UWIN_EV_OFF + rcx]
+    cmp dword [rdx], UWIN_EV_CLOSE
+    je .done
+    cmp dword [rdx], UWIN_EV_KEY
+    jne .ev_next
+    cmp dword [rdx + 4], SC_ESC
+    jne .ev_next
+    cmp dword [rdx + 8], 1  ; 눌림
+    je .done
+.ev_next:
+    inc eax
+    mov [r15 + UWIN_EV_HEAD], eax
+    jmp .ev_loop
+.ev_done:
+
+    ; 픽셀: R = x + t, G = y + 2t, B = 0x80
+    mov r8d, [r15 + UWIN_FRAMES]
+    lea rdi, [r15 + UWIN_PIXELS_OFF]
+    xor r9d, r9d            ; y
+.row:
+    xor r10d, r10d          ; x
+.col:
+    lea eax, [r10 + r8]
+    and eax, 0xFF
+    shl eax, 16
+    lea ecx, [r9 + r8 * 2]
+    and ecx, 0xFF
+    shl ecx, 8
+    or eax, ecx
+    or eax, 0xFF000080
+    mov [rdi], eax
+    add rdi, 4
+    inc r10d
+    cmp r10d, DEMO_W
+    jb .col
+    inc r9d
+    cmp r9d, DEMO_H
+    jb .row
+
+    xor edi, edi            ; x = 0, y = 0
+    mov rsi, (DEMO_H << 32) | DEMO_W
+    mov eax, SYS_WIN_DAMAGE
+    syscall
+
+    mov edi, 100            ; 최대 100 ms
+    mov eax, SYS_WIN_WAIT
+    syscall
+    jmp .frame
+
+.done:
+    xor eax, eax
+.exit:
+    mov rdi, rax
+    mov eax, SYS_EXIT
+    syscall
+    ud2
+
+.title:
+    db "uwin demo", 0
+uwin_demo_user_end:
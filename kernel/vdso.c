@@ -0,0 +1,155 @@
+#include "vdso.h"
+#include "clock.h"
+#include "ktimer.h"
+#include "kheap.h"
+#include "pmm.h"
+#include "serial.h"
+#include "spinlock.h"
+#include "mm/vmm.h"
+#include "task/task.h"
+#include "task/exec.h"
+#include "percpu.h"
+
+_Static_assert(sizeof(vdso_data_t) <= 4096, "one page");
+_Static_assert(VDSO_USER_VA == USER_VDSO_VA, "vdso_data.h VA matches the exec.h layout");
+_Static_assert(VDSO_CLOCK_JIFFIES == CLOCK_SRC_JIFFIES && VDSO_CLOCK_TSC == CLOCK_SRC_TSC &&
+               VDSO_CLOCK_HPET == CLOCK_SRC_HPET, "clock source ids");
+
+extern volatile uint64_t jiffies;
+
+static vdso_data_t *g_vdso;          // HHDM
+static uint64_t     g_vdso_phys;
+static spinlock_t   g_vdso_lock = SPINLOCK_INIT;   // 쓰는 쪽끼리 (타이머 IRQ와 샘플러)
+static ktimer_t     g_vdso_timer;
+static uint32_t     g_vdso_maps;
+
+static uint64_t write_begin(void)
+{
+    uint64_t fl = spin_lock_irqsave(&g_vdso_lock);
+    __atomic_store_n(&g_vdso->seq, g_vdso->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return fl;
+}
+
+static void write_end(uint64_t fl)
+{
+    __atomic_store_n(&g_vdso->seq, g_vdso->seq + 1, __ATOMIC_RELEASE);
+    spin_unlock_irqrestore(&g_vdso_lock, fl);
+}
+
+// 거친 시계는 페이지를 붙인 주소공간이 있을 때만 갱신한다: 아무도 읽지 않는데
+// 10 ms마다 깨우면 tickless idle이 소용없다.
+static void vdso_tick(void *arg)
+{
+    (void)arg;
+    uint64_t fl = write_begin();
+    g_vdso->jiffies = jiffies;
+    g_vdso->coarse_ns = ktime_ns();
+    write_end(fl);
+    if (__atomic_load_n(&g_vdso_maps, __ATOMIC_RELAXED) > 0)
+        ktimer_add(&g_vdso_timer, ktime_ms() + VDSO_TICK_MS);
+}
+
+void vdso_init(void)
+{
+    void *page = pmm_alloc_tag(KMEM_TAG_USER);
+    if (!page)
+    {
+        serial_printf("[vdso] page alloc failed\n");
+        return;
+    }
+    g_vdso = page;
+    spin_register(&g_vdso_lock, "vdso");
+    g_vdso_phys = (uint64_t)(uintptr_t)page - vmm_hhdm_offset();
+
+    uint64_t fl = write_begin();
+    g_vdso->version = VDSO_VERSION;
+    g_vdso->clock_src = (uint32_t)clock_source();
+    g_vdso->tsc_hz = clock_tsc_hz();
+    clock_get_params(&g_vdso->cycle_base, &g_vdso->mult, &g_vdso->boot_wall_ns);
+    g_vdso->jiffies = jiffies;
+    g_vdso->coarse_ns = ktime_ns();
+    write_end(fl);
+
+    vdso_update_stats();
+    ktimer_init(&g_vdso_timer, vdso_tick, NULL);
+    serial_printf("[vdso] data page phys=0x%llx user va=0x%llx clock=%s\n",
+                  (unsigned long long)g_vdso_phys, (unsigned long long)VDSO_USER_VA,
+                  clock_source_name());
+}
+
+const vdso_data_t *vdso_data(void)
+{
+    return g_vdso;
+}
+
+void vdso_update_stats(void)
+{
+    if (!g_vdso)
+        return;
+    // 락이 필요한 집계는 seqlock 밖에서 먼저 모은다
+    uint32_t ncpus = g_cpu_count < VDSO_MAX_CPUS ? g_cpu_count : VDSO_MAX_CPUS;
+    uint32_t load[VDSO_MAX_CPUS] = { 0 };
+    for (uint32_t i = 0; i < ncpus; ++i)
+        load[i] = sched_cpu_load(i);
+    uint32_t usage = task_cpu_usage_percent();
+    uint32_t total = pmm_total_count(), free = pmm_free_count();
+    uint64_t heap_total = kheap_total_bytes(), heap_used = kheap_used_bytes();
+    uint32_t ntasks = task_count();
+
+    uint64_t fl = write_begin();
+    g_vdso->stats_ns = ktime_ns();
+    g_vdso->ncpus = ncpus;
+    g_vdso->cpu_usage_pct = usage;
+    for (uint32_t i = 0; i < VDSO_MAX_CPUS; ++i)
+        g_vdso->cpu_load_pct[i] = load[i];
+    g_vdso->mem_total_pages = total;
+    g_vdso->mem_free_pages = free;
+    g_vdso->heap_total_bytes = heap_total;
+    g_vdso->heap_used_bytes = heap_used;
+    g_vdso->ntasks = ntasks;
+    write_end(fl);
+}
+
+int vdso_map(uint64_t cr3)
+{
+    if (!g_vdso)
+        return -1;
+    // VMM_RW 없음: 유저는 읽기만
+    if (vmm_space_map(cr3, VDSO_USER_VA, g_vdso_phys, VMM_P | VMM_US) != 0)
+        return -1;
+    // 첫 번째로 붙였으면 값을 지금 채우고 갱신 타이머를 다시 건다
+    if (__atomic_add_fetch(&g_vdso_maps, 1, __ATOMIC_RELAXED) == 1)
+        vdso_tick(NULL);
+    return 0;
+}
+
+void vdso_unmap(uint64_t cr3)
+{
+    // 공유 페이지가 vmm_space_destroy에서 유저 페이지 풀로 들어가지 않게
+    if (g_vdso && vmm_space_unmap(cr3, VDSO_USER_VA) == 0)
+        __atomic_sub_fetch(&g_vdso_maps, 1, __ATOMIC_RELAXED);
+}
+
+void vdso_dump(void)
+{
+    if (!g_vdso)
+    {
+        serial_printf("[vdso] not initialised\n");
+        return;
+    }
+    vdso_stats_t st;
+    vdso_read_stats(g_vdso, &st);
+    uint64_t t0 = clock_cycles();
+    uint64_t ns = vdso_monotonic_ns(g_vdso);
+    uint64_t t1 = clock_cycles();
+    uint32_t wall = vdso_wall_seconds(g_vdso);
+    serial_printf("[vdso] seq=%u mapped in %u spaces, mono=%llu ns (read %llu ns), wall %02u:%02u:%02u\n",
+                  g_vdso->seq, g_vdso_maps, (unsigned long long)ns,
+                  (unsigned long long)clock_cycles_to_ns(t1 - t0),
+                  wall / 3600u, (wall / 60u) % 60u, wall % 60u);
+    serial_printf("[vdso] cpus=%u usage=%u%% mem %u/%u pages free, heap %llu/%llu used, %u tasks\n",
+                  st.ncpus, st.cpu_usage_pct, st.mem_free_pages, st.mem_total_pages,
+                  (unsigned long long)st.heap_used_bytes, (unsigned long long)st.heap_total_bytes,
+                  st.ntasks);
+}
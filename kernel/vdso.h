@@ -0,0 +1,17 @@
+#pragma once
+#include <stdint.h>
+#include "vdso_data.h"
+
+// Kernel side of the shared data page (layout and readers in vdso_data.h).
+
+// clock_init() 다음에: 페이지를 만들고 시계 값을 채운다. 거친 시계 갱신 타이머는
+// 페이지가 어느 주소공간에든 붙어 있는 동안에만 돈다.
+void vdso_init(void);
+// 커널 쪽 보기 (vdso_init 전에는 NULL)
+const vdso_data_t *vdso_data(void);
+// CPU/메모리/태스크 통계 갱신. 잠들 수 있는 문맥에서 (GUI 루프 샘플러).
+void vdso_update_stats(void);
+// 유저 주소공간에 읽기 전용으로 붙이고 뗀다 (task/exec.c).
+int  vdso_map(uint64_t cr3);
+void vdso_unmap(uint64_t cr3);
+void vdso_dump(void);
@@ -0,0 +1,145 @@
+#pragma once
+#include <stdint.h>
+
+// vDSO-style shared data page (ABI).
+// - 커널이 갱신하고 모든 유저 주소공간의 VDSO_USER_VA에 읽기 전용으로 매핑된다.
+//   커널 안의 앱은 vdso_data()로 같은 페이지를 본다.
+// - seqlock: 쓰는 쪽이 seq를 홀수로 만들고 필드를 바꾼 뒤 다시 짝수로.
+//   읽는 쪽은 짝수 seq를 본 뒤 읽고, seq가 그대로면 그 값을 쓴다.
+// - 단조 시계: clock_src가 TSC면 ns = ((rdtsc - cycle_base) * mult) >> 32 를
+//   유저가 직접 계산한다. 다른 소스(HPET MMIO, jiffies)는 유저가 읽을 수 없으므로
+//   커널이 VDSO_TICK_MS마다 채우는 coarse_ns를 쓴다.
+// - 이 헤더는 커널과 유저 라이브러리(user/libvdso) 양쪽에서 쓰므로
+//   커널 헤더를 include하지 않는다.
+
+#define VDSO_VERSION     1
+#define VDSO_USER_VA     0x00005FFFFFBAC000ull
+#define VDSO_MAX_CPUS    16
+#define VDSO_TICK_MS     10
+
+// clock.h의 CLOCK_SRC_*와 같은 값
+#define VDSO_CLOCK_JIFFIES 0
+#define VDSO_CLOCK_TSC     1
+#define VDSO_CLOCK_HPET    2
+
+typedef struct {
+    volatile uint32_t seq;
+    uint32_t version;
+
+    // 시계 (clock_init 뒤 고정)
+    uint32_t clock_src;
+    uint32_t pad0;
+    uint64_t cycle_base;        // ktime 0의 카운터 값
+    uint64_t mult;              // ns = (cycles * mult) >> 32
+    uint64_t tsc_hz;
+    uint64_t boot_wall_ns;      // ktime 0 시점의 하루 중 시각 (ns)
+
+    // VDSO_TICK_MS마다
+    uint64_t jiffies;
+    uint64_t coarse_ns;         // 갱신 시점의 ktime_ns
+
+    // 1초마다
+    uint64_t stats_ns;          // 통계를 찍은 ktime_ns
+    uint32_t ncpus;
+    uint32_t cpu_usage_pct;     // 온라인 CPU 평균
+    uint32_t cpu_load_pct[VDSO_MAX_CPUS];
+    uint32_t mem_total_pages;
+    uint32_t mem_free_pages;
+    uint64_t heap_total_bytes;
+    uint64_t heap_used_bytes;
+    uint32_t ntasks;
+    uint32_t pad1;
+} vdso_data_t;
+
+typedef struct {
+    uint64_t stats_ns;
+    uint64_t jiffies;
+    uint32_t ncpus;
+    uint32_t cpu_usage_pct;
+    uint32_t cpu_load_pct[VDSO_MAX_CPUS];
+    uint32_t mem_total_pages;
+    uint32_t mem_free_pages;
+    uint64_t heap_total_bytes;
+    uint64_t heap_used_bytes;
+    uint32_t ntasks;
+} vdso_stats_t;
+
+/* --------- 읽는 쪽 --------- */
+
+static inline uint32_t vdso_read_begin(const vdso_data_t *d)
+{
+    uint32_t s;
+    while ((s = __atomic_load_n(&d->seq, __ATOMIC_ACQUIRE)) & 1)
+        __asm__ volatile("pause");
+    return s;
+}
+
+static inline int vdso_read_retry(const vdso_data_t *d, uint32_t s)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&d->seq, __ATOMIC_RELAXED) != s;
+}
+
+static inline uint64_t vdso_rdtsc(void)
+{
+    uint32_t lo, hi;
+    // lfence: 앞선 로드(seq)보다 먼저 TSC를 읽지 않도록
+    __asm__ volatile("lfence; rdtsc" : "=a"(lo), "=d"(hi) :: "memory");
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline uint64_t vdso_monotonic_ns(const vdso_data_t *d)
+{
+    uint64_t ns;
+    uint32_t s;
+    do {
+        s = vdso_read_begin(d);
+        if (d->clock_src == VDSO_CLOCK_TSC)
+            ns = (uint64_t)(((unsigned __int128)(vdso_rdtsc() - d->cycle_base) * d->mult) >> 32);
+        else
+            ns = d->coarse_ns;
+    } while (vdso_read_retry(d, s));
+    return ns;
+}
+
+static inline uint64_t vdso_coarse_ns(const vdso_data_t *d)
+{
+    uint64_t ns;
+    uint32_t s;
+    do {
+        s = vdso_read_begin(d);
+        ns = d->coarse_ns;
+    } while (vdso_read_retry(d, s));
+    return ns;
+}
+
+// 하루 중 초 (0..86399)
+static inline uint32_t vdso_wall_seconds(const vdso_data_t *d)
+{
+    uint64_t boot;
+    uint32_t s;
+    do {
+        s = vdso_read_begin(d);
+        boot = d->boot_wall_ns;
+    } while (vdso_read_retry(d, s));
+    return (uint32_t)(((boot + vdso_monotonic_ns(d)) / 1000000000ull) % 86400u);
+}
+
+static inline void vdso_read_stats(const vdso_data_t *d, vdso_stats_t *out)
+{
+    uint32_t s;
+    do {
+        s = vdso_read_begin(d);
+        out->stats_ns = d->stats_ns;
+        out->jiffies = d->jiffies;
+        out->ncpus = d->ncpus;
+        out->cpu_usage_pct = d->cpu_usage_pct;
+        for (uint32_t i = 0; i < VDSO_MAX_CPUS; ++i)
+            out->cpu_load_pct[i] = d->cpu_load_pct[i];
+        out->mem_total_pages = d->mem_total_pages;
+        out->mem_free_pages = d->mem_free_pages;
+        out->heap_total_bytes = d->heap_total_bytes;
+        out->heap_used_bytes = d->heap_used_bytes;
+        out->ntasks = d->ntasks;
+    } while (vdso_read_retry(d, s));
+}
@@ -0,0 +1,538 @@
+#include "workqueue.h"
+#include "clock.h"
+#include "serial.h"
+#include "spinlock.h"
+#include "task/sync.h"
+#include "task/task.h"
+
+#define WQ_LAT_BUCKETS 16      // 2^i us, 마지막 칸은 그 이상 모두
+
+struct workqueue
+{
+    const char *name;
+    int         max_active;
+    int         active;
+    work_t     *head, *tail;
+    uint32_t    depth, depth_max;
+    uint32_t    queued, started, done, canceled;
+    uint64_t    lat_sum_ns, lat_max_ns;
+    uint64_t    run_sum_ns, run_max_ns;
+    uint32_t    lat_hist[WQ_LAT_BUCKETS];
+};
+
+static const char *const g_worker_names[WQ_POOL_THREADS] = {
+    "kworker/0", "kworker/1", "kworker/2", "kworker/3",
+};
+
+static spinlock_t    g_wq_lock = SPINLOCK_INIT;   // 모든 큐, 워커의 current
+static workqueue_t   g_queues[WQ_MAX_QUEUES];
+static int           g_nqueues;
+static int           g_rr;                        // 다음에 먼저 볼 큐
+static work_t       *g_current[WQ_POOL_THREADS];  // 워커가 돌리는 중인 work
+static int           g_nworkers;
+static wait_queue_t  g_pool_wq = WAIT_QUEUE_INIT;
+static wait_queue_t  g_flush_wq = WAIT_QUEUE_INIT;
+static volatile int  g_flushers;
+
+workqueue_t *system_wq;
+workqueue_t *fs_wq;
+workqueue_t *audio_wq;
+
+workqueue_t *alloc_workqueue(const char *name, int max_active)
+{
+    uint64_t fl = spin_lock_irqsave(&g_wq_lock);
+    if (g_nqueues >= WQ_MAX_QUEUES)
+    {
+        spin_unlock_irqrestore(&g_wq_lock, fl);
+        return 0;
+    }
+    workqueue_t *q = &g_queues[g_nqueues++];
+    q->name = name;
+    q->max_active = (max_active > 0) ? max_active : WQ_POOL_THREADS;
+    spin_unlock_irqrestore(&g_wq_lock, fl);
+    return q;
+}
+
+static int work_running_locked(const work_t *w)
+{
+    for (int i = 0; i < g_nworkers; ++i)
+        if (g_current[i] == w)
+            return 1;
+    return 0;
+}
+
+static void insert_locked(workqueue_t *q, work_t *w)
+{
+    w->wq = q;
+    w->next = 0;
+    w->queued_ns = ktime_ns();
+    w->state |= WORK_PENDING | WORK_QUEUED;
+    if (q->tail)
+        q->tail->next = w;
+    else
+        q->head = w;
+    q->tail = w;
+    q->queued++;
+    if (++q->depth > q->depth_max)
+        q->depth_max = q->depth;
+}
+
+static void unlink_locked(workqueue_t *q, work_t *w, work_t *prev)
+{
+    if (prev)
+        prev->next = w->next;
+    else
+        q->head = w->next;
+    if (q->tail == w)
+        q->tail = prev;
+    w->next = 0;
+    w->state &= ~(WORK_PENDING | WORK_QUEUED);
+    q->depth--;
+}
+
+// 돌릴 수 있는 첫 work: 큐에 자리가 있고, 다른 워커가 같은 work를 돌리는 중이 아닌 것.
+// 큐는 라운드 로빈으로 보아 한 큐가 풀을 독차지하지 않게 한다.
+static work_t *find_runnable_locked(workqueue_t **qout, work_t **prev_out)
+{
+    for (int k = 0; k < g_nqueues; ++k)
+    {
+        workqueue_t *q = &g_queues[(g_rr + k) % g_nqueues];
+        if (q->active >= q->max_active)
+            continue;
+        work_t *prev = 0;
+        for (work_t *w = q->head; w; prev = w, w = w->next)
+        {
+            if (work_running_locked(w))
+                continue;
+            *qout = q;
+            *prev_out = prev;
+            return w;
+        }
+    }
+    return 0;
+}
+
+static int pool_has_work(void *arg)
+{
+    (void)arg;
+    workqueue_t *q;
+    work_t *prev;
+    uint64_t fl = spin_lock_irqsave(&g_wq_lock);
+    int r = find_runnable_locked(&q, &prev) != 0;
+    spin_unlock_irqrestore(&g_wq_lock, fl);
+    return r;
+}
+
+static void lat_add(workqueue_t *q, uint64_t ns)
+{
+    uint64_t us = ns / 1000u;
+    uint32_t b = 0;
+    while (b < WQ_LAT_BUCKETS - 1 && us >= (2ull << b))
+        b++;
+    q->lat_hist[b]++;
+    q->lat_sum_ns += ns;
+    if (ns > q->lat_max_ns)
+        q->lat_max_ns = ns;
+}
+
+static void worker_main(void *arg)
+{
+    int id = (int)(uintptr_t)arg;
+    for (;;)
+    {
+        wq_wait_cond(&g_pool_wq, pool_has_work, 0, WAIT_FOREVER);
+
+        workqueue_t *q, *nq;
+        work_t *prev;
+        uint64_t fl = spin_lock_irqsave(&g_wq_lock);
+        work_t *w = find_runnable_locked(&q, &prev);
+        if (!w)
+        {
+            spin_unlock_irqrestore(&g_wq_lock, fl);
+            continue;
+        }
+        unlink_locked(q, w, prev);
+        q->active++;
+        q->started++;
+        g_rr = (int)(q - g_queues + 1) % g_nqueues;
+        g_current[id] = w;
+        uint64_t t0 = ktime_ns();
+        lat_add(q, t0 - w->queued_ns);
+        work_fn_t fn = w->fn;
+        int more = find_runnable_locked(&nq, &prev) != 0;
+        spin_unlock_irqrestore(&g_wq_lock, fl);
+        // 자리가 더 있으면 다른 워커도 깨운다
+        if (more)
+            wq_wake_one(&g_pool_wq);
+
+        fn(w);   // fn이 w를 해제할 수 있다: 여기부터 w는 만지지 않는다
+
+        uint64_t dt = ktime_ns() - t0;
+        fl = spin_lock_irqsave(&g_wq_lock);
+        g_current[id] = 0;
+        q->active--;
+        q->done++;
+        q->run_sum_ns += dt;
+        if (dt > q->run_max_ns)
+            q->run_max_ns = dt;
+        more = find_runnable_locked(&nq, &prev) != 0;
+        spin_unlock_irqrestore(&g_wq_lock, fl);
+        // 자리가 났거나 같은 work가 다시 들어와 있었다
+        if (more)
+            wq_wake_one(&g_pool_wq);
+        if (__atomic_load_n(&g_flushers, __ATOMIC_ACQUIRE))
+            wq_wake_all(&g_flush_wq);
+    }
+}
+
+void workqueue_init(void)
+{
+    spin_register(&g_wq_lock, "workqueue");
+    system_wq = alloc_workqueue("system", 0);
+    fs_wq = alloc_workqueue("fs", 1);
+    audio_wq = alloc_workqueue("audio", 1);
+
+    int n = 0;
+    for (int i = 0; i < WQ_POOL_THREADS; ++i)
+    {
+        // g_nworkers보다 먼저 만들어도 된다: 워커는 깨울 때까지 잔다
+        if (!kthread_create(worker_main, (void *)(uintptr_t)i, g_worker_names[i]))
+            break;
+        n++;
+    }
+    __atomic_store_n(&g_nworkers, n, __ATOMIC_RELEASE);
+    if (!n)
+        serial_printf("[wq] no worker threads; work runs inline\n");
+    else
+        serial_printf("[wq] %d workers, queues: system(%d) fs(1) audio(1)\n", n, system_wq->max_active);
+}
+
+int queue_work(workqueue_t *wq, work_t *w)
+{
+    if (!wq)
+        wq = system_wq;
+    if (!__atomic_load_n(&g_nworkers, __ATOMIC_ACQUIRE) || !wq)
+    {
+        // 풀이 아직 없다: 예전처럼 그 자리에서
+        w->fn(w);
+        return 1;
+    }
+    uint64_t fl = spin_lock_irqsave(&g_wq_lock);
+    if (w->state & WORK_PENDING)
+    {
+        spin_unlock_irqrestore(&g_wq_lock, fl);
+        return 0;
+    }
+    insert_locked(wq, w);
+    spin_unlock_irqrestore(&g_wq_lock, fl);
+    wq_wake_one(&g_pool_wq);
+    return 1;
+}
+
+/* --------- delayed work --------- */
+
+static void delayed_work_timer(void *arg)
+{
+    // 타이머 IRQ 문맥: 큐에 넣고 워커를 깨우기만 한다
+    delayed_work_t *dw = (delayed_work_t *)arg;
+    uint64_t fl = spin_lock_irqsave(&g_wq_lock);
+    insert_locked(dw->target, &dw->work);
+    spin_unlock_irqrestore(&g_wq_lock, fl);
+    wq_wake_one(&g_pool_wq);
+}
+
+void init_delayed_work(delayed_work_t *dw, work_fn_t fn)
+{
+    init_work(&dw->work, fn);
+    ktimer_init(&dw->timer, delayed_work_timer, dw);
+    dw->target = 0;
+}
+
+int queue_delayed_work(workqueue_t *wq, delayed_work_t *dw, uint32_t delay_ms)
+{
+    if (!wq)
+        wq = system_wq;
+    if (!delay_ms || !__atomic_load_n(&g_nworkers, __ATOMIC_ACQUIRE))
+        return queue_work(wq, &dw->work);
+    uint64_t fl = spin_lock_irqsave(&g_wq_lock);
+    if (dw->work.state & WORK_PENDING)
+    {
+        spin_unlock_irqrestore(&g_wq_lock, fl);
+        return 0;
+    }
+    // 타이머에 걸린 동안: PENDING이지만 QUEUED는 아니다. 타이머는 락 안에서 건다:
+    // 락을 놓은 뒤에 걸면 그 사이의 cancel_delayed_work()가 ktimer_cancel()에서
+    // 0을 받고 돌아가, 취소했는데도 나중에 돈다. 콜백은 휠 락 밖에서 돌므로
+    // g_wq_lock -> 휠 락 순서는 안전하고, PENDING이 없으니 이 타이머의 콜백이
+    // g_wq_lock을 기다리는 중일 수도 없다.
+    dw->work.state |= WORK_PENDING;
+    dw->target = wq;
+    ktimer_add(&dw->timer, ktime_ms() + delay_ms);
+    spin_unlock_irqrestore(&g_wq_lock, fl);
+    return 1;
+}
+
+int cancel_delayed_work(delayed_work_t *dw)
+{
+    if (ktimer_cancel(&dw->timer))
+    {
+        uint64_t fl = spin_lock_irqsave(&g_wq_lock);
+        dw->work.state &= ~WORK_PENDING;
+        spin_unlock_irqrestore(&g_wq_lock, fl);
+        // flush_work()가 이 work를 기다리고 있을 수 있다
+        if (__atomic_load_n(&g_flushers, __ATOMIC_ACQUIRE))
+            wq_wake_all(&g_flush_wq);
+        return 1;
+    }
+    // 타이머는 이미 지났다: 큐에서 기다리는 중이면 뺀다
+    int r = 0;
+    uint64_t fl = spin_lock_irqsave(&g_wq_lock);
+    workqueue_t *q = dw->work.wq;
+    if ((dw->work.state & WORK_QUEUED) && q)
+    {
+        work_t *prev = 0;
+        for (work_t *w = q->head; w; prev = w, w = w->next)
+        {
+            if (w != &dw->work)
+                continue;
+            unlink_locked(q, w, prev);
+            q->canceled++;
+            r = 1;
+            break;
+        }
+    }
+    spin_unlock_irqrestore(&g_wq_lock, fl);
+    if (r && __atomic_load_n(&g_flushers, __ATOMIC_ACQUIRE))
+        wq_wake_all(&g_flush_wq);
+    return r;
+}
+
+/* --------- flush --------- */
+
+static int work_idle(void *arg)
+{
+    work_t *w = (work_t *)arg;
+    uint64_t fl = spin_lock_irqsave(&g_wq_lock);
+    int idle = !(w->state & WORK_PENDING) && !work_running_locked(w);
+    spin_unlock_irqrestore(&g_wq_lock, fl);
+    return idle;
+}
+
+int work_pending(const work_t *w)
+{
+    return (__atomic_load_n(&w->state, __ATOMIC_ACQUIRE) & WORK_PENDING) != 0;
+}
+
+int flush_work(work_t *w)
+{
+    if (work_idle(w))
+        return 0;
+    __atomic_add_fetch(&g_flushers, 1, __ATOMIC_ACQ_REL);
+    wq_wait_cond(&g_flush_wq, work_idle, w, WAIT_FOREVER);
+    __atomic_sub_fetch(&g_flushers, 1, __ATOMIC_ACQ_REL);
+    return 1;
+}
+
+int flush_delayed_work(delayed_work_t *dw)
+{
+    // 타이머에 걸려 있으면 당겨서 바로 넣는다
+    if (ktimer_cancel(&dw->timer))
+    {
+        uint64_t fl = spin_lock_irqsave(&g_wq_lock);
+        insert_locked(dw->target, &dw->work);
+        spin_unlock_irqrestore(&g_wq_lock, fl);
+        wq_wake_one(&g_pool_wq);
+    }
+    return flush_work(&dw->work);
+}
+
+typedef struct
+{
+    workqueue_t *q;
+    uint32_t     target;
+} wq_flush_arg_t;
+
+static int wq_drained(void *arg)
+{
+    wq_flush_arg_t *a = (wq_flush_arg_t *)arg;
+    // 끝나거나 취소된 수가 그때까지 넣은 수를 따라잡았는지 (32비트 넘침에도 맞게 차이로)
+    uint32_t finished = __atomic_load_n(&a->q->done, __ATOMIC_ACQUIRE) +
+                        __atomic_load_n(&a->q->canceled, __ATOMIC_ACQUIRE);
+    return (int32_t)(finished - a->target) >= 0;
+}
+
+void flush_workqueue(workqueue_t *wq)
+{
+    if (!wq || !__atomic_load_n(&g_nworkers, __ATOMIC_ACQUIRE))
+        return;
+    uint64_t fl = spin_lock_irqsave(&g_wq_lock);
+    wq_flush_arg_t a = { wq, wq->queued };
+    spin_unlock_irqrestore(&g_wq_lock, fl);
+    if (wq_drained(&a))
+        return;
+    __atomic_add_fetch(&g_flushers, 1, __ATOMIC_ACQ_REL);
+    wq_wait_cond(&g_flush_wq, wq_drained, &a, WAIT_FOREVER);
+    __atomic_sub_fetch(&g_flushers, 1, __ATOMIC_ACQ_REL);
+}
+
+/* --------- stats --------- */
+
+static uint64_t lat_pct_us(const workqueue_t *q, uint32_t pct)
+{
+    uint64_t want = ((uint64_t)q->started * pct + 99) / 100, seen = 0;
+    for (uint32_t b = 0; b < WQ_LAT_BUCKETS; ++b)
+    {
+        seen += q->lat_hist[b];
+        if (seen >= want)
+            return 2ull << b;
+    }
+    return 2ull << (WQ_LAT_BUCKETS - 1);
+}
+
+void workqueue_dump(void)
+{
+    int busy = 0;
+    for (int i = 0; i < g_nworkers; ++i)
+        if (g_current[i])
+            busy++;
+    serial_printf("[wq] pool: %d workers, %d busy\n", g_nworkers, busy);
+    for (int i = 0; i < g_nqueues; ++i)
+    {
+        const workqueue_t *q = &g_queues[i];
+        serial_printf("[wq] %s: max_active %d, active %d, queued %u, done %u, canceled %u, depth %u (max %u)\n",
+                      q->name, q->max_active, q->active, q->queued, q->done, q->canceled,
+                      q->depth, q->depth_max);
+        if (!q->started)
+            continue;
+        serial_printf("[wq]   enqueue -> start: avg %llu us, p50 <%llu us, p99 <%llu us, max %llu us\n",
+                      (unsigned long long)(q->lat_sum_ns / q->started / 1000u),
+                      (unsigned long long)lat_pct_us(q, 50), (unsigned long long)lat_pct_us(q, 99),
+                      (unsigned long long)(q->lat_max_ns / 1000u));
+        if (q->done)
+            serial_printf("[wq]   run: avg %llu us, max %llu us\n",
+                          (unsigned long long)(q->run_sum_ns / q->done / 1000u),
+                          (unsigned long long)(q->run_max_ns / 1000u));
+    }
+}
+
+/* --------- self-test (sercon "wqtest") --------- */
+
+#define WQT_WORKS  32
+#define WQT_RACES  200
+
+typedef struct
+{
+    delayed_work_t    dw;
+    volatile uint32_t runs;
+    uint32_t          sleep_ms;
+} wqt_item_t;
+
+static void wqt_fn(work_t *w)
+{
+    wqt_item_t *it = container_of(w, wqt_item_t, dw.work);
+    if (it->sleep_ms)
+        msleep(it->sleep_ms);
+    __atomic_add_fetch(&it->runs, 1, __ATOMIC_ACQ_REL);
+}
+
+static volatile int g_wqt_flushed;
+
+static void wqt_flusher(void *arg)
+{
+    flush_work(&((wqt_item_t *)arg)->dw.work);
+    __atomic_store_n(&g_wqt_flushed, 1, __ATOMIC_RELEASE);
+}
+
+static void wqt_report(const char *what, int ok)
+{
+    serial_printf("[wq] test %s: %s\n", what, ok ? "ok" : "FAIL");
+}
+
+void workqueue_selftest(void)
+{
+    static wqt_item_t a, b[WQT_WORKS];
+    if (!__atomic_load_n(&g_nworkers, __ATOMIC_ACQUIRE))
+    {
+        serial_printf("[wq] test: no worker threads\n");
+        return;
+    }
+    uint64_t t0 = ktime_ms();
+
+    // queue_work: 기다리는 동안 다시 넣으면 한 번만 돈다. flush_work는 끝까지 잔다.
+    init_delayed_work(&a.dw, wqt_fn);
+    a.runs = 0;
+    a.sleep_ms = 20;
+    int q1 = queue_work(system_wq, &a.dw.work);
+    int q2 = queue_work(system_wq, &a.dw.work);
+    int f = flush_work(&a.dw.work);
+    wqt_report("queue_work/flush_work", q1 == 1 && f == 1 && a.runs == (q2 ? 2u : 1u) && !work_pending(&a.dw.work));
+    a.sleep_ms = 0;
+
+    // 타이머에서 뺀 것은 돌지 않는다
+    a.runs = 0;
+    q1 = queue_delayed_work(system_wq, &a.dw, 30);
+    q2 = queue_delayed_work(system_wq, &a.dw, 30);
+    int c = cancel_delayed_work(&a.dw);
+    msleep(60);
+    wqt_report("cancel_delayed_work", q1 == 1 && q2 == 0 && c == 1 && a.runs == 0 && !work_pending(&a.dw.work));
+
+    // flush_delayed_work는 타이머를 당긴다
+    uint64_t s = ktime_ms();
+    queue_delayed_work(system_wq, &a.dw, 5000);
+    f = flush_delayed_work(&a.dw);
+    wqt_report("flush_delayed_work (5 s timer)", f == 1 && a.runs == 1 && ktime_ms() - s < 1000);
+
+    // 타이머에 걸린 work를 flush_work로 기다리는 스레드는 취소로 깨어나야 한다
+    a.runs = 0;
+    g_wqt_flushed = 0;
+    queue_delayed_work(system_wq, &a.dw, 5000);
+    task_t *th = kthread_create_joinable(wqt_flusher, &a, "wqtest");
+    if (th)
+    {
+        msleep(20);
+        cancel_delayed_work(&a.dw);
+        for (int i = 0; i < 50 && !__atomic_load_n(&g_wqt_flushed, __ATOMIC_ACQUIRE); ++i)
+            msleep(10);
+        int woke = __atomic_load_n(&g_wqt_flushed, __ATOMIC_ACQUIRE);
+        wqt_report("cancel wakes flush_work", woke && a.runs == 0);
+        if (!woke)
+            queue_work(system_wq, &a.dw.work);   // 끝난 work가 flusher를 깨운다
+        kthread_join(th);
+    }
+
+    // 취소와 타이머가 겨룬다: 취소에 성공한 것은 돌지 않고, 나머지는 한 번씩 돈다
+    uint32_t armed = 0, canceled = 0;
+    a.runs = 0;
+    for (uint32_t i = 0; i < WQT_RACES; ++i)
+    {
+        if (queue_delayed_work(system_wq, &a.dw, 1 + (i & 1)))
+            armed++;
+        for (volatile uint32_t spin = 0; spin < (i * 7919u) % 200000u; ++spin)
+            ;
+        if (cancel_delayed_work(&a.dw))
+            canceled++;
+        flush_work(&a.dw.work);
+    }
+    wqt_report("cancel vs timer race", a.runs == armed - canceled);
+    serial_printf("[wq] test   %u armed, %u canceled, %u ran\n", armed, canceled, a.runs);
+
+    // flush_workqueue: 그때까지 넣은 것이 모두 끝난다
+    for (int i = 0; i < WQT_WORKS; ++i)
+    {
+        init_delayed_work(&b[i].dw, wqt_fn);
+        b[i].runs = 0;
+        b[i].sleep_ms = (uint32_t)(i & 3);
+        if (i & 1)
+            queue_delayed_work(fs_wq, &b[i].dw, 10);
+        else
+            queue_work(fs_wq, &b[i].dw.work);
+    }
+    msleep(30);   // 지연된 것도 큐에 들어가 있게
+    flush_workqueue(fs_wq);
+    uint32_t done = 0;
+    for (int i = 0; i < WQT_WORKS; ++i)
+        done += b[i].runs;
+    wqt_report("flush_workqueue", done == WQT_WORKS);
+
+    serial_printf("[wq] test done in %llu ms\n", (unsigned long long)(ktime_ms() - t0));
+}
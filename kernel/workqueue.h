@@ -0,0 +1,88 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "ktimer.h"
+
+// Deferred work on a pool of kernel worker threads.
+// - work_t는 호출자가 가진 구조체에 넣어 쓴다 (할당 없음). queue_work()는 IRQ
+//   핸들러를 포함해 어디서나 부를 수 있고, fn은 워커 스레드에서 돈다 (잘 수 있음).
+// - 풀의 워커(WQ_POOL_THREADS개)가 모든 큐를 같이 처리한다. 큐마다 max_active가
+//   있어서 동시에 도는 work 수를 제한한다: 1이면 넣은 순서대로 하나씩 (ordered).
+// - 같은 work는 두 워커에서 동시에 돌지 않는다. 도는 중에 다시 넣으면 끝난 뒤
+//   한 번 더 돈다.
+// - 큐마다 통계: 넣은/시작한 수, 대기 깊이(현재/최대), 넣은 뒤 시작까지 지연
+//   (log2 히스토그램), 실행 시간. "wq" 콘솔 명령이 찍는다.
+// - workqueue_init() 전에는 queue_work()가 그 자리에서 바로 fn을 부른다.
+
+#define WQ_POOL_THREADS  4
+#define WQ_MAX_QUEUES    8
+
+#ifndef container_of
+// fn이 받은 work_t*에서 그것을 품은 구조체로
+#define container_of(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+#endif
+
+struct workqueue;
+struct work;
+typedef void (*work_fn_t)(struct work *w);
+
+typedef struct work
+{
+    work_fn_t          fn;
+    struct work       *next;
+    struct workqueue  *wq;          // 마지막으로 넣은 큐
+    uint64_t           queued_ns;
+    volatile uint32_t  state;       // WORK_*
+} work_t;
+
+#define WORK_PENDING  0x1u   // 타이머나 큐에서 기다리는 중
+#define WORK_QUEUED   0x2u   // 큐 목록에 실제로 들어 있음
+
+typedef struct delayed_work
+{
+    work_t            work;
+    ktimer_t          timer;
+    struct workqueue *target;
+} delayed_work_t;
+
+typedef struct workqueue workqueue_t;
+
+// workqueue_init()이 만드는 공용 큐
+extern workqueue_t *system_wq;   // 일반 작업, 풀 전체를 쓴다
+extern workqueue_t *fs_wq;       // FAT 읽기/쓰기: 넣은 순서대로 하나씩 (볼륨 락은 fs_fat32.c)
+extern workqueue_t *audio_wq;    // WAV 디코드/리샘플/재생 시작: 한 번에 하나씩
+
+static inline void init_work(work_t *w, work_fn_t fn)
+{
+    w->fn = fn;
+    w->next = 0;
+    w->wq = 0;
+    w->queued_ns = 0;
+    w->state = 0;
+}
+
+void init_delayed_work(delayed_work_t *dw, work_fn_t fn);
+
+// 스케줄러 시작 뒤: 워커 풀과 공용 큐
+void         workqueue_init(void);
+// max_active <= 0이면 풀 크기. 이름은 정적 문자열. 자리가 없으면 NULL.
+workqueue_t *alloc_workqueue(const char *name, int max_active);
+
+// 1이면 넣었고, 0이면 이미 기다리는 중이라 그대로 (한 번만 돈다).
+int  queue_work(workqueue_t *wq, work_t *w);
+// delay_ms 뒤에 wq에 넣는다 (ktimer). 0이면 바로. 이미 기다리는 중이면 0.
+int  queue_delayed_work(workqueue_t *wq, delayed_work_t *dw, uint32_t delay_ms);
+// 타이머나 큐에서 기다리던 것을 뺀다. 1이면 뺐다. 도는 중인 것은 건드리지 않는다.
+int  cancel_delayed_work(delayed_work_t *dw);
+// w가 기다리는 중이거나 도는 중이면 끝날 때까지 잔다. 1이면 기다렸다.
+// 스레드 문맥에서만, 그리고 w 자신의 fn 안에서는 부르지 않는다.
+int  flush_work(work_t *w);
+int  flush_delayed_work(delayed_work_t *dw);
+// 지금까지 wq에 들어간 모든 work가 끝날 때까지
+void flush_workqueue(workqueue_t *wq);
+
+int  work_pending(const work_t *w);
+
+void workqueue_dump(void);
+// 콘솔 "wqtest": 위 API들을 워커 풀에 대고 확인한다 (스레드 문맥)
+void workqueue_selftest(void);
@@ -0,0 +1,42 @@
+#pragma once
+// Tiny user-space library for the kernel's shared data page.
+// Header-only and freestanding: include it from a ring 3 program and call
+// these instead of trapping into the kernel. Every address space created by
+// exec() has the page mapped read-only at VDSO_USER_VA.
+//
+//   uint64_t t0 = vdso_clock_ns();
+//   ...
+//   uint64_t dt = vdso_clock_ns() - t0;
+#include "../../kernel/vdso_data.h"
+
+static inline const vdso_data_t *vdso_get(void)
+{
+    return (const vdso_data_t *)(uintptr_t)VDSO_USER_VA;
+}
+
+// Monotonic nanoseconds since boot (TSC-precise when the kernel clock is the TSC).
+static inline uint64_t vdso_clock_ns(void)
+{
+    return vdso_monotonic_ns(vdso_get());
+}
+
+// Same clock at VDSO_TICK_MS resolution, without reading the TSC.
+static inline uint64_t vdso_clock_coarse_ns(void)
+{
+    return vdso_coarse_ns(vdso_get());
+}
+
+// Wall clock as hours/minutes/seconds of the current day.
+static inline void vdso_time_of_day(uint32_t *hh, uint32_t *mm, uint32_t *ss)
+{
+    uint32_t s = vdso_wall_seconds(vdso_get());
+    *hh = s / 3600u;
+    *mm = (s / 60u) % 60u;
+    *ss = s % 60u;
+}
+
+// Consistent snapshot of the CPU, memory and task counters (refreshed once a second).
+static inline void vdso_stats(vdso_stats_t *out)
+{
+    vdso_read_stats(vdso_get(), out);
+}